@@ -292,10 +292,13 @@ sub which {
 #
 
 use Class::Struct HashSpec => [
-    name      => '$',
-    prefix    => '$',
-    nrbytes   => '$',
-    is_strong => '$',
+    name       => '$',
+    prefix     => '$',
+    nrbytes    => '$',
+    is_strong  => '$',
+    has_batch  => '$',
+    wide_batch => '$',
+    sort_batch => '$',
 ];
 use Class::Struct HashesConfData => [
     hashes             => '*%',
@@ -307,22 +310,25 @@ use Class::Struct HashesConfData => [
 ];
 
 # The canonical list of flags that can appear in the fourth field
-# of a hashes.conf entry.  Alphabetical, except for STRONG and
-# DEFAULT.
+# of a hashes.conf entry.  Alphabetical, except for STRONG, DEFAULT,
+# BATCH, WIDEBATCH, and SORTBATCH.
 my %VALID_FLAGS = (
-    STRONG  => 1,
-    DEFAULT => 1,
-    ALT     => 1,
-    DEBIAN  => 1,
-    FEDORA  => 1,
-    FREEBSD => 1,
-    GLIBC   => 1,
-    NETBSD  => 1,
-    OPENBSD => 1,
-    OSX     => 1,
-    OWL     => 1,
-    SOLARIS => 1,
-    SUSE    => 1,
+    STRONG    => 1,
+    DEFAULT   => 1,
+    BATCH     => 1,
+    WIDEBATCH => 1,
+    SORTBATCH => 1,
+    ALT       => 1,
+    DEBIAN    => 1,
+    FEDORA    => 1,
+    FREEBSD   => 1,
+    GLIBC     => 1,
+    NETBSD    => 1,
+    OPENBSD   => 1,
+    OSX       => 1,
+    OWL       => 1,
+    SOLARIS   => 1,
+    SUSE      => 1,
 );
 
 sub parse_hashes_conf {
@@ -372,6 +378,9 @@ sub parse_hashes_conf {
         my ($name, $h_prefix, $nrbytes, $flags) = @fields;
         my $default_cand = 0;
         my $is_strong    = 0;
+        my $has_batch    = 0;
+        my $wide_batch   = 0;
+        my $sort_batch   = 0;
         my @grps;
 
         if ($name eq ':') {
@@ -410,6 +419,13 @@ sub parse_hashes_conf {
                 $err->("unrecognized flag $_");
             } elsif ($_ eq 'DEFAULT') {
                 $default_cand = 1;
+            } elsif ($_ eq 'BATCH') {
+                $has_batch = 1;
+            } elsif ($_ eq 'WIDEBATCH') {
+                $has_batch  = 1;
+                $wide_batch = 1;
+            } elsif ($_ eq 'SORTBATCH') {
+                $sort_batch = 1;
             } else {
                 push @grps, lc;
                 if ($_ eq 'STRONG') {
@@ -420,14 +436,20 @@ sub parse_hashes_conf {
         if ($default_cand && !$is_strong) {
             $err->('weak hash marked as default candidate');
         }
+        if ($sort_batch && !$has_batch) {
+            $err->('SORTBATCH without BATCH or WIDEBATCH');
+        }
 
         next if $error;
 
         my $entry = HashSpec->new(
-            name      => $name,
-            prefix    => $h_prefix,
-            nrbytes   => $nrbytes,
-            is_strong => $is_strong,
+            name       => $name,
+            prefix     => $h_prefix,
+            nrbytes    => $nrbytes,
+            is_strong  => $is_strong,
+            has_batch  => $has_batch,
+            wide_batch => $wide_batch,
+            sort_batch => $sort_batch,
         );
         $hashes{$name} = $entry;
         for my $g (@grps) {
@@ -0,0 +1,737 @@
+/* Argon2id (RFC 9106).
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   Argon2 fills an array of 1 KiB blocks, divided into LANES rows that
+   are each split into four segments.  Within one pass, the segments
+   in the same column ("slice") of all the lanes can be computed at
+   the same time, and are, on up to lane_threads () threads; every
+   slice is a synchronization point.
+
+   Almost all of the time goes into the compression function, which
+   applies a BLAKE2b-like permutation with multiplications to the eight
+   rows and then the eight columns of a block.  Besides the portable
+   version, it is written with SSE2, AVX2 and AVX-512 intrinsics, of
+   which the best one the CPU supports is selected at load time.  */
+
+#include "crypt-port.h"
+
+#if INCLUDE_argon2id
+
+#include "alg-argon2.h"
+#include "alg-blake2b.h"
+#include "byteorder.h"
+
+#include <errno.h>
+
+#define ARGON2_QWORDS_IN_BLOCK    (ARGON2_BLOCK_SIZE / 8)
+#define ARGON2_SYNC_POINTS        4
+#define ARGON2_PREHASH_DIGEST     64
+#define ARGON2_TYPE_ID            2
+
+typedef struct
+{
+  uint64_t v[ARGON2_QWORDS_IN_BLOCK];
+} argon2_block;
+
+/* The portable compression function.  */
+
+static inline uint64_t
+rotr64 (uint64_t x, unsigned int n)
+{
+  return (x >> n) | (x << (64 - n));
+}
+
+static inline uint64_t
+fBlaMka (uint64_t x, uint64_t y)
+{
+  return x + y + 2 * (uint64_t) (uint32_t) x * (uint32_t) y;
+}
+
+#define GB(a, b, c, d) do {                     \
+    a = fBlaMka (a, b);                         \
+    d = rotr64 (d ^ a, 32);                     \
+    c = fBlaMka (c, d);                         \
+    b = rotr64 (b ^ c, 24);                     \
+    a = fBlaMka (a, b);                         \
+    d = rotr64 (d ^ a, 16);                     \
+    c = fBlaMka (c, d);                         \
+    b = rotr64 (b ^ c, 63);                     \
+  } while (0)
+
+#define BLAMKA_ROUND(v0, v1, v2, v3, v4, v5, v6, v7,                  \
+                     v8, v9, v10, v11, v12, v13, v14, v15) do {       \
+    GB (v0, v4, v8,  v12);                                            \
+    GB (v1, v5, v9,  v13);                                            \
+    GB (v2, v6, v10, v14);                                            \
+    GB (v3, v7, v11, v15);                                            \
+    GB (v0, v5, v10, v15);                                            \
+    GB (v1, v6, v11, v12);                                            \
+    GB (v2, v7, v8,  v13);                                            \
+    GB (v3, v4, v9,  v14);                                            \
+  } while (0)
+
+/* NEXT = G (PREV, REF), or, when WITH_XOR, NEXT ^= G (PREV, REF),
+   which is what passes after the first do.  */
+static void
+fill_block_generic (const argon2_block *prev, const argon2_block *ref,
+                    argon2_block *next, bool with_xor)
+{
+  argon2_block r, t;
+  unsigned int i;
+
+  for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++)
+    {
+      r.v[i] = prev->v[i] ^ ref->v[i];
+      t.v[i] = with_xor ? r.v[i] ^ next->v[i] : r.v[i];
+    }
+
+  for (i = 0; i < 8; i++)
+    {
+      uint64_t *v = r.v + 16 * i;
+      BLAMKA_ROUND (v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7],
+                    v[8], v[9], v[10], v[11], v[12], v[13], v[14], v[15]);
+    }
+  for (i = 0; i < 8; i++)
+    {
+      uint64_t *v = r.v + 2 * i;
+      BLAMKA_ROUND (v[0], v[1], v[16], v[17], v[32], v[33], v[48], v[49],
+                    v[64], v[65], v[80], v[81], v[96], v[97],
+                    v[112], v[113]);
+    }
+
+  for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++)
+    next->v[i] = t.v[i] ^ r.v[i];
+}
+
+/* The SIMD versions hold the sixteen words a round works on as four
+   vectors A, B, C and D of four words each, and apply GB to the
+   columns of that 4x4 matrix, then to its diagonals, by rotating B, C
+   and D by one, two and three words.  The columns of a block are
+   gathered from two words of each row into the same form.  */
+
+#if defined HAVE_X86_TARGET_SSE2 || defined HAVE_X86_TARGET_AVX2 \
+  || defined HAVE_X86_TARGET_AVX512F
+#include <immintrin.h>
+#endif
+
+#ifdef HAVE_X86_TARGET_SSE2
+/* With SSE2, each of A, B, C and D is split over two registers.  */
+
+#define SSE2_BLAMKA(x, y) \
+  _mm_add_epi64 (_mm_add_epi64 (x, y), \
+                 _mm_add_epi64 (_mm_mul_epu32 (x, y), _mm_mul_epu32 (x, y)))
+#define SSE2_ROTR(x, n) \
+  _mm_or_si128 (_mm_srli_epi64 (x, n), _mm_slli_epi64 (x, 64 - (n)))
+#define SSE2_ROTR32(x) _mm_shuffle_epi32 (x, _MM_SHUFFLE (2, 3, 0, 1))
+#define SSE2_ROTR63(x) \
+  _mm_xor_si128 (_mm_srli_epi64 (x, 63), _mm_add_epi64 (x, x))
+/* (X[1], Y[0]).  */
+#define SSE2_CROSS(x, y) \
+  _mm_castpd_si128 (_mm_shuffle_pd (_mm_castsi128_pd (x), \
+                                    _mm_castsi128_pd (y), 1))
+
+#define SSE2_G(a0, b0, c0, d0, a1, b1, c1, d1) do {             \
+    a0 = SSE2_BLAMKA (a0, b0);  a1 = SSE2_BLAMKA (a1, b1);      \
+    d0 = SSE2_ROTR32 (_mm_xor_si128 (d0, a0));                  \
+    d1 = SSE2_ROTR32 (_mm_xor_si128 (d1, a1));                  \
+    c0 = SSE2_BLAMKA (c0, d0);  c1 = SSE2_BLAMKA (c1, d1);      \
+    b0 = SSE2_ROTR (_mm_xor_si128 (b0, c0), 24);                \
+    b1 = SSE2_ROTR (_mm_xor_si128 (b1, c1), 24);                \
+    a0 = SSE2_BLAMKA (a0, b0);  a1 = SSE2_BLAMKA (a1, b1);      \
+    d0 = SSE2_ROTR (_mm_xor_si128 (d0, a0), 16);                \
+    d1 = SSE2_ROTR (_mm_xor_si128 (d1, a1), 16);                \
+    c0 = SSE2_BLAMKA (c0, d0);  c1 = SSE2_BLAMKA (c1, d1);      \
+    b0 = SSE2_ROTR63 (_mm_xor_si128 (b0, c0));                  \
+    b1 = SSE2_ROTR63 (_mm_xor_si128 (b1, c1));                  \
+  } while (0)
+
+/* Apply the permutation to the words at V[I[0]], V[I[0] + 1], ...,
+   V[I[7]], V[I[7] + 1].  */
+__attribute__((target("sse2"))) static inline void
+blamka_round_sse2 (uint64_t *v, const unsigned int i[8])
+{
+  __m128i a0 = _mm_loadu_si128 ((const __m128i *) (v + i[0]));
+  __m128i a1 = _mm_loadu_si128 ((const __m128i *) (v + i[1]));
+  __m128i b0 = _mm_loadu_si128 ((const __m128i *) (v + i[2]));
+  __m128i b1 = _mm_loadu_si128 ((const __m128i *) (v + i[3]));
+  __m128i c0 = _mm_loadu_si128 ((const __m128i *) (v + i[4]));
+  __m128i c1 = _mm_loadu_si128 ((const __m128i *) (v + i[5]));
+  __m128i d0 = _mm_loadu_si128 ((const __m128i *) (v + i[6]));
+  __m128i d1 = _mm_loadu_si128 ((const __m128i *) (v + i[7]));
+  __m128i t0, t1;
+
+  SSE2_G (a0, b0, c0, d0, a1, b1, c1, d1);
+
+  t0 = SSE2_CROSS (b0, b1);
+  t1 = SSE2_CROSS (b1, b0);
+  b0 = t0;
+  b1 = t1;
+  t0 = c0;
+  c0 = c1;
+  c1 = t0;
+  t0 = SSE2_CROSS (d1, d0);
+  t1 = SSE2_CROSS (d0, d1);
+  d0 = t0;
+  d1 = t1;
+
+  SSE2_G (a0, b0, c0, d0, a1, b1, c1, d1);
+
+  t0 = SSE2_CROSS (b1, b0);
+  t1 = SSE2_CROSS (b0, b1);
+  b0 = t0;
+  b1 = t1;
+  t0 = c0;
+  c0 = c1;
+  c1 = t0;
+  t0 = SSE2_CROSS (d0, d1);
+  t1 = SSE2_CROSS (d1, d0);
+  d0 = t0;
+  d1 = t1;
+
+  _mm_storeu_si128 ((__m128i *) (v + i[0]), a0);
+  _mm_storeu_si128 ((__m128i *) (v + i[1]), a1);
+  _mm_storeu_si128 ((__m128i *) (v + i[2]), b0);
+  _mm_storeu_si128 ((__m128i *) (v + i[3]), b1);
+  _mm_storeu_si128 ((__m128i *) (v + i[4]), c0);
+  _mm_storeu_si128 ((__m128i *) (v + i[5]), c1);
+  _mm_storeu_si128 ((__m128i *) (v + i[6]), d0);
+  _mm_storeu_si128 ((__m128i *) (v + i[7]), d1);
+}
+
+__attribute__((target("sse2"))) static void
+fill_block_sse2 (const argon2_block *prev, const argon2_block *ref,
+                 argon2_block *next, bool with_xor)
+{
+  argon2_block r, t;
+  unsigned int i, j;
+
+  for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i += 2)
+    {
+      __m128i x = _mm_xor_si128 (
+        _mm_loadu_si128 ((const __m128i *) (prev->v + i)),
+        _mm_loadu_si128 ((const __m128i *) (ref->v + i)));
+      _mm_storeu_si128 ((__m128i *) (r.v + i), x);
+      if (with_xor)
+        x = _mm_xor_si128 (x, _mm_loadu_si128 ((const __m128i *)
+                                               (next->v + i)));
+      _mm_storeu_si128 ((__m128i *) (t.v + i), x);
+    }
+
+  for (i = 0; i < 8; i++)
+    {
+      unsigned int row[8];
+      for (j = 0; j < 8; j++)
+        row[j] = 16 * i + 2 * j;
+      blamka_round_sse2 (r.v, row);
+    }
+  for (i = 0; i < 8; i++)
+    {
+      unsigned int col[8];
+      for (j = 0; j < 8; j++)
+        col[j] = 2 * i + 16 * j;
+      blamka_round_sse2 (r.v, col);
+    }
+
+  for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i += 2)
+    _mm_storeu_si128 ((__m128i *) (next->v + i),
+                      _mm_xor_si128 (
+                        _mm_loadu_si128 ((const __m128i *) (t.v + i)),
+                        _mm_loadu_si128 ((const __m128i *) (r.v + i))));
+}
+#endif /* HAVE_X86_TARGET_SSE2 */
+
+#ifdef HAVE_X86_TARGET_AVX2
+#define AVX2_BLAMKA(x, y) \
+  _mm256_add_epi64 (_mm256_add_epi64 (x, y), \
+                    _mm256_add_epi64 (_mm256_mul_epu32 (x, y), \
+                                      _mm256_mul_epu32 (x, y)))
+#define AVX2_ROTR32(x) _mm256_shuffle_epi32 (x, _MM_SHUFFLE (2, 3, 0, 1))
+#define AVX2_ROTR24(x) _mm256_shuffle_epi8 (x, _mm256_setr_epi8 ( \
+    3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,         \
+    3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10))
+#define AVX2_ROTR16(x) _mm256_shuffle_epi8 (x, _mm256_setr_epi8 ( \
+    2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,         \
+    2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9))
+#define AVX2_ROTR63(x) \
+  _mm256_xor_si256 (_mm256_srli_epi64 (x, 63), _mm256_add_epi64 (x, x))
+
+#define AVX2_G(a, b, c, d) do {                                 \
+    a = AVX2_BLAMKA (a, b);                                     \
+    d = AVX2_ROTR32 (_mm256_xor_si256 (d, a));                  \
+    c = AVX2_BLAMKA (c, d);                                     \
+    b = AVX2_ROTR24 (_mm256_xor_si256 (b, c));                  \
+    a = AVX2_BLAMKA (a, b);                                     \
+    d = AVX2_ROTR16 (_mm256_xor_si256 (d, a));                  \
+    c = AVX2_BLAMKA (c, d);                                     \
+    b = AVX2_ROTR63 (_mm256_xor_si256 (b, c));                  \
+  } while (0)
+
+__attribute__((target("avx2"))) static inline void
+blamka_round_avx2 (__m256i *a, __m256i *b, __m256i *c, __m256i *d)
+{
+  AVX2_G (*a, *b, *c, *d);
+  *b = _mm256_permute4x64_epi64 (*b, _MM_SHUFFLE (0, 3, 2, 1));
+  *c = _mm256_permute4x64_epi64 (*c, _MM_SHUFFLE (1, 0, 3, 2));
+  *d = _mm256_permute4x64_epi64 (*d, _MM_SHUFFLE (2, 1, 0, 3));
+  AVX2_G (*a, *b, *c, *d);
+  *b = _mm256_permute4x64_epi64 (*b, _MM_SHUFFLE (2, 1, 0, 3));
+  *c = _mm256_permute4x64_epi64 (*c, _MM_SHUFFLE (1, 0, 3, 2));
+  *d = _mm256_permute4x64_epi64 (*d, _MM_SHUFFLE (0, 3, 2, 1));
+}
+
+__attribute__((target("avx2"))) static void
+fill_block_avx2 (const argon2_block *prev, const argon2_block *ref,
+                 argon2_block *next, bool with_xor)
+{
+  /* Register 4 * I + J holds words 4 * J to 4 * J + 3 of row I.  */
+  __m256i r[32], t[32];
+  unsigned int i;
+
+  for (i = 0; i < 32; i++)
+    {
+      r[i] = _mm256_xor_si256 (
+        _mm256_loadu_si256 ((const __m256i *) prev->v + i),
+        _mm256_loadu_si256 ((const __m256i *) ref->v + i));
+      t[i] = with_xor
+        ? _mm256_xor_si256 (r[i],
+                            _mm256_loadu_si256 ((const __m256i *) next->v + i))
+        : r[i];
+    }
+
+  for (i = 0; i < 8; i++)
+    blamka_round_avx2 (&r[4 * i], &r[4 * i + 1], &r[4 * i + 2],
+                       &r[4 * i + 3]);
+
+  /* Columns 2J and 2J + 1 are the low and high halves of registers J,
+     J + 4, ..., J + 28.  */
+  for (i = 0; i < 4; i++)
+    {
+      __m256i a0 = _mm256_permute2x128_si256 (r[i], r[i + 4], 0x20);
+      __m256i a1 = _mm256_permute2x128_si256 (r[i], r[i + 4], 0x31);
+      __m256i b0 = _mm256_permute2x128_si256 (r[i + 8], r[i + 12], 0x20);
+      __m256i b1 = _mm256_permute2x128_si256 (r[i + 8], r[i + 12], 0x31);
+      __m256i c0 = _mm256_permute2x128_si256 (r[i + 16], r[i + 20], 0x20);
+      __m256i c1 = _mm256_permute2x128_si256 (r[i + 16], r[i + 20], 0x31);
+      __m256i d0 = _mm256_permute2x128_si256 (r[i + 24], r[i + 28], 0x20);
+      __m256i d1 = _mm256_permute2x128_si256 (r[i + 24], r[i + 28], 0x31);
+
+      blamka_round_avx2 (&a0, &b0, &c0, &d0);
+      blamka_round_avx2 (&a1, &b1, &c1, &d1);
+
+      r[i]      = _mm256_permute2x128_si256 (a0, a1, 0x20);
+      r[i + 4]  = _mm256_permute2x128_si256 (a0, a1, 0x31);
+      r[i + 8]  = _mm256_permute2x128_si256 (b0, b1, 0x20);
+      r[i + 12] = _mm256_permute2x128_si256 (b0, b1, 0x31);
+      r[i + 16] = _mm256_permute2x128_si256 (c0, c1, 0x20);
+      r[i + 20] = _mm256_permute2x128_si256 (c0, c1, 0x31);
+      r[i + 24] = _mm256_permute2x128_si256 (d0, d1, 0x20);
+      r[i + 28] = _mm256_permute2x128_si256 (d0, d1, 0x31);
+    }
+
+  for (i = 0; i < 32; i++)
+    _mm256_storeu_si256 ((__m256i *) next->v + i,
+                         _mm256_xor_si256 (t[i], r[i]));
+}
+#endif /* HAVE_X86_TARGET_AVX2 */
+
+#ifdef HAVE_X86_TARGET_AVX512F
+/* With AVX-512, two rounds are done at once, one in each 256-bit half
+   of the registers.  */
+#define AVX512_BLAMKA(x, y) \
+  _mm512_add_epi64 (_mm512_add_epi64 (x, y), \
+                    _mm512_add_epi64 (_mm512_mul_epu32 (x, y), \
+                                      _mm512_mul_epu32 (x, y)))
+
+#define AVX512_G(a, b, c, d) do {                               \
+    a = AVX512_BLAMKA (a, b);                                   \
+    d = _mm512_ror_epi64 (_mm512_xor_si512 (d, a), 32);         \
+    c = AVX512_BLAMKA (c, d);                                   \
+    b = _mm512_ror_epi64 (_mm512_xor_si512 (b, c), 24);         \
+    a = AVX512_BLAMKA (a, b);                                   \
+    d = _mm512_ror_epi64 (_mm512_xor_si512 (d, a), 16);         \
+    c = AVX512_BLAMKA (c, d);                                   \
+    b = _mm512_ror_epi64 (_mm512_xor_si512 (b, c), 63);         \
+  } while (0)
+
+__attribute__((target("avx512f"))) static inline void
+blamka_round_avx512 (__m512i *a, __m512i *b, __m512i *c, __m512i *d)
+{
+  AVX512_G (*a, *b, *c, *d);
+  *b = _mm512_permutex_epi64 (*b, _MM_SHUFFLE (0, 3, 2, 1));
+  *c = _mm512_permutex_epi64 (*c, _MM_SHUFFLE (1, 0, 3, 2));
+  *d = _mm512_permutex_epi64 (*d, _MM_SHUFFLE (2, 1, 0, 3));
+  AVX512_G (*a, *b, *c, *d);
+  *b = _mm512_permutex_epi64 (*b, _MM_SHUFFLE (2, 1, 0, 3));
+  *c = _mm512_permutex_epi64 (*c, _MM_SHUFFLE (1, 0, 3, 2));
+  *d = _mm512_permutex_epi64 (*d, _MM_SHUFFLE (0, 3, 2, 1));
+}
+
+/* The four words at P in the low half and those at Q in the high half.  */
+#define AVX512_LOAD2(p, q) \
+  _mm512_inserti64x4 (_mm512_castsi256_si512 ( \
+    _mm256_loadu_si256 ((const __m256i *) (p))), \
+    _mm256_loadu_si256 ((const __m256i *) (q)), 1)
+#define AVX512_STORE2(p, q, x) do { \
+    _mm256_storeu_si256 ((__m256i *) (p), _mm512_castsi512_si256 (x)); \
+    _mm256_storeu_si256 ((__m256i *) (q), _mm512_extracti64x4_epi64 (x, 1)); \
+  } while (0)
+/* Exchange the second and third 128-bit quarters.  */
+#define AVX512_SWAP_MIDDLE(x) \
+  _mm512_shuffle_i64x2 (x, x, _MM_SHUFFLE (3, 1, 2, 0))
+
+__attribute__((target("avx512f"))) static void
+fill_block_avx512 (const argon2_block *prev, const argon2_block *ref,
+                   argon2_block *next, bool with_xor)
+{
+  argon2_block r, t;
+  unsigned int i, j;
+
+  for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i += 8)
+    {
+      __m512i x = _mm512_xor_si512 (_mm512_loadu_si512 (prev->v + i),
+                                    _mm512_loadu_si512 (ref->v + i));
+      _mm512_storeu_si512 (r.v + i, x);
+      if (with_xor)
+        x = _mm512_xor_si512 (x, _mm512_loadu_si512 (next->v + i));
+      _mm512_storeu_si512 (t.v + i, x);
+    }
+
+  /* Rows I and I + 1.  */
+  for (i = 0; i < 8; i += 2)
+    {
+      uint64_t *p = r.v + 16 * i, *q = p + 16;
+      __m512i a = AVX512_LOAD2 (p, q);
+      __m512i b = AVX512_LOAD2 (p + 4, q + 4);
+      __m512i c = AVX512_LOAD2 (p + 8, q + 8);
+      __m512i d = AVX512_LOAD2 (p + 12, q + 12);
+      blamka_round_avx512 (&a, &b, &c, &d);
+      AVX512_STORE2 (p, q, a);
+      AVX512_STORE2 (p + 4, q + 4, b);
+      AVX512_STORE2 (p + 8, q + 8, c);
+      AVX512_STORE2 (p + 12, q + 12, d);
+    }
+
+  /* Columns 2J and 2J + 1.  Each of A, B, C and D takes two words of
+     two consecutive rows for each column; loading four words of each
+     row and exchanging the middle quarters puts those of column 2J in
+     the low half and those of column 2J + 1 in the high half.  */
+  for (j = 0; j < 4; j++)
+    {
+      __m512i v[4];
+      for (i = 0; i < 4; i++)
+        v[i] = AVX512_SWAP_MIDDLE (AVX512_LOAD2 (r.v + 32 * i + 4 * j,
+                                                 r.v + 32 * i + 16 + 4 * j));
+      blamka_round_avx512 (&v[0], &v[1], &v[2], &v[3]);
+      for (i = 0; i < 4; i++)
+        AVX512_STORE2 (r.v + 32 * i + 4 * j, r.v + 32 * i + 16 + 4 * j,
+                       AVX512_SWAP_MIDDLE (v[i]));
+    }
+
+  for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i += 8)
+    _mm512_storeu_si512 (next->v + i,
+                         _mm512_xor_si512 (_mm512_loadu_si512 (t.v + i),
+                                           _mm512_loadu_si512 (r.v + i)));
+}
+#endif /* HAVE_X86_TARGET_AVX512F */
+
+/* The implementation to use; upgraded, if the CPU allows, when the
+   library is loaded.  */
+static void (*fill_block) (const argon2_block *, const argon2_block *,
+                           argon2_block *, bool) = fill_block_generic;
+
+#if defined HAVE_X86_TARGET_SSE2 || defined HAVE_X86_TARGET_AVX2 \
+  || defined HAVE_X86_TARGET_AVX512F
+CPU_DISPATCH (fill_block_select)
+
+static void
+fill_block_select (void)
+{
+  fill_block = fill_block_generic;
+#ifdef HAVE_X86_TARGET_AVX512F
+  if (cpu_supports (CPU_AVX512F))
+    {
+      fill_block = fill_block_avx512;
+      return;
+    }
+#endif
+#ifdef HAVE_X86_TARGET_AVX2
+  if (cpu_supports (CPU_AVX2))
+    {
+      fill_block = fill_block_avx2;
+      return;
+    }
+#endif
+#ifdef HAVE_X86_TARGET_SSE2
+  if (cpu_supports (CPU_SSE2))
+    fill_block = fill_block_sse2;
+#endif
+}
+#endif
+
+/* Filling memory.  */
+
+struct argon2_instance
+{
+  argon2_block *memory;
+  uint32_t passes;
+  uint32_t lanes;
+  uint32_t lane_length;
+  uint32_t segment_length;
+  uint32_t memory_blocks;
+  /* The slice being filled.  */
+  uint32_t pass;
+  uint32_t slice;
+};
+
+/* The next 128 pseudo-random numbers for data-independent addressing,
+   from the counter in INPUT.  */
+static void
+next_addresses (argon2_block *address, argon2_block *input,
+                const argon2_block *zero)
+{
+  input->v[6]++;
+  fill_block (zero, input, address, false);
+  fill_block (zero, address, address, false);
+}
+
+/* The position within its lane of the block that the block at INDEX
+   in the current segment refers to, given the low 32 bits of its
+   pseudo-random number.  */
+static uint32_t
+index_alpha (const struct argon2_instance *in, uint32_t index,
+             uint32_t pseudo_rand, bool same_lane)
+{
+  uint32_t area, start = 0;
+  uint64_t rel;
+
+  /* The blocks that may be referred to: in the first pass, those
+     already filled; in later passes, all but the current segment;
+     and never the previous block.  Blocks of other lanes in the
+     current slice are still being filled.  */
+  if (in->pass == 0)
+    {
+      if (in->slice == 0)
+        area = index - 1;
+      else if (same_lane)
+        area = in->slice * in->segment_length + index - 1;
+      else
+        area = in->slice * in->segment_length - (index == 0);
+    }
+  else
+    {
+      if (same_lane)
+        area = in->lane_length - in->segment_length + index - 1;
+      else
+        area = in->lane_length - in->segment_length - (index == 0);
+      if (in->slice != ARGON2_SYNC_POINTS - 1)
+        start = (in->slice + 1) * in->segment_length;
+    }
+
+  rel = pseudo_rand;
+  rel = (rel * rel) >> 32;
+  rel = area - 1 - ((area * rel) >> 32);
+  return (uint32_t) ((start + rel) % in->lane_length);
+}
+
+static void
+fill_segment (void *arg, uint32_t lane)
+{
+  const struct argon2_instance *in = arg;
+  argon2_block address, input, zero;
+  /* Argon2id uses data-independent addressing for the first half of
+     the first pass, and data-dependent addressing after that.  */
+  bool data_independent = in->pass == 0
+                          && in->slice < ARGON2_SYNC_POINTS / 2;
+  uint32_t i, start = 0, curr, prev;
+
+  if (data_independent)
+    {
+      memset (&zero, 0, sizeof zero);
+      memset (&input, 0, sizeof input);
+      input.v[0] = in->pass;
+      input.v[1] = lane;
+      input.v[2] = in->slice;
+      input.v[3] = in->memory_blocks;
+      input.v[4] = in->passes;
+      input.v[5] = ARGON2_TYPE_ID;
+    }
+
+  /* The first two blocks of each lane are made from the passphrase.  */
+  if (in->pass == 0 && in->slice == 0)
+    {
+      start = 2;
+      if (data_independent)
+        next_addresses (&address, &input, &zero);
+    }
+
+  curr = lane * in->lane_length + in->slice * in->segment_length + start;
+  if (curr % in->lane_length == 0)
+    prev = curr + in->lane_length - 1;
+  else
+    prev = curr - 1;
+
+  for (i = start; i < in->segment_length; i++, curr++, prev++)
+    {
+      uint64_t pseudo_rand;
+      uint32_t ref_lane, ref_index;
+
+      if (curr % in->lane_length == 1)
+        prev = curr - 1;
+
+      if (data_independent)
+        {
+          if (i % ARGON2_QWORDS_IN_BLOCK == 0)
+            next_addresses (&address, &input, &zero);
+          pseudo_rand = address.v[i % ARGON2_QWORDS_IN_BLOCK];
+        }
+      else
+        pseudo_rand = in->memory[prev].v[0];
+
+      if (in->pass == 0 && in->slice == 0)
+        ref_lane = lane;
+      else
+        ref_lane = (uint32_t) ((pseudo_rand >> 32) % in->lanes);
+      ref_index = index_alpha (in, i, (uint32_t) pseudo_rand,
+                               ref_lane == lane);
+
+      fill_block (&in->memory[prev],
+                  &in->memory[(size_t) ref_lane * in->lane_length
+                              + ref_index],
+                  &in->memory[curr], in->pass != 0);
+    }
+
+  if (data_independent)
+    {
+      explicit_bzero (&address, sizeof address);
+      explicit_bzero (&input, sizeof input);
+    }
+}
+
+static void
+load_block (argon2_block *dst, const uint8_t *src)
+{
+  for (unsigned int i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++)
+    dst->v[i] = le64_to_cpu (src + 8 * i);
+}
+
+static void
+store_block (uint8_t *dst, const argon2_block *src)
+{
+  for (unsigned int i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++)
+    cpu_to_le64 (dst + 8 * i, src->v[i]);
+}
+
+static void
+blake2b_update_le32 (struct blake2b_ctx *ctx, uint32_t n)
+{
+  uint8_t buf[4];
+  cpu_to_le32 (buf, n);
+  blake2b_update (ctx, buf, sizeof buf);
+}
+
+int
+argon2id_hash (uint32_t t_cost, uint32_t m_cost, uint32_t lanes,
+               const uint8_t *pwd, size_t pwdlen,
+               const uint8_t *salt, size_t saltlen,
+               const uint8_t *secret, size_t secretlen,
+               const uint8_t *ad, size_t adlen,
+               uint8_t *out, size_t outlen,
+               argon2_local_t *local)
+{
+  struct argon2_instance in;
+  struct blake2b_ctx ctx;
+  uint8_t h0[ARGON2_PREHASH_DIGEST + 8];
+  uint8_t buf[ARGON2_BLOCK_SIZE];
+  argon2_block last;
+  uint32_t l;
+
+  if (t_cost < 1 || lanes < 1 || lanes > ARGON2_MAX_LANES
+      || m_cost / 8 < lanes || saltlen < ARGON2_MIN_SALT
+      || outlen < ARGON2_MIN_OUTLEN || outlen > UINT32_MAX
+      || pwdlen > UINT32_MAX || saltlen > UINT32_MAX
+      || secretlen > UINT32_MAX || adlen > UINT32_MAX)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  /* The number of blocks is rounded down to a multiple of four per
+     lane, so that every segment has the same length.  */
+  in.memory_blocks = m_cost - m_cost % (ARGON2_SYNC_POINTS * lanes);
+  in.segment_length = in.memory_blocks / (ARGON2_SYNC_POINTS * lanes);
+  in.lane_length = in.segment_length * ARGON2_SYNC_POINTS;
+  in.lanes = lanes;
+  in.passes = t_cost;
+
+  if ((uint64_t) in.memory_blocks * ARGON2_BLOCK_SIZE > SIZE_MAX)
+    {
+      errno = ENOMEM;
+      return -1;
+    }
+  size_t size = (size_t) in.memory_blocks * ARGON2_BLOCK_SIZE;
+  if (local->aligned_size < size)
+    {
+      free_region (local);
+      if (!alloc_region (local, size))
+        return -1;
+    }
+  in.memory = local->aligned;
+
+  /* H0, from all the inputs and parameters.  */
+  blake2b_init (&ctx, ARGON2_PREHASH_DIGEST);
+  blake2b_update_le32 (&ctx, lanes);
+  blake2b_update_le32 (&ctx, (uint32_t) outlen);
+  blake2b_update_le32 (&ctx, m_cost);
+  blake2b_update_le32 (&ctx, t_cost);
+  blake2b_update_le32 (&ctx, ARGON2_VERSION);
+  blake2b_update_le32 (&ctx, ARGON2_TYPE_ID);
+  blake2b_update_le32 (&ctx, (uint32_t) pwdlen);
+  blake2b_update (&ctx, pwd, pwdlen);
+  blake2b_update_le32 (&ctx, (uint32_t) saltlen);
+  blake2b_update (&ctx, salt, saltlen);
+  blake2b_update_le32 (&ctx, (uint32_t) secretlen);
+  blake2b_update (&ctx, secret, secretlen);
+  blake2b_update_le32 (&ctx, (uint32_t) adlen);
+  blake2b_update (&ctx, ad, adlen);
+  blake2b_final (&ctx, h0);
+
+  /* The first two blocks of each lane are H'(H0 || j || lane).  */
+  for (l = 0; l < lanes; l++)
+    for (uint32_t j = 0; j < 2; j++)
+      {
+        cpu_to_le32 (h0 + ARGON2_PREHASH_DIGEST, j);
+        cpu_to_le32 (h0 + ARGON2_PREHASH_DIGEST + 4, l);
+        blake2b_long (buf, ARGON2_BLOCK_SIZE, h0, sizeof h0);
+        load_block (&in.memory[(size_t) l * in.lane_length + j], buf);
+      }
+
+  uint32_t nthreads = lane_threads ();
+  for (in.pass = 0; in.pass < t_cost; in.pass++)
+    for (in.slice = 0; in.slice < ARGON2_SYNC_POINTS; in.slice++)
+      run_lanes (fill_segment, &in, lanes, nthreads);
+
+  /* The tag is H' of the last blocks of all the lanes, XORed.  */
+  last = in.memory[in.lane_length - 1];
+  for (l = 1; l < lanes; l++)
+    {
+      const argon2_block *b =
+        &in.memory[(size_t) l * in.lane_length + in.lane_length - 1];
+      for (unsigned int i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++)
+        last.v[i] ^= b->v[i];
+    }
+  store_block (buf, &last);
+  blake2b_long (out, outlen, buf, sizeof buf);
+
+  explicit_bzero (h0, sizeof h0);
+  explicit_bzero (buf, sizeof buf);
+  explicit_bzero (&last, sizeof last);
+  return 0;
+}
+
+#endif /* INCLUDE_argon2id */
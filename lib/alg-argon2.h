@@ -0,0 +1,40 @@
+/* Argon2id (RFC 9106).
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.  */
+
+#ifndef _CRYPT_ALG_ARGON2_H
+#define _CRYPT_ALG_ARGON2_H 1
+
+#define ARGON2_VERSION      0x13
+#define ARGON2_BLOCK_SIZE   1024
+#define ARGON2_MIN_SALT     8
+#define ARGON2_MIN_OUTLEN   4
+#define ARGON2_MAX_LANES    0xffffff
+
+/* Memory for the blocks of an Argon2 computation.  It is far larger
+   than the scratch area in struct crypt_data, so it is allocated
+   separately, with init_region_cached and free_region_cached, and may
+   be kept by the thread for its next hash, like yescrypt_local_t.  */
+typedef struct memory_region argon2_local_t;
+
+/* Compute the Argon2id tag of OUTLEN bytes for the password PWD and
+   the salt SALT, with the optional secret SECRET and associated data
+   AD, using T_COST passes over M_COST KiB of memory divided into
+   LANES lanes.  Memory is taken from LOCAL, which is enlarged if
+   necessary.  Lanes are filled on up to lane_threads () threads.
+   Returns 0 on success, or -1 with errno set to EINVAL if the
+   parameters are out of range, or to ENOMEM.  */
+extern int argon2id_hash (uint32_t t_cost, uint32_t m_cost, uint32_t lanes,
+                          const uint8_t *pwd, size_t pwdlen,
+                          const uint8_t *salt, size_t saltlen,
+                          const uint8_t *secret, size_t secretlen,
+                          const uint8_t *ad, size_t adlen,
+                          uint8_t *out, size_t outlen,
+                          argon2_local_t *local);
+
+#endif /* alg-argon2.h */
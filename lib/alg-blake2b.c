@@ -0,0 +1,204 @@
+/* BLAKE2b (RFC 7693), unkeyed, as used by Argon2.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   Argon2 uses BLAKE2b only to derive its first blocks from the
+   passphrase and to compress its last block into the tag, so this is
+   a straightforward portable implementation; the time goes into the
+   BLAKE2b round function as Argon2's compression function uses it,
+   which is in alg-argon2.c.  */
+
+#include "crypt-port.h"
+
+#if INCLUDE_argon2id
+
+#include "alg-blake2b.h"
+#include "byteorder.h"
+
+static const uint64_t blake2b_iv[8] =
+{
+  0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+  0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+  0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+  0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t blake2b_sigma[12][16] =
+{
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+  { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+  { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+  {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+  {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+  {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+  { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+  { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+  {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+  { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+  { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+};
+
+static inline uint64_t
+rotr64 (uint64_t x, unsigned int n)
+{
+  return (x >> n) | (x << (64 - n));
+}
+
+#define B2B_G(a, b, c, d, x, y) do {            \
+    v[a] = v[a] + v[b] + (x);                   \
+    v[d] = rotr64 (v[d] ^ v[a], 32);            \
+    v[c] = v[c] + v[d];                         \
+    v[b] = rotr64 (v[b] ^ v[c], 24);            \
+    v[a] = v[a] + v[b] + (y);                   \
+    v[d] = rotr64 (v[d] ^ v[a], 16);            \
+    v[c] = v[c] + v[d];                         \
+    v[b] = rotr64 (v[b] ^ v[c], 63);            \
+  } while (0)
+
+static void
+blake2b_compress (struct blake2b_ctx *ctx, const uint8_t *block, bool last)
+{
+  uint64_t m[16], v[16];
+  int i;
+
+  for (i = 0; i < 16; i++)
+    m[i] = le64_to_cpu (block + 8 * i);
+  for (i = 0; i < 8; i++)
+    {
+      v[i] = ctx->h[i];
+      v[i + 8] = blake2b_iv[i];
+    }
+  v[12] ^= ctx->t[0];
+  v[13] ^= ctx->t[1];
+  if (last)
+    v[14] = ~v[14];
+
+  for (i = 0; i < 12; i++)
+    {
+      const uint8_t *s = blake2b_sigma[i];
+      B2B_G (0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+      B2B_G (1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+      B2B_G (2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+      B2B_G (3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+      B2B_G (0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+      B2B_G (1, 6, 11, 12, m[s[10]], m[s[11]]);
+      B2B_G (2, 7,  8, 13, m[s[12]], m[s[13]]);
+      B2B_G (3, 4,  9, 14, m[s[14]], m[s[15]]);
+    }
+
+  for (i = 0; i < 8; i++)
+    ctx->h[i] ^= v[i] ^ v[i + 8];
+
+  explicit_bzero (m, sizeof m);
+  explicit_bzero (v, sizeof v);
+}
+
+static void
+blake2b_increment (struct blake2b_ctx *ctx, size_t n)
+{
+  ctx->t[0] += n;
+  if (ctx->t[0] < n)
+    ctx->t[1]++;
+}
+
+void
+blake2b_init (struct blake2b_ctx *ctx, size_t outlen)
+{
+  assert (outlen >= 1 && outlen <= BLAKE2B_OUTBYTES);
+  memcpy (ctx->h, blake2b_iv, sizeof ctx->h);
+  /* Parameter block: digest length, no key, fanout 1, depth 1.  */
+  ctx->h[0] ^= 0x01010000ULL ^ outlen;
+  ctx->t[0] = ctx->t[1] = 0;
+  ctx->buflen = 0;
+  ctx->outlen = outlen;
+}
+
+void
+blake2b_update (struct blake2b_ctx *ctx, const void *in, size_t inlen)
+{
+  const uint8_t *p = in;
+
+  /* The last block has to be compressed by blake2b_final, so a full
+     buffer is only compressed once more input arrives.  */
+  while (inlen > 0)
+    {
+      if (ctx->buflen == BLAKE2B_BLOCKBYTES)
+        {
+          blake2b_increment (ctx, BLAKE2B_BLOCKBYTES);
+          blake2b_compress (ctx, ctx->buf, false);
+          ctx->buflen = 0;
+        }
+      size_t n = MIN (inlen, BLAKE2B_BLOCKBYTES - ctx->buflen);
+      memcpy (ctx->buf + ctx->buflen, p, n);
+      ctx->buflen += n;
+      p += n;
+      inlen -= n;
+    }
+}
+
+void
+blake2b_final (struct blake2b_ctx *ctx, void *out)
+{
+  uint8_t digest[BLAKE2B_OUTBYTES];
+
+  blake2b_increment (ctx, ctx->buflen);
+  memset (ctx->buf + ctx->buflen, 0, BLAKE2B_BLOCKBYTES - ctx->buflen);
+  blake2b_compress (ctx, ctx->buf, true);
+
+  for (int i = 0; i < 8; i++)
+    cpu_to_le64 (digest + 8 * i, ctx->h[i]);
+  memcpy (out, digest, ctx->outlen);
+
+  explicit_bzero (digest, sizeof digest);
+  explicit_bzero (ctx, sizeof *ctx);
+}
+
+void
+blake2b_long (void *out, size_t outlen, const void *in, size_t inlen)
+{
+  struct blake2b_ctx ctx;
+  uint8_t lenbuf[4];
+  uint8_t v[BLAKE2B_OUTBYTES];
+  uint8_t *p = out;
+
+  cpu_to_le32 (lenbuf, (uint32_t) outlen);
+  blake2b_init (&ctx, MIN (outlen, BLAKE2B_OUTBYTES));
+  blake2b_update (&ctx, lenbuf, sizeof lenbuf);
+  blake2b_update (&ctx, in, inlen);
+
+  if (outlen <= BLAKE2B_OUTBYTES)
+    {
+      blake2b_final (&ctx, out);
+      return;
+    }
+
+  /* Longer outputs are the first halves of a chain of 64-byte digests,
+     followed by one last digest of whatever length remains.  */
+  blake2b_final (&ctx, v);
+  memcpy (p, v, BLAKE2B_OUTBYTES / 2);
+  p += BLAKE2B_OUTBYTES / 2;
+  outlen -= BLAKE2B_OUTBYTES / 2;
+
+  while (outlen > BLAKE2B_OUTBYTES)
+    {
+      blake2b_init (&ctx, BLAKE2B_OUTBYTES);
+      blake2b_update (&ctx, v, sizeof v);
+      blake2b_final (&ctx, v);
+      memcpy (p, v, BLAKE2B_OUTBYTES / 2);
+      p += BLAKE2B_OUTBYTES / 2;
+      outlen -= BLAKE2B_OUTBYTES / 2;
+    }
+
+  blake2b_init (&ctx, outlen);
+  blake2b_update (&ctx, v, sizeof v);
+  blake2b_final (&ctx, p);
+  explicit_bzero (v, sizeof v);
+}
+
+#endif /* INCLUDE_argon2id */
@@ -0,0 +1,38 @@
+/* BLAKE2b (RFC 7693), unkeyed, as used by Argon2.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.  */
+
+#ifndef _CRYPT_ALG_BLAKE2B_H
+#define _CRYPT_ALG_BLAKE2B_H 1
+
+#define BLAKE2B_BLOCKBYTES 128
+#define BLAKE2B_OUTBYTES   64
+
+struct blake2b_ctx
+{
+  uint64_t h[8];
+  uint64_t t[2];
+  uint8_t buf[BLAKE2B_BLOCKBYTES];
+  size_t buflen;
+  size_t outlen;
+};
+
+/* Start computing a digest of OUTLEN bytes, from 1 to BLAKE2B_OUTBYTES.  */
+extern void blake2b_init (struct blake2b_ctx *ctx, size_t outlen);
+extern void blake2b_update (struct blake2b_ctx *ctx,
+                            const void *in, size_t inlen);
+/* Write the digest to OUT, and erase CTX.  */
+extern void blake2b_final (struct blake2b_ctx *ctx, void *out);
+
+/* Argon2's variable-length hash function H' (RFC 9106, section 3.3):
+   write OUTLEN bytes, any number from 1 up, derived from the INLEN
+   bytes at IN to OUT.  */
+extern void blake2b_long (void *out, size_t outlen,
+                          const void *in, size_t inlen);
+
+#endif /* alg-blake2b.h */
@@ -0,0 +1,201 @@
+/* Bitsliced DES, for hashing many passphrases at once.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   Instead of processing one block at a time with table lookups, as
+   des_crypt_block does, this engine stores bit N of every block in
+   word N of an array, one block (and one key) per bit position within
+   the words.  Each DES round is then a fixed sequence of word-wide
+   logical operations: the E expansion and the P permutation become
+   array indexing, and the S-boxes become the circuits in
+   alg-des-sboxes.h.  Every key can still have its own salt; the salt
+   is applied as a masked exchange of the two halves of the expanded
+   block, exactly as des_crypt_block applies it.
+
+   Key schedules and salts are computed for each key individually with
+   the table-driven des_set_key and des_set_salt, and then transposed
+   into the bitsliced form; only the repeated encryption of the block,
+   which is where the time goes, is done in parallel.  */
+
+#include "crypt-port.h"
+
+#if INCLUDE_descrypt || INCLUDE_bigcrypt || INCLUDE_bsdicrypt
+
+#include "alg-des.h"
+#include "alg-des-sboxes.h"
+#include "byteorder.h"
+
+/* The E expansion: bit J of the expanded block is bit des_bs_e[J] of
+   the right half, counting from zero at the most significant bit.  */
+static const uint8_t des_bs_e[48] =
+{
+  31,  0,  1,  2,  3,  4,  3,  4,  5,  6,  7,  8,
+   7,  8,  9, 10, 11, 12, 11, 12, 13, 14, 15, 16,
+  15, 16, 17, 18, 19, 20, 19, 20, 21, 22, 23, 24,
+  23, 24, 25, 26, 27, 28, 27, 28, 29, 30, 31,  0
+};
+
+/* Transpose the 64x64 bit matrix A in place, so that bit 63-J of A[I]
+   becomes bit 63-I of A[J].  (Hacker's Delight, section 7-3.)  */
+static void
+des_bs_transpose (des_bs_word a[64])
+{
+  des_bs_word m, t;
+  int j, k;
+
+  for (j = 32, m = 0x00000000FFFFFFFF; j; j >>= 1, m ^= m << j)
+    for (k = 0; k < 64; k = ((k | j) + 1) & ~j)
+      {
+        t = (a[k] ^ (a[k | j] >> j)) & m;
+        a[k] ^= t;
+        a[k | j] ^= t << j;
+      }
+}
+
+void
+des_bs_set_lane (struct des_bs_ctx *restrict bs, unsigned int lane,
+                 const struct des_ctx *restrict ctx, uint32_t count)
+{
+  /* The round keys and the salt are stored a lane at a time, with
+     bit J of the expanded block at bit 63-J, and transposed by
+     des_bs_crypt_zero.  des_crypt_block's 'left' and 'right' words
+     hold bits 0-23 and 24-47 of the expanded block, most significant
+     bit first.  */
+  for (int round = 0; round < 16; round++)
+    bs->keys[round][lane] = (des_bs_word)ctx->keysl[round] << 40
+                            | (des_bs_word)ctx->keysr[round] << 16;
+  bs->salt[lane] = (des_bs_word)ctx->saltbits << 40;
+
+  /* As in des_crypt_block, zero encryptions means one.  */
+  bs->count[lane] = count ? count : 1;
+}
+
+/* One DES round: L ^= f(R, K), with the salt swaps given by SALT.  */
+static inline void
+des_bs_round (des_bs_word *restrict l, const des_bs_word *restrict r,
+              const des_bs_word *restrict k,
+              const des_bs_word *restrict salt)
+{
+  des_bs_word x[48];
+  int j;
+
+  for (j = 0; j < 48; j++)
+    x[j] = r[des_bs_e[j]];
+  for (j = 0; j < 24; j++)
+    {
+      des_bs_word d = (x[j] ^ x[j + 24]) & salt[j];
+      x[j] ^= d;
+      x[j + 24] ^= d;
+    }
+  for (j = 0; j < 48; j++)
+    x[j] ^= k[j];
+
+  des_bs_s1 (x[ 0], x[ 1], x[ 2], x[ 3], x[ 4], x[ 5], l);
+  des_bs_s2 (x[ 6], x[ 7], x[ 8], x[ 9], x[10], x[11], l);
+  des_bs_s3 (x[12], x[13], x[14], x[15], x[16], x[17], l);
+  des_bs_s4 (x[18], x[19], x[20], x[21], x[22], x[23], l);
+  des_bs_s5 (x[24], x[25], x[26], x[27], x[28], x[29], l);
+  des_bs_s6 (x[30], x[31], x[32], x[33], x[34], x[35], l);
+  des_bs_s7 (x[36], x[37], x[38], x[39], x[40], x[41], l);
+  des_bs_s8 (x[42], x[43], x[44], x[45], x[46], x[47], l);
+}
+
+void
+des_bs_crypt_zero (struct des_bs_ctx *restrict bs, unsigned int nlanes,
+                   unsigned char out[][8])
+{
+  des_bs_word *l = bs->block[0], *r = bs->block[1], *t;
+  uint32_t count, next;
+  unsigned int lane;
+  int i, round;
+
+  /* After this, bit 63-N of word J is bit J of lane N's value.  */
+  for (round = 0; round < 16; round++)
+    des_bs_transpose (bs->keys[round]);
+  des_bs_transpose (bs->salt);
+
+  /* The initial permutation of an all-zero block is all zeroes.  */
+  memset (bs->block, 0, sizeof bs->block);
+  memset (bs->done, 0, sizeof bs->done);
+
+  next = UINT32_MAX;
+  for (lane = 0; lane < nlanes; lane++)
+    next = MIN (next, bs->count[lane]);
+
+  for (count = 1; count <= next; count++)
+    {
+      for (round = 0; round < 16; round += 2)
+        {
+          des_bs_round (l, r, bs->keys[round], bs->salt);
+          des_bs_round (r, l, bs->keys[round + 1], bs->salt);
+        }
+      /* L now holds L16 and R holds R16.  des_crypt_block leaves
+         them the other way around, which is also how the next
+         encryption starts, so the roles of the arrays change here.  */
+      t = l;
+      l = r;
+      r = t;
+
+      if (count < next)
+        continue;
+
+      /* Save the blocks that have been encrypted the right number of
+         times, and find out when the next ones will be.  */
+      des_bs_word mask = 0;
+      uint32_t after = UINT32_MAX;
+      for (lane = 0; lane < nlanes; lane++)
+        if (bs->count[lane] == count)
+          mask |= (des_bs_word)1 << (63 - lane);
+        else if (bs->count[lane] > count)
+          after = MIN (after, bs->count[lane]);
+      for (i = 0; i < 32; i++)
+        {
+          bs->done[i] |= l[i] & mask;
+          bs->done[i + 32] |= r[i] & mask;
+        }
+      if (after == UINT32_MAX)
+        break;
+      next = after;
+    }
+
+  /* After this, the high and low halves of done[N] are the left and
+     right halves of lane N's block.  */
+  des_bs_transpose (bs->done);
+
+  for (lane = 0; lane < nlanes; lane++)
+    {
+      uint32_t l_out, r_out;
+      uint32_t lv = (uint32_t)(bs->done[lane] >> 32);
+      uint32_t rv = (uint32_t)bs->done[lane];
+
+      /* Do final permutation (inverse of IP).  */
+      l_out =
+        fp_maskl[0][(lv >> 24) & 0xff]
+        | fp_maskl[1][(lv >> 16) & 0xff]
+        | fp_maskl[2][(lv >>  8) & 0xff]
+        | fp_maskl[3][(lv >>  0) & 0xff]
+        | fp_maskl[4][(rv >> 24) & 0xff]
+        | fp_maskl[5][(rv >> 16) & 0xff]
+        | fp_maskl[6][(rv >>  8) & 0xff]
+        | fp_maskl[7][(rv >>  0) & 0xff];
+      r_out =
+        fp_maskr[0][(lv >> 24) & 0xff]
+        | fp_maskr[1][(lv >> 16) & 0xff]
+        | fp_maskr[2][(lv >>  8) & 0xff]
+        | fp_maskr[3][(lv >>  0) & 0xff]
+        | fp_maskr[4][(rv >> 24) & 0xff]
+        | fp_maskr[5][(rv >> 16) & 0xff]
+        | fp_maskr[6][(rv >>  8) & 0xff]
+        | fp_maskr[7][(rv >>  0) & 0xff];
+
+      cpu_to_be32 (out[lane], l_out);
+      cpu_to_be32 (out[lane] + 4, r_out);
+    }
+}
+
+#endif
@@ -0,0 +1,760 @@
+/* Generated by build-aux/scripts/gen-des-sboxes.  DO NOT EDIT.
+   To regenerate, run from the top of the source tree:
+       perl build-aux/scripts/gen-des-sboxes > lib/alg-des-sboxes.h  */
+
+/* The DES S-boxes as boolean circuits, for the bitsliced engine in
+   alg-des-bitslice.c.  Each function takes the six input bits of one
+   S-box, numbered as in FIPS 46-3, and XORs its four output bits,
+   already moved to their places by the P permutation, into OUT.  */
+
+#ifndef _CRYPT_ALG_DES_SBOXES_H
+#define _CRYPT_ALG_DES_SBOXES_H 1
+
+/* S1, 88 gates.  */
+static inline void
+des_bs_s1 (des_bs_word a1, des_bs_word a2, des_bs_word a3,
+           des_bs_word a4, des_bs_word a5, des_bs_word a6,
+           des_bs_word *restrict out)
+{
+  des_bs_word x1 = a3 & ~a5;
+  des_bs_word x2 = x1 ^ a4;
+  des_bs_word x3 = x1 & ~a4;
+  des_bs_word x4 = a5 ^ x3;
+  des_bs_word x5 = x4 & a6;
+  des_bs_word x6 = x2 ^ x5;
+  des_bs_word x7 = a5 ^ a6;
+  des_bs_word x8 = a4 & ~x7;
+  des_bs_word x9 = ~x8;
+  des_bs_word x10 = a6 & ~a3;
+  des_bs_word x11 = x9 ^ x10;
+  des_bs_word x12 = x11 & ~a2;
+  des_bs_word x13 = x6 ^ x12;
+  des_bs_word x14 = ~a5;
+  des_bs_word x15 = x14 | a3;
+  des_bs_word x16 = x15 & a2;
+  des_bs_word x17 = x16 | a6;
+  des_bs_word x18 = x7 & ~x10;
+  des_bs_word x19 = a3 & ~a6;
+  des_bs_word x20 = a6 & a5;
+  des_bs_word x21 = x19 ^ x20;
+  des_bs_word x22 = x21 & ~a2;
+  des_bs_word x23 = x18 ^ x22;
+  des_bs_word x24 = x23 & ~a4;
+  des_bs_word x25 = x17 ^ x24;
+  des_bs_word x26 = x25 & a1;
+  des_bs_word x27 = x13 ^ x26;
+  des_bs_word x28 = a1 | a4;
+  des_bs_word x29 = x28 & ~a5;
+  des_bs_word x30 = a5 & a1;
+  des_bs_word x31 = a4 ^ x30;
+  des_bs_word x32 = x31 & ~a6;
+  des_bs_word x33 = x29 ^ x32;
+  des_bs_word x34 = a6 & ~a4;
+  des_bs_word x35 = x34 | a5;
+  des_bs_word x36 = a1 & ~x35;
+  des_bs_word x37 = ~x36;
+  des_bs_word x38 = x37 & ~a3;
+  des_bs_word x39 = x33 ^ x38;
+  des_bs_word x40 = a4 | a6;
+  des_bs_word x41 = x40 | a3;
+  des_bs_word x42 = x41 | a1;
+  des_bs_word x43 = ~a3;
+  des_bs_word x44 = a6 & a4;
+  des_bs_word x45 = x43 ^ x44;
+  des_bs_word x46 = x19 ^ x40;
+  des_bs_word x47 = x46 & a1;
+  des_bs_word x48 = x45 ^ x47;
+  des_bs_word x49 = x48 & a5;
+  des_bs_word x50 = x42 ^ x49;
+  des_bs_word x51 = x50 & ~a2;
+  des_bs_word x52 = x39 ^ x51;
+  des_bs_word x53 = x35 & ~x6;
+  des_bs_word x54 = a1 & a4;
+  des_bs_word x55 = x54 & ~a5;
+  des_bs_word x56 = x28 ^ x55;
+  des_bs_word x57 = x56 & ~a2;
+  des_bs_word x58 = x53 ^ x57;
+  des_bs_word x59 = a2 ^ a5;
+  des_bs_word x60 = x59 | a4;
+  des_bs_word x61 = x60 & ~a1;
+  des_bs_word x62 = x14 ^ x61;
+  des_bs_word x63 = a1 & x31;
+  des_bs_word x64 = x63 & ~a2;
+  des_bs_word x65 = x31 ^ x64;
+  des_bs_word x66 = x65 & a6;
+  des_bs_word x67 = x62 ^ x66;
+  des_bs_word x68 = x67 & ~a3;
+  des_bs_word x69 = x58 ^ x68;
+  des_bs_word x70 = a5 & a3;
+  des_bs_word x71 = x20 ^ x70;
+  des_bs_word x72 = x71 ^ a4;
+  des_bs_word x73 = ~a4;
+  des_bs_word x74 = a6 & a3;
+  des_bs_word x75 = x73 ^ x74;
+  des_bs_word x76 = x75 & ~a5;
+  des_bs_word x77 = x40 ^ x76;
+  des_bs_word x78 = x77 & a2;
+  des_bs_word x79 = x72 ^ x78;
+  des_bs_word x80 = x40 | x70;
+  des_bs_word x81 = a5 ^ x18;
+  des_bs_word x82 = a5 ^ x19;
+  des_bs_word x83 = x82 & ~a4;
+  des_bs_word x84 = x81 ^ x83;
+  des_bs_word x85 = x84 & ~a2;
+  des_bs_word x86 = x80 ^ x85;
+  des_bs_word x87 = x86 & a1;
+  des_bs_word x88 = x79 ^ x87;
+  out[8] ^= x69;
+  out[16] ^= x27;
+  out[22] ^= x52;
+  out[30] ^= x88;
+}
+
+/* S2, 74 gates.  */
+static inline void
+des_bs_s2 (des_bs_word a1, des_bs_word a2, des_bs_word a3,
+           des_bs_word a4, des_bs_word a5, des_bs_word a6,
+           des_bs_word *restrict out)
+{
+  des_bs_word x1 = ~a5;
+  des_bs_word x2 = x1 ^ a4;
+  des_bs_word x3 = a5 & a6;
+  des_bs_word x4 = x3 & a4;
+  des_bs_word x5 = a6 ^ x4;
+  des_bs_word x6 = x5 & ~a3;
+  des_bs_word x7 = x2 ^ x6;
+  des_bs_word x8 = x7 ^ a1;
+  des_bs_word x9 = ~a3;
+  des_bs_word x10 = a3 ^ a4;
+  des_bs_word x11 = x10 & a5;
+  des_bs_word x12 = x11 & a1;
+  des_bs_word x13 = a4 ^ x12;
+  des_bs_word x14 = x13 & ~a6;
+  des_bs_word x15 = x9 ^ x14;
+  des_bs_word x16 = x15 & a2;
+  des_bs_word x17 = x8 ^ x16;
+  des_bs_word x18 = a6 ^ x9;
+  des_bs_word x19 = x18 ^ a1;
+  des_bs_word x20 = a3 | a6;
+  des_bs_word x21 = x20 & ~a1;
+  des_bs_word x22 = a4 ^ x21;
+  des_bs_word x23 = x22 & a2;
+  des_bs_word x24 = x19 ^ x23;
+  des_bs_word x25 = ~a4;
+  des_bs_word x26 = x25 | a2;
+  des_bs_word x27 = a3 & a6;
+  des_bs_word x28 = a4 | a6;
+  des_bs_word x29 = x28 & ~a2;
+  des_bs_word x30 = x27 ^ x29;
+  des_bs_word x31 = x30 & a1;
+  des_bs_word x32 = x26 ^ x31;
+  des_bs_word x33 = x32 & a5;
+  des_bs_word x34 = x24 ^ x33;
+  des_bs_word x35 = x25 & ~a1;
+  des_bs_word x36 = x35 | a6;
+  des_bs_word x37 = x36 ^ a2;
+  des_bs_word x38 = a1 ^ a4;
+  des_bs_word x39 = a2 & ~a4;
+  des_bs_word x40 = x39 | a1;
+  des_bs_word x41 = x40 & a6;
+  des_bs_word x42 = x38 ^ x41;
+  des_bs_word x43 = x42 & ~a5;
+  des_bs_word x44 = x37 ^ x43;
+  des_bs_word x45 = a4 & ~a6;
+  des_bs_word x46 = x25 & a5;
+  des_bs_word x47 = x45 ^ x46;
+  des_bs_word x48 = x47 | a1;
+  des_bs_word x49 = a1 & a5;
+  des_bs_word x50 = x49 | a6;
+  des_bs_word x51 = a1 & ~a4;
+  des_bs_word x52 = x50 ^ x51;
+  des_bs_word x53 = x52 & a2;
+  des_bs_word x54 = x48 ^ x53;
+  des_bs_word x55 = x54 & ~a3;
+  des_bs_word x56 = x44 ^ x55;
+  des_bs_word x57 = a5 | x9;
+  des_bs_word x58 = x57 & ~a1;
+  des_bs_word x59 = a4 ^ x58;
+  des_bs_word x60 = a1 & ~a5;
+  des_bs_word x61 = x60 | a3;
+  des_bs_word x62 = a5 & ~a1;
+  des_bs_word x63 = x62 & a4;
+  des_bs_word x64 = x61 ^ x63;
+  des_bs_word x65 = x64 & a6;
+  des_bs_word x66 = x59 ^ x65;
+  des_bs_word x67 = a6 | x11;
+  des_bs_word x68 = x2 ^ x57;
+  des_bs_word x69 = x68 & a6;
+  des_bs_word x70 = x1 ^ x69;
+  des_bs_word x71 = x70 & a1;
+  des_bs_word x72 = x67 ^ x71;
+  des_bs_word x73 = x72 & a2;
+  des_bs_word x74 = x66 ^ x73;
+  out[12] ^= x34;
+  out[27] ^= x17;
+  out[1] ^= x56;
+  out[17] ^= x74;
+}
+
+/* S3, 74 gates.  */
+static inline void
+des_bs_s3 (des_bs_word a1, des_bs_word a2, des_bs_word a3,
+           des_bs_word a4, des_bs_word a5, des_bs_word a6,
+           des_bs_word *restrict out)
+{
+  des_bs_word x1 = a3 ^ a6;
+  des_bs_word x2 = a4 | a6;
+  des_bs_word x3 = x2 & a1;
+  des_bs_word x4 = x1 ^ x3;
+  des_bs_word x5 = a3 ^ a4;
+  des_bs_word x6 = x5 | a1;
+  des_bs_word x7 = x6 & ~a5;
+  des_bs_word x8 = x4 ^ x7;
+  des_bs_word x9 = a5 | x1;
+  des_bs_word x10 = a3 & a6;
+  des_bs_word x11 = x10 & ~a4;
+  des_bs_word x12 = x9 ^ x11;
+  des_bs_word x13 = a1 & ~x12;
+  des_bs_word x14 = ~x13;
+  des_bs_word x15 = x14 & a2;
+  des_bs_word x16 = x8 ^ x15;
+  des_bs_word x17 = a5 ^ x5;
+  des_bs_word x18 = x17 ^ a1;
+  des_bs_word x19 = a3 & a5;
+  des_bs_word x20 = x19 | a4;
+  des_bs_word x21 = x20 | a1;
+  des_bs_word x22 = x21 & a6;
+  des_bs_word x23 = x18 ^ x22;
+  des_bs_word x24 = ~a4;
+  des_bs_word x25 = x24 & ~a1;
+  des_bs_word x26 = x25 | a3;
+  des_bs_word x27 = a4 & a1;
+  des_bs_word x28 = x5 ^ x27;
+  des_bs_word x29 = x28 & ~a6;
+  des_bs_word x30 = x29 & a5;
+  des_bs_word x31 = x26 ^ x30;
+  des_bs_word x32 = x31 & ~a2;
+  des_bs_word x33 = x23 ^ x32;
+  des_bs_word x34 = a5 ^ a6;
+  des_bs_word x35 = a2 | a6;
+  des_bs_word x36 = x35 & ~a3;
+  des_bs_word x37 = x34 ^ x36;
+  des_bs_word x38 = a3 | a5;
+  des_bs_word x39 = a5 | a6;
+  des_bs_word x40 = x39 & a2;
+  des_bs_word x41 = x38 ^ x40;
+  des_bs_word x42 = x41 & a4;
+  des_bs_word x43 = x37 ^ x42;
+  des_bs_word x44 = a2 & ~a4;
+  des_bs_word x45 = a2 & a4;
+  des_bs_word x46 = a3 & ~x45;
+  des_bs_word x47 = ~x46;
+  des_bs_word x48 = x47 & ~a6;
+  des_bs_word x49 = x44 ^ x48;
+  des_bs_word x50 = a2 ^ x5;
+  des_bs_word x51 = a4 | x50;
+  des_bs_word x52 = x51 & a6;
+  des_bs_word x53 = x50 ^ x52;
+  des_bs_word x54 = x53 & ~a5;
+  des_bs_word x55 = x49 ^ x54;
+  des_bs_word x56 = x55 & ~a1;
+  des_bs_word x57 = x43 ^ x56;
+  des_bs_word x58 = a2 ^ a6;
+  des_bs_word x59 = x58 ^ a1;
+  des_bs_word x60 = a2 & ~a6;
+  des_bs_word x61 = x60 & ~a1;
+  des_bs_word x62 = x61 | a3;
+  des_bs_word x63 = x62 & ~a5;
+  des_bs_word x64 = x59 ^ x63;
+  des_bs_word x65 = ~x1;
+  des_bs_word x66 = x65 & a2;
+  des_bs_word x67 = x39 ^ x66;
+  des_bs_word x68 = a5 & a6;
+  des_bs_word x69 = x68 ^ a2;
+  des_bs_word x70 = x69 & ~a3;
+  des_bs_word x71 = x70 & a1;
+  des_bs_word x72 = x67 ^ x71;
+  des_bs_word x73 = x72 & a4;
+  des_bs_word x74 = x64 ^ x73;
+  out[23] ^= x33;
+  out[15] ^= x74;
+  out[29] ^= x57;
+  out[5] ^= x16;
+}
+
+/* S4, 95 gates.  */
+static inline void
+des_bs_s4 (des_bs_word a1, des_bs_word a2, des_bs_word a3,
+           des_bs_word a4, des_bs_word a5, des_bs_word a6,
+           des_bs_word *restrict out)
+{
+  des_bs_word x1 = a2 | a3;
+  des_bs_word x2 = x1 ^ a5;
+  des_bs_word x3 = a3 & ~a5;
+  des_bs_word x4 = x3 ^ a2;
+  des_bs_word x5 = x4 & a6;
+  des_bs_word x6 = x2 ^ x5;
+  des_bs_word x7 = a6 & ~a2;
+  des_bs_word x8 = a5 & ~x7;
+  des_bs_word x9 = ~x8;
+  des_bs_word x10 = x9 | a3;
+  des_bs_word x11 = x10 & ~a1;
+  des_bs_word x12 = x6 ^ x11;
+  des_bs_word x13 = a2 | x8;
+  des_bs_word x14 = a2 & ~a5;
+  des_bs_word x15 = a6 ^ x14;
+  des_bs_word x16 = x15 & ~a1;
+  des_bs_word x17 = x13 ^ x16;
+  des_bs_word x18 = a2 & ~a6;
+  des_bs_word x19 = a6 & ~a5;
+  des_bs_word x20 = x19 ^ a2;
+  des_bs_word x21 = x20 & a1;
+  des_bs_word x22 = x18 ^ x21;
+  des_bs_word x23 = x22 & a3;
+  des_bs_word x24 = x17 ^ x23;
+  des_bs_word x25 = x24 & a4;
+  des_bs_word x26 = x12 ^ x25;
+  des_bs_word x27 = a2 & ~a4;
+  des_bs_word x28 = a5 ^ x27;
+  des_bs_word x29 = a4 | a5;
+  des_bs_word x30 = x29 & ~a2;
+  des_bs_word x31 = x30 & ~a6;
+  des_bs_word x32 = x28 ^ x31;
+  des_bs_word x33 = ~x18;
+  des_bs_word x34 = a6 & ~x20;
+  des_bs_word x35 = x34 & a4;
+  des_bs_word x36 = x33 ^ x35;
+  des_bs_word x37 = x36 & ~a3;
+  des_bs_word x38 = x32 ^ x37;
+  des_bs_word x39 = a5 | x7;
+  des_bs_word x40 = a3 & ~x39;
+  des_bs_word x41 = ~x40;
+  des_bs_word x42 = x9 & x20;
+  des_bs_word x43 = a6 ^ x20;
+  des_bs_word x44 = x43 & a3;
+  des_bs_word x45 = x42 ^ x44;
+  des_bs_word x46 = x45 & ~a4;
+  des_bs_word x47 = x41 ^ x46;
+  des_bs_word x48 = x47 & a1;
+  des_bs_word x49 = x38 ^ x48;
+  des_bs_word x50 = a3 ^ a6;
+  des_bs_word x51 = x50 & ~a2;
+  des_bs_word x52 = x18 & ~a3;
+  des_bs_word x53 = a6 ^ x52;
+  des_bs_word x54 = x53 & a4;
+  des_bs_word x55 = x51 ^ x54;
+  des_bs_word x56 = a4 | a6;
+  des_bs_word x57 = a3 & ~x56;
+  des_bs_word x58 = ~x57;
+  des_bs_word x59 = a4 & a6;
+  des_bs_word x60 = x59 & ~a2;
+  des_bs_word x61 = x58 ^ x60;
+  des_bs_word x62 = x61 & ~a5;
+  des_bs_word x63 = x55 ^ x62;
+  des_bs_word x64 = a2 ^ a6;
+  des_bs_word x65 = a4 & ~x64;
+  des_bs_word x66 = ~x65;
+  des_bs_word x67 = x66 | a3;
+  des_bs_word x68 = x18 ^ x56;
+  des_bs_word x69 = x68 & ~a3;
+  des_bs_word x70 = x65 ^ x69;
+  des_bs_word x71 = x70 & a5;
+  des_bs_word x72 = x67 ^ x71;
+  des_bs_word x73 = x72 & ~a1;
+  des_bs_word x74 = x63 ^ x73;
+  des_bs_word x75 = a4 ^ a5;
+  des_bs_word x76 = a4 & ~a5;
+  des_bs_word x77 = x76 | a3;
+  des_bs_word x78 = x77 & ~a6;
+  des_bs_word x79 = x75 ^ x78;
+  des_bs_word x80 = a4 ^ x29;
+  des_bs_word x81 = a6 & ~x80;
+  des_bs_word x82 = ~x81;
+  des_bs_word x83 = x56 & a3;
+  des_bs_word x84 = x82 ^ x83;
+  des_bs_word x85 = x84 & ~a2;
+  des_bs_word x86 = x79 ^ x85;
+  des_bs_word x87 = x15 | x29;
+  des_bs_word x88 = x14 | x19;
+  des_bs_word x89 = a5 ^ x43;
+  des_bs_word x90 = x89 & ~a4;
+  des_bs_word x91 = x88 ^ x90;
+  des_bs_word x92 = x91 & a3;
+  des_bs_word x93 = x87 ^ x92;
+  des_bs_word x94 = x93 & a1;
+  des_bs_word x95 = x86 ^ x94;
+  out[25] ^= x74;
+  out[19] ^= x26;
+  out[9] ^= x95;
+  out[0] ^= x49;
+}
+
+/* S5, 84 gates.  */
+static inline void
+des_bs_s5 (des_bs_word a1, des_bs_word a2, des_bs_word a3,
+           des_bs_word a4, des_bs_word a5, des_bs_word a6,
+           des_bs_word *restrict out)
+{
+  des_bs_word x1 = a2 ^ a6;
+  des_bs_word x2 = a2 & a6;
+  des_bs_word x3 = x2 | a4;
+  des_bs_word x4 = x3 & a5;
+  des_bs_word x5 = x1 ^ x4;
+  des_bs_word x6 = a5 & a6;
+  des_bs_word x7 = x6 & ~a2;
+  des_bs_word x8 = a5 ^ x7;
+  des_bs_word x9 = a2 & ~a5;
+  des_bs_word x10 = x9 | a6;
+  des_bs_word x11 = x10 & a4;
+  des_bs_word x12 = x8 ^ x11;
+  des_bs_word x13 = x12 & ~a1;
+  des_bs_word x14 = x5 ^ x13;
+  des_bs_word x15 = a1 | a6;
+  des_bs_word x16 = a4 ^ a6;
+  des_bs_word x17 = x16 & a1;
+  des_bs_word x18 = x17 & ~a2;
+  des_bs_word x19 = x15 ^ x18;
+  des_bs_word x20 = a4 & ~a6;
+  des_bs_word x21 = x20 ^ x2;
+  des_bs_word x22 = x21 ^ x17;
+  des_bs_word x23 = x22 & ~a5;
+  des_bs_word x24 = x19 ^ x23;
+  des_bs_word x25 = x24 & a3;
+  des_bs_word x26 = x14 ^ x25;
+  des_bs_word x27 = a1 | a3;
+  des_bs_word x28 = x27 ^ a5;
+  des_bs_word x29 = a3 | a5;
+  des_bs_word x30 = x29 & a1;
+  des_bs_word x31 = x30 & a4;
+  des_bs_word x32 = x28 ^ x31;
+  des_bs_word x33 = a1 & a3;
+  des_bs_word x34 = x33 | a4;
+  des_bs_word x35 = x34 & ~a2;
+  des_bs_word x36 = x32 ^ x35;
+  des_bs_word x37 = a3 & ~a5;
+  des_bs_word x38 = ~x37;
+  des_bs_word x39 = a5 & a1;
+  des_bs_word x40 = x38 ^ x39;
+  des_bs_word x41 = x27 & a2;
+  des_bs_word x42 = x40 ^ x41;
+  des_bs_word x43 = x42 | a4;
+  des_bs_word x44 = x43 & a6;
+  des_bs_word x45 = x36 ^ x44;
+  des_bs_word x46 = a3 ^ a5;
+  des_bs_word x47 = x29 & a2;
+  des_bs_word x48 = x46 ^ x47;
+  des_bs_word x49 = x10 & ~a4;
+  des_bs_word x50 = x48 ^ x49;
+  des_bs_word x51 = a2 | a5;
+  des_bs_word x52 = a4 | x51;
+  des_bs_word x53 = x52 & a6;
+  des_bs_word x54 = x51 ^ x53;
+  des_bs_word x55 = a6 & x51;
+  des_bs_word x56 = ~a5;
+  des_bs_word x57 = x56 ^ a2;
+  des_bs_word x58 = x57 & ~a6;
+  des_bs_word x59 = x58 & ~a4;
+  des_bs_word x60 = x55 ^ x59;
+  des_bs_word x61 = x60 & ~a3;
+  des_bs_word x62 = x54 ^ x61;
+  des_bs_word x63 = x62 & ~a1;
+  des_bs_word x64 = x50 ^ x63;
+  des_bs_word x65 = a4 & a2;
+  des_bs_word x66 = a3 ^ x65;
+  des_bs_word x67 = a2 ^ a4;
+  des_bs_word x68 = x67 | a3;
+  des_bs_word x69 = x68 & a5;
+  des_bs_word x70 = x66 ^ x69;
+  des_bs_word x71 = a2 ^ a3;
+  des_bs_word x72 = x71 & ~a4;
+  des_bs_word x73 = x72 | a5;
+  des_bs_word x74 = x73 & a6;
+  des_bs_word x75 = x70 ^ x74;
+  des_bs_word x76 = a3 | x10;
+  des_bs_word x77 = a3 ^ x56;
+  des_bs_word x78 = x77 & ~a2;
+  des_bs_word x79 = x37 & ~a6;
+  des_bs_word x80 = x78 ^ x79;
+  des_bs_word x81 = x80 & a4;
+  des_bs_word x82 = x76 ^ x81;
+  des_bs_word x83 = x82 & a1;
+  des_bs_word x84 = x75 ^ x83;
+  out[7] ^= x26;
+  out[13] ^= x45;
+  out[24] ^= x64;
+  out[2] ^= x84;
+}
+
+/* S6, 76 gates.  */
+static inline void
+des_bs_s6 (des_bs_word a1, des_bs_word a2, des_bs_word a3,
+           des_bs_word a4, des_bs_word a5, des_bs_word a6,
+           des_bs_word *restrict out)
+{
+  des_bs_word x1 = a4 ^ a6;
+  des_bs_word x2 = a3 & a2;
+  des_bs_word x3 = x1 ^ x2;
+  des_bs_word x4 = a2 ^ a6;
+  des_bs_word x5 = x4 | a3;
+  des_bs_word x6 = x5 & a1;
+  des_bs_word x7 = x3 ^ x6;
+  des_bs_word x8 = a1 | a3;
+  des_bs_word x9 = a4 & ~a1;
+  des_bs_word x10 = a3 ^ x9;
+  des_bs_word x11 = x10 & a2;
+  des_bs_word x12 = x8 ^ x11;
+  des_bs_word x13 = a2 ^ a4;
+  des_bs_word x14 = a3 ^ a4;
+  des_bs_word x15 = x14 & ~a2;
+  des_bs_word x16 = x15 & a1;
+  des_bs_word x17 = x13 ^ x16;
+  des_bs_word x18 = x17 & a6;
+  des_bs_word x19 = x12 ^ x18;
+  des_bs_word x20 = x19 & a5;
+  des_bs_word x21 = x7 ^ x20;
+  des_bs_word x22 = a1 ^ x1;
+  des_bs_word x23 = a6 & x9;
+  des_bs_word x24 = a3 & ~x23;
+  des_bs_word x25 = ~x24;
+  des_bs_word x26 = x25 & a2;
+  des_bs_word x27 = x22 ^ x26;
+  des_bs_word x28 = ~a6;
+  des_bs_word x29 = x28 & ~a4;
+  des_bs_word x30 = x29 | a3;
+  des_bs_word x31 = a3 ^ x28;
+  des_bs_word x32 = a6 & x14;
+  des_bs_word x33 = x32 & ~a2;
+  des_bs_word x34 = x31 ^ x33;
+  des_bs_word x35 = x34 & a1;
+  des_bs_word x36 = x30 ^ x35;
+  des_bs_word x37 = x36 & ~a5;
+  des_bs_word x38 = x27 ^ x37;
+  des_bs_word x39 = a5 & ~a4;
+  des_bs_word x40 = x39 ^ a3;
+  des_bs_word x41 = a3 & a5;
+  des_bs_word x42 = x41 & a1;
+  des_bs_word x43 = x40 ^ x42;
+  des_bs_word x44 = a3 | a5;
+  des_bs_word x45 = x44 & a4;
+  des_bs_word x46 = x45 | a1;
+  des_bs_word x47 = x46 & ~a6;
+  des_bs_word x48 = x43 ^ x47;
+  des_bs_word x49 = a4 & ~a6;
+  des_bs_word x50 = a6 & a1;
+  des_bs_word x51 = x49 ^ x50;
+  des_bs_word x52 = x51 | a3;
+  des_bs_word x53 = x23 & ~a5;
+  des_bs_word x54 = x52 ^ x53;
+  des_bs_word x55 = x54 & a2;
+  des_bs_word x56 = x48 ^ x55;
+  des_bs_word x57 = a1 & ~a3;
+  des_bs_word x58 = x4 ^ x57;
+  des_bs_word x59 = a2 | a6;
+  des_bs_word x60 = x59 & a1;
+  des_bs_word x61 = a3 & ~x60;
+  des_bs_word x62 = ~x61;
+  des_bs_word x63 = x62 & ~a5;
+  des_bs_word x64 = x58 ^ x63;
+  des_bs_word x65 = a3 & x50;
+  des_bs_word x66 = a2 & ~x65;
+  des_bs_word x67 = ~x66;
+  des_bs_word x68 = a3 ^ a6;
+  des_bs_word x69 = x68 & ~a1;
+  des_bs_word x70 = a1 ^ a6;
+  des_bs_word x71 = x70 & ~a2;
+  des_bs_word x72 = x69 ^ x71;
+  des_bs_word x73 = x72 & a5;
+  des_bs_word x74 = x67 ^ x73;
+  des_bs_word x75 = x74 & a4;
+  des_bs_word x76 = x64 ^ x75;
+  out[3] ^= x38;
+  out[28] ^= x76;
+  out[10] ^= x21;
+  out[18] ^= x56;
+}
+
+/* S7, 78 gates.  */
+static inline void
+des_bs_s7 (des_bs_word a1, des_bs_word a2, des_bs_word a3,
+           des_bs_word a4, des_bs_word a5, des_bs_word a6,
+           des_bs_word *restrict out)
+{
+  des_bs_word x1 = a5 ^ a6;
+  des_bs_word x2 = a4 | a6;
+  des_bs_word x3 = x2 & a2;
+  des_bs_word x4 = x1 ^ x3;
+  des_bs_word x5 = ~a6;
+  des_bs_word x6 = x5 ^ a4;
+  des_bs_word x7 = x6 ^ a2;
+  des_bs_word x8 = x3 & x6;
+  des_bs_word x9 = x8 & ~a5;
+  des_bs_word x10 = x7 ^ x9;
+  des_bs_word x11 = x10 & ~a1;
+  des_bs_word x12 = x4 ^ x11;
+  des_bs_word x13 = a1 ^ a6;
+  des_bs_word x14 = x13 & a5;
+  des_bs_word x15 = x14 & a4;
+  des_bs_word x16 = a1 ^ x15;
+  des_bs_word x17 = a1 & ~x6;
+  des_bs_word x18 = ~x17;
+  des_bs_word x19 = x18 & a2;
+  des_bs_word x20 = x16 ^ x19;
+  des_bs_word x21 = x20 & a3;
+  des_bs_word x22 = x12 ^ x21;
+  des_bs_word x23 = a3 ^ a6;
+  des_bs_word x24 = a6 & ~a3;
+  des_bs_word x25 = a4 ^ x24;
+  des_bs_word x26 = x25 & a1;
+  des_bs_word x27 = x23 ^ x26;
+  des_bs_word x28 = a3 & ~a6;
+  des_bs_word x29 = x28 | a4;
+  des_bs_word x30 = x29 | a1;
+  des_bs_word x31 = x30 & a2;
+  des_bs_word x32 = x27 ^ x31;
+  des_bs_word x33 = a4 & ~a6;
+  des_bs_word x34 = x33 & ~a3;
+  des_bs_word x35 = x5 ^ x34;
+  des_bs_word x36 = x35 & ~a1;
+  des_bs_word x37 = x2 ^ x36;
+  des_bs_word x38 = a3 ^ a4;
+  des_bs_word x39 = x38 & a1;
+  des_bs_word x40 = x39 & ~a2;
+  des_bs_word x41 = x37 ^ x40;
+  des_bs_word x42 = x41 & a5;
+  des_bs_word x43 = x32 ^ x42;
+  des_bs_word x44 = a3 ^ x1;
+  des_bs_word x45 = x44 ^ a1;
+  des_bs_word x46 = a1 & a6;
+  des_bs_word x47 = x46 | a5;
+  des_bs_word x48 = x47 | a3;
+  des_bs_word x49 = x48 & a4;
+  des_bs_word x50 = x45 ^ x49;
+  des_bs_word x51 = ~a3;
+  des_bs_word x52 = a4 & ~a5;
+  des_bs_word x53 = a5 ^ x38;
+  des_bs_word x54 = x53 & a1;
+  des_bs_word x55 = x52 ^ x54;
+  des_bs_word x56 = x55 & a6;
+  des_bs_word x57 = x51 ^ x56;
+  des_bs_word x58 = x57 & a2;
+  des_bs_word x59 = x50 ^ x58;
+  des_bs_word x60 = a2 ^ a4;
+  des_bs_word x61 = x33 & ~a2;
+  des_bs_word x62 = x5 ^ x61;
+  des_bs_word x63 = x62 & a5;
+  des_bs_word x64 = x60 ^ x63;
+  des_bs_word x65 = a5 | a6;
+  des_bs_word x66 = x52 & a2;
+  des_bs_word x67 = x65 ^ x66;
+  des_bs_word x68 = x67 & a1;
+  des_bs_word x69 = x64 ^ x68;
+  des_bs_word x70 = x5 | x16;
+  des_bs_word x71 = a1 & ~x47;
+  des_bs_word x72 = a6 & ~a1;
+  des_bs_word x73 = x72 & a4;
+  des_bs_word x74 = x71 ^ x73;
+  des_bs_word x75 = x74 & ~a2;
+  des_bs_word x76 = x70 ^ x75;
+  des_bs_word x77 = x76 & a3;
+  des_bs_word x78 = x69 ^ x77;
+  out[31] ^= x43;
+  out[11] ^= x22;
+  out[21] ^= x78;
+  out[6] ^= x59;
+}
+
+/* S8, 82 gates.  */
+static inline void
+des_bs_s8 (des_bs_word a1, des_bs_word a2, des_bs_word a3,
+           des_bs_word a4, des_bs_word a5, des_bs_word a6,
+           des_bs_word *restrict out)
+{
+  des_bs_word x1 = a3 ^ a6;
+  des_bs_word x2 = a1 & ~a6;
+  des_bs_word x3 = x2 | a3;
+  des_bs_word x4 = x3 & a5;
+  des_bs_word x5 = x1 ^ x4;
+  des_bs_word x6 = ~a5;
+  des_bs_word x7 = x6 ^ a3;
+  des_bs_word x8 = x7 | a1;
+  des_bs_word x9 = x8 & ~a2;
+  des_bs_word x10 = x5 ^ x9;
+  des_bs_word x11 = a3 & ~a2;
+  des_bs_word x12 = x11 | a6;
+  des_bs_word x13 = a1 & ~x12;
+  des_bs_word x14 = ~x13;
+  des_bs_word x15 = a2 & ~a1;
+  des_bs_word x16 = x15 & ~a5;
+  des_bs_word x17 = x14 ^ x16;
+  des_bs_word x18 = x17 & a4;
+  des_bs_word x19 = x10 ^ x18;
+  des_bs_word x20 = a6 | x6;
+  des_bs_word x21 = x20 & ~a4;
+  des_bs_word x22 = a5 ^ x21;
+  des_bs_word x23 = x22 ^ a3;
+  des_bs_word x24 = a5 | a6;
+  des_bs_word x25 = a5 & a4;
+  des_bs_word x26 = x24 ^ x25;
+  des_bs_word x27 = a4 & ~a6;
+  des_bs_word x28 = x27 & ~a3;
+  des_bs_word x29 = x26 ^ x28;
+  des_bs_word x30 = x29 & ~a2;
+  des_bs_word x31 = x23 ^ x30;
+  des_bs_word x32 = a2 & a4;
+  des_bs_word x33 = x11 ^ x32;
+  des_bs_word x34 = x33 | a5;
+  des_bs_word x35 = a5 & ~a3;
+  des_bs_word x36 = a2 & ~x35;
+  des_bs_word x37 = ~x36;
+  des_bs_word x38 = a3 ^ a5;
+  des_bs_word x39 = x38 | a2;
+  des_bs_word x40 = x39 & ~a4;
+  des_bs_word x41 = x37 ^ x40;
+  des_bs_word x42 = x41 & ~a6;
+  des_bs_word x43 = x34 ^ x42;
+  des_bs_word x44 = x43 & a1;
+  des_bs_word x45 = x31 ^ x44;
+  des_bs_word x46 = a3 & ~a5;
+  des_bs_word x47 = x46 ^ a2;
+  des_bs_word x48 = a2 & ~a6;
+  des_bs_word x49 = x48 | a3;
+  des_bs_word x50 = x49 & a5;
+  des_bs_word x51 = a6 ^ x50;
+  des_bs_word x52 = x51 & a1;
+  des_bs_word x53 = x47 ^ x52;
+  des_bs_word x54 = a5 | x2;
+  des_bs_word x55 = a6 & ~a3;
+  des_bs_word x56 = a5 & a6;
+  des_bs_word x57 = x56 & ~a1;
+  des_bs_word x58 = x55 ^ x57;
+  des_bs_word x59 = x58 & a2;
+  des_bs_word x60 = x54 ^ x59;
+  des_bs_word x61 = x60 & ~a4;
+  des_bs_word x62 = x53 ^ x61;
+  des_bs_word x63 = a2 & ~a4;
+  des_bs_word x64 = x63 ^ a3;
+  des_bs_word x65 = x64 ^ a1;
+  des_bs_word x66 = a1 & ~a4;
+  des_bs_word x67 = ~x66;
+  des_bs_word x68 = x67 & ~a3;
+  des_bs_word x69 = x68 & ~a2;
+  des_bs_word x70 = a4 ^ x69;
+  des_bs_word x71 = x70 & a6;
+  des_bs_word x72 = x65 ^ x71;
+  des_bs_word x73 = x1 ^ x3;
+  des_bs_word x74 = x73 | a2;
+  des_bs_word x75 = ~x55;
+  des_bs_word x76 = a2 ^ a6;
+  des_bs_word x77 = x76 & ~a1;
+  des_bs_word x78 = x75 ^ x77;
+  des_bs_word x79 = x78 & ~a4;
+  des_bs_word x80 = x74 ^ x79;
+  des_bs_word x81 = x80 & ~a5;
+  des_bs_word x82 = x72 ^ x81;
+  out[4] ^= x45;
+  out[26] ^= x19;
+  out[14] ^= x62;
+  out[20] ^= x82;
+}
+
+#endif /* alg-des-sboxes.h */
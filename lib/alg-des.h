@@ -63,6 +63,39 @@ extern void des_crypt_block (struct des_ctx *restrict ctx,
                              unsigned char *out, const unsigned char *in,
                              unsigned int count, bool decrypt);
 
+/* des-bitslice.c */
+
+/* The bitsliced engine encrypts one block for each bit of a
+   des_bs_word, all at once.  Word N of each array holds bit N of
+   every lane's block or key, and lane L is bit 63-L of each word.  */
+typedef uint64_t des_bs_word;
+#define DES_BS_LANES 64
+
+struct des_bs_ctx
+{
+  des_bs_word keys[16][64];
+  des_bs_word salt[64];
+  uint32_t count[DES_BS_LANES];
+  des_bs_word block[2][32];
+  des_bs_word done[64];
+};
+
+/* Copy the key schedule and salt of CTX into lane LANE of BS, and
+   arrange for that lane's block to be encrypted COUNT times.  */
+extern void des_bs_set_lane (struct des_bs_ctx *restrict bs,
+                             unsigned int lane,
+                             const struct des_ctx *restrict ctx,
+                             uint32_t count);
+
+/* For each of the first NLANES lanes of BS, encrypt a block of zeroes
+   as many times as was requested, with that lane's key and salt, and
+   write the result to OUT[lane].  This has the same effect as calling
+   des_crypt_block on each lane separately.  Every lane must be set up
+   again before the next call.  */
+extern void des_bs_crypt_zero (struct des_bs_ctx *restrict bs,
+                               unsigned int nlanes,
+                               unsigned char out[][8]);
+
 /* des-tables.c (generated by des-mktables) */
 extern const uint8_t m_sbox[4][4096];
 extern const uint32_t ip_maskl[8][256], ip_maskr[8][256];
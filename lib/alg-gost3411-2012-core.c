@@ -97,7 +97,7 @@ add512(const uint512_u *x, const uint512_u *y, uint512_u *r)
 }
 
 static void
-g(uint512_u *h, const uint512_u *N, const unsigned char *m)
+g_generic(uint512_u *h, const uint512_u *N, const unsigned char *m)
 {
 #ifdef __GOST3411_HAS_SSE2__
     __m128i xmm0, xmm2, xmm4, xmm6; /* XMMR0-quadruple */
@@ -145,6 +145,258 @@ g(uint512_u *h, const uint512_u *N, const unsigned char *m)
 #endif
 }
 
+/*
+ * Two independent compressions.  The SIMD implementations below can
+ * overlap them; this one just does one after the other.
+ */
+static void
+g2_generic(uint512_u *h1, const uint512_u *N1, const unsigned char *m1,
+           uint512_u *h2, const uint512_u *N2, const unsigned char *m2)
+{
+    g_generic(h1, N1, m1);
+    g_generic(h2, N2, m2);
+}
+
+/*
+ * SIMD versions of g().  Each output word of LPS is the XOR of eight
+ * table entries, one from each Ax[k], indexed by byte i of input word k;
+ * these compute all eight output words at once, looking up the entries
+ * for each k with gather instructions instead of 64 separate loads.
+ * The precalc tables are the little-endian ones, which is all x86 uses.
+ */
+#if defined HAVE_X86_TARGET_AVX2 && !defined __GOST3411_HAS_SSE2__
+#include <immintrin.h>
+
+#define LOAD256(p) _mm256_loadu_si256((const __m256i *) (const void *) (p))
+
+/* (*o0, *o1) = LPS(x0, x1), with each 512-bit value as two halves. */
+__attribute__((target("avx2"))) static inline void
+lps_avx2(__m256i x0, __m256i x1, __m256i *o0, __m256i *o1)
+{
+    const __m256i sh0 = _mm256_set_epi64x(24, 16, 8, 0);
+    const __m256i sh1 = _mm256_set_epi64x(56, 48, 40, 32);
+    const __m256i ff = _mm256_set1_epi64x(0xff);
+    unsigned long long r[8];
+    __m256i a0, a1, b, i0, i1;
+    int k;
+
+    _mm256_storeu_si256((__m256i *) (void *) &r[0], x0);
+    _mm256_storeu_si256((__m256i *) (void *) &r[4], x1);
+    a0 = a1 = _mm256_setzero_si256();
+    for (k = 0; k < 8; k++)
+    {
+        b = _mm256_set1_epi64x((long long) r[k]);
+        i0 = _mm256_and_si256(_mm256_srlv_epi64(b, sh0), ff);
+        i1 = _mm256_and_si256(_mm256_srlv_epi64(b, sh1), ff);
+        a0 = _mm256_xor_si256(a0, _mm256_i64gather_epi64(
+            (const long long *) (const void *) Ax[k], i0, 8));
+        a1 = _mm256_xor_si256(a1, _mm256_i64gather_epi64(
+            (const long long *) (const void *) Ax[k], i1, 8));
+    }
+    *o0 = a0;
+    *o1 = a1;
+}
+
+#define XLPS256(x0, x1, y0, y1, o0, o1) \
+    lps_avx2(_mm256_xor_si256(x0, y0), _mm256_xor_si256(x1, y1), &o0, &o1)
+
+__attribute__((target("avx2"))) static void
+g_avx2(uint512_u *h, const uint512_u *N, const unsigned char *m)
+{
+    __m256i h0, h1, m0, m1, k0, k1, d0, d1;
+    unsigned int i;
+
+    h0 = LOAD256(&h->QWORD[0]);
+    h1 = LOAD256(&h->QWORD[4]);
+    m0 = LOAD256(&m[0]);
+    m1 = LOAD256(&m[32]);
+
+    XLPS256(h0, h1, LOAD256(&N->QWORD[0]), LOAD256(&N->QWORD[4]), k0, k1);
+
+    /* Starting E() */
+    XLPS256(k0, k1, m0, m1, d0, d1);
+    for (i = 0; i < 11; i++)
+    {
+        XLPS256(k0, k1, LOAD256(&C[i].QWORD[0]), LOAD256(&C[i].QWORD[4]),
+                k0, k1);
+        XLPS256(k0, k1, d0, d1, d0, d1);
+    }
+    XLPS256(k0, k1, LOAD256(&C[11].QWORD[0]), LOAD256(&C[11].QWORD[4]),
+            k0, k1);
+    /* E() done */
+
+    d0 = _mm256_xor_si256(_mm256_xor_si256(d0, k0), _mm256_xor_si256(h0, m0));
+    d1 = _mm256_xor_si256(_mm256_xor_si256(d1, k1), _mm256_xor_si256(h1, m1));
+    _mm256_storeu_si256((__m256i *) (void *) &h->QWORD[0], d0);
+    _mm256_storeu_si256((__m256i *) (void *) &h->QWORD[4], d1);
+}
+
+__attribute__((target("avx2"))) static void
+g2_avx2(uint512_u *h1, const uint512_u *N1, const unsigned char *m1,
+        uint512_u *h2, const uint512_u *N2, const unsigned char *m2)
+{
+    g_avx2(h1, N1, m1);
+    g_avx2(h2, N2, m2);
+}
+#endif
+
+#if defined HAVE_X86_TARGET_AVX512F && !defined __GOST3411_HAS_SSE2__
+#include <immintrin.h>
+
+#define LOAD512(p) _mm512_loadu_si512((const void *) (p))
+
+/*
+ * (*ox, *oy) = (LPS(x), LPS(y)).  Doing two at once keeps more gathers
+ * in flight, which is where the time goes.
+ */
+__attribute__((target("avx512f"))) static inline void
+lps2_avx512(__m512i x, __m512i y, __m512i *ox, __m512i *oy)
+{
+    const __m512i sh = _mm512_set_epi64(56, 48, 40, 32, 24, 16, 8, 0);
+    const __m512i ff = _mm512_set1_epi64(0xff);
+    __m512i a, c, sel, ix, iy;
+    int k;
+
+    a = c = _mm512_setzero_si512();
+    for (k = 0; k < 8; k++)
+    {
+        sel = _mm512_set1_epi64(k);
+        ix = _mm512_and_si512(
+            _mm512_srlv_epi64(_mm512_permutexvar_epi64(sel, x), sh), ff);
+        iy = _mm512_and_si512(
+            _mm512_srlv_epi64(_mm512_permutexvar_epi64(sel, y), sh), ff);
+        a = _mm512_xor_si512(a, _mm512_i64gather_epi64(
+            ix, (const long long *) (const void *) Ax[k], 8));
+        c = _mm512_xor_si512(c, _mm512_i64gather_epi64(
+            iy, (const long long *) (const void *) Ax[k], 8));
+    }
+    *ox = a;
+    *oy = c;
+}
+
+/* *o = LPS(x). */
+__attribute__((target("avx512f"))) static inline __m512i
+lps_avx512(__m512i x)
+{
+    const __m512i sh = _mm512_set_epi64(56, 48, 40, 32, 24, 16, 8, 0);
+    const __m512i ff = _mm512_set1_epi64(0xff);
+    __m512i a, ix;
+    int k;
+
+    a = _mm512_setzero_si512();
+    for (k = 0; k < 8; k++)
+    {
+        ix = _mm512_and_si512(_mm512_srlv_epi64(
+            _mm512_permutexvar_epi64(_mm512_set1_epi64(k), x), sh), ff);
+        a = _mm512_xor_si512(a, _mm512_i64gather_epi64(
+            ix, (const long long *) (const void *) Ax[k], 8));
+    }
+    return a;
+}
+
+__attribute__((target("avx512f"))) static void
+g_avx512(uint512_u *h, const uint512_u *N, const unsigned char *m)
+{
+    __m512i hv, mv, k, d;
+    unsigned int i;
+
+    hv = LOAD512(h);
+    mv = LOAD512(m);
+    k = lps_avx512(_mm512_xor_si512(hv, LOAD512(N)));
+
+    /* Starting E() */
+    d = lps_avx512(_mm512_xor_si512(k, mv));
+    for (i = 0; i < 11; i++)
+    {
+        k = lps_avx512(_mm512_xor_si512(k, LOAD512(&C[i])));
+        d = lps_avx512(_mm512_xor_si512(k, d));
+    }
+    k = lps_avx512(_mm512_xor_si512(k, LOAD512(&C[11])));
+    /* E() done */
+
+    _mm512_storeu_si512((void *) h,
+        _mm512_xor_si512(_mm512_xor_si512(d, k), _mm512_xor_si512(hv, mv)));
+}
+
+__attribute__((target("avx512f"))) static void
+g2_avx512(uint512_u *h1, const uint512_u *N1, const unsigned char *m1,
+          uint512_u *h2, const uint512_u *N2, const unsigned char *m2)
+{
+    __m512i hv1, mv1, k1, d1, hv2, mv2, k2, d2, c;
+    unsigned int i;
+
+    hv1 = LOAD512(h1);
+    mv1 = LOAD512(m1);
+    hv2 = LOAD512(h2);
+    mv2 = LOAD512(m2);
+    lps2_avx512(_mm512_xor_si512(hv1, LOAD512(N1)),
+                _mm512_xor_si512(hv2, LOAD512(N2)), &k1, &k2);
+
+    /* Starting E() */
+    lps2_avx512(_mm512_xor_si512(k1, mv1), _mm512_xor_si512(k2, mv2),
+                &d1, &d2);
+    for (i = 0; i < 11; i++)
+    {
+        c = LOAD512(&C[i]);
+        lps2_avx512(_mm512_xor_si512(k1, c), _mm512_xor_si512(k2, c),
+                    &k1, &k2);
+        lps2_avx512(_mm512_xor_si512(k1, d1), _mm512_xor_si512(k2, d2),
+                    &d1, &d2);
+    }
+    c = LOAD512(&C[11]);
+    lps2_avx512(_mm512_xor_si512(k1, c), _mm512_xor_si512(k2, c), &k1, &k2);
+    /* E() done */
+
+    _mm512_storeu_si512((void *) h1,
+        _mm512_xor_si512(_mm512_xor_si512(d1, k1), _mm512_xor_si512(hv1, mv1)));
+    _mm512_storeu_si512((void *) h2,
+        _mm512_xor_si512(_mm512_xor_si512(d2, k2), _mm512_xor_si512(hv2, mv2)));
+}
+#endif
+
+/*
+ * The implementations to use.  These start out as the portable ones
+ * and are upgraded, if the CPU allows, when the library is loaded.
+ */
+static void (*g_impl)(uint512_u *, const uint512_u *,
+                      const unsigned char *) = g_generic;
+static void (*g2_impl)(uint512_u *, const uint512_u *, const unsigned char *,
+                       uint512_u *, const uint512_u *,
+                       const unsigned char *) = g2_generic;
+
+#if (defined HAVE_X86_TARGET_AVX2 || defined HAVE_X86_TARGET_AVX512F) \
+    && !defined __GOST3411_HAS_SSE2__
+CPU_DISPATCH(g_select)
+
+static void
+g_select(void)
+{
+    g_impl = g_generic;
+    g2_impl = g2_generic;
+#ifdef HAVE_X86_TARGET_AVX512F
+    if (cpu_supports(CPU_AVX512F))
+    {
+        g_impl = g_avx512;
+        g2_impl = g2_avx512;
+        return;
+    }
+#endif
+#ifdef HAVE_X86_TARGET_AVX2
+    if (cpu_supports(CPU_AVX2))
+    {
+        g_impl = g_avx2;
+        g2_impl = g2_avx2;
+    }
+#endif
+}
+#endif
+
+static inline void
+g(uint512_u *h, const uint512_u *N, const unsigned char *m)
+{
+    g_impl(h, N, m);
+}
+
 static inline void
 stage2(GOST34112012Context *CTX, const unsigned char *data)
 {
@@ -182,6 +434,27 @@ stage3(GOST34112012Context *CTX)
     memcpy(&(CTX->hash), &(CTX->h), sizeof (uint512_u));
 }
 
+void
+GOST34112012UpdateBlock2(GOST34112012Context *CTX1,
+                         const unsigned char *data1,
+                         GOST34112012Context *CTX2,
+                         const unsigned char *data2)
+{
+    uint512_u m1, m2;
+
+    assert(CTX1->bufsize == 0 && CTX2->bufsize == 0);
+
+    memcpy(&m1, data1, sizeof(m1));
+    memcpy(&m2, data2, sizeof(m2));
+    g2_impl(&(CTX1->h), &(CTX1->N), (const unsigned char *)&m1,
+            &(CTX2->h), &(CTX2->N), (const unsigned char *)&m2);
+
+    add512(&(CTX1->N), &buffer512, &(CTX1->N));
+    add512(&(CTX1->Sigma), &m1, &(CTX1->Sigma));
+    add512(&(CTX2->N), &buffer512, &(CTX2->N));
+    add512(&(CTX2->Sigma), &m2, &(CTX2->Sigma));
+}
+
 void
 GOST34112012Update(GOST34112012Context *CTX, const unsigned char *data, size_t len)
 {
@@ -43,6 +43,18 @@ extern void GOST34112012Init(GOST34112012Context *CTX,
 extern void GOST34112012Update(GOST34112012Context *CTX,
                const unsigned char *data, size_t len);
 
+/*
+ * Absorb one 64-byte block into each of two contexts, neither of which
+ * may have buffered data.  This is the same as calling
+ * GOST34112012Update(CTX1, data1, 64) and GOST34112012Update(CTX2,
+ * data2, 64), but the two compressions are computed together when the
+ * CPU allows.
+ */
+extern void GOST34112012UpdateBlock2(GOST34112012Context *CTX1,
+               const unsigned char *data1,
+               GOST34112012Context *CTX2,
+               const unsigned char *data2);
+
 extern void GOST34112012Final(GOST34112012Context *CTX,
                unsigned char *digest);
 
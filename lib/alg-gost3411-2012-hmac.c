@@ -47,29 +47,25 @@ gost_hmac256 (const uint8_t *k, size_t n, const uint8_t *t, size_t len,
   for (i = 0; i < sizeof (gostbuf->pad); i++)
     gostbuf->kstar[i] = i < n ? k[i] : 0;
 
-  GOST34112012Init (&gostbuf->ctx, GOSTR3411_2012_BITS);
-
   for (i = 0; i < sizeof (gostbuf->pad); i++)
-    gostbuf->pad[i] = gostbuf->kstar[i] ^ 0x36; /* ipad */
-
-  GOST34112012Update (&gostbuf->ctx, gostbuf->pad,
-                      sizeof (gostbuf->pad));
-  GOST34112012Update (&gostbuf->ctx, t, len);
-  GOST34112012Final (&gostbuf->ctx, gostbuf->digest);
-
-  /* Clear the context state. */
-  explicit_bzero (&gostbuf->ctx, sizeof (GOST34112012Context));
+    {
+      gostbuf->pad[i] = gostbuf->kstar[i] ^ 0x36; /* ipad */
+      gostbuf->opad[i] = gostbuf->kstar[i] ^ 0x5c; /* opad */
+    }
 
+  /* The first blocks of the inner and the outer hash depend only on
+     the key, so they can be compressed together.  */
   GOST34112012Init (&gostbuf->ctx, GOSTR3411_2012_BITS);
+  GOST34112012Init (&gostbuf->octx, GOSTR3411_2012_BITS);
+  GOST34112012UpdateBlock2 (&gostbuf->ctx, gostbuf->pad,
+                            &gostbuf->octx, gostbuf->opad);
 
-  for (i = 0; i < sizeof (gostbuf->pad); i++)
-    gostbuf->pad[i] = gostbuf->kstar[i] ^ 0x5c; /* opad */
+  GOST34112012Update (&gostbuf->ctx, t, len);
+  GOST34112012Final (&gostbuf->ctx, gostbuf->digest);
 
-  GOST34112012Update (&gostbuf->ctx, gostbuf->pad,
-                      sizeof (gostbuf->pad));
-  GOST34112012Update (&gostbuf->ctx, gostbuf->digest,
+  GOST34112012Update (&gostbuf->octx, gostbuf->digest,
                       sizeof (gostbuf->digest));
-  GOST34112012Final (&gostbuf->ctx, out32);
+  GOST34112012Final (&gostbuf->octx, out32);
 
   /* Clear the context state. */
   explicit_bzero (gostbuf, sizeof (gost_hmac_256_t));
@@ -30,7 +30,9 @@
 typedef struct
 {
   GOST34112012Context ctx;
-  unsigned char pad[GOSTR3411_2012_B];   /* ipad and opad */
+  GOST34112012Context octx;              /* outer hash */
+  unsigned char pad[GOSTR3411_2012_B];   /* ipad */
+  unsigned char opad[GOSTR3411_2012_B];
   unsigned char kstar[GOSTR3411_2012_B]; /* derived key */
   unsigned char digest[GOSTR3411_2012_L];
 } gost_hmac_256_t;
@@ -34,6 +34,7 @@
 #include "crypt-port.h"
 #include "alg-hmac-sha1.h"
 #include "alg-sha1.h"
+#include "byteorder.h"
 
 #include <stdlib.h>
 
@@ -137,4 +138,87 @@ hmac_sha1_process_data (const uint8_t *text, size_t text_len,
   explicit_bzero (k_opad, HMAC_BLOCKSZ);
 }
 
+void
+hmac_sha1_init_key (struct hmac_sha1_key *hk,
+                    const uint8_t *key, size_t key_len)
+{
+  struct sha1_ctx ctx;
+  uint8_t pad[HMAC_BLOCKSZ];
+  unsigned char tk[HASH_LENGTH];
+  size_t i;
+
+  if (key_len > HMAC_BLOCKSZ)
+    {
+      sha1_init_ctx (&ctx);
+      sha1_process_bytes (key, &ctx, key_len);
+      sha1_finish_ctx (&ctx, &tk);
+
+      key = tk;
+      key_len = HASH_LENGTH;
+    }
+
+  /* Each padded key is exactly one block, so the state after it is
+     all there is to remember.  */
+  memset (pad, HMAC_IPAD, sizeof pad);
+  for (i = 0; i < key_len; i++)
+    pad[i] ^= key[i];
+  sha1_init_ctx (&ctx);
+  memcpy (hk->istate, ctx.state, sizeof hk->istate);
+  sha1_transform (hk->istate, pad);
+
+  memset (pad, HMAC_OPAD, sizeof pad);
+  for (i = 0; i < key_len; i++)
+    pad[i] ^= key[i];
+  memcpy (hk->ostate, ctx.state, sizeof hk->ostate);
+  sha1_transform (hk->ostate, pad);
+
+  /* Clean the stack. */
+  explicit_bzero (pad, sizeof pad);
+  explicit_bzero (tk, sizeof tk);
+  explicit_bzero (&ctx, sizeof ctx);
+}
+
+void
+hmac_sha1_pad_block (uint8_t block[64])
+{
+  /* The message is 20 bytes long, after one 64-byte block.  */
+  block[HASH_LENGTH] = 0x80;
+  memset (block + HASH_LENGTH + 1, 0, 64 - 8 - (HASH_LENGTH + 1));
+  cpu_to_be32 (block + 56, 0);
+  cpu_to_be32 (block + 60, (HMAC_BLOCKSZ + HASH_LENGTH) * 8);
+}
+
+void
+hmac_sha1_iterate (const struct hmac_sha1_key *hk, uint8_t buf[20],
+                   unsigned long n)
+{
+  uint32_t state[5];
+  uint8_t block[64];
+  int j;
+
+  memcpy (block, buf, HASH_LENGTH);
+  hmac_sha1_pad_block (block);
+
+  while (n-- > 0)
+    {
+      /* Inner hash.  */
+      memcpy (state, hk->istate, sizeof state);
+      sha1_transform (state, block);
+      for (j = 0; j < 5; j++)
+        cpu_to_be32 (block + 4 * j, state[j]);
+
+      /* Outer hash.  */
+      memcpy (state, hk->ostate, sizeof state);
+      sha1_transform (state, block);
+      for (j = 0; j < 5; j++)
+        cpu_to_be32 (block + 4 * j, state[j]);
+    }
+
+  memcpy (buf, block, HASH_LENGTH);
+
+  /* Clean the stack. */
+  explicit_bzero (state, sizeof state);
+  explicit_bzero (block, sizeof block);
+}
+
 #endif
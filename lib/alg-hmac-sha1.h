@@ -33,3 +33,31 @@ extern void
 hmac_sha1_process_data (const uint8_t *text, size_t text_len,
                         const uint8_t *key, size_t key_len,
                         void *resbuf);
+
+/* The state of the inner and outer hashes of HMAC-SHA1 after they
+   have absorbed their padded keys.  Computing this once per key
+   means that each further HMAC of a short message costs only the
+   compression function calls for the message itself.  */
+struct hmac_sha1_key
+{
+  uint32_t istate[5];
+  uint32_t ostate[5];
+};
+
+/* Set up HK for computing HMACs keyed with KEY.  */
+extern void
+hmac_sha1_init_key (struct hmac_sha1_key *hk,
+                    const uint8_t *key, size_t key_len);
+
+/* Fill in the SHA-1 padding of a 64-byte BLOCK whose first 20 bytes
+   are a digest, and which follows one block already absorbed (the
+   padded key).  This is the last block of both the inner and the
+   outer hash when an HMAC is taken of another HMAC.  */
+extern void
+hmac_sha1_pad_block (uint8_t block[64]);
+
+/* Replace the 20 bytes in BUF with their HMAC under HK, N times over.
+   Each time takes exactly two calls to the compression function.  */
+extern void
+hmac_sha1_iterate (const struct hmac_sha1_key *hk, uint8_t buf[20],
+                   unsigned long n);
@@ -40,6 +40,7 @@
 #if INCLUDE_md5crypt || INCLUDE_sunmd5
 
 #include "alg-md5.h"
+#include "byteorder.h"
 
 /*
  * The basic MD5 functions.
@@ -204,6 +205,363 @@ static const void *body(MD5_CTX *ctx, const void *data, unsigned long size)
 	return ptr;
 }
 
+/*
+ * Multi-buffer MD5.  The SIMD implementations below hold word j of every
+ * lane's block, or of every lane's state, in element i of one vector
+ * register, so that the 64 steps are executed once for all lanes.
+ */
+
+/* Portable fallback: one lane at a time */
+static void MD5_Transform_MB_generic(uint32_t states[][4],
+    const uint8_t * const *blocks, size_t nlanes)
+{
+	MD5_CTX ctx;
+	size_t l;
+
+	for (l = 0; l < nlanes; l++) {
+		ctx.a = states[l][0];
+		ctx.b = states[l][1];
+		ctx.c = states[l][2];
+		ctx.d = states[l][3];
+		body(&ctx, blocks[l], 64);
+		states[l][0] = ctx.a;
+		states[l][1] = ctx.b;
+		states[l][2] = ctx.c;
+		states[l][3] = ctx.d;
+	}
+
+	explicit_bzero(&ctx, sizeof(ctx));
+}
+
+#if defined HAVE_X86_TARGET_SSE2 || defined HAVE_X86_TARGET_AVX2 || \
+    defined HAVE_X86_TARGET_AVX512F
+#include <immintrin.h>
+
+/*
+ * The same 64 steps as in body(), on vectors.  Each implementation
+ * defines V_ADD, V_ROTL (by a constant), V_SET1 (broadcast), and the
+ * four basic functions V_F, V_G, V_H and V_I before using this.
+ */
+#define MB_STEP(f, a, b, c, d, x, t, s) \
+	(a) = V_ADD(V_ADD((a), f((b), (c), (d))), \
+	    V_ADD(W[(x)], V_SET1((int)(t)))); \
+	(a) = V_ADD(V_ROTL((a), (s)), (b));
+
+#define MB_ROUNDS(V) do { \
+	V a = S[0], b = S[1], c = S[2], d = S[3]; \
+	MB_STEP(V_F, a, b, c, d, 0, 0xd76aa478, 7) \
+	MB_STEP(V_F, d, a, b, c, 1, 0xe8c7b756, 12) \
+	MB_STEP(V_F, c, d, a, b, 2, 0x242070db, 17) \
+	MB_STEP(V_F, b, c, d, a, 3, 0xc1bdceee, 22) \
+	MB_STEP(V_F, a, b, c, d, 4, 0xf57c0faf, 7) \
+	MB_STEP(V_F, d, a, b, c, 5, 0x4787c62a, 12) \
+	MB_STEP(V_F, c, d, a, b, 6, 0xa8304613, 17) \
+	MB_STEP(V_F, b, c, d, a, 7, 0xfd469501, 22) \
+	MB_STEP(V_F, a, b, c, d, 8, 0x698098d8, 7) \
+	MB_STEP(V_F, d, a, b, c, 9, 0x8b44f7af, 12) \
+	MB_STEP(V_F, c, d, a, b, 10, 0xffff5bb1, 17) \
+	MB_STEP(V_F, b, c, d, a, 11, 0x895cd7be, 22) \
+	MB_STEP(V_F, a, b, c, d, 12, 0x6b901122, 7) \
+	MB_STEP(V_F, d, a, b, c, 13, 0xfd987193, 12) \
+	MB_STEP(V_F, c, d, a, b, 14, 0xa679438e, 17) \
+	MB_STEP(V_F, b, c, d, a, 15, 0x49b40821, 22) \
+	MB_STEP(V_G, a, b, c, d, 1, 0xf61e2562, 5) \
+	MB_STEP(V_G, d, a, b, c, 6, 0xc040b340, 9) \
+	MB_STEP(V_G, c, d, a, b, 11, 0x265e5a51, 14) \
+	MB_STEP(V_G, b, c, d, a, 0, 0xe9b6c7aa, 20) \
+	MB_STEP(V_G, a, b, c, d, 5, 0xd62f105d, 5) \
+	MB_STEP(V_G, d, a, b, c, 10, 0x02441453, 9) \
+	MB_STEP(V_G, c, d, a, b, 15, 0xd8a1e681, 14) \
+	MB_STEP(V_G, b, c, d, a, 4, 0xe7d3fbc8, 20) \
+	MB_STEP(V_G, a, b, c, d, 9, 0x21e1cde6, 5) \
+	MB_STEP(V_G, d, a, b, c, 14, 0xc33707d6, 9) \
+	MB_STEP(V_G, c, d, a, b, 3, 0xf4d50d87, 14) \
+	MB_STEP(V_G, b, c, d, a, 8, 0x455a14ed, 20) \
+	MB_STEP(V_G, a, b, c, d, 13, 0xa9e3e905, 5) \
+	MB_STEP(V_G, d, a, b, c, 2, 0xfcefa3f8, 9) \
+	MB_STEP(V_G, c, d, a, b, 7, 0x676f02d9, 14) \
+	MB_STEP(V_G, b, c, d, a, 12, 0x8d2a4c8a, 20) \
+	MB_STEP(V_H, a, b, c, d, 5, 0xfffa3942, 4) \
+	MB_STEP(V_H, d, a, b, c, 8, 0x8771f681, 11) \
+	MB_STEP(V_H, c, d, a, b, 11, 0x6d9d6122, 16) \
+	MB_STEP(V_H, b, c, d, a, 14, 0xfde5380c, 23) \
+	MB_STEP(V_H, a, b, c, d, 1, 0xa4beea44, 4) \
+	MB_STEP(V_H, d, a, b, c, 4, 0x4bdecfa9, 11) \
+	MB_STEP(V_H, c, d, a, b, 7, 0xf6bb4b60, 16) \
+	MB_STEP(V_H, b, c, d, a, 10, 0xbebfbc70, 23) \
+	MB_STEP(V_H, a, b, c, d, 13, 0x289b7ec6, 4) \
+	MB_STEP(V_H, d, a, b, c, 0, 0xeaa127fa, 11) \
+	MB_STEP(V_H, c, d, a, b, 3, 0xd4ef3085, 16) \
+	MB_STEP(V_H, b, c, d, a, 6, 0x04881d05, 23) \
+	MB_STEP(V_H, a, b, c, d, 9, 0xd9d4d039, 4) \
+	MB_STEP(V_H, d, a, b, c, 12, 0xe6db99e5, 11) \
+	MB_STEP(V_H, c, d, a, b, 15, 0x1fa27cf8, 16) \
+	MB_STEP(V_H, b, c, d, a, 2, 0xc4ac5665, 23) \
+	MB_STEP(V_I, a, b, c, d, 0, 0xf4292244, 6) \
+	MB_STEP(V_I, d, a, b, c, 7, 0x432aff97, 10) \
+	MB_STEP(V_I, c, d, a, b, 14, 0xab9423a7, 15) \
+	MB_STEP(V_I, b, c, d, a, 5, 0xfc93a039, 21) \
+	MB_STEP(V_I, a, b, c, d, 12, 0x655b59c3, 6) \
+	MB_STEP(V_I, d, a, b, c, 3, 0x8f0ccc92, 10) \
+	MB_STEP(V_I, c, d, a, b, 10, 0xffeff47d, 15) \
+	MB_STEP(V_I, b, c, d, a, 1, 0x85845dd1, 21) \
+	MB_STEP(V_I, a, b, c, d, 8, 0x6fa87e4f, 6) \
+	MB_STEP(V_I, d, a, b, c, 15, 0xfe2ce6e0, 10) \
+	MB_STEP(V_I, c, d, a, b, 6, 0xa3014314, 15) \
+	MB_STEP(V_I, b, c, d, a, 13, 0x4e0811a1, 21) \
+	MB_STEP(V_I, a, b, c, d, 4, 0xf7537e82, 6) \
+	MB_STEP(V_I, d, a, b, c, 11, 0xbd3af235, 10) \
+	MB_STEP(V_I, c, d, a, b, 2, 0x2ad7d2bb, 15) \
+	MB_STEP(V_I, b, c, d, a, 9, 0xeb86d391, 21) \
+	S[0] = V_ADD(S[0], a); \
+	S[1] = V_ADD(S[1], b); \
+	S[2] = V_ADD(S[2], c); \
+	S[3] = V_ADD(S[3], d); \
+} while (0)
+
+/* Load word j of the block for lane l, or of the last lane if l is unused */
+#define MB_WORD(l, j) \
+	((int)le32_to_cpu(blocks[(l) < n ? (l) : n - 1] + 4 * (j)))
+#define MB_STATE(l, j) \
+	((int)states[(l) < n ? (l) : n - 1][j])
+#endif
+
+#ifdef HAVE_X86_TARGET_SSE2
+#define V_ADD(x, y)	_mm_add_epi32(x, y)
+#define V_ROTL(x, s) \
+	_mm_or_si128(_mm_slli_epi32(x, s), _mm_srli_epi32(x, 32 - (s)))
+#define V_SET1(x)	_mm_set1_epi32(x)
+#define V_F(x, y, z) \
+	_mm_xor_si128(z, _mm_and_si128(x, _mm_xor_si128(y, z)))
+#define V_G(x, y, z) \
+	_mm_xor_si128(y, _mm_and_si128(z, _mm_xor_si128(x, y)))
+#define V_H(x, y, z)	_mm_xor_si128(_mm_xor_si128(x, y), z)
+#define V_I(x, y, z) \
+	_mm_xor_si128(y, _mm_or_si128(x, _mm_xor_si128(z, _mm_set1_epi32(-1))))
+
+/* Four lanes per 128-bit vector */
+__attribute__((target("sse2"))) static void
+MD5_Transform_MB_sse2(uint32_t states[][4],
+    const uint8_t * const *blocks, size_t nlanes)
+{
+	__m128i W[16], S[4];
+	uint32_t out[4];
+	size_t l, n;
+	int j;
+
+	for (; nlanes > 0; states += n, blocks += n, nlanes -= n) {
+		n = nlanes < 4 ? nlanes : 4;
+
+		for (j = 0; j < 16; j++)
+			W[j] = _mm_set_epi32(MB_WORD(3, j), MB_WORD(2, j),
+			    MB_WORD(1, j), MB_WORD(0, j));
+		for (j = 0; j < 4; j++)
+			S[j] = _mm_set_epi32(MB_STATE(3, j), MB_STATE(2, j),
+			    MB_STATE(1, j), MB_STATE(0, j));
+
+		MB_ROUNDS(__m128i);
+
+		for (j = 0; j < 4; j++) {
+			_mm_storeu_si128((__m128i *)out, S[j]);
+			for (l = 0; l < n; l++)
+				states[l][j] = out[l];
+		}
+	}
+
+	explicit_bzero(W, sizeof(W));
+	explicit_bzero(S, sizeof(S));
+	explicit_bzero(out, sizeof(out));
+}
+
+#undef V_ADD
+#undef V_ROTL
+#undef V_SET1
+#undef V_F
+#undef V_G
+#undef V_H
+#undef V_I
+#endif
+
+#ifdef HAVE_X86_TARGET_AVX2
+#define V_ADD(x, y)	_mm256_add_epi32(x, y)
+#define V_ROTL(x, s) \
+	_mm256_or_si256(_mm256_slli_epi32(x, s), _mm256_srli_epi32(x, 32 - (s)))
+#define V_SET1(x)	_mm256_set1_epi32(x)
+#define V_F(x, y, z) \
+	_mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define V_G(x, y, z) \
+	_mm256_xor_si256(y, _mm256_and_si256(z, _mm256_xor_si256(x, y)))
+#define V_H(x, y, z)	_mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define V_I(x, y, z) \
+	_mm256_xor_si256(y, _mm256_or_si256(x, \
+	    _mm256_xor_si256(z, _mm256_set1_epi32(-1))))
+
+/* Eight lanes per 256-bit vector */
+__attribute__((target("avx2"))) static void
+MD5_Transform_MB_avx2(uint32_t states[][4],
+    const uint8_t * const *blocks, size_t nlanes)
+{
+	__m256i W[16], S[4];
+	uint32_t out[8];
+	size_t l, n;
+	int j;
+
+	for (; nlanes > 0; states += n, blocks += n, nlanes -= n) {
+		n = nlanes < 8 ? nlanes : 8;
+
+		for (j = 0; j < 16; j++)
+			W[j] = _mm256_set_epi32(MB_WORD(7, j), MB_WORD(6, j),
+			    MB_WORD(5, j), MB_WORD(4, j), MB_WORD(3, j),
+			    MB_WORD(2, j), MB_WORD(1, j), MB_WORD(0, j));
+		for (j = 0; j < 4; j++)
+			S[j] = _mm256_set_epi32(MB_STATE(7, j), MB_STATE(6, j),
+			    MB_STATE(5, j), MB_STATE(4, j), MB_STATE(3, j),
+			    MB_STATE(2, j), MB_STATE(1, j), MB_STATE(0, j));
+
+		MB_ROUNDS(__m256i);
+
+		for (j = 0; j < 4; j++) {
+			_mm256_storeu_si256((__m256i *)out, S[j]);
+			for (l = 0; l < n; l++)
+				states[l][j] = out[l];
+		}
+	}
+
+	explicit_bzero(W, sizeof(W));
+	explicit_bzero(S, sizeof(S));
+	explicit_bzero(out, sizeof(out));
+}
+
+#undef V_ADD
+#undef V_ROTL
+#undef V_SET1
+#undef V_F
+#undef V_G
+#undef V_H
+#undef V_I
+#endif
+
+#ifdef HAVE_X86_TARGET_AVX512F
+#define V_ADD(x, y)	_mm512_add_epi32(x, y)
+#define V_ROTL(x, s)	_mm512_rol_epi32(x, s)
+#define V_SET1(x)	_mm512_set1_epi32(x)
+#define V_F(x, y, z)	_mm512_ternarylogic_epi32(x, y, z, 0xca)
+#define V_G(x, y, z)	_mm512_ternarylogic_epi32(x, y, z, 0xe4)
+#define V_H(x, y, z)	_mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define V_I(x, y, z)	_mm512_ternarylogic_epi32(x, y, z, 0x39)
+
+/*
+ * Sixteen lanes per 512-bit vector.  Batches of eight lanes or fewer would
+ * leave at least half of the vector unused, so those are passed on to the
+ * AVX2 implementation instead.
+ */
+__attribute__((target("avx512f"))) static void
+MD5_Transform_MB_avx512(uint32_t states[][4],
+    const uint8_t * const *blocks, size_t nlanes)
+{
+	__m512i W[16], S[4];
+	uint32_t out[16];
+	size_t l, n = nlanes;
+	int j;
+
+#ifdef HAVE_X86_TARGET_AVX2
+	if (nlanes <= 8) {
+		MD5_Transform_MB_avx2(states, blocks, nlanes);
+		return;
+	}
+#endif
+
+	for (j = 0; j < 16; j++)
+		W[j] = _mm512_set_epi32(MB_WORD(15, j), MB_WORD(14, j),
+		    MB_WORD(13, j), MB_WORD(12, j), MB_WORD(11, j),
+		    MB_WORD(10, j), MB_WORD(9, j), MB_WORD(8, j),
+		    MB_WORD(7, j), MB_WORD(6, j), MB_WORD(5, j),
+		    MB_WORD(4, j), MB_WORD(3, j), MB_WORD(2, j),
+		    MB_WORD(1, j), MB_WORD(0, j));
+	for (j = 0; j < 4; j++)
+		S[j] = _mm512_set_epi32(MB_STATE(15, j), MB_STATE(14, j),
+		    MB_STATE(13, j), MB_STATE(12, j), MB_STATE(11, j),
+		    MB_STATE(10, j), MB_STATE(9, j), MB_STATE(8, j),
+		    MB_STATE(7, j), MB_STATE(6, j), MB_STATE(5, j),
+		    MB_STATE(4, j), MB_STATE(3, j), MB_STATE(2, j),
+		    MB_STATE(1, j), MB_STATE(0, j));
+
+	MB_ROUNDS(__m512i);
+
+	for (j = 0; j < 4; j++) {
+		_mm512_storeu_si512(out, S[j]);
+		for (l = 0; l < n; l++)
+			states[l][j] = out[l];
+	}
+
+	explicit_bzero(W, sizeof(W));
+	explicit_bzero(S, sizeof(S));
+	explicit_bzero(out, sizeof(out));
+}
+
+#undef V_ADD
+#undef V_ROTL
+#undef V_SET1
+#undef V_F
+#undef V_G
+#undef V_H
+#undef V_I
+#endif
+
+/*
+ * The implementation to use, and how many lanes it processes at once.
+ * These start out as the portable fallback and are upgraded, if the CPU
+ * allows, when the library is loaded.
+ */
+static void (*MD5_Transform_MB_impl)(uint32_t[][4],
+    const uint8_t * const *, size_t) = MD5_Transform_MB_generic;
+static size_t MD5_Transform_MB_nlanes = 1;
+
+#if defined HAVE_X86_TARGET_SSE2 || defined HAVE_X86_TARGET_AVX2 || \
+    defined HAVE_X86_TARGET_AVX512F
+CPU_DISPATCH(MD5_Transform_MB_select)
+
+static void
+MD5_Transform_MB_select(void)
+{
+
+	MD5_Transform_MB_impl = MD5_Transform_MB_generic;
+	MD5_Transform_MB_nlanes = 1;
+#ifdef HAVE_X86_TARGET_AVX512F
+	if (cpu_supports(CPU_AVX512F)) {
+		MD5_Transform_MB_impl = MD5_Transform_MB_avx512;
+		MD5_Transform_MB_nlanes = 16;
+		return;
+	}
+#endif
+#ifdef HAVE_X86_TARGET_AVX2
+	if (cpu_supports(CPU_AVX2)) {
+		MD5_Transform_MB_impl = MD5_Transform_MB_avx2;
+		MD5_Transform_MB_nlanes = 8;
+		return;
+	}
+#endif
+#ifdef HAVE_X86_TARGET_SSE2
+	if (cpu_supports(CPU_SSE2)) {
+		MD5_Transform_MB_impl = MD5_Transform_MB_sse2;
+		MD5_Transform_MB_nlanes = 4;
+	}
+#endif
+}
+#endif
+
+void MD5_Transform_MB(uint32_t states[][4],
+    const uint8_t * const *blocks, size_t nlanes)
+{
+	if (nlanes > 0)
+		MD5_Transform_MB_impl(states, blocks, nlanes);
+}
+
+size_t MD5_Transform_MB_lanes(void)
+{
+	return MD5_Transform_MB_nlanes;
+}
+
 void MD5_Init(MD5_CTX *ctx)
 {
 	ctx->a = 0x67452301;
@@ -40,4 +40,24 @@ extern void MD5_Init(MD5_CTX *ctx);
 extern void MD5_Update(MD5_CTX *ctx, const void *data, size_t size);
 extern void MD5_Final(uint8_t result[16], MD5_CTX *ctx);
 
+/* Largest number of lanes accepted by MD5_Transform_MB */
+#define MD5_MB_MAX_LANES 16
+
+/*
+ * Apply the MD5 compression function to nlanes independent states, where
+ * states[i] (a, b, c, d) is transformed via the 64-byte block blocks[i].
+ * This is equivalent to nlanes separate calls to the compression function,
+ * but uses SIMD instructions to process several lanes in parallel when the
+ * CPU supports them.  nlanes must be at most MD5_MB_MAX_LANES.  The caller
+ * is responsible for the padding and for the initial state.
+ */
+extern void MD5_Transform_MB(uint32_t states[][4],
+    const uint8_t * const *blocks, size_t nlanes);
+
+/*
+ * The number of lanes that MD5_Transform_MB processes in parallel on this
+ * CPU; 1 if it has no SIMD implementation to use.
+ */
+extern size_t MD5_Transform_MB_lanes(void);
+
 #endif /* alg-md5.h */
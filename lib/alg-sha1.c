@@ -71,6 +71,7 @@ modified for use with libxcrypt
 
 #include "crypt-port.h"
 #include "alg-sha1.h"
+#include "byteorder.h"
 
 #if INCLUDE_sha1crypt
 
@@ -213,6 +214,328 @@ sha1_do_transform (uint32_t state[5], const uint8_t buffer[64])
 }
 
 
+/* Apply the compression function to STATE and one 64-byte BLOCK. */
+void
+sha1_transform (uint32_t state[5], const uint8_t block[64])
+{
+  sha1_do_transform (state, block);
+}
+
+
+/* Multi-buffer SHA-1.  The SIMD implementations below hold word j of
+   every lane's block, or of every lane's state, in element i of one
+   vector register, so that the 80 steps are executed once for all
+   lanes.  */
+
+/* Portable fallback: one lane at a time. */
+static void
+sha1_transform_mb_generic (uint32_t states[][5],
+                           const uint8_t *const *blocks, size_t nlanes)
+{
+  for (size_t l = 0; l < nlanes; l++)
+    sha1_do_transform (states[l], blocks[l]);
+}
+
+#if defined HAVE_X86_TARGET_SSE2 || defined HAVE_X86_TARGET_AVX2 || \
+    defined HAVE_X86_TARGET_AVX512F
+#include <immintrin.h>
+
+/* The 80 steps, for a vector type V.  Each implementation defines
+   V_ADD, V_ROTL (by a constant), V_SET1 (broadcast), V_XOR4 (for the
+   message schedule), and the basic functions V_CH, V_PARITY and V_MAJ
+   before using this.  */
+#define MB_STEP(f, k, i)                                        \
+  do {                                                          \
+    if ((i) >= 16)                                              \
+      W[(i) & 15] = V_ROTL (V_XOR4 (W[((i) - 3) & 15],          \
+                                    W[((i) - 8) & 15],          \
+                                    W[((i) - 14) & 15],         \
+                                    W[(i) & 15]), 1);           \
+    t = V_ADD (V_ADD (V_ROTL (a, 5), f (b, c, d)),              \
+               V_ADD (e, V_ADD (W[(i) & 15], V_SET1 ((int) (k))))); \
+    e = d;                                                      \
+    d = c;                                                      \
+    c = V_ROTL (b, 30);                                         \
+    b = a;                                                      \
+    a = t;                                                      \
+  } while (0)
+
+#define MB_ROUNDS(V)                                            \
+  do {                                                          \
+    V a = S[0], b = S[1], c = S[2], d = S[3], e = S[4], t;      \
+    for (i = 0; i < 20; i++)                                    \
+      MB_STEP (V_CH, 0x5A827999, i);                            \
+    for (; i < 40; i++)                                         \
+      MB_STEP (V_PARITY, 0x6ED9EBA1, i);                        \
+    for (; i < 60; i++)                                         \
+      MB_STEP (V_MAJ, 0x8F1BBCDC, i);                           \
+    for (; i < 80; i++)                                         \
+      MB_STEP (V_PARITY, 0xCA62C1D6, i);                        \
+    S[0] = V_ADD (S[0], a);                                     \
+    S[1] = V_ADD (S[1], b);                                     \
+    S[2] = V_ADD (S[2], c);                                     \
+    S[3] = V_ADD (S[3], d);                                     \
+    S[4] = V_ADD (S[4], e);                                     \
+  } while (0)
+
+/* Load word j of the block for lane l, or of the last lane if l is
+   unused.  */
+#define MB_WORD(l, j) \
+  ((int) be32_to_cpu (blocks[(l) < n ? (l) : n - 1] + 4 * (j)))
+#define MB_STATE(l, j) \
+  ((int) states[(l) < n ? (l) : n - 1][j])
+#endif
+
+#ifdef HAVE_X86_TARGET_SSE2
+#define V_ADD(x, y)       _mm_add_epi32 (x, y)
+#define V_ROTL(x, s) \
+  _mm_or_si128 (_mm_slli_epi32 (x, s), _mm_srli_epi32 (x, 32 - (s)))
+#define V_SET1(x)         _mm_set1_epi32 (x)
+#define V_XOR4(w, x, y, z) \
+  _mm_xor_si128 (_mm_xor_si128 (w, x), _mm_xor_si128 (y, z))
+#define V_CH(x, y, z) \
+  _mm_xor_si128 (z, _mm_and_si128 (x, _mm_xor_si128 (y, z)))
+#define V_PARITY(x, y, z) _mm_xor_si128 (_mm_xor_si128 (x, y), z)
+#define V_MAJ(x, y, z) \
+  _mm_or_si128 (_mm_and_si128 (x, y), _mm_and_si128 (z, _mm_or_si128 (x, y)))
+
+/* Four lanes per 128-bit vector. */
+__attribute__((target ("sse2"))) static void
+sha1_transform_mb_sse2 (uint32_t states[][5],
+                        const uint8_t *const *blocks, size_t nlanes)
+{
+  __m128i W[16], S[5];
+  uint32_t out[4];
+  size_t l, n;
+  int i, j;
+
+  for (; nlanes > 0; states += n, blocks += n, nlanes -= n)
+    {
+      n = nlanes < 4 ? nlanes : 4;
+
+      for (j = 0; j < 16; j++)
+        W[j] = _mm_set_epi32 (MB_WORD (3, j), MB_WORD (2, j),
+                              MB_WORD (1, j), MB_WORD (0, j));
+      for (j = 0; j < 5; j++)
+        S[j] = _mm_set_epi32 (MB_STATE (3, j), MB_STATE (2, j),
+                              MB_STATE (1, j), MB_STATE (0, j));
+
+      MB_ROUNDS (__m128i);
+
+      for (j = 0; j < 5; j++)
+        {
+          _mm_storeu_si128 ((__m128i *) out, S[j]);
+          for (l = 0; l < n; l++)
+            states[l][j] = out[l];
+        }
+    }
+
+  explicit_bzero (W, sizeof W);
+  explicit_bzero (S, sizeof S);
+  explicit_bzero (out, sizeof out);
+}
+
+#undef V_ADD
+#undef V_ROTL
+#undef V_SET1
+#undef V_XOR4
+#undef V_CH
+#undef V_PARITY
+#undef V_MAJ
+#endif
+
+#ifdef HAVE_X86_TARGET_AVX2
+#define V_ADD(x, y)       _mm256_add_epi32 (x, y)
+#define V_ROTL(x, s) \
+  _mm256_or_si256 (_mm256_slli_epi32 (x, s), _mm256_srli_epi32 (x, 32 - (s)))
+#define V_SET1(x)         _mm256_set1_epi32 (x)
+#define V_XOR4(w, x, y, z) \
+  _mm256_xor_si256 (_mm256_xor_si256 (w, x), _mm256_xor_si256 (y, z))
+#define V_CH(x, y, z) \
+  _mm256_xor_si256 (z, _mm256_and_si256 (x, _mm256_xor_si256 (y, z)))
+#define V_PARITY(x, y, z) _mm256_xor_si256 (_mm256_xor_si256 (x, y), z)
+#define V_MAJ(x, y, z) \
+  _mm256_or_si256 (_mm256_and_si256 (x, y), \
+                   _mm256_and_si256 (z, _mm256_or_si256 (x, y)))
+
+/* Eight lanes per 256-bit vector. */
+__attribute__((target ("avx2"))) static void
+sha1_transform_mb_avx2 (uint32_t states[][5],
+                        const uint8_t *const *blocks, size_t nlanes)
+{
+  __m256i W[16], S[5];
+  uint32_t out[8];
+  size_t l, n;
+  int i, j;
+
+  for (; nlanes > 0; states += n, blocks += n, nlanes -= n)
+    {
+      n = nlanes < 8 ? nlanes : 8;
+
+      for (j = 0; j < 16; j++)
+        W[j] = _mm256_set_epi32 (MB_WORD (7, j), MB_WORD (6, j),
+                                 MB_WORD (5, j), MB_WORD (4, j),
+                                 MB_WORD (3, j), MB_WORD (2, j),
+                                 MB_WORD (1, j), MB_WORD (0, j));
+      for (j = 0; j < 5; j++)
+        S[j] = _mm256_set_epi32 (MB_STATE (7, j), MB_STATE (6, j),
+                                 MB_STATE (5, j), MB_STATE (4, j),
+                                 MB_STATE (3, j), MB_STATE (2, j),
+                                 MB_STATE (1, j), MB_STATE (0, j));
+
+      MB_ROUNDS (__m256i);
+
+      for (j = 0; j < 5; j++)
+        {
+          _mm256_storeu_si256 ((__m256i *) out, S[j]);
+          for (l = 0; l < n; l++)
+            states[l][j] = out[l];
+        }
+    }
+
+  explicit_bzero (W, sizeof W);
+  explicit_bzero (S, sizeof S);
+  explicit_bzero (out, sizeof out);
+}
+
+#undef V_ADD
+#undef V_ROTL
+#undef V_SET1
+#undef V_XOR4
+#undef V_CH
+#undef V_PARITY
+#undef V_MAJ
+#endif
+
+#ifdef HAVE_X86_TARGET_AVX512F
+#define V_ADD(x, y)        _mm512_add_epi32 (x, y)
+#define V_ROTL(x, s)       _mm512_rol_epi32 (x, s)
+#define V_SET1(x)          _mm512_set1_epi32 (x)
+#define V_XOR4(w, x, y, z) \
+  _mm512_ternarylogic_epi32 (_mm512_xor_si512 (w, x), y, z, 0x96)
+#define V_CH(x, y, z)      _mm512_ternarylogic_epi32 (x, y, z, 0xca)
+#define V_PARITY(x, y, z)  _mm512_ternarylogic_epi32 (x, y, z, 0x96)
+#define V_MAJ(x, y, z)     _mm512_ternarylogic_epi32 (x, y, z, 0xe8)
+
+/* Sixteen lanes per 512-bit vector.  Batches of eight lanes or fewer
+   would leave at least half of the vector unused, so those are passed
+   on to the AVX2 implementation instead.  */
+__attribute__((target ("avx512f"))) static void
+sha1_transform_mb_avx512 (uint32_t states[][5],
+                          const uint8_t *const *blocks, size_t nlanes)
+{
+  __m512i W[16], S[5];
+  uint32_t out[16];
+  size_t l, n = nlanes;
+  int i, j;
+
+#ifdef HAVE_X86_TARGET_AVX2
+  if (nlanes <= 8)
+    {
+      sha1_transform_mb_avx2 (states, blocks, nlanes);
+      return;
+    }
+#endif
+
+  for (j = 0; j < 16; j++)
+    W[j] = _mm512_set_epi32 (MB_WORD (15, j), MB_WORD (14, j),
+                             MB_WORD (13, j), MB_WORD (12, j),
+                             MB_WORD (11, j), MB_WORD (10, j),
+                             MB_WORD (9, j), MB_WORD (8, j),
+                             MB_WORD (7, j), MB_WORD (6, j),
+                             MB_WORD (5, j), MB_WORD (4, j),
+                             MB_WORD (3, j), MB_WORD (2, j),
+                             MB_WORD (1, j), MB_WORD (0, j));
+  for (j = 0; j < 5; j++)
+    S[j] = _mm512_set_epi32 (MB_STATE (15, j), MB_STATE (14, j),
+                             MB_STATE (13, j), MB_STATE (12, j),
+                             MB_STATE (11, j), MB_STATE (10, j),
+                             MB_STATE (9, j), MB_STATE (8, j),
+                             MB_STATE (7, j), MB_STATE (6, j),
+                             MB_STATE (5, j), MB_STATE (4, j),
+                             MB_STATE (3, j), MB_STATE (2, j),
+                             MB_STATE (1, j), MB_STATE (0, j));
+
+  MB_ROUNDS (__m512i);
+
+  for (j = 0; j < 5; j++)
+    {
+      _mm512_storeu_si512 (out, S[j]);
+      for (l = 0; l < n; l++)
+        states[l][j] = out[l];
+    }
+
+  explicit_bzero (W, sizeof W);
+  explicit_bzero (S, sizeof S);
+  explicit_bzero (out, sizeof out);
+}
+
+#undef V_ADD
+#undef V_ROTL
+#undef V_SET1
+#undef V_XOR4
+#undef V_CH
+#undef V_PARITY
+#undef V_MAJ
+#endif
+
+/* The implementation to use, and how many lanes it processes at once.
+   These start out as the portable fallback and are upgraded, if the
+   CPU allows, when the library is loaded.  */
+static void (*sha1_transform_mb_impl) (uint32_t[][5], const uint8_t *const *,
+                                       size_t) = sha1_transform_mb_generic;
+static size_t sha1_transform_mb_nlanes = 1;
+
+#if defined HAVE_X86_TARGET_SSE2 || defined HAVE_X86_TARGET_AVX2 || \
+    defined HAVE_X86_TARGET_AVX512F
+CPU_DISPATCH (sha1_transform_mb_select)
+
+static void
+sha1_transform_mb_select (void)
+{
+  sha1_transform_mb_impl = sha1_transform_mb_generic;
+  sha1_transform_mb_nlanes = 1;
+#ifdef HAVE_X86_TARGET_AVX512F
+  if (cpu_supports (CPU_AVX512F))
+    {
+      sha1_transform_mb_impl = sha1_transform_mb_avx512;
+      sha1_transform_mb_nlanes = 16;
+      return;
+    }
+#endif
+#ifdef HAVE_X86_TARGET_AVX2
+  if (cpu_supports (CPU_AVX2))
+    {
+      sha1_transform_mb_impl = sha1_transform_mb_avx2;
+      sha1_transform_mb_nlanes = 8;
+      return;
+    }
+#endif
+#ifdef HAVE_X86_TARGET_SSE2
+  if (cpu_supports (CPU_SSE2))
+    {
+      sha1_transform_mb_impl = sha1_transform_mb_sse2;
+      sha1_transform_mb_nlanes = 4;
+    }
+#endif
+}
+#endif
+
+void
+sha1_transform_mb (uint32_t states[][5], const uint8_t *const *blocks,
+                   size_t nlanes)
+{
+  if (nlanes > 0)
+    sha1_transform_mb_impl (states, blocks, nlanes);
+}
+
+size_t
+sha1_transform_mb_lanes (void)
+{
+  return sha1_transform_mb_nlanes;
+}
+
+
 /* SHA1Init - Initialize new context */
 void
 sha1_init_ctx (struct sha1_ctx* ctx)
@@ -31,4 +31,23 @@ extern void sha1_process_bytes (const void *buffer, struct sha1_ctx *ctx, size_t
    data written to CTX is erased before returning from the function.  */
 extern void *sha1_finish_ctx (struct sha1_ctx *ctx, void *resbuf);
 
+/* Apply the SHA-1 compression function to STATE and one 64-byte BLOCK.
+   The caller is responsible for the padding.  */
+extern void sha1_transform (uint32_t state[5], const uint8_t block[64]);
+
+/* Largest number of lanes accepted by sha1_transform_mb.  */
+#define SHA1_MB_MAX_LANES 16
+
+/* Apply the compression function to NLANES independent states, where
+   STATES[i] is transformed via the 64-byte block BLOCKS[i].  This is
+   equivalent to NLANES calls to sha1_transform, but uses SIMD
+   instructions to process several lanes in parallel when the CPU
+   supports them.  NLANES must be at most SHA1_MB_MAX_LANES.  */
+extern void sha1_transform_mb (uint32_t states[][5],
+                               const uint8_t *const *blocks, size_t nlanes);
+
+/* The number of lanes that sha1_transform_mb processes in parallel on
+   this CPU; 1 if it has no SIMD implementation to use.  */
+extern size_t sha1_transform_mb_lanes (void);
+
 #endif
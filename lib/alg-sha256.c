@@ -101,7 +101,7 @@ static const uint32_t Krnd[64] = {
  * the 512-bit input block to produce a new state.
  */
 static void
-SHA256_Transform(uint32_t state[static restrict 8],
+SHA256_Transform_generic(uint32_t state[static restrict 8],
     const uint8_t block[static restrict 64],
     uint32_t W[static restrict 64], uint32_t S[static restrict 8])
 {
@@ -165,6 +165,441 @@ SHA256_Transform(uint32_t state[static restrict 8],
 	state[7] += S[7];
 }
 
+#ifdef HAVE_X86_TARGET_SHA
+#include <immintrin.h>
+
+/*
+ * Four rounds with the x86 SHA extensions.  Ma holds W[i-16..i-13] on
+ * entry and is replaced by W[i..i+3]; Mb, Mc and Md hold the following
+ * twelve words.  For the first sixteen rounds, Ma already holds the
+ * message words and the schedule update is skipped.
+ */
+#define SHANI_RND4(i, Ma, Mb, Mc, Md) do {				\
+	if (i >= 16) {							\
+		TMP = _mm_sha256msg1_epu32(Ma, Mb);			\
+		TMP = _mm_add_epi32(TMP, _mm_alignr_epi8(Md, Mc, 4));	\
+		Ma = _mm_sha256msg2_epu32(TMP, Md);			\
+	}								\
+	MSG = _mm_add_epi32(Ma,						\
+	    _mm_loadu_si128((const __m128i *)&Krnd[i]));		\
+	STATE1 = _mm_sha256rnds2_epu32(STATE1, STATE0, MSG);		\
+	MSG = _mm_shuffle_epi32(MSG, 0x0E);				\
+	STATE0 = _mm_sha256rnds2_epu32(STATE0, STATE1, MSG);		\
+} while (0)
+
+/*
+ * SHA256 block compression function using the SHA-NI instructions.  The
+ * state is kept as the two vectors ABEF and CDGH that they operate on.
+ */
+__attribute__((target("sha,sse4.1"))) static void
+SHA256_Transform_shani(uint32_t state[static restrict 8],
+    const uint8_t block[static restrict 64],
+    uint32_t W[static restrict 64], uint32_t S[static restrict 8])
+{
+	const __m128i BSWAP = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+	    0x0405060700010203ULL);
+	__m128i STATE0, STATE1, ABEF_SAVE, CDGH_SAVE;
+	__m128i MSG, TMP, M0, M1, M2, M3;
+
+	(void)W;
+	(void)S;
+
+	/* Load the state and rearrange it from ABCD EFGH to ABEF CDGH. */
+	TMP = _mm_loadu_si128((const __m128i *)&state[0]);
+	STATE1 = _mm_loadu_si128((const __m128i *)&state[4]);
+	TMP = _mm_shuffle_epi32(TMP, 0xB1);
+	STATE1 = _mm_shuffle_epi32(STATE1, 0x1B);
+	STATE0 = _mm_alignr_epi8(TMP, STATE1, 8);
+	STATE1 = _mm_blend_epi16(STATE1, TMP, 0xF0);
+	ABEF_SAVE = STATE0;
+	CDGH_SAVE = STATE1;
+
+	/* Load the message words, converting them from big-endian. */
+	M0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&block[0]),
+	    BSWAP);
+	M1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&block[16]),
+	    BSWAP);
+	M2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&block[32]),
+	    BSWAP);
+	M3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&block[48]),
+	    BSWAP);
+
+	SHANI_RND4(0, M0, M1, M2, M3);
+	SHANI_RND4(4, M1, M2, M3, M0);
+	SHANI_RND4(8, M2, M3, M0, M1);
+	SHANI_RND4(12, M3, M0, M1, M2);
+	SHANI_RND4(16, M0, M1, M2, M3);
+	SHANI_RND4(20, M1, M2, M3, M0);
+	SHANI_RND4(24, M2, M3, M0, M1);
+	SHANI_RND4(28, M3, M0, M1, M2);
+	SHANI_RND4(32, M0, M1, M2, M3);
+	SHANI_RND4(36, M1, M2, M3, M0);
+	SHANI_RND4(40, M2, M3, M0, M1);
+	SHANI_RND4(44, M3, M0, M1, M2);
+	SHANI_RND4(48, M0, M1, M2, M3);
+	SHANI_RND4(52, M1, M2, M3, M0);
+	SHANI_RND4(56, M2, M3, M0, M1);
+	SHANI_RND4(60, M3, M0, M1, M2);
+
+	STATE0 = _mm_add_epi32(STATE0, ABEF_SAVE);
+	STATE1 = _mm_add_epi32(STATE1, CDGH_SAVE);
+
+	/* Rearrange the state back to ABCD EFGH and store it. */
+	TMP = _mm_shuffle_epi32(STATE0, 0x1B);
+	STATE1 = _mm_shuffle_epi32(STATE1, 0xB1);
+	STATE0 = _mm_blend_epi16(TMP, STATE1, 0xF0);
+	STATE1 = _mm_alignr_epi8(STATE1, TMP, 8);
+	_mm_storeu_si128((__m128i *)&state[0], STATE0);
+	_mm_storeu_si128((__m128i *)&state[4], STATE1);
+}
+#endif
+
+/*
+ * The block compression function to use.  This starts out as the
+ * portable implementation and is upgraded, if the CPU has instructions
+ * for SHA256, when the library is loaded.
+ */
+static void (*SHA256_Transform_impl)(uint32_t *, const uint8_t *,
+    uint32_t *, uint32_t *) = SHA256_Transform_generic;
+
+#ifdef HAVE_X86_TARGET_SHA
+CPU_DISPATCH(SHA256_Transform_select)
+
+static void
+SHA256_Transform_select(void)
+{
+
+	SHA256_Transform_impl = SHA256_Transform_generic;
+	if (cpu_supports(CPU_SHA | CPU_SSE41))
+		SHA256_Transform_impl = SHA256_Transform_shani;
+}
+#endif
+
+/*
+ * SHA256 block compression function.  ${W} and ${S} are scratch space
+ * for the portable implementation; the others do not need them.
+ */
+static inline void
+SHA256_Transform(uint32_t state[static restrict 8],
+    const uint8_t block[static restrict 64],
+    uint32_t W[static restrict 64], uint32_t S[static restrict 8])
+{
+
+	SHA256_Transform_impl(state, block, W, S);
+}
+
+/*
+ * Multi-buffer variants of the block compression function.  Each lane
+ * is an independent SHA256 computation; the SIMD implementations keep
+ * word j of every lane's state in element i of one vector register, so
+ * that the 64 rounds are executed once for all lanes.
+ */
+
+/* Portable fallback: one lane at a time. */
+static void
+SHA256_Transform_MB_generic(uint32_t states[][8],
+    const uint8_t * const * blocks, size_t nlanes)
+{
+	uint32_t tmp32[72];
+	size_t l;
+
+	for (l = 0; l < nlanes; l++)
+		SHA256_Transform(states[l], blocks[l], &tmp32[0], &tmp32[64]);
+
+	/* Clean the stack. */
+	explicit_bzero(tmp32, 288);
+}
+
+#if defined HAVE_X86_TARGET_SSE41 || defined HAVE_X86_TARGET_AVX2 || \
+    defined HAVE_X86_TARGET_AVX512F
+#include <immintrin.h>
+
+/*
+ * Generic SIMD round structure, parameterized by the vector type and
+ * its operations: ADD, XOR3 (three-way exclusive or), CH, MAJ, VROTR,
+ * VSHR, and SET1 (broadcast).
+ */
+#define SHA256_MB_ROUNDS(V, S, W, ADD, XOR3, CH, MAJ, VROTR, VSHR, SET1) do { \
+	V a = S[0], b = S[1], c = S[2], d = S[3];			\
+	V e = S[4], f = S[5], g = S[6], h = S[7];			\
+	V t1, t2;							\
+	for (i = 0; i < 64; i++) {					\
+		if (i >= 16)						\
+			W[i & 15] = ADD(ADD(W[i & 15], W[(i - 7) & 15]), \
+			    ADD(XOR3(VROTR(W[(i - 2) & 15], 17),		\
+			        VROTR(W[(i - 2) & 15], 19),		\
+			        VSHR(W[(i - 2) & 15], 10)),		\
+			    XOR3(VROTR(W[(i - 15) & 15], 7),		\
+			        VROTR(W[(i - 15) & 15], 18),		\
+			        VSHR(W[(i - 15) & 15], 3))));		\
+		t1 = ADD(ADD(h, XOR3(VROTR(e, 6), VROTR(e, 11),		\
+		    VROTR(e, 25))), ADD(CH(e, f, g),			\
+		    ADD(SET1((int)Krnd[i]), W[i & 15])));		\
+		t2 = ADD(XOR3(VROTR(a, 2), VROTR(a, 13), VROTR(a, 22)),	\
+		    MAJ(a, b, c));					\
+		h = g; g = f; f = e; e = ADD(d, t1);			\
+		d = c; c = b; b = a; a = ADD(t1, t2);			\
+	}								\
+	S[0] = ADD(S[0], a); S[1] = ADD(S[1], b);			\
+	S[2] = ADD(S[2], c); S[3] = ADD(S[3], d);			\
+	S[4] = ADD(S[4], e); S[5] = ADD(S[5], f);			\
+	S[6] = ADD(S[6], g); S[7] = ADD(S[7], h);			\
+} while (0)
+
+/* Load word j of the block for lane l, or of the last lane if l is unused. */
+#define MB_WORD(blocks, nlanes, l, j) \
+	((int)be32dec(blocks[(l) < (nlanes) ? (l) : (nlanes) - 1] + 4 * (j)))
+#define MB_STATE(states, nlanes, l, j) \
+	((int)states[(l) < (nlanes) ? (l) : (nlanes) - 1][j])
+#endif
+
+#ifdef HAVE_X86_TARGET_SSE41
+#define SSE_ADD(x, y)		_mm_add_epi32(x, y)
+#define SSE_XOR3(x, y, z)	_mm_xor_si128(_mm_xor_si128(x, y), z)
+#define SSE_CH(x, y, z) \
+	_mm_xor_si128(_mm_and_si128(x, _mm_xor_si128(y, z)), z)
+#define SSE_MAJ(x, y, z) \
+	_mm_or_si128(_mm_and_si128(x, y), \
+	    _mm_and_si128(z, _mm_or_si128(x, y)))
+#define SSE_ROTR(x, n) \
+	_mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - (n)))
+#define SSE_SHR(x, n)		_mm_srli_epi32(x, n)
+#define SSE_SET1(x)		_mm_set1_epi32(x)
+
+/* Four lanes per 128-bit vector. */
+__attribute__((target("sse4.1"))) static void
+SHA256_Transform_MB_sse41(uint32_t states[][8],
+    const uint8_t * const * blocks, size_t nlanes)
+{
+	__m128i W[16];
+	__m128i S[8];
+	size_t n;
+	int i, j;
+
+	for (; nlanes > 0; states += n, blocks += n, nlanes -= n) {
+		n = nlanes < 4 ? nlanes : 4;
+
+		for (j = 0; j < 16; j++)
+			W[j] = _mm_set_epi32(MB_WORD(blocks, n, 3, j),
+			    MB_WORD(blocks, n, 2, j), MB_WORD(blocks, n, 1, j),
+			    MB_WORD(blocks, n, 0, j));
+		for (j = 0; j < 8; j++)
+			S[j] = _mm_set_epi32(MB_STATE(states, n, 3, j),
+			    MB_STATE(states, n, 2, j), MB_STATE(states, n, 1, j),
+			    MB_STATE(states, n, 0, j));
+
+		SHA256_MB_ROUNDS(__m128i, S, W, SSE_ADD, SSE_XOR3, SSE_CH,
+		    SSE_MAJ, SSE_ROTR, SSE_SHR, SSE_SET1);
+
+		for (j = 0; j < 8; j++) {
+			states[0][j] = (uint32_t)_mm_extract_epi32(S[j], 0);
+			if (n > 1)
+				states[1][j] = (uint32_t)_mm_extract_epi32(S[j], 1);
+			if (n > 2)
+				states[2][j] = (uint32_t)_mm_extract_epi32(S[j], 2);
+			if (n > 3)
+				states[3][j] = (uint32_t)_mm_extract_epi32(S[j], 3);
+		}
+	}
+
+	explicit_bzero(W, sizeof(W));
+	explicit_bzero(S, sizeof(S));
+}
+#endif
+
+#ifdef HAVE_X86_TARGET_AVX2
+#define AVX2_ADD(x, y)		_mm256_add_epi32(x, y)
+#define AVX2_XOR3(x, y, z)	_mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define AVX2_CH(x, y, z) \
+	_mm256_xor_si256(_mm256_and_si256(x, _mm256_xor_si256(y, z)), z)
+#define AVX2_MAJ(x, y, z) \
+	_mm256_or_si256(_mm256_and_si256(x, y), \
+	    _mm256_and_si256(z, _mm256_or_si256(x, y)))
+#define AVX2_ROTR(x, n) \
+	_mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define AVX2_SHR(x, n)		_mm256_srli_epi32(x, n)
+#define AVX2_SET1(x)		_mm256_set1_epi32(x)
+
+/* Eight lanes per 256-bit vector. */
+__attribute__((target("avx2"))) static void
+SHA256_Transform_MB_avx2(uint32_t states[][8],
+    const uint8_t * const * blocks, size_t nlanes)
+{
+	__m256i W[16];
+	__m256i S[8];
+	uint32_t out[8];
+	size_t l, n;
+	int i, j;
+
+	for (; nlanes > 0; states += n, blocks += n, nlanes -= n) {
+		n = nlanes < 8 ? nlanes : 8;
+
+		for (j = 0; j < 16; j++)
+			W[j] = _mm256_set_epi32(MB_WORD(blocks, n, 7, j),
+			    MB_WORD(blocks, n, 6, j), MB_WORD(blocks, n, 5, j),
+			    MB_WORD(blocks, n, 4, j), MB_WORD(blocks, n, 3, j),
+			    MB_WORD(blocks, n, 2, j), MB_WORD(blocks, n, 1, j),
+			    MB_WORD(blocks, n, 0, j));
+		for (j = 0; j < 8; j++)
+			S[j] = _mm256_set_epi32(MB_STATE(states, n, 7, j),
+			    MB_STATE(states, n, 6, j), MB_STATE(states, n, 5, j),
+			    MB_STATE(states, n, 4, j), MB_STATE(states, n, 3, j),
+			    MB_STATE(states, n, 2, j), MB_STATE(states, n, 1, j),
+			    MB_STATE(states, n, 0, j));
+
+		SHA256_MB_ROUNDS(__m256i, S, W, AVX2_ADD, AVX2_XOR3, AVX2_CH,
+		    AVX2_MAJ, AVX2_ROTR, AVX2_SHR, AVX2_SET1);
+
+		for (j = 0; j < 8; j++) {
+			_mm256_storeu_si256((__m256i *)out, S[j]);
+			for (l = 0; l < n; l++)
+				states[l][j] = out[l];
+		}
+	}
+
+	explicit_bzero(W, sizeof(W));
+	explicit_bzero(S, sizeof(S));
+	explicit_bzero(out, sizeof(out));
+}
+#endif
+
+#ifdef HAVE_X86_TARGET_AVX512F
+#define AVX512_ADD(x, y)	_mm512_add_epi32(x, y)
+#define AVX512_XOR3(x, y, z)	_mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define AVX512_CH(x, y, z)	_mm512_ternarylogic_epi32(x, y, z, 0xca)
+#define AVX512_MAJ(x, y, z)	_mm512_ternarylogic_epi32(x, y, z, 0xe8)
+#define AVX512_ROTR(x, n)	_mm512_ror_epi32(x, n)
+#define AVX512_SHR(x, n)	_mm512_srli_epi32(x, n)
+#define AVX512_SET1(x)		_mm512_set1_epi32(x)
+
+/*
+ * Sixteen lanes per 512-bit vector.  Batches of eight lanes or fewer
+ * would leave at least half of the vector unused, so those are passed
+ * on to the AVX2 implementation instead.
+ */
+__attribute__((target("avx512f"))) static void
+SHA256_Transform_MB_avx512(uint32_t states[][8],
+    const uint8_t * const * blocks, size_t nlanes)
+{
+	__m512i W[16];
+	__m512i S[8];
+	uint32_t out[16];
+	size_t l, n = nlanes;
+	int i, j;
+
+#ifdef HAVE_X86_TARGET_AVX2
+	if (nlanes <= 8) {
+		SHA256_Transform_MB_avx2(states, blocks, nlanes);
+		return;
+	}
+#endif
+
+	for (j = 0; j < 16; j++)
+		W[j] = _mm512_set_epi32(MB_WORD(blocks, n, 15, j),
+		    MB_WORD(blocks, n, 14, j), MB_WORD(blocks, n, 13, j),
+		    MB_WORD(blocks, n, 12, j), MB_WORD(blocks, n, 11, j),
+		    MB_WORD(blocks, n, 10, j), MB_WORD(blocks, n, 9, j),
+		    MB_WORD(blocks, n, 8, j), MB_WORD(blocks, n, 7, j),
+		    MB_WORD(blocks, n, 6, j), MB_WORD(blocks, n, 5, j),
+		    MB_WORD(blocks, n, 4, j), MB_WORD(blocks, n, 3, j),
+		    MB_WORD(blocks, n, 2, j), MB_WORD(blocks, n, 1, j),
+		    MB_WORD(blocks, n, 0, j));
+	for (j = 0; j < 8; j++)
+		S[j] = _mm512_set_epi32(MB_STATE(states, n, 15, j),
+		    MB_STATE(states, n, 14, j), MB_STATE(states, n, 13, j),
+		    MB_STATE(states, n, 12, j), MB_STATE(states, n, 11, j),
+		    MB_STATE(states, n, 10, j), MB_STATE(states, n, 9, j),
+		    MB_STATE(states, n, 8, j), MB_STATE(states, n, 7, j),
+		    MB_STATE(states, n, 6, j), MB_STATE(states, n, 5, j),
+		    MB_STATE(states, n, 4, j), MB_STATE(states, n, 3, j),
+		    MB_STATE(states, n, 2, j), MB_STATE(states, n, 1, j),
+		    MB_STATE(states, n, 0, j));
+
+	SHA256_MB_ROUNDS(__m512i, S, W, AVX512_ADD, AVX512_XOR3, AVX512_CH,
+	    AVX512_MAJ, AVX512_ROTR, AVX512_SHR, AVX512_SET1);
+
+	for (j = 0; j < 8; j++) {
+		_mm512_storeu_si512(out, S[j]);
+		for (l = 0; l < n; l++)
+			states[l][j] = out[l];
+	}
+
+	explicit_bzero(W, sizeof(W));
+	explicit_bzero(S, sizeof(S));
+	explicit_bzero(out, sizeof(out));
+}
+#endif
+
+/*
+ * The implementation to use, and how many lanes it processes at once.
+ * These start out as the portable fallback and are upgraded, if the
+ * CPU allows, when the library is loaded.
+ */
+static void (*SHA256_Transform_MB_impl)(uint32_t[][8],
+    const uint8_t * const *, size_t) = SHA256_Transform_MB_generic;
+static size_t SHA256_Transform_MB_nlanes = 1;
+
+#if defined HAVE_X86_TARGET_SSE41 || defined HAVE_X86_TARGET_AVX2 || \
+    defined HAVE_X86_TARGET_AVX512F
+CPU_DISPATCH(SHA256_Transform_MB_select)
+
+static void
+SHA256_Transform_MB_select(void)
+{
+
+	SHA256_Transform_MB_impl = SHA256_Transform_MB_generic;
+	SHA256_Transform_MB_nlanes = 1;
+#ifdef HAVE_X86_TARGET_AVX512F
+	if (cpu_supports(CPU_AVX512F)) {
+		SHA256_Transform_MB_impl = SHA256_Transform_MB_avx512;
+		SHA256_Transform_MB_nlanes = 16;
+		return;
+	}
+#endif
+#ifdef HAVE_X86_TARGET_AVX2
+	if (cpu_supports(CPU_AVX2)) {
+		SHA256_Transform_MB_impl = SHA256_Transform_MB_avx2;
+		SHA256_Transform_MB_nlanes = 8;
+		return;
+	}
+#endif
+#ifdef HAVE_X86_TARGET_SHA
+	/* One lane at a time with SHA-NI is faster than four with SSE4.1. */
+	if (cpu_supports(CPU_SHA | CPU_SSE41))
+		return;
+#endif
+#ifdef HAVE_X86_TARGET_SSE41
+	if (cpu_supports(CPU_SSE41)) {
+		SHA256_Transform_MB_impl = SHA256_Transform_MB_sse41;
+		SHA256_Transform_MB_nlanes = 4;
+	}
+#endif
+}
+#endif
+
+void
+SHA256_Transform_MB(uint32_t states[][8],
+    const uint8_t * const * blocks, size_t nlanes)
+{
+
+	if (nlanes > 0)
+		SHA256_Transform_MB_impl(states, blocks, nlanes);
+}
+
+size_t
+SHA256_Transform_MB_lanes(void)
+{
+
+	return SHA256_Transform_MB_nlanes;
+}
+
+int
+SHA256_Transform_accelerated(void)
+{
+
+	return (SHA256_Transform_impl != SHA256_Transform_generic);
+}
+
 static const uint8_t PAD[64] = {
 	0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -503,16 +938,132 @@ SHA256_Pad_Almost(SHA256_CTX * ctx, uint8_t len[static restrict 8],
 	return 0;
 }
 
+/*
+ * Compute the blocks of PBKDF2_SHA256 output for c = 1, given the HMAC
+ * state ${hctx} after processing P and S with both of its final blocks
+ * already padded, and the offset ${ivoff} of INT(i) in the inner one.
+ * Each block takes two compressions, one inner and one outer; those of
+ * up to SHA256_MB_MAX_LANES blocks are done at once.
+ */
+static void
+PBKDF2_SHA256_blocks_MB(const HMAC_SHA256_CTX * hctx, size_t ivoff,
+    uint8_t * buf, size_t dkLen)
+{
+	uint8_t msg[SHA256_MB_MAX_LANES][64];
+	uint32_t state[SHA256_MB_MAX_LANES][8];
+	const uint8_t * blocks[SHA256_MB_MAX_LANES];
+	size_t nlanes = SHA256_Transform_MB_lanes();
+	size_t i, l, n;
+
+	for (i = 0; i * 32 < dkLen; i += n) {
+		n = dkLen / 32 - i;
+		if (n > nlanes)
+			n = nlanes;
+
+		/* Inner hashes of S || INT(i + l + 1). */
+		for (l = 0; l < n; l++) {
+			memcpy(msg[l], hctx->ictx.buf, 64);
+			be32enc(&msg[l][ivoff], (uint32_t)(i + l + 1));
+			memcpy(state[l], hctx->ictx.state, sizeof(state[l]));
+			blocks[l] = msg[l];
+		}
+		SHA256_Transform_MB(state, blocks, n);
+
+		/* Outer hashes, which are U_1 and thus T_(i + l + 1). */
+		for (l = 0; l < n; l++) {
+			memcpy(msg[l], hctx->octx.buf, 64);
+			be32enc_vect(msg[l], state[l], 8);
+			memcpy(state[l], hctx->octx.state, sizeof(state[l]));
+		}
+		SHA256_Transform_MB(state, blocks, n);
+
+		for (l = 0; l < n; l++)
+			be32enc_vect(&buf[(i + l) * 32], state[l], 8);
+	}
+
+	/* Clean the stack. */
+	explicit_bzero(msg, sizeof(msg));
+	explicit_bzero(state, sizeof(state));
+}
+
+/*
+ * Encode a digest like be32enc_vect(dst, src, 8), but as whole words, so
+ * that the compiler can use wide stores.  A SHA256_Transform that reads
+ * the block with 16-byte loads, as the SHA-NI one does, can then have the
+ * data forwarded from those stores instead of waiting for 32 byte stores
+ * to retire.
+ */
+static inline void
+PBKDF2_SHA256_enc(uint8_t dst[static restrict 32],
+    const uint32_t src[static restrict 8])
+{
+	uint32_t w[8];
+	int k;
+
+	for (k = 0; k < 8; k++) {
+#if XCRYPT_USE_BIGENDIAN
+		w[k] = src[k];
+#else
+		w[k] = (src[k] >> 24) | ((src[k] >> 8) & 0xff00) |
+		    ((src[k] & 0xff00) << 8) | (src[k] << 24);
+#endif
+	}
+	memcpy(dst, w, 32);
+}
+
+/*
+ * Replace the 32 bytes in ${U} with their HMAC under the key whose HMAC
+ * state is ${Phctx}, and XOR the result into ${T}; repeat ${n} times.
+ * The message and the inner hash are each exactly one block after the
+ * padded key, so the padding of both final blocks is written once and
+ * every iteration is just two compressions.
+ */
+static void
+PBKDF2_SHA256_iterate(const HMAC_SHA256_CTX * Phctx, uint8_t U[32],
+    uint8_t T[32], uint64_t n, uint32_t tmp32[static restrict 72])
+{
+	uint8_t block[64];
+	uint32_t state[8];
+	uint64_t j;
+	int k;
+
+	/* Both messages are 32 bytes long, after one 64-byte block. */
+	memcpy(block, U, 32);
+	memcpy(&block[32], PAD, 24);
+	be64enc(&block[56], (64 + 32) << 3);
+
+	for (j = 0; j < n; j++) {
+		/* Inner hash of U_(j-1). */
+		memcpy(state, Phctx->ictx.state, sizeof(state));
+		SHA256_Transform(state, block, &tmp32[0], &tmp32[64]);
+		PBKDF2_SHA256_enc(block, state);
+
+		/* Outer hash, which is U_j. */
+		memcpy(state, Phctx->octx.state, sizeof(state));
+		SHA256_Transform(state, block, &tmp32[0], &tmp32[64]);
+		PBKDF2_SHA256_enc(block, state);
+
+		for (k = 0; k < 32; k++)
+			T[k] ^= block[k];
+	}
+
+	/* Clean the stack. */
+	explicit_bzero(block, sizeof(block));
+	explicit_bzero(state, sizeof(state));
+}
+
 /**
- * PBKDF2_SHA256(passwd, passwdlen, salt, saltlen, c, buf, dkLen):
+ * PBKDF2_SHA256_HMAC(Phctx, salt, saltlen, c, buf, dkLen):
  * Compute PBKDF2(passwd, salt, c, dkLen) using HMAC-SHA256 as the PRF, and
- * write the output to buf.  The value dkLen must be at most 32 * (2^32 - 1).
+ * write the output to buf, given the state ${Phctx} of HMAC_SHA256_Init
+ * with passwd as the key.  This lets callers that derive several keys
+ * from the same password initialize the HMAC only once.
  */
 void
-PBKDF2_SHA256(const uint8_t * passwd, size_t passwdlen, const uint8_t * salt,
+PBKDF2_SHA256_HMAC(const HMAC_SHA256_CTX * Phctx, const uint8_t * salt,
     size_t saltlen, uint64_t c, uint8_t * buf, size_t dkLen)
 {
-	HMAC_SHA256_CTX Phctx, PShctx, hctx;
+	HMAC_SHA256_CTX PShctx, hctx;
 	uint32_t tmp32[72];
 	union {
 		uint8_t tmp8[96];
@@ -522,8 +1073,6 @@ PBKDF2_SHA256(const uint8_t * passwd, size_t passwdlen, const uint8_t * salt,
 	uint8_t ivec[4];
 	uint8_t U[32];
 	uint8_t T[32];
-	uint64_t j;
-	int k;
 	size_t clen;
 
 	/* Sanity-check. */
@@ -534,8 +1083,7 @@ PBKDF2_SHA256(const uint8_t * passwd, size_t passwdlen, const uint8_t * salt,
 		uint8_t * ivecp;
 
 		/* Compute HMAC state after processing P and S. */
-		_HMAC_SHA256_Init(&hctx, passwd, passwdlen,
-		    tmp32, &u.tmp8[0], &u.tmp8[64]);
+		memcpy(&hctx, Phctx, sizeof(HMAC_SHA256_CTX));
 		_HMAC_SHA256_Update(&hctx, salt, saltlen, tmp32);
 
 		/* Prepare ictx padding. */
@@ -550,6 +1098,16 @@ PBKDF2_SHA256(const uint8_t * passwd, size_t passwdlen, const uint8_t * salt,
 		hctx.octx.count += 32 << 3;
 		SHA256_Pad_Almost(&hctx.octx, u.tmp8, tmp32);
 
+		/*
+		 * The blocks are independent of each other, so if the CPU
+		 * can run several SHA256 computations in parallel, do that.
+		 */
+		if (SHA256_Transform_MB_lanes() > 1 && dkLen > 32) {
+			PBKDF2_SHA256_blocks_MB(&hctx,
+			    (size_t)(ivecp - hctx.ictx.buf), buf, dkLen);
+			goto cleanup;
+		}
+
 		/* Iterate through the blocks. */
 		for (i = 0; i * 32 < dkLen; i++) {
 			/* Generate INT(i + 1). */
@@ -570,12 +1128,8 @@ PBKDF2_SHA256(const uint8_t * passwd, size_t passwdlen, const uint8_t * salt,
 	}
 
 generic:
-	/* Compute HMAC state after processing P. */
-	_HMAC_SHA256_Init(&Phctx, passwd, passwdlen,
-	    tmp32, &u.tmp8[0], &u.tmp8[64]);
-
 	/* Compute HMAC state after processing P and S. */
-	memcpy(&PShctx, &Phctx, sizeof(HMAC_SHA256_CTX));
+	memcpy(&PShctx, Phctx, sizeof(HMAC_SHA256_CTX));
 	_HMAC_SHA256_Update(&PShctx, salt, saltlen, tmp32);
 
 	/* Iterate through the blocks. */
@@ -588,20 +1142,10 @@ generic:
 		_HMAC_SHA256_Update(&hctx, ivec, 4, tmp32);
 		_HMAC_SHA256_Final(T, &hctx, tmp32, u.tmp8);
 
+		/* T_i = U_1 xor U_2 xor ... xor U_c. */
 		if (c > 1) {
-			/* T_i = U_1 ... */
 			memcpy(U, T, 32);
-
-			for (j = 2; j <= c; j++) {
-				/* Compute U_j. */
-				memcpy(&hctx, &Phctx, sizeof(HMAC_SHA256_CTX));
-				_HMAC_SHA256_Update(&hctx, U, 32, tmp32);
-				_HMAC_SHA256_Final(U, &hctx, tmp32, u.tmp8);
-
-				/* ... xor U_j ... */
-				for (k = 0; k < 32; k++)
-					T[k] ^= U[k];
-			}
+			PBKDF2_SHA256_iterate(Phctx, U, T, c - 1, tmp32);
 		}
 
 		/* Copy as many bytes as necessary into buf. */
@@ -612,7 +1156,6 @@ generic:
 	}
 
 	/* Clean the stack. */
-	explicit_bzero(&Phctx, sizeof(HMAC_SHA256_CTX));
 	explicit_bzero(&PShctx, sizeof(HMAC_SHA256_CTX));
 	explicit_bzero(U, 32);
 	explicit_bzero(T, 32);
@@ -623,4 +1166,24 @@ cleanup:
 	explicit_bzero(&u, sizeof(u));
 }
 
+/**
+ * PBKDF2_SHA256(passwd, passwdlen, salt, saltlen, c, buf, dkLen):
+ * Compute PBKDF2(passwd, salt, c, dkLen) using HMAC-SHA256 as the PRF, and
+ * write the output to buf.  The value dkLen must be at most 32 * (2^32 - 1).
+ */
+void
+PBKDF2_SHA256(const uint8_t * passwd, size_t passwdlen, const uint8_t * salt,
+    size_t saltlen, uint64_t c, uint8_t * buf, size_t dkLen)
+{
+	HMAC_SHA256_CTX Phctx;
+
+	/* Compute HMAC state after processing P. */
+	HMAC_SHA256_Init(&Phctx, passwd, passwdlen);
+
+	PBKDF2_SHA256_HMAC(&Phctx, salt, saltlen, c, buf, dkLen);
+
+	/* Clean the stack. */
+	explicit_bzero(&Phctx, sizeof(HMAC_SHA256_CTX));
+}
+
 #endif /* INCLUDE_gost_yescrypt || INCLUDE_yescrypt || INCLUDE_scrypt */
@@ -41,6 +41,9 @@
 #define SHA256_Final libcperciva_SHA256_Final
 #define SHA256_Buf libcperciva_SHA256_Buf
 #define SHA256_CTX libcperciva_SHA256_CTX
+#define SHA256_Transform_MB libcperciva_SHA256_Transform_MB
+#define SHA256_Transform_MB_lanes libcperciva_SHA256_Transform_MB_lanes
+#define SHA256_Transform_accelerated libcperciva_SHA256_Transform_accelerated
 #define HMAC_SHA256_Init libcperciva_HMAC_SHA256_Init
 #define HMAC_SHA256_Update libcperciva_HMAC_SHA256_Update
 #define HMAC_SHA256_Final libcperciva_HMAC_SHA256_Final
@@ -79,6 +82,36 @@ extern void SHA256_Final(uint8_t[32], SHA256_CTX *);
  */
 extern void SHA256_Buf(const void *, size_t, uint8_t[32]);
 
+/* Largest number of lanes accepted by SHA256_Transform_MB. */
+#define SHA256_MB_MAX_LANES 16
+
+/**
+ * SHA256_Transform_MB(states, blocks, nlanes):
+ * Apply the SHA256 block compression function to ${nlanes} independent
+ * states, where ${states}[i] is transformed via the 64-byte block
+ * ${blocks}[i].  This is equivalent to ${nlanes} separate calls to the
+ * compression function, but uses SIMD instructions to process several
+ * lanes in parallel when the CPU supports them.  ${nlanes} must be at
+ * most SHA256_MB_MAX_LANES.
+ */
+extern void SHA256_Transform_MB(uint32_t[][8], const uint8_t * const *,
+    size_t);
+
+/**
+ * SHA256_Transform_MB_lanes():
+ * Return the number of lanes that SHA256_Transform_MB processes in
+ * parallel on this CPU; 1 if it has no SIMD implementation to use.
+ */
+extern size_t SHA256_Transform_MB_lanes(void);
+
+/**
+ * SHA256_Transform_accelerated():
+ * Return nonzero if the single-lane SHA256 compression function uses
+ * instructions made for SHA256 on this CPU.  It is then about as fast
+ * per lane as SHA256_Transform_MB with all of its lanes in use.
+ */
+extern int SHA256_Transform_accelerated(void);
+
 /* Context structure for HMAC-SHA256 operations. */
 typedef struct {
 	SHA256_CTX ictx;
@@ -120,4 +153,14 @@ extern void HMAC_SHA256_Buf(const void *, size_t, const void *, size_t, uint8_t[
 extern void PBKDF2_SHA256(const uint8_t *, size_t, const uint8_t *, size_t,
     uint64_t, uint8_t *, size_t);
 
+/**
+ * PBKDF2_SHA256_HMAC(Phctx, salt, saltlen, c, buf, dkLen):
+ * Compute PBKDF2(passwd, salt, c, dkLen) using HMAC-SHA256 as the PRF, and
+ * write the output to buf, given the state ${Phctx} of HMAC_SHA256_Init
+ * with passwd as the key.  This lets callers that derive several keys
+ * from the same password initialize the HMAC only once.
+ */
+extern void PBKDF2_SHA256_HMAC(const HMAC_SHA256_CTX *, const uint8_t *,
+    size_t, uint64_t, uint8_t *, size_t);
+
 #endif /* !_SHA256_H_ */
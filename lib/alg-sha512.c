@@ -172,6 +172,216 @@ SHA512_Transform(uint64_t * state, const unsigned char block[SHA512_BLOCK_LENGTH
 		state[i] += S[i];
 }
 
+/*
+ * Multi-buffer variants of the block compression function.  Each lane
+ * is an independent SHA512 computation; the SIMD implementations keep
+ * word j of every lane's state in element i of one vector register, so
+ * that the 80 rounds are executed once for all lanes.
+ */
+
+/* Portable fallback: one lane at a time. */
+static void
+SHA512_Transform_MB_generic(uint64_t states[][8],
+    const unsigned char * const * blocks, size_t nlanes)
+{
+	size_t l;
+
+	for (l = 0; l < nlanes; l++)
+		SHA512_Transform(states[l], blocks[l]);
+}
+
+#if defined HAVE_X86_TARGET_AVX2 || defined HAVE_X86_TARGET_AVX512F
+#include <immintrin.h>
+
+/*
+ * Generic SIMD round structure, parameterized by the vector type and
+ * its operations: ADD, XOR3 (three-way exclusive or), CH, MAJ, ROTR, SHR,
+ * and SET1 (broadcast).
+ */
+#define SHA512_MB_ROUNDS(V, S, W, ADD, XOR3, CH, MAJ, ROTR, SHR, SET1) do { \
+	V a = S[0], b = S[1], c = S[2], d = S[3];			\
+	V e = S[4], f = S[5], g = S[6], h = S[7];			\
+	V t1, t2;							\
+	for (i = 0; i < 80; i++) {					\
+		if (i >= 16)						\
+			W[i & 15] = ADD(ADD(W[i & 15], W[(i - 7) & 15]), \
+			    ADD(XOR3(ROTR(W[(i - 2) & 15], 19),		\
+			        ROTR(W[(i - 2) & 15], 61),		\
+			        SHR(W[(i - 2) & 15], 6)),		\
+			    XOR3(ROTR(W[(i - 15) & 15], 1),		\
+			        ROTR(W[(i - 15) & 15], 8),		\
+			        SHR(W[(i - 15) & 15], 7))));		\
+		t1 = ADD(ADD(h, XOR3(ROTR(e, 14), ROTR(e, 18),		\
+		    ROTR(e, 41))), ADD(CH(e, f, g),			\
+		    ADD(SET1((long long)K[i]), W[i & 15])));		\
+		t2 = ADD(XOR3(ROTR(a, 28), ROTR(a, 34), ROTR(a, 39)),	\
+		    MAJ(a, b, c));					\
+		h = g; g = f; f = e; e = ADD(d, t1);			\
+		d = c; c = b; b = a; a = ADD(t1, t2);			\
+	}								\
+	S[0] = ADD(S[0], a); S[1] = ADD(S[1], b);			\
+	S[2] = ADD(S[2], c); S[3] = ADD(S[3], d);			\
+	S[4] = ADD(S[4], e); S[5] = ADD(S[5], f);			\
+	S[6] = ADD(S[6], g); S[7] = ADD(S[7], h);			\
+} while (0)
+
+/* Load word j of the block for lane l, or of the last lane if l is unused. */
+#define MB_WORD(blocks, nlanes, l, j) \
+	((long long)be64dec(blocks[(l) < (nlanes) ? (l) : (nlanes) - 1] + 8 * (j)))
+#define MB_STATE(states, nlanes, l, j) \
+	((long long)states[(l) < (nlanes) ? (l) : (nlanes) - 1][j])
+#endif
+
+#ifdef HAVE_X86_TARGET_AVX2
+#define AVX2_ADD(x, y)		_mm256_add_epi64(x, y)
+#define AVX2_XOR3(x, y, z)	_mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define AVX2_CH(x, y, z) \
+	_mm256_xor_si256(_mm256_and_si256(x, _mm256_xor_si256(y, z)), z)
+#define AVX2_MAJ(x, y, z) \
+	_mm256_or_si256(_mm256_and_si256(x, y), \
+	    _mm256_and_si256(z, _mm256_or_si256(x, y)))
+#define AVX2_ROTR(x, n) \
+	_mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - (n)))
+#define AVX2_SHR(x, n)		_mm256_srli_epi64(x, n)
+#define AVX2_SET1(x)		_mm256_set1_epi64x(x)
+
+/* Four lanes per 256-bit vector. */
+__attribute__((target("avx2"))) static void
+SHA512_Transform_MB_avx2(uint64_t states[][8],
+    const unsigned char * const * blocks, size_t nlanes)
+{
+	__m256i W[16];
+	__m256i S[8];
+	uint64_t out[4];
+	size_t l, n;
+	int i, j;
+
+	for (; nlanes > 0; states += n, blocks += n, nlanes -= n) {
+		n = nlanes < 4 ? nlanes : 4;
+
+		for (j = 0; j < 16; j++)
+			W[j] = _mm256_set_epi64x(MB_WORD(blocks, n, 3, j),
+			    MB_WORD(blocks, n, 2, j), MB_WORD(blocks, n, 1, j),
+			    MB_WORD(blocks, n, 0, j));
+		for (j = 0; j < 8; j++)
+			S[j] = _mm256_set_epi64x(MB_STATE(states, n, 3, j),
+			    MB_STATE(states, n, 2, j), MB_STATE(states, n, 1, j),
+			    MB_STATE(states, n, 0, j));
+
+		SHA512_MB_ROUNDS(__m256i, S, W, AVX2_ADD, AVX2_XOR3, AVX2_CH,
+		    AVX2_MAJ, AVX2_ROTR, AVX2_SHR, AVX2_SET1);
+
+		for (j = 0; j < 8; j++) {
+			_mm256_storeu_si256((__m256i *)out, S[j]);
+			for (l = 0; l < n; l++)
+				states[l][j] = out[l];
+		}
+	}
+
+	explicit_bzero(W, sizeof(W));
+	explicit_bzero(S, sizeof(S));
+	explicit_bzero(out, sizeof(out));
+}
+#endif
+
+#ifdef HAVE_X86_TARGET_AVX512F
+#define AVX512_ADD(x, y)	_mm512_add_epi64(x, y)
+#define AVX512_XOR3(x, y, z)	_mm512_ternarylogic_epi64(x, y, z, 0x96)
+#define AVX512_CH(x, y, z)	_mm512_ternarylogic_epi64(x, y, z, 0xca)
+#define AVX512_MAJ(x, y, z)	_mm512_ternarylogic_epi64(x, y, z, 0xe8)
+#define AVX512_ROTR(x, n)	_mm512_ror_epi64(x, n)
+#define AVX512_SHR(x, n)	_mm512_srli_epi64(x, n)
+#define AVX512_SET1(x)		_mm512_set1_epi64(x)
+
+/* Eight lanes per 512-bit vector. */
+__attribute__((target("avx512f"))) static void
+SHA512_Transform_MB_avx512(uint64_t states[][8],
+    const unsigned char * const * blocks, size_t nlanes)
+{
+	__m512i W[16];
+	__m512i S[8];
+	uint64_t out[8];
+	size_t l, n = nlanes;
+	int i, j;
+
+	for (j = 0; j < 16; j++)
+		W[j] = _mm512_set_epi64(MB_WORD(blocks, n, 7, j),
+		    MB_WORD(blocks, n, 6, j), MB_WORD(blocks, n, 5, j),
+		    MB_WORD(blocks, n, 4, j), MB_WORD(blocks, n, 3, j),
+		    MB_WORD(blocks, n, 2, j), MB_WORD(blocks, n, 1, j),
+		    MB_WORD(blocks, n, 0, j));
+	for (j = 0; j < 8; j++)
+		S[j] = _mm512_set_epi64(MB_STATE(states, n, 7, j),
+		    MB_STATE(states, n, 6, j), MB_STATE(states, n, 5, j),
+		    MB_STATE(states, n, 4, j), MB_STATE(states, n, 3, j),
+		    MB_STATE(states, n, 2, j), MB_STATE(states, n, 1, j),
+		    MB_STATE(states, n, 0, j));
+
+	SHA512_MB_ROUNDS(__m512i, S, W, AVX512_ADD, AVX512_XOR3, AVX512_CH,
+	    AVX512_MAJ, AVX512_ROTR, AVX512_SHR, AVX512_SET1);
+
+	for (j = 0; j < 8; j++) {
+		_mm512_storeu_si512(out, S[j]);
+		for (l = 0; l < n; l++)
+			states[l][j] = out[l];
+	}
+
+	explicit_bzero(W, sizeof(W));
+	explicit_bzero(S, sizeof(S));
+	explicit_bzero(out, sizeof(out));
+}
+#endif
+
+/*
+ * The implementation to use, and how many lanes it processes at once.
+ * These start out as the portable fallback and are upgraded, if the
+ * CPU allows, when the library is loaded.
+ */
+static void (*SHA512_Transform_MB_impl)(uint64_t[][8],
+    const unsigned char * const *, size_t) = SHA512_Transform_MB_generic;
+static size_t SHA512_Transform_MB_nlanes = 1;
+
+#if defined HAVE_X86_TARGET_AVX2 || defined HAVE_X86_TARGET_AVX512F
+CPU_DISPATCH(SHA512_Transform_MB_select)
+
+static void
+SHA512_Transform_MB_select(void)
+{
+
+	SHA512_Transform_MB_impl = SHA512_Transform_MB_generic;
+	SHA512_Transform_MB_nlanes = 1;
+#ifdef HAVE_X86_TARGET_AVX512F
+	if (cpu_supports(CPU_AVX512F)) {
+		SHA512_Transform_MB_impl = SHA512_Transform_MB_avx512;
+		SHA512_Transform_MB_nlanes = 8;
+		return;
+	}
+#endif
+#ifdef HAVE_X86_TARGET_AVX2
+	if (cpu_supports(CPU_AVX2)) {
+		SHA512_Transform_MB_impl = SHA512_Transform_MB_avx2;
+		SHA512_Transform_MB_nlanes = 4;
+	}
+#endif
+}
+#endif
+
+void
+SHA512_Transform_MB(uint64_t states[][8],
+    const unsigned char * const * blocks, size_t nlanes)
+{
+
+	if (nlanes > 0)
+		SHA512_Transform_MB_impl(states, blocks, nlanes);
+}
+
+size_t
+SHA512_Transform_MB_lanes(void)
+{
+
+	return SHA512_Transform_MB_nlanes;
+}
+
 static const unsigned char PAD[SHA512_BLOCK_LENGTH] = {
 	0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
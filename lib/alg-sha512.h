@@ -39,6 +39,8 @@
 #define SHA512_Final libcperciva_SHA512_Final
 #define SHA512_Buf libcperciva_SHA512_Buf
 #define SHA512_CTX libcperciva_SHA512_CTX
+#define SHA512_Transform_MB libcperciva_SHA512_Transform_MB
+#define SHA512_Transform_MB_lanes libcperciva_SHA512_Transform_MB_lanes
 
 /* Common constants. */
 #define SHA512_BLOCK_LENGTH 128
@@ -78,4 +80,26 @@ extern void SHA512_Final(unsigned char[MIN_SIZE(SHA512_DIGEST_LENGTH)],
 extern void SHA512_Buf(const void *, size_t,
     unsigned char[MIN_SIZE(SHA512_DIGEST_LENGTH)]);
 
+/* Largest number of lanes accepted by SHA512_Transform_MB. */
+#define SHA512_MB_MAX_LANES 8
+
+/**
+ * SHA512_Transform_MB(states, blocks, nlanes):
+ * Apply the SHA512 block compression function to ${nlanes} independent
+ * states, where ${states}[i] is transformed via the block ${blocks}[i].
+ * This is equivalent to ${nlanes} separate calls to the compression
+ * function, but uses SIMD instructions to process several lanes in
+ * parallel when the CPU supports them.  ${nlanes} must be at most
+ * SHA512_MB_MAX_LANES.
+ */
+extern void SHA512_Transform_MB(uint64_t[][8],
+    const unsigned char * const *, size_t);
+
+/**
+ * SHA512_Transform_MB_lanes():
+ * Return the number of lanes that SHA512_Transform_MB processes in
+ * parallel on this CPU; 1 if it has no SIMD implementation to use.
+ */
+extern size_t SHA512_Transform_MB_lanes(void);
+
 #endif /* !_SHA512_H_ */
@@ -446,6 +446,9 @@ uint8_t *yescrypt_r(const yescrypt_shared_t *shared, yescrypt_local_t *local,
 	if (need > buflen || need < saltstrlen)
 		goto fail;
 
+	if (!params.NROM)
+		shared = NULL;
+
 	if (yescrypt_kdf(shared, local, passwd, passwdlen, salt, saltlen,
 	    &params, hashbin, sizeof(hashbin)))
 		goto fail;
@@ -0,0 +1,15 @@
+/* yescrypt_kdf compiled for XOP; see alg-yescrypt-opt.c.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.  */
+
+#ifndef __XOP__
+#error "This file must be compiled with XOP enabled"
+#endif
+
+#define YESCRYPT_KDF_VARIANT yescrypt_kdf_xop
+#include "alg-yescrypt-opt.c"
@@ -58,6 +58,15 @@
 #endif
 #endif
 
+/*
+ * Which of the above is used is normally decided by the compiler options.
+ * To make the best choice at runtime instead, this file is also compiled
+ * by alg-yescrypt-opt-*.c with YESCRYPT_KDF_VARIANT defined to the name
+ * that yescrypt_kdf() should have in that build.  Those builds only
+ * provide that one function; yescrypt_kdf() itself, built the normal way,
+ * calls the best variant supported by the CPU.
+ */
+
 /*
  * The SSE4 code version has fewer instructions than the generic SSE2 version,
  * but all of the instructions are SIMD, thereby wasting the scalar execution
@@ -98,8 +107,6 @@
 #define YESCRYPT_INTERNAL
 #include "alg-yescrypt.h"
 
-#include "alg-yescrypt-platform.c"
-
 #if __STDC_VERSION__ >= 199901L
 /* Have restrict */
 #elif defined(__GNUC__)
@@ -576,6 +583,15 @@ static volatile uint64_t Smask2var = Smask2;
 }
 #endif
 
+/*
+ * Each PWXFORM_SIMD is one 128-bit lane.  Putting two lanes in each
+ * 256-bit AVX2 register, so that the multiply, add and XOR cover both,
+ * was tried and was about 1.4 times slower on an AVX-512 capable Xeon
+ * (N=1024 r=8 and N=4096 r=32): pwxform is latency-bound, and getting
+ * the S-box indices out of the upper halves lengthens every round.
+ * Fetching all four lanes' S-box entries with AVX-512 gathers was about
+ * 2.8 times slower.
+ */
 #define PWXFORM_ROUND \
 	PWXFORM_SIMD(X0) \
 	PWXFORM_SIMD(X1) \
@@ -1030,26 +1046,98 @@ static uint64_t p2floor(uint64_t x)
 	return x;
 }
 
+/*
+ * Arguments of smix() shared by all of its lanes, for smix_lane1() and
+ * smix_lane2() below.  XY_per_lane is set when XY has room for p lanes,
+ * so that the lanes can be computed concurrently.
+ */
+typedef struct {
+	uint8_t *B;
+	size_t r;
+	uint32_t N, p;
+	yescrypt_flags_t flags;
+	salsa20_blk_t *V;
+	uint32_t NROM;
+	const salsa20_blk_t *VROM;
+	salsa20_blk_t *XY;
+	uint8_t *S, *passwd;
+	uint32_t Nchunk;
+	uint64_t Nloop_all, Nloop_rw;
+	int XY_per_lane;
+} smix_args_t;
+
+/*
+ * First loop of smix() for lane i: initialize its S-boxes if needed, then
+ * run SMix1 and the read-write part of SMix2 on its own chunk of V.
+ */
+static void smix_lane1(void *args, uint32_t i)
+{
+	const smix_args_t *a = args;
+	size_t r = a->r, s = 2 * r;
+	uint32_t Vchunk = i * a->Nchunk;
+	uint32_t Np = (i < a->p - 1) ? a->Nchunk : (a->N - Vchunk);
+	uint8_t *Bp = &a->B[128 * r * i];
+	salsa20_blk_t *Vp = &a->V[Vchunk * s];
+	salsa20_blk_t *XYp = a->XY_per_lane ? &a->XY[i * (2 * s)] : a->XY;
+	pwxform_ctx_t *ctx_i = NULL;
+	if (a->flags & YESCRYPT_RW) {
+		uint8_t *Si = a->S + i * Salloc;
+		smix1(Bp, 1, Sbytes / 128, 0 /* no flags */,
+		    (salsa20_blk_t *)Si, 0, NULL, XYp, NULL);
+		ctx_i = (pwxform_ctx_t *)(Si + Sbytes);
+		ctx_i->S2 = Si;
+		ctx_i->S1 = Si + Sbytes / 3;
+		ctx_i->S0 = Si + Sbytes / 3 * 2;
+		ctx_i->w = 0;
+		if (i == 0)
+			HMAC_SHA256_Buf(Bp + (128 * r - 64), 64,
+			    a->passwd, 32, a->passwd);
+	}
+	smix1(Bp, r, Np, a->flags, Vp, a->NROM, a->VROM, XYp, ctx_i);
+	smix2(Bp, r, p2floor(Np), a->Nloop_rw, a->flags, Vp,
+	    a->NROM, a->VROM, XYp, ctx_i);
+}
+
+/*
+ * Second loop of smix() for lane i: the read-only part of SMix2, over all
+ * of V.  This must not start until smix_lane1() has finished for all lanes.
+ */
+static void smix_lane2(void *args, uint32_t i)
+{
+	const smix_args_t *a = args;
+	size_t r = a->r, s = 2 * r;
+	uint8_t *Bp = &a->B[128 * r * i];
+	salsa20_blk_t *XYp = a->XY_per_lane ? &a->XY[i * (2 * s)] : a->XY;
+	pwxform_ctx_t *ctx_i = NULL;
+	if (a->flags & YESCRYPT_RW) {
+		uint8_t *Si = a->S + i * Salloc;
+		ctx_i = (pwxform_ctx_t *)(Si + Sbytes);
+	}
+	smix2(Bp, r, a->N, a->Nloop_all - a->Nloop_rw,
+	    a->flags & (yescrypt_flags_t)~YESCRYPT_RW,
+	    a->V, a->NROM, a->VROM, XYp, ctx_i);
+}
+
 /**
- * smix(B, r, N, p, t, flags, V, NROM, VROM, XY, S, passwd):
+ * smix(B, r, N, p, t, flags, V, NROM, VROM, XY, S, passwd, nthreads):
  * Compute B = SMix_r(B, N).  The input B must be 128rp bytes in length; the
  * temporary storage V must be 128rN bytes in length; the temporary storage
  * XY must be 256r or 256rp bytes in length (the larger size is required with
- * OpenMP-enabled builds).  N must be a power of 2 and at least 4.  The array V
- * must be aligned to a multiple of 64 bytes, and arrays B and XY to a multiple
- * of at least 16 bytes (aligning them to 64 bytes as well saves cache lines
- * and helps avoid false sharing in OpenMP-enabled builds when p > 1, but it
- * might also result in cache bank conflicts).
+ * OpenMP-enabled builds, or if nthreads > 1).  N must be a power of 2 and at
+ * least 4.  The array V must be aligned to a multiple of 64 bytes, and arrays
+ * B and XY to a multiple of at least 16 bytes (aligning them to 64 bytes as
+ * well saves cache lines and helps avoid false sharing in OpenMP-enabled
+ * builds when p > 1, but it might also result in cache bank conflicts).
+ * Without OpenMP, the p lanes are computed on up to nthreads threads.
  */
 static void smix(uint8_t *B, size_t r, uint32_t N, uint32_t p, uint32_t t,
     yescrypt_flags_t flags,
     salsa20_blk_t *V, uint32_t NROM, const salsa20_blk_t *VROM,
-    salsa20_blk_t *XY, uint8_t *S, uint8_t *passwd)
+    salsa20_blk_t *XY, uint8_t *S, uint8_t *passwd, uint32_t nthreads)
 {
-	size_t s = 2 * r;
+	smix_args_t a;
 	uint32_t Nchunk;
 	uint64_t Nloop_all, Nloop_rw;
-	uint32_t i;
 
 	Nchunk = N / p;
 	Nloop_all = Nchunk;
@@ -1077,63 +1165,32 @@ static void smix(uint8_t *B, size_t r, uint32_t N, uint32_t p, uint32_t t,
 	Nloop_all++; Nloop_all &= ~(uint64_t)1; /* round up to even */
 	Nloop_rw++; Nloop_rw &= ~(uint64_t)1; /* round up to even */
 
+	a.B = B; a.r = r; a.N = N; a.p = p; a.flags = flags;
+	a.V = V; a.NROM = NROM; a.VROM = VROM;
+	a.XY = XY; a.S = S; a.passwd = passwd;
+	a.Nchunk = Nchunk; a.Nloop_all = Nloop_all; a.Nloop_rw = Nloop_rw;
+
 #ifdef _OPENMP
-#pragma omp parallel if (p > 1) default(none) private(i) shared(B, r, N, p, flags, V, NROM, VROM, XY, S, passwd, s, Nchunk, Nloop_all, Nloop_rw)
+	(void)nthreads; /* unused */
+	a.XY_per_lane = 1;
+	uint32_t i;
+#pragma omp parallel if (p > 1) default(none) private(i) shared(a, p, Nloop_all, Nloop_rw)
 	{
 #pragma omp for
-#endif
-	for (i = 0; i < p; i++) {
-		uint32_t Vchunk = i * Nchunk;
-		uint32_t Np = (i < p - 1) ? Nchunk : (N - Vchunk);
-		uint8_t *Bp = &B[128 * r * i];
-		salsa20_blk_t *Vp = &V[Vchunk * s];
-#ifdef _OPENMP
-		salsa20_blk_t *XYp = &XY[i * (2 * s)];
-#else
-		salsa20_blk_t *XYp = XY;
-#endif
-		pwxform_ctx_t *ctx_i = NULL;
-		if (flags & YESCRYPT_RW) {
-			uint8_t *Si = S + i * Salloc;
-			smix1(Bp, 1, Sbytes / 128, 0 /* no flags */,
-			    (salsa20_blk_t *)Si, 0, NULL, XYp, NULL);
-			ctx_i = (pwxform_ctx_t *)(Si + Sbytes);
-			ctx_i->S2 = Si;
-			ctx_i->S1 = Si + Sbytes / 3;
-			ctx_i->S0 = Si + Sbytes / 3 * 2;
-			ctx_i->w = 0;
-			if (i == 0)
-				HMAC_SHA256_Buf(Bp + (128 * r - 64), 64,
-				    passwd, 32, passwd);
-		}
-		smix1(Bp, r, Np, flags, Vp, NROM, VROM, XYp, ctx_i);
-		smix2(Bp, r, p2floor(Np), Nloop_rw, flags, Vp,
-		    NROM, VROM, XYp, ctx_i);
-	}
+		for (i = 0; i < p; i++)
+			smix_lane1(&a, i);
 
-	if (Nloop_all > Nloop_rw) {
-#ifdef _OPENMP
+		if (Nloop_all > Nloop_rw) {
 #pragma omp for
-#endif
-		for (i = 0; i < p; i++) {
-			uint8_t *Bp = &B[128 * r * i];
-#ifdef _OPENMP
-			salsa20_blk_t *XYp = &XY[i * (2 * s)];
-#else
-			salsa20_blk_t *XYp = XY;
-#endif
-			pwxform_ctx_t *ctx_i = NULL;
-			if (flags & YESCRYPT_RW) {
-				uint8_t *Si = S + i * Salloc;
-				ctx_i = (pwxform_ctx_t *)(Si + Sbytes);
-			}
-			smix2(Bp, r, N, Nloop_all - Nloop_rw,
-                              flags & (yescrypt_flags_t)~YESCRYPT_RW,
-                              V, NROM, VROM, XYp, ctx_i);
+			for (i = 0; i < p; i++)
+				smix_lane2(&a, i);
 		}
 	}
-#ifdef _OPENMP
-	}
+#else
+	a.XY_per_lane = nthreads > 1;
+	run_lanes(smix_lane1, &a, p, nthreads);
+	if (Nloop_all > Nloop_rw)
+		run_lanes(smix_lane2, &a, p, nthreads);
 #endif
 }
 
@@ -1169,8 +1226,10 @@ static int yescrypt_kdf_body(const yescrypt_shared_t *shared,
 	size_t B_size, V_size, XY_size, need;
 	uint8_t *B, *S;
 	salsa20_blk_t *V, *XY;
+	HMAC_SHA256_CTX Phctx;
 	uint8_t sha256[32];
 	uint8_t dk[sizeof(sha256)], *dkp = buf;
+	uint32_t nthreads = 1;
 
 	/* Sanity-check parameters */
 	switch (flags & YESCRYPT_MODE_MASK) {
@@ -1225,6 +1284,16 @@ static int yescrypt_kdf_body(const yescrypt_shared_t *shared,
 	}
 #endif
 
+	/*
+	 * The lanes of YESCRYPT_RW can use more threads if the application
+	 * allows it.  For the other modes that would need p times the memory.
+	 */
+	if ((flags & YESCRYPT_RW) && p > 1) {
+		uint32_t max_threads = lane_threads();
+		if (max_threads > 1)
+			nthreads = max_threads < p ? max_threads : p;
+	}
+
 	VROM = NULL;
 	if (shared) {
 		uint64_t expected_size = (size_t)128 * r * NROM;
@@ -1270,9 +1339,10 @@ static int yescrypt_kdf_body(const yescrypt_shared_t *shared,
 	if (need < B_size)
 		goto out_EINVAL;
 	XY_size = (size_t)256 * r;
-#ifdef _OPENMP
-	XY_size *= p;
+#ifndef _OPENMP
+	if (nthreads > 1)
 #endif
+		XY_size *= p;
 	need += XY_size;
 	if (need < XY_size)
 		goto out_EINVAL;
@@ -1313,13 +1383,16 @@ static int yescrypt_kdf_body(const yescrypt_shared_t *shared,
 		passwdlen = sizeof(sha256);
 	}
 
-	PBKDF2_SHA256(passwd, passwdlen, salt, saltlen, 1, B, B_size);
+	HMAC_SHA256_Init(&Phctx, passwd, passwdlen);
+
+	PBKDF2_SHA256_HMAC(&Phctx, salt, saltlen, 1, B, B_size);
 
 	if (flags)
 		memcpy(sha256, B, sizeof(sha256));
 
 	if (p == 1 || (flags & YESCRYPT_RW)) {
-		smix(B, r, N, p, t, flags, V, NROM, VROM, XY, S, sha256);
+		smix(B, r, N, p, t, flags, V, NROM, VROM, XY, S, sha256,
+		    nthreads);
 	} else {
 		uint32_t i;
 #ifdef _OPENMP
@@ -1330,21 +1403,30 @@ static int yescrypt_kdf_body(const yescrypt_shared_t *shared,
 			smix(&B[(size_t)128 * r * i], r, N, 1, t, flags,
 			    &V[(size_t)2 * r * i * N],
 			    NROM, VROM,
-			    &XY[(size_t)4 * r * i], NULL, NULL);
+			    &XY[(size_t)4 * r * i], NULL, NULL, 1);
 #else
 			smix(&B[(size_t)128 * r * i], r, N, 1, t, flags, V,
-			    NROM, VROM, XY, NULL, NULL);
+			    NROM, VROM, XY, NULL, NULL, 1);
 #endif
 		}
 	}
 
+	/*
+	 * Except for classic scrypt, passwd is sha256, which has changed
+	 * since the first PBKDF2.  Either way, the remaining ones share a
+	 * key, so the HMAC is initialized for them only once.
+	 */
+	if (flags)
+		HMAC_SHA256_Init(&Phctx, passwd, passwdlen);
+
 	dkp = buf;
 	if (flags && buflen < sizeof(dk)) {
-		PBKDF2_SHA256(passwd, passwdlen, B, B_size, 1, dk, sizeof(dk));
+		PBKDF2_SHA256_HMAC(&Phctx, B, B_size, 1, dk, sizeof(dk));
 		dkp = dk;
 	}
 
-	PBKDF2_SHA256(passwd, passwdlen, B, B_size, 1, buf, buflen);
+	PBKDF2_SHA256_HMAC(&Phctx, B, B_size, 1, buf, buflen);
+	explicit_bzero(&Phctx, sizeof(Phctx));
 
 	/*
 	 * Except when computing classic scrypt, allow all computation so far
@@ -1384,6 +1466,21 @@ out_EINVAL:
 	return -1;
 }
 
+typedef int yescrypt_kdf_t(const yescrypt_shared_t *shared,
+    yescrypt_local_t *local,
+    const uint8_t *passwd, size_t passwdlen,
+    const uint8_t *salt, size_t saltlen,
+    const yescrypt_params_t *params,
+    uint8_t *buf, size_t buflen);
+
+#ifdef YESCRYPT_KDF_VARIANT
+#define YESCRYPT_KDF_IS_VARIANT 1
+yescrypt_kdf_t YESCRYPT_KDF_VARIANT;
+#else
+#define YESCRYPT_KDF_VARIANT yescrypt_kdf_generic
+static yescrypt_kdf_t YESCRYPT_KDF_VARIANT;
+#endif
+
 /**
  * yescrypt_kdf(shared, local, passwd, passwdlen, salt, saltlen, params,
  *     buf, buflen):
@@ -1391,7 +1488,8 @@ out_EINVAL:
  * to this function are the same as those for yescrypt_kdf_body() above, with
  * the addition of g, which controls hash upgrades (0 for no upgrades so far).
  */
-int yescrypt_kdf(const yescrypt_shared_t *shared, yescrypt_local_t *local,
+int YESCRYPT_KDF_VARIANT(const yescrypt_shared_t *shared,
+    yescrypt_local_t *local,
     const uint8_t *passwd, size_t passwdlen,
     const uint8_t *salt, size_t saltlen,
     const yescrypt_params_t *params,
@@ -1441,6 +1539,49 @@ int yescrypt_kdf(const yescrypt_shared_t *shared, yescrypt_local_t *local,
 	return retval;
 }
 
+#ifndef YESCRYPT_KDF_IS_VARIANT
+yescrypt_kdf_t yescrypt_kdf_sse2, yescrypt_kdf_avx, yescrypt_kdf_xop;
+
+static yescrypt_kdf_t *yescrypt_kdf_impl = yescrypt_kdf_generic;
+
+#if defined HAVE_YESCRYPT_SSE2 || defined HAVE_YESCRYPT_AVX || \
+    defined HAVE_YESCRYPT_XOP
+CPU_DISPATCH(yescrypt_kdf_select)
+
+static void
+yescrypt_kdf_select(void)
+{
+
+	yescrypt_kdf_impl = yescrypt_kdf_generic;
+#ifdef HAVE_YESCRYPT_XOP
+	if (cpu_supports(CPU_XOP)) {
+		yescrypt_kdf_impl = yescrypt_kdf_xop;
+		return;
+	}
+#endif
+#ifdef HAVE_YESCRYPT_AVX
+	if (cpu_supports(CPU_AVX)) {
+		yescrypt_kdf_impl = yescrypt_kdf_avx;
+		return;
+	}
+#endif
+#ifdef HAVE_YESCRYPT_SSE2
+	if (cpu_supports(CPU_SSE2))
+		yescrypt_kdf_impl = yescrypt_kdf_sse2;
+#endif
+}
+#endif
+
+int yescrypt_kdf(const yescrypt_shared_t *shared, yescrypt_local_t *local,
+    const uint8_t *passwd, size_t passwdlen,
+    const uint8_t *salt, size_t saltlen,
+    const yescrypt_params_t *params,
+    uint8_t *buf, size_t buflen)
+{
+	return yescrypt_kdf_impl(shared, local, passwd, passwdlen,
+	    salt, saltlen, params, buf, buflen);
+}
+
 int yescrypt_init_shared(yescrypt_shared_t *shared,
     const uint8_t *seed, size_t seedlen,
     const yescrypt_params_t *params)
@@ -1555,4 +1696,16 @@ int yescrypt_free_local(yescrypt_local_t *local)
 	return free_region(local);
 }
 
+int yescrypt_init_local_cached(yescrypt_local_t *local)
+{
+	init_region_cached(local);
+	return 0;
+}
+
+int yescrypt_free_local_cached(yescrypt_local_t *local)
+{
+	return free_region_cached(local);
+}
+#endif /* !YESCRYPT_KDF_IS_VARIANT */
+
 #endif /* INCLUDE_yescrypt || INCLUDE_scrypt || INCLUDE_gost_yescrypt */
@@ -59,10 +59,7 @@ extern int crypto_scrypt(const uint8_t *passwd, size_t passwdlen,
  * Use yescrypt_shared_t and yescrypt_local_t as appropriate instead, since
  * they might differ from each other in a future version.
  */
-typedef struct {
-	void *base, *aligned;
-	size_t base_size, aligned_size;
-} yescrypt_region_t;
+typedef struct memory_region yescrypt_region_t;
 
 /**
  * Types for shared (ROM) and thread-local (RAM) data structures.
@@ -214,6 +211,49 @@ extern int yescrypt_init_local(yescrypt_local_t *local);
  */
 extern int yescrypt_free_local(yescrypt_local_t *local);
 
+/**
+ * yescrypt_init_local_cached(local):
+ * Like yescrypt_init_local(), but hand over the memory that the calling
+ * thread kept from a previous yescrypt_free_local_cached(), if any, so that
+ * a hash needing no more than that does not have to allocate it again.
+ *
+ * Return 0 on success; or -1 on error.
+ *
+ * MT-safe as long as local is local to the thread.
+ */
+extern int yescrypt_init_local_cached(yescrypt_local_t *local);
+
+/**
+ * yescrypt_free_local_cached(local):
+ * Like yescrypt_free_local(), but if the CRYPT_TUNE_KEEP_MEMORY tunable
+ * allows it, zeroize the memory and keep it for the calling thread's next
+ * yescrypt_init_local_cached() instead of freeing it.  Kept memory is freed
+ * when the thread exits.
+ *
+ * Return 0 on success; or -1 on error.
+ *
+ * MT-safe as long as local is local to the thread.
+ */
+extern int yescrypt_free_local_cached(yescrypt_local_t *local);
+
+/**
+ * yescrypt_rom_acquire():
+ * Return the ROM loaded with crypt_rom_load(), or NULL if there is none.  The
+ * ROM stays mapped, even if another one is loaded meanwhile, until it is
+ * passed to yescrypt_rom_release().
+ *
+ * MT-safe.
+ */
+extern const yescrypt_shared_t *yescrypt_rom_acquire(void);
+
+/**
+ * yescrypt_rom_release(shared):
+ * Release a ROM returned by yescrypt_rom_acquire().  shared may be NULL.
+ *
+ * MT-safe.
+ */
+extern void yescrypt_rom_release(const yescrypt_shared_t *shared);
+
 /**
  * yescrypt_kdf(shared, local, passwd, passwdlen, salt, saltlen, params,
  *     buf, buflen):
@@ -261,8 +301,9 @@ extern int yescrypt_kdf(const yescrypt_shared_t *shared,
 /**
  * yescrypt_r(shared, local, passwd, passwdlen, setting, key, buf, buflen):
  * Compute and encode an scrypt or enhanced scrypt hash of passwd given the
- * parameters and salt value encoded in setting.  If shared is not NULL, a ROM
- * is used and YESCRYPT_RW is required.  Otherwise, whether to compute classic
+ * parameters and salt value encoded in setting.  If shared is not NULL and
+ * setting specifies NROM, a ROM is used and YESCRYPT_RW is required; shared is
+ * ignored for settings without NROM.  Otherwise, whether to compute classic
  * scrypt, YESCRYPT_WORM (a slight deviation from classic scrypt), or
  * YESCRYPT_RW (time-memory tradeoff discouraging modification) is determined
  * by the setting string.  shared (if not NULL) and local must be initialized
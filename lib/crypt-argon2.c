@@ -0,0 +1,267 @@
+/* Argon2id hashes in the PHC string format.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   Hashes look like
+
+     $argon2id$v=19$m=65536,t=3,p=4$<salt>$<tag>
+
+   as produced by the reference implementation and most others, where
+   M is the memory in KiB, T the number of passes and P the number of
+   lanes, and the salt and the tag are in the standard base64 alphabet
+   without padding.  Only version 19 (0x13) is supported.  The tag is
+   as long as that of the hash being checked, or 32 bytes when
+   hashing with a bare setting.  */
+
+#include "crypt-port.h"
+
+#if INCLUDE_argon2id
+
+#include "alg-argon2.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#define ARGON2ID_PREFIX      "$argon2id$v=19$"
+#define ARGON2ID_PREFIX_LEN  (sizeof ARGON2ID_PREFIX - 1)
+#define ARGON2ID_MAX_SALT    64
+#define ARGON2ID_MAX_TAG     64
+#define ARGON2ID_DEFAULT_TAG 32
+
+/* crypt_gensalt's count is the base-2 logarithm of the memory in KiB;
+   the number of passes and lanes are those of RFC 9106's second
+   recommended option.  */
+#define ARGON2ID_MIN_COUNT     10
+#define ARGON2ID_MAX_COUNT     22
+#define ARGON2ID_DEFAULT_COUNT 16
+#define ARGON2ID_PASSES        3u
+#define ARGON2ID_LANES         4u
+
+/* For use in scratch space by crypt_argon2id_rn().  */
+typedef struct
+{
+  argon2_local_t local;
+  uint8_t salt[ARGON2ID_MAX_SALT];
+  uint8_t tag[ARGON2ID_MAX_TAG];
+  uint8_t outbuf[CRYPT_OUTPUT_SIZE];
+} crypt_argon2id_internal_t;
+
+static_assert (sizeof (crypt_argon2id_internal_t) <= ALG_SPECIFIC_SIZE,
+               "ALG_SPECIFIC_SIZE is too small for Argon2id.");
+const size_t crypt_argon2id_scratch_size = sizeof (crypt_argon2id_internal_t);
+
+static const char b64_std[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int
+b64_value (char c)
+{
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A';
+  if (c >= 'a' && c <= 'z')
+    return c - 'a' + 26;
+  if (c >= '0' && c <= '9')
+    return c - '0' + 52;
+  if (c == '+')
+    return 62;
+  if (c == '/')
+    return 63;
+  return -1;
+}
+
+/* Decode the base64 text at SRC, up to the first character outside
+   the alphabet, into at most DSTMAX bytes at DST.  Returns the number
+   of characters consumed and sets *DSTLEN, or returns 0 if the text
+   is too long or not the canonical encoding of some bytes.  */
+static size_t
+decode_b64 (uint8_t *dst, size_t dstmax, size_t *dstlen, const char *src)
+{
+  uint32_t acc = 0;
+  unsigned int bits = 0;
+  size_t n = 0, i;
+  int v;
+
+  for (i = 0; (v = b64_value (src[i])) >= 0; i++)
+    {
+      acc = (acc << 6) | (uint32_t) v;
+      bits += 6;
+      if (bits >= 8)
+        {
+          bits -= 8;
+          if (n == dstmax)
+            return 0;
+          dst[n++] = (uint8_t) (acc >> bits);
+        }
+    }
+  /* A single leftover character, or leftover bits that are not zero,
+     would not be produced by encode_b64.  */
+  if (bits >= 6 || (acc & ((1u << bits) - 1)))
+    return 0;
+  *dstlen = n;
+  return i;
+}
+
+static char *
+encode_b64 (char *dst, const uint8_t *src, size_t srclen)
+{
+  uint32_t acc = 0;
+  unsigned int bits = 0;
+
+  for (size_t i = 0; i < srclen; i++)
+    {
+      acc = (acc << 8) | src[i];
+      bits += 8;
+      while (bits >= 6)
+        {
+          bits -= 6;
+          *dst++ = b64_std[(acc >> bits) & 0x3f];
+        }
+    }
+  if (bits > 0)
+    *dst++ = b64_std[(acc << (6 - bits)) & 0x3f];
+  *dst = '\0';
+  return dst;
+}
+
+/* Parse the decimal number at *P, which must be written without
+   leading zeros and fit in 32 bits, followed by the character END.  */
+static bool
+parse_param (const char **p, char end, uint32_t *value)
+{
+  const char *s = *p;
+  unsigned long n = 0;
+
+  if (*s < '0' || *s > '9' || (s[0] == '0' && s[1] != end))
+    return false;
+  for (; *s >= '0' && *s <= '9'; s++)
+    {
+      n = n * 10 + (unsigned long) (*s - '0');
+      if (n > UINT32_MAX)
+        return false;
+    }
+  if (*s != end)
+    return false;
+  *value = (uint32_t) n;
+  *p = s + 1;
+  return true;
+}
+
+void
+crypt_argon2id_rn (const char *phrase, size_t phr_size,
+                   const char *setting, size_t ARG_UNUSED (set_size),
+                   uint8_t *output, size_t o_size,
+                   void *scratch, size_t s_size)
+{
+  crypt_argon2id_internal_t *intbuf = scratch;
+  uint32_t m_cost, t_cost, lanes;
+  size_t saltlen, taglen = ARGON2ID_DEFAULT_TAG, n;
+  const char *p;
+
+  if (s_size < sizeof (crypt_argon2id_internal_t))
+    {
+      errno = ERANGE;
+      return;
+    }
+
+  if (strncmp (setting, ARGON2ID_PREFIX, ARGON2ID_PREFIX_LEN))
+    {
+      errno = EINVAL;
+      return;
+    }
+  p = setting + ARGON2ID_PREFIX_LEN;
+  if (strncmp (p, "m=", 2))
+    goto invalid;
+  p += 2;
+  if (!parse_param (&p, ',', &m_cost) || strncmp (p, "t=", 2))
+    goto invalid;
+  p += 2;
+  if (!parse_param (&p, ',', &t_cost) || strncmp (p, "p=", 2))
+    goto invalid;
+  p += 2;
+  if (!parse_param (&p, '$', &lanes))
+    goto invalid;
+
+  n = decode_b64 (intbuf->salt, sizeof intbuf->salt, &saltlen, p);
+  if (!n || saltlen < ARGON2_MIN_SALT)
+    goto invalid;
+  p += n;
+  size_t prefix_len = (size_t) (p - setting);
+
+  /* An existing tag determines the length of the new one.  */
+  if (*p == '$')
+    {
+      n = decode_b64 (intbuf->tag, sizeof intbuf->tag, &taglen, p + 1);
+      if (!n || p[1 + n] != '\0' || taglen < ARGON2_MIN_OUTLEN)
+        goto invalid;
+    }
+  else if (*p != '\0')
+    goto invalid;
+
+  if (prefix_len + 1 + BASE64_LEN (taglen) + 1 > MIN (o_size,
+                                                      sizeof intbuf->outbuf))
+    {
+      errno = ERANGE;
+      return;
+    }
+
+  init_region_cached (&intbuf->local);
+  int r = argon2id_hash (t_cost, m_cost, lanes,
+                         (const uint8_t *) phrase, phr_size,
+                         intbuf->salt, saltlen, NULL, 0, NULL, 0,
+                         intbuf->tag, taglen, &intbuf->local);
+  free_region_cached (&intbuf->local);
+  if (r)
+    return;
+
+  memcpy (intbuf->outbuf, setting, prefix_len);
+  intbuf->outbuf[prefix_len] = '$';
+  encode_b64 ((char *) intbuf->outbuf + prefix_len + 1, intbuf->tag, taglen);
+  strcpy_or_abort (output, o_size, intbuf->outbuf);
+  return;
+
+invalid:
+  errno = EINVAL;
+}
+
+void
+gensalt_argon2id_rn (unsigned long count,
+                     const uint8_t *rbytes, size_t nrbytes,
+                     uint8_t *output, size_t o_size)
+{
+  char outbuf[CRYPT_GENSALT_OUTPUT_SIZE];
+
+  /* RFC 9106 recommends 128-bit salts; up to 256 bits are used.  */
+  if (nrbytes < 16)
+    {
+      errno = EINVAL;
+      return;
+    }
+  nrbytes = MIN (nrbytes, 32);
+
+  if (count == 0)
+    count = ARGON2ID_DEFAULT_COUNT;
+  if (count < ARGON2ID_MIN_COUNT || count > ARGON2ID_MAX_COUNT)
+    {
+      errno = EINVAL;
+      return;
+    }
+
+  int len = snprintf (outbuf, sizeof outbuf,
+                      ARGON2ID_PREFIX "m=%lu,t=%u,p=%u$",
+                      1UL << count, ARGON2ID_PASSES, ARGON2ID_LANES);
+  if (len < 0 || (size_t) len + BASE64_LEN (nrbytes) + 1 > sizeof outbuf
+      || (size_t) len + BASE64_LEN (nrbytes) + 1 > o_size)
+    {
+      errno = ERANGE;
+      return;
+    }
+  encode_b64 (outbuf + len, rbytes, nrbytes);
+  strcpy_or_abort (output, o_size, outbuf);
+}
+
+#endif /* INCLUDE_argon2id */
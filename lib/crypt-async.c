@@ -0,0 +1,453 @@
+/* Hashing passphrases on background threads.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   crypt_submit puts a request on a queue, from which a pool of worker
+   threads takes requests in order and hashes them with crypt_rn.
+   Finished requests are moved to a second list, and a file descriptor
+   that the application can wait on becomes readable.  crypt_poll,
+   called by the application, typically from its event loop, takes
+   finished requests off that list and calls their completion
+   functions on the calling thread.
+
+   Workers are started as requests arrive, up to CRYPT_TUNE_ASYNC_THREADS
+   of them, and then stay until the library is unloaded, after which
+   crypt_submit fails with ECANCELED.  The number of requests that have
+   been submitted but not yet returned by crypt_poll is limited by
+   CRYPT_TUNE_ASYNC_QUEUE; beyond that, crypt_submit fails with EAGAIN,
+   so that a flood of requests cannot use unbounded memory or delay
+   every answer indefinitely.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#include <signal.h>
+#endif
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+
+#if INCLUDE_crypt_submit || INCLUDE_crypt_poll || INCLUDE_crypt_async_fd
+#ifdef HAVE_PTHREADS
+#define HAVE_ASYNC 1
+
+struct async_req
+{
+  struct async_req *next;
+  struct crypt_data *data;
+  void (*done) (struct crypt_data *, int, void *);
+  void *arg;
+  int err;
+};
+
+/* Everything below is protected by LOCK.  NQUEUED is the length of
+   the queue, and OUTSTANDING counts requests anywhere between
+   crypt_submit and crypt_poll.  NOTIFY_FD[0] is the end that
+   crypt_async_fd returns and that is drained, NOTIFY_FD[1] the end
+   that is written to; with an eventfd they are the same.  */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work = PTHREAD_COND_INITIALIZER;
+static struct async_req *queue_head, **queue_tail = &queue_head;
+static struct async_req *done_head, **done_tail = &done_head;
+static long nqueued, outstanding;
+static unsigned int nworkers, nidle;
+static pthread_t workers[MAX_LANE_THREADS];
+static int notify_fd[2] = { -1, -1 };
+static bool stopping, atfork_registered;
+
+static void
+free_list (struct async_req *req)
+{
+  while (req)
+    {
+      struct async_req *next = req->next;
+      free (req);
+      req = next;
+    }
+}
+
+/* Make NOTIFY_FD readable.  Called with LOCK held, only when the list
+   of finished requests becomes non-empty.  */
+static void
+notify (void)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  uint64_t one = 1;
+#else
+  char one = 1;
+#endif
+  ssize_t rv;
+  do
+    rv = write (notify_fd[1], &one, sizeof one);
+  while (rv < 0 && errno == EINTR);
+}
+
+/* Make NOTIFY_FD unreadable again.  Called with LOCK held, when the
+   list of finished requests has been emptied.  */
+static void
+drain (void)
+{
+  char buf[16];
+  ssize_t rv;
+  do
+    rv = read (notify_fd[0], buf, sizeof buf);
+  while (rv > 0 || (rv < 0 && errno == EINTR));
+}
+
+/* Create NOTIFY_FD, if that has not been done yet.  Called with LOCK
+   held.  Returns 0 on success, or -1 with errno set.  */
+static int
+open_notify_fd (void)
+{
+  if (notify_fd[0] >= 0)
+    return 0;
+
+#ifdef HAVE_SYS_EVENTFD_H
+  int fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (fd < 0)
+    return -1;
+  notify_fd[0] = notify_fd[1] = fd;
+#else
+  int fds[2];
+  if (pipe (fds))
+    return -1;
+  for (int i = 0; i < 2; i++)
+    if (fcntl (fds[i], F_SETFD, FD_CLOEXEC)
+        || fcntl (fds[i], F_SETFL, O_NONBLOCK))
+      {
+        int err = errno;
+        close (fds[0]);
+        close (fds[1]);
+        errno = err;
+        return -1;
+      }
+  notify_fd[0] = fds[0];
+  notify_fd[1] = fds[1];
+#endif
+  return 0;
+}
+
+static void
+close_notify_fd (void)
+{
+  if (notify_fd[0] < 0)
+    return;
+  if (notify_fd[1] != notify_fd[0])
+    close (notify_fd[1]);
+  close (notify_fd[0]);
+  notify_fd[0] = notify_fd[1] = -1;
+}
+
+static void *
+worker (void *unused)
+{
+  (void) unused;
+
+  pthread_mutex_lock (&lock);
+  for (;;)
+    {
+      while (!queue_head && !stopping)
+        {
+          nidle++;
+          pthread_cond_wait (&work, &lock);
+          nidle--;
+        }
+      if (stopping)
+        break;
+
+      struct async_req *req = queue_head;
+      queue_head = req->next;
+      if (!queue_head)
+        queue_tail = &queue_head;
+      nqueued--;
+      pthread_mutex_unlock (&lock);
+
+      struct crypt_data *data = req->data;
+      errno = 0;
+      if (crypt_rn (data->input, data->setting, data, (int) sizeof *data))
+        req->err = 0;
+      else
+        req->err = errno ? errno : EINVAL;
+      explicit_bzero (data->input, sizeof data->input);
+
+      pthread_mutex_lock (&lock);
+      req->next = 0;
+      *done_tail = req;
+      done_tail = &req->next;
+      if (done_head == req)
+        notify ();
+    }
+  pthread_mutex_unlock (&lock);
+  return 0;
+}
+
+/* Start one more worker.  Called with LOCK held.  */
+static int
+start_worker (void)
+{
+  /* The workers are ours; make sure none of the application's signals
+     are delivered to them.  */
+  sigset_t all, saved;
+  sigfillset (&all);
+  pthread_sigmask (SIG_SETMASK, &all, &saved);
+  int rv = pthread_create (&workers[nworkers], 0, worker, 0);
+  pthread_sigmask (SIG_SETMASK, &saved, 0);
+  if (rv)
+    return rv;
+  nworkers++;
+  return 0;
+}
+
+/* Hold LOCK across fork, so that the child gets the lists and counters
+   in a consistent state, not half-way through a change made by a
+   worker or by another thread of the application.  */
+static void
+atfork_prepare (void)
+{
+  pthread_mutex_lock (&lock);
+}
+
+static void
+atfork_parent (void)
+{
+  pthread_mutex_unlock (&lock);
+}
+
+/* In the child of a fork, only the thread that called fork exists,
+   and it holds LOCK.  Forget the workers and every request: the ones
+   in flight will never finish, and the ones already finished belong
+   to the parent.  The notification descriptor is shared with the
+   parent, so the child gets a new one when it next needs it.  */
+static void
+atfork_child (void)
+{
+  free_list (queue_head);
+  free_list (done_head);
+  queue_head = done_head = 0;
+  queue_tail = &queue_head;
+  done_tail = &done_head;
+  nqueued = outstanding = 0;
+  nworkers = nidle = 0;
+  close_notify_fd ();
+  pthread_cond_init (&work, 0);
+  pthread_mutex_unlock (&lock);
+}
+
+/* Stop the workers when the library is unloaded or the program exits.
+   Requests that are still queued are dropped; the ones in progress
+   are finished first.  Afterward, crypt_submit fails with ECANCELED,
+   as another destructor or atexit handler might still call it.  */
+static void __attribute__ ((destructor))
+stop_workers (void)
+{
+  pthread_mutex_lock (&lock);
+  stopping = true;
+  pthread_cond_broadcast (&work);
+  pthread_mutex_unlock (&lock);
+
+  for (unsigned int i = 0; i < nworkers; i++)
+    pthread_join (workers[i], 0);
+
+  pthread_mutex_lock (&lock);
+  free_list (queue_head);
+  free_list (done_head);
+  queue_head = done_head = 0;
+  queue_tail = &queue_head;
+  done_tail = &done_head;
+  nqueued = outstanding = 0;
+  nworkers = nidle = 0;
+  close_notify_fd ();
+  pthread_mutex_unlock (&lock);
+}
+
+#endif /* HAVE_PTHREADS */
+#endif /* INCLUDE_crypt_submit || INCLUDE_crypt_poll || ... */
+
+#if INCLUDE_crypt_submit
+int
+crypt_submit (const char *phrase, const char *setting,
+              struct crypt_data *data,
+              void (*done) (struct crypt_data *, int, void *), void *arg)
+{
+  if (!phrase || !setting || !data || !done)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  size_t phr_size = strlen (phrase);
+  size_t set_size = strlen (setting);
+  if (phr_size >= sizeof data->input)
+    {
+      errno = ERANGE;
+      return -1;
+    }
+  if (set_size >= sizeof data->setting)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+#ifdef HAVE_ASYNC
+  struct async_req *req = malloc (sizeof *req);
+  if (!req)
+    return -1;
+  req->next = 0;
+  req->data = data;
+  req->done = done;
+  req->arg = arg;
+  req->err = 0;
+
+  pthread_mutex_lock (&lock);
+  if (stopping)
+    {
+      pthread_mutex_unlock (&lock);
+      free (req);
+      errno = ECANCELED;
+      return -1;
+    }
+  if (outstanding >= get_tunable (CRYPT_TUNE_ASYNC_QUEUE))
+    {
+      pthread_mutex_unlock (&lock);
+      free (req);
+      errno = EAGAIN;
+      return -1;
+    }
+  if (open_notify_fd ())
+    {
+      int err = errno;
+      pthread_mutex_unlock (&lock);
+      free (req);
+      errno = err;
+      return -1;
+    }
+  if (!atfork_registered)
+    {
+      if (pthread_atfork (atfork_prepare, atfork_parent, atfork_child))
+        {
+          pthread_mutex_unlock (&lock);
+          free (req);
+          errno = ENOMEM;
+          return -1;
+        }
+      atfork_registered = true;
+    }
+
+  /* Every request waiting in the queue should have an idle worker to
+     take it, as long as the limit allows.  If no worker can be
+     started at all, the request could never finish.  */
+  long max_workers = get_tunable (CRYPT_TUNE_ASYNC_THREADS);
+  if (max_workers == 0)
+    {
+      max_workers = sysconf (_SC_NPROCESSORS_ONLN);
+      max_workers = MAX (1, MIN (max_workers, MAX_LANE_THREADS));
+    }
+  if (nqueued >= (long) nidle && nworkers < (unsigned long) max_workers)
+    {
+      int rv = start_worker ();
+      if (rv && nworkers == 0)
+        {
+          pthread_mutex_unlock (&lock);
+          free (req);
+          errno = rv;
+          return -1;
+        }
+    }
+
+  /* The passphrase and setting are copied only now, so that a failed
+     call leaves DATA as it was.  They may already be in DATA.  */
+  if (phrase != data->input)
+    memcpy (data->input, phrase, phr_size + 1);
+  if (setting != data->setting)
+    memcpy (data->setting, setting, set_size + 1);
+
+  *queue_tail = req;
+  queue_tail = &req->next;
+  nqueued++;
+  outstanding++;
+  pthread_cond_signal (&work);
+  pthread_mutex_unlock (&lock);
+  return 0;
+#else
+  (void) arg;
+  errno = ENOTSUP;
+  return -1;
+#endif
+}
+SYMVER_crypt_submit;
+#endif
+
+#if INCLUDE_crypt_poll
+int
+crypt_poll (int max)
+{
+  if (max < 1)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+#ifdef HAVE_ASYNC
+  struct async_req *list, *req;
+  int n = 0;
+
+  /* Take the requests off the list first, and call their completion
+     functions without holding the lock, so that those can submit
+     more requests.  */
+  pthread_mutex_lock (&lock);
+  list = done_head;
+  for (req = done_head; req && n < max; req = req->next)
+    {
+      n++;
+      done_head = req->next;
+    }
+  if (!done_head)
+    {
+      done_tail = &done_head;
+      if (n)
+        drain ();
+    }
+  outstanding -= n;
+  pthread_mutex_unlock (&lock);
+
+  for (int i = 0; i < n; i++)
+    {
+      req = list;
+      list = req->next;
+      req->done (req->data, req->err, req->arg);
+      free (req);
+    }
+  return n;
+#else
+  return 0;
+#endif
+}
+SYMVER_crypt_poll;
+#endif
+
+#if INCLUDE_crypt_async_fd
+int
+crypt_async_fd (void)
+{
+#ifdef HAVE_ASYNC
+  pthread_mutex_lock (&lock);
+  int rv = open_notify_fd ();
+  int fd = notify_fd[0];
+  pthread_mutex_unlock (&lock);
+  return rv ? -1 : fd;
+#else
+  errno = ENOTSUP;
+  return -1;
+#endif
+}
+SYMVER_crypt_async_fd;
+#endif
@@ -715,10 +715,26 @@ struct BF_buffer
 static_assert (sizeof (struct BF_buffer) <= ALG_SPECIFIC_SIZE,
                "ALG_SPECIFIC_SIZE is too small for bcrypt");
 
+#if INCLUDE_bcrypt
+const size_t crypt_bcrypt_scratch_size = sizeof (struct BF_buffer);
+#endif
+#if INCLUDE_bcrypt_a
+const size_t crypt_bcrypt_a_scratch_size = sizeof (struct BF_buffer);
+#endif
+#if INCLUDE_bcrypt_x
+const size_t crypt_bcrypt_x_scratch_size = sizeof (struct BF_buffer);
+#endif
+#if INCLUDE_bcrypt_y
+const size_t crypt_bcrypt_y_scratch_size = sizeof (struct BF_buffer);
+#endif
+
 
+/* Parse SETTING, which must ask for at least MIN iterations, and run the
+   key setup of bcrypt for KEY up to, but not including, the expensive
+   loop.  Store the number of iterations of that loop in *COUNTP.  */
 static bool
-BF_crypt (const char *key, const char *setting, unsigned char *output,
-          struct BF_data *data, BF_word min)
+BF_prepare (const char *key, const char *setting,
+            struct BF_data *data, BF_word min, BF_word *countp)
 {
   BF_word L, R;
   BF_word tmp1, tmp2, tmp3, tmp4;
@@ -781,6 +797,20 @@ BF_crypt (const char *key, const char *setting, unsigned char *output,
     }
   while (ptr < &data->ctx.S[3][0xFF]);
 
+  *countp = count;
+  return true;
+}
+
+/* Mix the expanded key and the salt back into the state, COUNT times.
+   This is where bcrypt spends nearly all of its time.  */
+static void
+BF_expand (struct BF_data *data, BF_word count)
+{
+  BF_word L, R;
+  BF_word tmp1, tmp2, tmp3, tmp4;
+  BF_word *ptr;
+  int i;
+
   do
     {
       int done;
@@ -816,6 +846,17 @@ BF_crypt (const char *key, const char *setting, unsigned char *output,
       while (1);
     }
   while (--count);
+}
+
+/* Encrypt the magic string with the final state and write the complete
+   hash for SETTING to OUTPUT.  */
+static void
+BF_finish (const char *setting, unsigned char *output, struct BF_data *data)
+{
+  BF_word L, R;
+  BF_word tmp1, tmp2, tmp3, tmp4;
+  BF_word count;
+  int i;
 
   for (i = 0; i < 6; i += 2)
     {
@@ -844,10 +885,130 @@ BF_crypt (const char *key, const char *setting, unsigned char *output,
   BF_swap (data->binary.output, 6);
   BF_encode (&output[BF_SETTING_LENGTH], data->binary.output, 23);
   output[BF_HASH_LENGTH - 1] = '\0';
+}
 
+static bool
+BF_crypt (const char *key, const char *setting, unsigned char *output,
+          struct BF_data *data, BF_word min)
+{
+  BF_word count;
+
+  if (!BF_prepare (key, setting, data, min, &count))
+    return false;
+  BF_expand (data, count);
+  BF_finish (setting, output, data);
   return true;
 }
 
+/*
+ * The loop in BF_expand is a chain of dependent S-box lookups, so a single
+ * hash cannot keep the CPU busy.  When several passphrases are hashed at once
+ * with the same cost, BF_expand_x runs the loop for BF_X of them together,
+ * interleaving their rounds so that the lookups of one lane overlap with
+ * those of the others.  Each lane has its own state.
+ */
+#define BF_X 4
+
+#define BF_F(c, x) \
+        ((((c)->S[0][(x) >> 24] + (c)->S[1][((x) >> 16) & 0xFF]) ^ \
+          (c)->S[2][((x) >> 8) & 0xFF]) + (c)->S[3][(x) & 0xFF])
+
+/* Apply OP to each lane K, which names its variables with a K suffix.  */
+#define BF_EACH(op, A, B, N) \
+        op(0, A, B, N) op(1, A, B, N) op(2, A, B, N) op(3, A, B, N)
+
+#define BF_XOR_P(k, A, B, N)    A##k ^= c##k->P[N];
+#define BF_ROUND_X(k, A, B, N)  B##k ^= BF_F(c##k, A##k) ^ c##k->P[(N) + 1];
+#define BF_SWAP_X(k, A, B, N) \
+        tmp##k = B##k; B##k = A##k; A##k = tmp##k ^ c##k->P[N];
+#define BF_STORE_X(k, A, B, N) \
+        p##k[N] = A##k; p##k[(N) + 1] = B##k;
+
+#define BF_ENCRYPT_X \
+        BF_EACH(BF_XOR_P, L, R, 0) \
+        BF_EACH(BF_ROUND_X, L, R, 0) \
+        BF_EACH(BF_ROUND_X, R, L, 1) \
+        BF_EACH(BF_ROUND_X, L, R, 2) \
+        BF_EACH(BF_ROUND_X, R, L, 3) \
+        BF_EACH(BF_ROUND_X, L, R, 4) \
+        BF_EACH(BF_ROUND_X, R, L, 5) \
+        BF_EACH(BF_ROUND_X, L, R, 6) \
+        BF_EACH(BF_ROUND_X, R, L, 7) \
+        BF_EACH(BF_ROUND_X, L, R, 8) \
+        BF_EACH(BF_ROUND_X, R, L, 9) \
+        BF_EACH(BF_ROUND_X, L, R, 10) \
+        BF_EACH(BF_ROUND_X, R, L, 11) \
+        BF_EACH(BF_ROUND_X, L, R, 12) \
+        BF_EACH(BF_ROUND_X, R, L, 13) \
+        BF_EACH(BF_ROUND_X, L, R, 14) \
+        BF_EACH(BF_ROUND_X, R, L, 15) \
+        BF_EACH(BF_SWAP_X, L, R, BF_N + 1)
+
+/* Same as BF_body for each of the lanes.  */
+static void
+BF_body_x (BF_ctx *c0, BF_ctx *c1, BF_ctx *c2, BF_ctx *c3)
+{
+  BF_word L0 = 0, L1 = 0, L2 = 0, L3 = 0;
+  BF_word R0 = 0, R1 = 0, R2 = 0, R3 = 0;
+  BF_word tmp0, tmp1, tmp2, tmp3;
+  BF_word *p0 = c0->P, *p1 = c1->P, *p2 = c2->P, *p3 = c3->P;
+  unsigned int i;
+
+  for (i = 0; i < BF_N + 2; i += 2)
+    {
+      BF_ENCRYPT_X;
+      BF_EACH(BF_STORE_X, L, R, i)
+    }
+
+  p0 = c0->S[0];
+  p1 = c1->S[0];
+  p2 = c2->S[0];
+  p3 = c3->S[0];
+  for (i = 0; i < 4 * 0x100; i += 2)
+    {
+      BF_ENCRYPT_X;
+      BF_EACH(BF_STORE_X, L, R, i)
+    }
+}
+
+/* Same as BF_expand for each of the BF_X lanes in DATA, all of which
+   must have the same COUNT.  */
+static void
+BF_expand_x (struct BF_data *data[BF_X], BF_word count)
+{
+  unsigned int i, k;
+
+  do
+    {
+      for (k = 0; k < BF_X; k++)
+        for (i = 0; i < BF_N + 2; i++)
+          data[k]->ctx.P[i] ^= data[k]->expanded_key[i];
+
+      BF_body_x (&data[0]->ctx, &data[1]->ctx, &data[2]->ctx, &data[3]->ctx);
+
+      for (k = 0; k < BF_X; k++)
+        for (i = 0; i < BF_N + 2; i++)
+          data[k]->ctx.P[i] ^= data[k]->binary.salt[i & 3];
+
+      BF_body_x (&data[0]->ctx, &data[1]->ctx, &data[2]->ctx, &data[3]->ctx);
+    }
+  while (--count);
+}
+
+/* Subtypes that passed the self-test in this process, as bits indexed
+   by the subtype letter minus 'a'.  */
+static unsigned int BF_self_tests_passed;
+
+/* Overwrite the stack below the caller's frame, where BF_crypt kept
+   its sensitive data, in case the self-test was skipped.  */
+#define BF_CLEAN_STACK_SIZE 1024
+static NO_INLINE void
+BF_clean_stack (void)
+{
+  unsigned char buf[BF_CLEAN_STACK_SIZE];
+  explicit_bzero (buf, sizeof buf);
+}
+
 /*
  * Please preserve the runtime self-test.  It serves two purposes at once:
  *
@@ -866,33 +1027,24 @@ BF_crypt (const char *key, const char *setting, unsigned char *output,
  * computation is more reliable.
  *
  * The performance cost of this quick self-test is around 0.6% at the "$2a$08"
- * setting.
+ * setting, but around 6% at "$2a$04", so applications that use such low costs
+ * may choose to run it only once per subtype, with the CRYPT_TUNE_SELF_TEST
+ * tunable.  Callers also clean the stack explicitly, so that this does
+ * not depend on whether the self-test ran.
+ *
+ * BF_self_test must be called from the same scope as BF_crypt, see below.
+ * It returns false if the code for SUBTYPE is broken.
  */
-static void
-BF_full_crypt (const char *phrase, const char *setting,
-               uint8_t *output, size_t out_size,
-               void *scratch, size_t scr_size)
+static bool
+BF_self_test (char subtype, struct BF_buffer *buffer)
 {
-  /* This shouldn't ever happen, but...  */
-  if (out_size < BF_HASH_LENGTH || scr_size < sizeof (struct BF_buffer))
-    {
-      errno = ERANGE;
-      return;
-    }
-  struct BF_buffer *buffer = scratch;
-
-  /* Hash the supplied password */
-  if (!BF_crypt (phrase, setting, buffer->re_output, &buffer->data, 16))
-    return; /* errno has already been set */
-
-  /* Save and restore the current value of errno around the self-test.  */
-  int save_errno = errno;
-
-  /* Do a quick self-test.  It is important that we make both calls to
-     BF_crypt() from the same scope such that they likely use the same
-     stack locations, which makes the second call overwrite the first
-     call's sensitive data on the stack and makes it more likely that
-     any alignment related issues would be detected by the self-test.  */
+  /* The application may ask for each subtype to be self-tested only
+     once per process.  The caller cleans the stack either way.  */
+  unsigned int subtype_bit = 1u << (subtype - 'a');
+  if (get_tunable (CRYPT_TUNE_SELF_TEST) == CRYPT_SELF_TEST_ONCE
+      && (__atomic_load_n (&BF_self_tests_passed, __ATOMIC_RELAXED)
+          & subtype_bit))
+    return true;
 
   static const char test_key[] = "8b \xd0\xc1\xd2\xcf\xcc\xd8";
   static const char test_setting_init[] = "$2a$00$abcdefghijklmnopqrstuu";
@@ -904,12 +1056,12 @@ BF_full_crypt (const char *phrase, const char *setting,
   const char *test_hash = test_hashes[0];
   char test_setting[BF_SETTING_LENGTH];
   unsigned int flags = flags_by_subtype[(unsigned int) (unsigned char)
-                                                       setting[2] - 'a'];
+                                                       subtype - 'a'];
   bool ok;
 
   memcpy (test_setting, test_setting_init, BF_SETTING_LENGTH);
   test_hash = test_hashes[flags & 1];
-  test_setting[2] = setting[2];
+  test_setting[2] = subtype;
 
   memset (buffer->st_output, 0x55, sizeof buffer->st_output);
 
@@ -929,6 +1081,39 @@ BF_full_crypt (const char *phrase, const char *setting,
          !memcmp (ae, ye, sizeof (ae)) && !memcmp (ai, yi, sizeof (ai));
   }
 
+  if (ok)
+    __atomic_fetch_or (&BF_self_tests_passed, subtype_bit, __ATOMIC_RELAXED);
+  return ok;
+}
+
+static void
+BF_full_crypt (const char *phrase, const char *setting,
+               uint8_t *output, size_t out_size,
+               void *scratch, size_t scr_size)
+{
+  /* This shouldn't ever happen, but...  */
+  if (out_size < BF_HASH_LENGTH || scr_size < sizeof (struct BF_buffer))
+    {
+      errno = ERANGE;
+      return;
+    }
+  struct BF_buffer *buffer = scratch;
+
+  /* Hash the supplied password */
+  if (!BF_crypt (phrase, setting, buffer->re_output, &buffer->data, 16))
+    return; /* errno has already been set */
+
+  /* Save and restore the current value of errno around the self-test.  */
+  int save_errno = errno;
+
+  /* Do a quick self-test.  It is important that we make both calls to
+     BF_crypt() from the same scope such that they likely use the same
+     stack locations, which makes the second call overwrite the first
+     call's sensitive data on the stack and makes it more likely that
+     any alignment related issues would be detected by the self-test.
+     The self-test may be skipped, so clean the stack explicitly too.  */
+  bool ok = BF_self_test (setting[2], buffer);
+  BF_clean_stack ();
   if (!ok)
     {
       /* Self-test failed; pretend we don't support this hash type.  */
@@ -941,6 +1126,106 @@ BF_full_crypt (const char *phrase, const char *setting,
   memcpy (output, buffer->re_output, BF_HASH_LENGTH);
   errno = save_errno;
 }
+
+/* Scratch space for BF_full_crypt_batch.  */
+struct BF_batch_buffer
+{
+  struct BF_buffer lane[BF_X];
+  unsigned char re_output[CRYPT_BATCH_LANES][BF_HASH_LENGTH];
+};
+
+static_assert (sizeof (struct BF_batch_buffer) <= ALG_BATCH_SPECIFIC_SIZE,
+               "ALG_BATCH_SPECIFIC_SIZE is too small for bcrypt");
+
+/* Same as calling BF_full_crypt on each of LANES, all of which use the
+   same subtype, but runs the expensive loop for up to BF_X of them at
+   once.  Lanes are grouped in order; a lane whose cost differs from
+   the first in its group is hashed by itself.  */
+static void
+BF_full_crypt_batch (struct crypt_batch_lane *lanes, size_t nlanes,
+                     void *scratch, size_t scr_size)
+{
+  if (nlanes > CRYPT_BATCH_LANES
+      || scr_size < sizeof (struct BF_batch_buffer))
+    {
+      for (size_t l = 0; l < nlanes; l++)
+        BF_full_crypt (lanes[l].phrase, lanes[l].setting,
+                       lanes[l].output, lanes[l].out_size,
+                       scratch, scr_size);
+      return;
+    }
+
+  struct BF_batch_buffer *bb = scratch;
+  struct BF_data *data[BF_X];
+  BF_word count[BF_X];
+  size_t group[BF_X];
+  bool hashed[CRYPT_BATCH_LANES];
+  size_t l = 0, ng, k;
+
+  for (k = 0; k < BF_X; k++)
+    data[k] = &bb->lane[k].data;
+
+  while (l < nlanes)
+    {
+      ng = 0;
+      while (ng < BF_X && l < nlanes)
+        {
+          hashed[l] = false;
+          if (lanes[l].out_size < BF_HASH_LENGTH
+              || !BF_prepare (lanes[l].phrase, lanes[l].setting,
+                              data[ng], 16, &count[ng]))
+            {
+              l++;
+              continue;
+            }
+          hashed[l] = true;
+          if (ng > 0 && count[ng] != count[0])
+            {
+              BF_expand (data[ng], count[ng]);
+              BF_finish (lanes[l].setting, bb->re_output[l], data[ng]);
+              l++;
+              continue;
+            }
+          group[ng++] = l++;
+        }
+
+      if (ng == 1)
+        BF_expand (data[0], count[0]);
+      else if (ng > 1)
+        {
+          /* Fill the unused lanes with copies of the first one.  */
+          for (k = ng; k < BF_X; k++)
+            memcpy (data[k], data[0], sizeof (struct BF_data));
+          BF_expand_x (data, count[0]);
+        }
+
+      for (k = 0; k < ng; k++)
+        BF_finish (lanes[group[k]].setting, bb->re_output[group[k]],
+                   data[k]);
+    }
+
+  for (l = 0; l < nlanes && !hashed[l]; l++)
+    ;
+  if (l == nlanes)
+    return;
+
+  /* One self-test for the whole batch, from the same scope as the
+     hashing, as in BF_full_crypt.  BF_expand_x has a larger stack
+     frame than BF_crypt, so clean the stack explicitly too.  */
+  int save_errno = errno;
+  bool ok = BF_self_test (lanes[l].setting[2], &bb->lane[0]);
+  BF_clean_stack ();
+  if (!ok)
+    {
+      errno = EINVAL;
+      return;
+    }
+
+  for (l = 0; l < nlanes; l++)
+    if (hashed[l])
+      memcpy (lanes[l].output, bb->re_output[l], BF_HASH_LENGTH);
+  errno = save_errno;
+}
 #endif
 
 #if INCLUDE_bcrypt || INCLUDE_bcrypt_a || INCLUDE_bcrypt_y
@@ -990,6 +1275,13 @@ crypt_bcrypt_rn (const char *phrase, size_t ARG_UNUSED (phr_size),
   BF_full_crypt (phrase, setting, output, out_size, scratch, scr_size);
 }
 
+void
+crypt_bcrypt_batch_rn (struct crypt_batch_lane *lanes, size_t nlanes,
+                       void *scratch, size_t scr_size)
+{
+  BF_full_crypt_batch (lanes, nlanes, scratch, scr_size);
+}
+
 void
 gensalt_bcrypt_rn (unsigned long count,
                    const uint8_t *rbytes, size_t nrbytes,
@@ -1009,6 +1301,13 @@ crypt_bcrypt_a_rn (const char *phrase, size_t ARG_UNUSED (phr_size),
   BF_full_crypt (phrase, setting, output, out_size, scratch, scr_size);
 }
 
+void
+crypt_bcrypt_a_batch_rn (struct crypt_batch_lane *lanes, size_t nlanes,
+                         void *scratch, size_t scr_size)
+{
+  BF_full_crypt_batch (lanes, nlanes, scratch, scr_size);
+}
+
 void
 gensalt_bcrypt_a_rn (unsigned long count,
                      const uint8_t *rbytes, size_t nrbytes,
@@ -1028,6 +1327,13 @@ crypt_bcrypt_x_rn (const char *phrase, size_t ARG_UNUSED (phr_size),
   BF_full_crypt (phrase, setting, output, out_size, scratch, scr_size);
 }
 
+void
+crypt_bcrypt_x_batch_rn (struct crypt_batch_lane *lanes, size_t nlanes,
+                         void *scratch, size_t scr_size)
+{
+  BF_full_crypt_batch (lanes, nlanes, scratch, scr_size);
+}
+
 void
 gensalt_bcrypt_x_rn (ARG_UNUSED(unsigned long count),
                      ARG_UNUSED(const uint8_t *rbytes),
@@ -1051,6 +1357,13 @@ crypt_bcrypt_y_rn (const char *phrase, size_t ARG_UNUSED (phr_size),
   BF_full_crypt (phrase, setting, output, out_size, scratch, scr_size);
 }
 
+void
+crypt_bcrypt_y_batch_rn (struct crypt_batch_lane *lanes, size_t nlanes,
+                         void *scratch, size_t scr_size)
+{
+  BF_full_crypt_batch (lanes, nlanes, scratch, scr_size);
+}
+
 void
 gensalt_bcrypt_y_rn (unsigned long count,
                      const uint8_t *rbytes, size_t nrbytes,
@@ -0,0 +1,177 @@
+/* Preallocated working memory for the memory-hard hashing methods.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   A crypt_ctx owns one arena of memory, which crypt_ctx_new maps,
+   faults in, and optionally locks.  While a context is bound to a
+   thread with crypt_ctx_bind, yescrypt, gost-yescrypt, scrypt and
+   argon2id hashes computed on that thread take their working memory
+   from the arena, through ctx_arena_acquire, instead of mapping it
+   afresh, as long as the arena is big enough and not already in use
+   by another thread bound to the same context.  ctx_arena_release
+   erases the part of the arena that was used before the next hash
+   can have it.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+struct crypt_ctx
+{
+  struct memory_region arena;
+  long obtained;  /* CRYPT_MEMORY_* flags honored for the arena */
+  bool busy;      /* accessed atomically */
+};
+
+/* The context bound to each thread.  Before the first call to
+   crypt_ctx_bind, no thread has one, and there is no key to look
+   them up with.  */
+#ifdef HAVE_PTHREADS
+static pthread_key_t bound_key;
+static pthread_once_t bound_once = PTHREAD_ONCE_INIT;
+static bool bound_ok;
+
+static void
+bound_create (void)
+{
+  __atomic_store_n (&bound_ok, !pthread_key_create (&bound_key, NULL),
+                    __ATOMIC_RELEASE);
+}
+
+static struct crypt_ctx *
+bound_ctx (void)
+{
+  if (!__atomic_load_n (&bound_ok, __ATOMIC_ACQUIRE))
+    return NULL;
+  return pthread_getspecific (bound_key);
+}
+#else
+static struct crypt_ctx *bound;
+
+static struct crypt_ctx *
+bound_ctx (void)
+{
+  return bound;
+}
+#endif
+
+void *
+ctx_arena_acquire (size_t size)
+{
+  struct crypt_ctx *ctx = bound_ctx ();
+
+  if (!ctx || size > ctx->arena.aligned_size
+      || __atomic_exchange_n (&ctx->busy, true, __ATOMIC_ACQUIRE))
+    return NULL;
+  store_tunable (CRYPT_TUNE_MEMORY_OBTAINED, ctx->obtained);
+  return ctx->arena.aligned;
+}
+
+bool
+ctx_arena_release (void *mem, size_t size)
+{
+  struct crypt_ctx *ctx = bound_ctx ();
+
+  if (!ctx || !mem || mem != ctx->arena.aligned)
+    return false;
+  explicit_bzero (mem, size);
+  __atomic_store_n (&ctx->busy, false, __ATOMIC_RELEASE);
+  return true;
+}
+
+#if INCLUDE_crypt_ctx_new
+struct crypt_ctx *
+crypt_ctx_new (unsigned long max_mem, int flags)
+{
+  struct crypt_ctx *ctx;
+
+  if (max_mem == 0 || (flags & ~CRYPT_CTX_LOCK))
+    {
+      errno = EINVAL;
+      return NULL;
+    }
+  ctx = malloc (sizeof *ctx);
+  if (!ctx)
+    return NULL;
+
+  /* The arena is faulted in below whatever the policy says, so that
+     hashes never take a page fault on it; locking it does that as
+     well.  */
+  long policy = get_tunable (CRYPT_TUNE_MEMORY_POLICY)
+                & ~CRYPT_MEMORY_POPULATE;
+  long obtained = map_region (&ctx->arena, max_mem, policy);
+  if (obtained < 0)
+    {
+      free (ctx);
+      return NULL;
+    }
+  if (populate_region (&ctx->arena, flags & CRYPT_CTX_LOCK))
+    {
+      int err = errno;
+      unmap_region (&ctx->arena);
+      free (ctx);
+      errno = err;
+      return NULL;
+    }
+
+  ctx->obtained = obtained | CRYPT_MEMORY_POPULATE;
+  ctx->busy = false;
+  return ctx;
+}
+SYMVER_crypt_ctx_new;
+#endif
+
+#if INCLUDE_crypt_ctx_free
+void
+crypt_ctx_free (struct crypt_ctx *ctx)
+{
+  if (!ctx)
+    return;
+  if (bound_ctx () == ctx)
+    {
+#ifdef HAVE_PTHREADS
+      pthread_setspecific (bound_key, NULL);
+#else
+      bound = NULL;
+#endif
+    }
+  unmap_region (&ctx->arena);
+  free (ctx);
+}
+SYMVER_crypt_ctx_free;
+#endif
+
+#if INCLUDE_crypt_ctx_bind
+int
+crypt_ctx_bind (struct crypt_ctx *ctx)
+{
+#ifdef HAVE_PTHREADS
+  if (pthread_once (&bound_once, bound_create))
+    return -1;
+  if (!bound_ok)
+    {
+      errno = EAGAIN;
+      return -1;
+    }
+  int err = pthread_setspecific (bound_key, ctx);
+  if (err)
+    {
+      errno = err;
+      return -1;
+    }
+#else
+  bound = ctx;
+#endif
+  return 0;
+}
+SYMVER_crypt_ctx_bind;
+#endif
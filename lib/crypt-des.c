@@ -73,6 +73,16 @@ struct des_buffer
 static_assert (sizeof (struct des_buffer) <= ALG_SPECIFIC_SIZE,
                "ALG_SPECIFIC_SIZE is too small for DES");
 
+#if INCLUDE_descrypt
+const size_t crypt_descrypt_scratch_size = sizeof (struct des_buffer);
+#endif
+#if INCLUDE_bigcrypt
+const size_t crypt_bigcrypt_scratch_size = sizeof (struct des_buffer);
+#endif
+#if INCLUDE_bsdicrypt
+const size_t crypt_bsdicrypt_scratch_size = sizeof (struct des_buffer);
+#endif
+
 
 static inline int
 ascii_to_bin(char ch)
@@ -92,19 +102,11 @@ ascii_to_bin(char ch)
   return -1;
 }
 
-/* Generate an 11-character DES password hash into the buffer at
-   OUTPUT, and nul-terminate it.  The salt and key have already been
-   set.  The plaintext is 64 bits of zeroes, and the raw ciphertext is
-   written to cbuf[].  */
+/* Encode the raw ciphertext in CBUF as an 11-character DES password
+   hash into the buffer at OUTPUT, and nul-terminate it.  */
 static void
-des_gen_hash (struct des_ctx *ctx, uint32_t count, uint8_t *output,
-              uint8_t cbuf[8])
+des_encode_hash (const uint8_t cbuf[8], uint8_t *output)
 {
-  uint8_t plaintext[8];
-  memset (plaintext, 0, 8);
-  des_crypt_block (ctx, cbuf, plaintext, count, false);
-
-  /* Now encode the result.  */
   const uint8_t *sptr = cbuf;
   const uint8_t *end = sptr + 8;
   unsigned int c1, c2;
@@ -138,6 +140,58 @@ des_gen_hash (struct des_ctx *ctx, uint32_t count, uint8_t *output,
   while (end - sptr > 0);
   *output = '\0';
 }
+
+/* Generate an 11-character DES password hash into the buffer at
+   OUTPUT, and nul-terminate it.  The salt and key have already been
+   set.  The plaintext is 64 bits of zeroes, and the raw ciphertext is
+   written to cbuf[].  */
+static void
+des_gen_hash (struct des_ctx *ctx, uint32_t count, uint8_t *output,
+              uint8_t cbuf[8])
+{
+  uint8_t plaintext[8];
+  memset (plaintext, 0, 8);
+  des_crypt_block (ctx, cbuf, plaintext, count, false);
+  des_encode_hash (cbuf, output);
+}
+#endif
+
+#if INCLUDE_descrypt || INCLUDE_bigcrypt
+/* Decode the two-character salt at the beginning of SETTING into
+   *SALTP.  Returns false if SETTING does not begin with a valid salt.
+   Note: ascii_to_bin maps all byte values outside the ascii64
+   alphabet to -1.  Do not read past the end of the string.  */
+static bool
+des_trd_salt (const char *setting, uint32_t *saltp)
+{
+  int i;
+
+  i = ascii_to_bin (setting[0]);
+  if (i < 0)
+    return false;
+  *saltp = (unsigned int)i;
+  i = ascii_to_bin (setting[1]);
+  if (i < 0)
+    return false;
+  *saltp |= ((unsigned int)i << 6);
+  return true;
+}
+
+/* Copy the next 8 characters of the password at *PHRASEP into keybuf,
+   shifting each character up by 1 bit and padding on the right with
+   zeroes, and advance *PHRASEP past them.  */
+static void
+des_trd_key (uint8_t keybuf[8], const char **phrasep)
+{
+  const char *phrase = *phrasep;
+  for (int i = 0; i < 8; i++)
+    {
+      keybuf[i] = (uint8_t)(*phrase << 1);
+      if (*phrase)
+        phrase++;
+    }
+  *phrasep = phrase;
+}
 #endif
 
 #if INCLUDE_descrypt
@@ -160,25 +214,13 @@ crypt_descrypt_rn (const char *phrase, size_t ARG_UNUSED (phr_size),
   uint32_t salt = 0;
   uint8_t *keybuf = buf->keybuf, *pkbuf = buf->pkbuf;
   uint8_t *cp = output;
-  int i;
 
-  /* "old"-style: setting - 2 bytes of salt, phrase - up to 8 characters.
-     Note: ascii_to_bin maps all byte values outside the ascii64
-     alphabet to -1.  Do not read past the end of the string.  */
-  i = ascii_to_bin (setting[0]);
-  if (i < 0)
-    {
-      errno = EINVAL;
-      return;
-    }
-  salt = (unsigned int)i;
-  i = ascii_to_bin (setting[1]);
-  if (i < 0)
+  /* "old"-style: setting - 2 bytes of salt, phrase - up to 8 characters.  */
+  if (!des_trd_salt (setting, &salt))
     {
       errno = EINVAL;
       return;
     }
-  salt |= ((unsigned int)i << 6);
 
   /* Write the canonical form of the salt to the output buffer.  We do
      this instead of copying from the setting because the setting
@@ -188,15 +230,7 @@ crypt_descrypt_rn (const char *phrase, size_t ARG_UNUSED (phr_size),
   *cp++ = ascii64[salt & 0x3f];
   *cp++ = ascii64[(salt >> 6) & 0x3f];
 
-  /* Copy the first 8 characters of the password into keybuf, shifting
-     each character up by 1 bit and padding on the right with zeroes.  */
-  for (i = 0; i < 8; i++)
-    {
-      keybuf[i] = (uint8_t)(*phrase << 1);
-      if (*phrase)
-        phrase++;
-    }
-
+  des_trd_key (keybuf, &phrase);
   des_set_key (ctx, keybuf);
   des_set_salt (ctx, salt);
   des_gen_hash (ctx, 25, cp, pkbuf);
@@ -257,24 +291,15 @@ crypt_bigcrypt_rn (const char *phrase, size_t phr_size,
   uint32_t salt = 0;
   uint8_t *keybuf = buf->keybuf, *pkbuf = buf->pkbuf;
   uint8_t *cp = output;
-  int i, seg;
+  int seg;
 
   /* The setting string is exactly the same as for a traditional DES
      hash.  */
-  i = ascii_to_bin (setting[0]);
-  if (i < 0)
+  if (!des_trd_salt (setting, &salt))
     {
       errno = EINVAL;
       return;
     }
-  salt = (unsigned int)i;
-  i = ascii_to_bin (setting[1]);
-  if (i < 0)
-    {
-      errno = EINVAL;
-      return;
-    }
-  salt |= ((unsigned int)i << 6);
 
   *cp++ = ascii64[salt & 0x3f];
   *cp++ = ascii64[(salt >> 6) & 0x3f];
@@ -282,13 +307,7 @@ crypt_bigcrypt_rn (const char *phrase, size_t phr_size,
   for (seg = 0; seg < 16; seg++)
     {
       /* Copy and shift each block as for the traditional DES.  */
-      for (i = 0; i < 8; i++)
-        {
-          keybuf[i] = (uint8_t)(*phrase << 1);
-          if (*phrase)
-            phrase++;
-        }
-
+      des_trd_key (keybuf, &phrase);
       des_set_key (ctx, keybuf);
       des_set_salt (ctx, salt);
       des_gen_hash (ctx, 25, cp, pkbuf);
@@ -306,6 +325,64 @@ crypt_bigcrypt_rn (const char *phrase, size_t phr_size,
 #endif
 
 #if INCLUDE_bsdicrypt
+/* Decode the iteration count and salt of a BSD-style setting string
+   (underscore, 4 bytes of count, 4 bytes of salt) into *COUNTP and
+   *SALTP.  Returns false if they are not valid.  */
+static bool
+des_ext_setting (const char *setting, uint32_t *countp, uint32_t *saltp)
+{
+  uint32_t count = 0, salt = 0;
+  int i, x;
+
+  for (i = 1; i < 5; i++)
+    {
+      x = ascii_to_bin(setting[i]);
+      if (x < 0)
+        return false;
+      count |= (unsigned int)x << ((i - 1) * 6);
+    }
+
+  for (i = 5; i < 9; i++)
+    {
+      x = ascii_to_bin(setting[i]);
+      if (x < 0)
+        return false;
+      salt |= (unsigned int)x << ((i - 5) * 6);
+    }
+
+  *countp = count;
+  *saltp = salt;
+  return true;
+}
+
+/* Fold passwords longer than 8 bytes into a single DES key using a
+   procedure similar to a Merkle-Dåmgard hash construction.  Each
+   block is shifted and padded, as for the traditional hash, then
+   XORed with the output of the previous round (IV all bits zero),
+   set as the DES key, and encrypted to produce the round output.
+   The salt is zero throughout this procedure.  On return, CTX has
+   the folded key and a salt of zero.  */
+static void
+des_ext_key (struct des_ctx *ctx, uint8_t keybuf[8], uint8_t pkbuf[8],
+             const char *phrase)
+{
+  des_set_salt (ctx, 0);
+  memset (pkbuf, 0, 8);
+  for (;;)
+    {
+      for (int i = 0; i < 8; i++)
+        {
+          keybuf[i] = (uint8_t)(pkbuf[i] ^ (*phrase << 1));
+          if (*phrase)
+            phrase++;
+        }
+      des_set_key (ctx, keybuf);
+      if (*phrase == 0)
+        break;
+      des_crypt_block (ctx, pkbuf, keybuf, 1, false);
+    }
+}
+
 /* crypt_rn() entry point for BSD-style extended DES hashes.  These
    permit long passwords and have more salt and a controllable iteration
    count, but are still unacceptably weak by modern standards.  */
@@ -335,62 +412,288 @@ crypt_bsdicrypt_rn (const char *phrase, size_t ARG_UNUSED (phr_size),
   uint32_t count = 0, salt = 0;
   uint8_t *keybuf = buf->keybuf, *pkbuf = buf->pkbuf;
   uint8_t *cp = output;
-  int i, x;
 
   /* "new"-style DES hash:
    	setting - underscore, 4 bytes of count, 4 bytes of salt
    	phrase - unlimited characters
    */
-  for (i = 1; i < 5; i++)
+  if (!des_ext_setting (setting, &count, &salt))
     {
-      x = ascii_to_bin(setting[i]);
-      if (x < 0)
+      errno = EINVAL;
+      return;
+    }
+
+  memcpy (cp, setting, 9);
+  cp += 9;
+
+  des_ext_key (ctx, keybuf, pkbuf, phrase);
+
+  /* Proceed as for the traditional DES hash.  */
+  des_set_salt (ctx, salt);
+  des_gen_hash (ctx, count, cp, pkbuf);
+}
+#endif
+
+#if INCLUDE_descrypt || INCLUDE_bigcrypt || INCLUDE_bsdicrypt
+/* Batch entry points, for crypt_verify_many.  Each passphrase's key
+   schedule and salt are set up in a des_ctx of its own, just as for
+   the single-passphrase entry points, and then the DES encryptions are
+   done DES_BS_LANES at a time with the bitsliced engine in
+   alg-des-bitslice.c.  */
+
+/* One encryption of DES_BS_LANES blocks with the bitsliced engine
+   takes about as long as this many encryptions of a single block
+   with des_crypt_block, no matter how many of the lanes are in use.  */
+#define DES_BS_COST 14
+
+struct des_batch_buffer
+{
+  struct des_bs_ctx bs;
+  struct des_ctx ctx[DES_BS_LANES];
+  uint32_t count[DES_BS_LANES];
+  uint8_t *dest[DES_BS_LANES];
+  const char *phrase[DES_BS_LANES];
+  uint8_t cbuf[DES_BS_LANES][8];
+  uint8_t order[DES_BS_LANES];
+  uint8_t keybuf[8];
+  uint8_t pkbuf[8];
+};
+
+static_assert (sizeof (struct des_batch_buffer) <= ALG_BATCH_SPECIFIC_SIZE,
+               "ALG_BATCH_SPECIFIC_SIZE is too small for DES");
+static_assert (CRYPT_BATCH_LANES * CRYPT_OUTPUT_SIZE / CRYPT_WIDE_BATCH_LANES
+               >= MAX (DES_TRD_OUTPUT_LEN, DES_EXT_OUTPUT_LEN),
+               "CRYPT_WIDE_BATCH_LANES is too large for DES");
+
+/* Encrypt a block of zeroes buf->count[i] times with the key and salt
+   in buf->ctx[i], for each i less than N, and encode each result as
+   an 11-character hash at buf->dest[i].  */
+static void
+des_batch_run (struct des_batch_buffer *buf, unsigned int n)
+{
+  unsigned int i, j, k;
+
+  /* The bitsliced engine keeps going until its lane with the highest
+     count is done, so if the counts are very different it can be
+     quicker to leave some of them out.  Sort the lanes by count and
+     pass the first K of them to the engine, choosing K to minimize
+     the estimated total time.  */
+  for (i = 0; i < n; i++)
+    {
+      uint8_t x = (uint8_t)i;
+      for (j = i; j > 0 && buf->count[buf->order[j - 1]] > buf->count[x]; j--)
+        buf->order[j] = buf->order[j - 1];
+      buf->order[j] = x;
+    }
+
+  uint64_t serial = 0, best_cost;
+  for (i = 0; i < n; i++)
+    serial += MAX (buf->count[i], 1);
+  best_cost = serial;
+  k = 0;
+  for (i = 1; i <= n; i++)
+    {
+      uint32_t top = MAX (buf->count[buf->order[i - 1]], 1);
+      serial -= top;
+      uint64_t cost = (uint64_t) top * DES_BS_COST + serial;
+      if (cost < best_cost)
         {
-          errno = EINVAL;
-          return;
+          best_cost = cost;
+          k = i;
         }
-      count |= (unsigned int)x << ((i - 1) * 6);
     }
 
-  for (i = 5; i < 9; i++)
+  for (i = 0; i < k; i++)
+    des_bs_set_lane (&buf->bs, i, &buf->ctx[buf->order[i]],
+                     buf->count[buf->order[i]]);
+  if (k > 0)
+    des_bs_crypt_zero (&buf->bs, k, buf->cbuf);
+  for (i = 0; i < k; i++)
+    des_encode_hash (buf->cbuf[i], buf->dest[buf->order[i]]);
+
+  for (i = k; i < n; i++)
     {
-      x = ascii_to_bin(setting[i]);
-      if (x < 0)
+      j = buf->order[i];
+      des_gen_hash (&buf->ctx[j], buf->count[j], buf->dest[j], buf->cbuf[j]);
+    }
+}
+#endif
+
+#if INCLUDE_descrypt || INCLUDE_bigcrypt
+/* Set up lane N of BUF for the first (or only) block of a traditional
+   DES hash of LANE, exactly as crypt_descrypt_rn would, and write the
+   salt to LANE's output.  Returns false if LANE's setting is
+   invalid.  */
+static bool
+des_batch_add_trd (struct des_batch_buffer *buf, unsigned int n,
+                   const struct crypt_batch_lane *lane)
+{
+  uint32_t salt;
+  if (!des_trd_salt (lane->setting, &salt))
+    return false;
+
+  lane->output[0] = ascii64[salt & 0x3f];
+  lane->output[1] = ascii64[(salt >> 6) & 0x3f];
+
+  buf->phrase[n] = lane->phrase;
+  des_trd_key (buf->keybuf, &buf->phrase[n]);
+  des_set_key (&buf->ctx[n], buf->keybuf);
+  des_set_salt (&buf->ctx[n], salt);
+  buf->count[n] = 25;
+  buf->dest[n] = lane->output + 2;
+  return true;
+}
+#endif
+
+#if INCLUDE_descrypt
+void
+crypt_descrypt_batch_rn (struct crypt_batch_lane *lanes, size_t nlanes,
+                         void *scratch, size_t scr_size)
+{
+  /* This shouldn't ever happen, but...  */
+  if (scr_size < sizeof (struct des_batch_buffer))
+    {
+      errno = ERANGE;
+      return;
+    }
+
+  struct des_batch_buffer *buf = scratch;
+  unsigned int n = 0;
+
+  for (size_t l = 0; l < nlanes; l++)
+    {
+      if (lanes[l].out_size < DES_TRD_OUTPUT_LEN
+          || !des_batch_add_trd (buf, n, &lanes[l]))
+        continue;
+      if (++n == DES_BS_LANES)
         {
-          errno = EINVAL;
-          return;
+          des_batch_run (buf, n);
+          n = 0;
         }
-      salt |= (unsigned int)x << ((i - 5) * 6);
     }
+  if (n > 0)
+    des_batch_run (buf, n);
+}
+#endif
 
-  memcpy (cp, setting, 9);
-  cp += 9;
+#if INCLUDE_bigcrypt
+void
+crypt_bigcrypt_batch_rn (struct crypt_batch_lane *lanes, size_t nlanes,
+                         void *scratch, size_t scr_size)
+{
+  /* This shouldn't ever happen, but...  */
+  if (scr_size < sizeof (struct des_batch_buffer))
+    {
+      errno = ERANGE;
+      return;
+    }
 
-  /* Fold passwords longer than 8 bytes into a single DES key using a
-     procedure similar to a Merkle-Dåmgard hash construction.  Each
-     block is shifted and padded, as for the traditional hash, then
-     XORed with the output of the previous round (IV all bits zero),
-     set as the DES key, and encrypted to produce the round output.
-     The salt is zero throughout this procedure.  */
-  des_set_salt (ctx, 0);
-  memset (pkbuf, 0, 8);
-  for (;;)
+  struct des_batch_buffer *buf = scratch;
+  size_t l = 0;
+
+  while (l < nlanes)
     {
-      for (i = 0; i < 8; i++)
+      unsigned int n = 0;
+
+      /* The first block of every hash is computed exactly as for
+         descrypt.  */
+      for (; l < nlanes && n < DES_BS_LANES; l++)
         {
-          keybuf[i] = (uint8_t)(pkbuf[i] ^ (*phrase << 1));
-          if (*phrase)
-            phrase++;
+          const struct crypt_batch_lane *lane = &lanes[l];
+
+          /* See crypt_bigcrypt_rn for why short settings with long
+             phrases are special.  */
+          bool trd = lane->phr_size > 8 && lane->set_size <= 13;
+#if !INCLUDE_descrypt
+          if (trd)
+            continue;
+#endif
+          size_t out_len = trd ? DES_TRD_OUTPUT_LEN
+            : 2 + 11 * MIN (16, MAX (1, (lane->phr_size + 7) / 8)) + 1;
+
+          if (lane->out_size < out_len || !des_batch_add_trd (buf, n, lane))
+            continue;
+          if (trd)
+            buf->phrase[n] = "";
+          n++;
+        }
+
+      /* Each further block uses the first two characters of the
+         previous one as its salt, so all of the hashes advance by one
+         block at a time, and drop out of the group when they run out
+         of phrase.  */
+      for (int seg = 0; n > 0; seg++)
+        {
+          des_batch_run (buf, n);
+          if (seg == 15)
+            break;
+
+          unsigned int m = 0;
+          for (unsigned int i = 0; i < n; i++)
+            {
+              if (*buf->phrase[i] == '\0')
+                continue;
+
+              uint8_t *cp = buf->dest[i];
+              uint32_t salt = (unsigned int)ascii_to_bin ((char)cp[0]);
+              salt |= (unsigned int)ascii_to_bin ((char)cp[1]) << 6;
+
+              buf->phrase[m] = buf->phrase[i];
+              des_trd_key (buf->keybuf, &buf->phrase[m]);
+              des_set_key (&buf->ctx[m], buf->keybuf);
+              des_set_salt (&buf->ctx[m], salt);
+              buf->count[m] = 25;
+              buf->dest[m] = cp + 11;
+              m++;
+            }
+          n = m;
         }
-      des_set_key (ctx, keybuf);
-      if (*phrase == 0)
-        break;
-      des_crypt_block (ctx, pkbuf, keybuf, 1, false);
     }
+}
+#endif
 
-  /* Proceed as for the traditional DES hash.  */
-  des_set_salt (ctx, salt);
-  des_gen_hash (ctx, count, cp, pkbuf);
+#if INCLUDE_bsdicrypt
+void
+crypt_bsdicrypt_batch_rn (struct crypt_batch_lane *lanes, size_t nlanes,
+                          void *scratch, size_t scr_size)
+{
+  /* This shouldn't ever happen, but...  */
+  if (scr_size < sizeof (struct des_batch_buffer))
+    {
+      errno = ERANGE;
+      return;
+    }
+
+  struct des_batch_buffer *buf = scratch;
+  unsigned int n = 0;
+
+  for (size_t l = 0; l < nlanes; l++)
+    {
+      const struct crypt_batch_lane *lane = &lanes[l];
+      uint32_t count, salt;
+
+      if (lane->out_size < DES_EXT_OUTPUT_LEN
+          || *lane->setting != '_' || lane->set_size < 9
+          || !des_ext_setting (lane->setting, &count, &salt))
+        continue;
+
+      memcpy (lane->output, lane->setting, 9);
+
+      /* Only the iterated encryption is done in parallel; folding
+         the phrase into a key is cheap in comparison.  */
+      des_ext_key (&buf->ctx[n], buf->keybuf, buf->pkbuf, lane->phrase);
+      des_set_salt (&buf->ctx[n], salt);
+      buf->count[n] = count;
+      buf->dest[n] = lane->output + 9;
+
+      if (++n == DES_BS_LANES)
+        {
+          des_batch_run (buf, n);
+          n = 0;
+        }
+    }
+  if (n > 0)
+    des_batch_run (buf, n);
 }
 #endif
 
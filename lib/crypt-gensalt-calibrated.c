@@ -0,0 +1,321 @@
+/* Choosing the cost parameter of a new setting by measuring hashes.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   The COUNT argument of crypt_gensalt means something different for
+   every hashing method.  For the methods listed in cost_models, it
+   either scales the work linearly (an iteration count) or doubles it
+   at every step (a base-2 logarithm), and for some methods it also
+   determines the amount of memory a hash uses.  The functions here
+   find, by hashing a fixed passphrase with increasing counts, the
+   count whose hash takes as close to a requested time as possible
+   without going over it or over a memory budget, and remember it for
+   the rest of the process.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#if INCLUDE_crypt_gensalt_calibrated_rn || INCLUDE_crypt_gensalt_calibrated
+
+enum cost_kind
+{
+  COST_LINEAR,
+  COST_LOG2,
+};
+
+struct cost_model
+{
+  const char *prefix;
+  unsigned long min, max;
+  enum cost_kind kind;
+  /* If nonzero, a hash with count N uses 2**(N + MEM_SHIFT) bytes.  */
+  unsigned int mem_shift;
+};
+
+static const struct cost_model cost_models[] =
+{
+#if INCLUDE_bcrypt
+  { "$2b$", 4, 31, COST_LOG2, 0 },
+#endif
+#if INCLUDE_bcrypt_a
+  { "$2a$", 4, 31, COST_LOG2, 0 },
+#endif
+#if INCLUDE_bcrypt_y
+  { "$2y$", 4, 31, COST_LOG2, 0 },
+#endif
+#if INCLUDE_yescrypt
+  { "$y$", 1, 11, COST_LOG2, 19 },
+#endif
+#if INCLUDE_gost_yescrypt
+  { "$gy$", 1, 11, COST_LOG2, 19 },
+#endif
+#if INCLUDE_scrypt
+  { "$7$", 6, 11, COST_LOG2, 19 },
+#endif
+#if INCLUDE_argon2id
+  { "$argon2id$", 10, 22, COST_LOG2, 10 },
+#endif
+#if INCLUDE_sha512crypt
+  { "$6$", 1000, 999999999, COST_LINEAR, 0 },
+#endif
+#if INCLUDE_sha256crypt
+  { "$5$", 1000, 999999999, COST_LINEAR, 0 },
+#endif
+#if INCLUDE_sha1crypt
+  { "$sha1", 4, 0xffffffff, COST_LINEAR, 0 },
+#endif
+#if INCLUDE_sunmd5
+  { "$md5", 32768, 0xfffeffff, COST_LINEAR, 0 },
+#endif
+#if INCLUDE_bsdicrypt
+  { "_", 1, 0xffffff, COST_LINEAR, 0 },
+#endif
+  { 0, 0, 0, 0, 0 }
+};
+
+/* Counts found so far.  When the cache is full, the oldest entry is
+   replaced.  */
+struct cost_cache_entry
+{
+  const struct cost_model *model;
+  int msec;
+  unsigned long memory;
+  unsigned long count;
+};
+
+#define COST_CACHE_SIZE 16
+
+static struct cost_cache_entry cost_cache[COST_CACHE_SIZE];
+static unsigned int cost_cache_next;
+#ifdef HAVE_PTHREADS
+static pthread_mutex_t cost_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#define cost_cache_acquire() pthread_mutex_lock (&cost_cache_lock)
+#define cost_cache_release() pthread_mutex_unlock (&cost_cache_lock)
+#else
+#define cost_cache_acquire() ((void) 0)
+#define cost_cache_release() ((void) 0)
+#endif
+
+static const struct cost_model *
+find_cost_model (const char *prefix)
+{
+  const struct cost_model *m;
+  for (m = cost_models; m->prefix; m++)
+    if (!strncmp (prefix, m->prefix, strlen (m->prefix)))
+      return m;
+  return 0;
+}
+
+static uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+#ifdef CLOCK_MONOTONIC
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+#else
+  clock_gettime (CLOCK_REALTIME, &ts);
+#endif
+  return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/* Return the time, in nanoseconds, that a hash with MODEL and COUNT
+   takes, or 0 if it cannot be computed.  Hashes that are much shorter
+   than LIMIT are measured twice, and the shorter time is used, so that
+   a single interruption does not skew the result.  */
+static uint64_t
+time_hash (const struct cost_model *model, unsigned long count,
+           uint64_t limit, struct crypt_data *cd)
+{
+  static const char rbytes[64] = "calibration salt, not secret";
+  char setting[CRYPT_GENSALT_OUTPUT_SIZE];
+  uint64_t best = UINT64_MAX;
+
+  if (!crypt_gensalt_rn (model->prefix, count, rbytes, (int) sizeof rbytes,
+                         setting, (int) sizeof setting))
+    return 0;
+
+  for (int i = 0; i < 2; i++)
+    {
+      uint64_t start = now_ns ();
+      if (!crypt_rn ("calibration", setting, cd, (int) sizeof *cd))
+        return 0;
+      uint64_t elapsed = now_ns () - start;
+      best = MIN (best, MAX (elapsed, 1));
+      if (best >= limit / 4)
+        break;
+    }
+  return best;
+}
+
+static bool
+memory_fits (const struct cost_model *model, unsigned long count,
+             unsigned long memory)
+{
+  if (!memory || !model->mem_shift)
+    return true;
+  unsigned int shift = (unsigned int) count + model->mem_shift;
+  return shift < sizeof (unsigned long) * 8 && (1UL << shift) <= memory;
+}
+
+/* Find the count for MODEL whose hashes take at most MSEC
+   milliseconds and MEMORY bytes (0 meaning no limit), or 0 if no count
+   fits in MEMORY or hashing fails.  */
+static unsigned long
+calibrate (const struct cost_model *model, int msec, unsigned long memory)
+{
+  uint64_t target = (uint64_t) msec * 1000000u;
+  unsigned long count = model->min, best;
+  uint64_t t;
+
+  if (!memory_fits (model, count, memory))
+    {
+      errno = EINVAL;
+      return 0;
+    }
+
+  struct crypt_data *cd = calloc (1, sizeof *cd);
+  if (!cd)
+    return 0;
+
+  if (model->kind == COST_LOG2)
+    {
+      /* Every step doubles the time, so trying them in order costs
+         at most about twice the target.  The smallest count is used
+         even if it is too slow.  */
+      best = count;
+      while ((t = time_hash (model, count, target, cd)) != 0
+             && t <= target)
+        {
+          best = count;
+          if (count >= model->max || !memory_fits (model, count + 1, memory))
+            break;
+          count++;
+        }
+      if (!t)
+        best = 0;
+    }
+  else
+    {
+      /* Quadruple the count until a hash takes a good fraction of the
+         target, so that the measurement is precise enough, then scale
+         the count to the target.  */
+      while ((t = time_hash (model, count, target, cd)) != 0
+             && t < target / 4 && count < model->max)
+        count = count > model->max / 4 ? model->max : count * 4;
+      if (!t)
+        best = 0;
+      else
+        {
+          uint64_t scaled = (uint64_t) count * target / t;
+          best = (unsigned long) MAX (model->min, MIN (model->max, scaled));
+        }
+    }
+
+  explicit_bzero (cd, sizeof *cd);
+  free (cd);
+  return best;
+}
+
+/* Return the count for MODEL, MSEC and MEMORY, from the cache if it
+   has been found before.  */
+static unsigned long
+get_count (const struct cost_model *model, int msec, unsigned long memory)
+{
+  unsigned long count = 0;
+
+  cost_cache_acquire ();
+  for (size_t i = 0; i < COST_CACHE_SIZE; i++)
+    if (cost_cache[i].model == model && cost_cache[i].msec == msec
+        && cost_cache[i].memory == memory)
+      {
+        count = cost_cache[i].count;
+        break;
+      }
+  cost_cache_release ();
+  if (count)
+    return count;
+
+  /* The lock is not held while calibrating, which can take a while;
+     threads that calibrate the same thing at once all store their
+     results, which are equally good.  */
+  count = calibrate (model, msec, memory);
+  if (!count)
+    return 0;
+
+  cost_cache_acquire ();
+  struct cost_cache_entry *e = &cost_cache[cost_cache_next];
+  cost_cache_next = (cost_cache_next + 1) % COST_CACHE_SIZE;
+  e->model = model;
+  e->msec = msec;
+  e->memory = memory;
+  e->count = count;
+  cost_cache_release ();
+  return count;
+}
+
+#endif /* INCLUDE_crypt_gensalt_calibrated_rn || ... */
+
+#if INCLUDE_crypt_gensalt_calibrated_rn
+char *
+crypt_gensalt_calibrated_rn (const char *prefix, int msec,
+                             unsigned long memory,
+                             const char *rbytes, int nrbytes,
+                             char *output, int output_size)
+{
+  const struct cost_model *model;
+  unsigned long count = 0;
+
+  make_failure_token ("", output, output_size);
+  if (output_size < 3)
+    {
+      errno = ERANGE;
+      return 0;
+    }
+  if (!prefix)
+    prefix = crypt_preferred_method ();
+  if (!prefix || msec < 1)
+    {
+      errno = EINVAL;
+      return 0;
+    }
+
+  /* Methods with no cost parameter get their only setting.  */
+  model = find_cost_model (prefix);
+  if (model)
+    {
+      count = get_count (model, msec, memory);
+      if (!count)
+        return 0;
+    }
+
+  return crypt_gensalt_rn (prefix, count, rbytes, nrbytes,
+                           output, output_size);
+}
+SYMVER_crypt_gensalt_calibrated_rn;
+#endif
+
+#if INCLUDE_crypt_gensalt_calibrated
+char *
+crypt_gensalt_calibrated (const char *prefix, int msec, unsigned long memory,
+                          const char *rbytes, int nrbytes)
+{
+  char *output = thread_state_get (THREAD_STATE_GENSALT_CALIBRATED);
+  if (!output)
+    return 0;
+
+  return crypt_gensalt_calibrated_rn (prefix, msec, memory, rbytes, nrbytes,
+                                      output, CRYPT_GENSALT_OUTPUT_SIZE);
+}
+SYMVER_crypt_gensalt_calibrated;
+#endif
@@ -18,17 +18,20 @@
 
 /* The functions that use global state objects are isolated in their
    own files so that a statically-linked program that doesn't use them
-   will not have the state objects in its data segment.  */
+   will not have the state objects in its data segment.  The state
+   itself is per-thread, see util-thread-state.c.  */
 
 #if INCLUDE_crypt_gensalt
 char *
 crypt_gensalt (const char *prefix, unsigned long count,
                const char *rbytes, int nrbytes)
 {
-  static char output[CRYPT_GENSALT_OUTPUT_SIZE];
+  char *output = thread_state_get (THREAD_STATE_GENSALT);
+  if (!output)
+    return 0;
 
   return crypt_gensalt_rn (prefix, count,
-                           rbytes, nrbytes, output, sizeof (output));
+                           rbytes, nrbytes, output, CRYPT_GENSALT_OUTPUT_SIZE);
 }
 SYMVER_crypt_gensalt;
 #endif
@@ -47,16 +47,18 @@ typedef struct
 
 static_assert (sizeof (crypt_gost_yescrypt_internal_t) <= ALG_SPECIFIC_SIZE,
                "ALG_SPECIFIC_SIZE is too small for GOST-YESCRYPT.");
+const size_t crypt_gost_yescrypt_scratch_size =
+  sizeof (crypt_gost_yescrypt_internal_t);
 
 /*
  * As OUTPUT is initialized with a failure token before gensalt_yescrypt_rn
  * is called, in case of an error we could just set an appropriate errno
  * and return.
  */
-void
-gensalt_gost_yescrypt_rn (unsigned long count,
-                          const uint8_t *rbytes, size_t nrbytes,
-                          uint8_t *output, size_t o_size)
+static void
+gensalt_gost_yescrypt (unsigned long count, bool use_rom,
+                       const uint8_t *rbytes, size_t nrbytes,
+                       uint8_t *output, size_t o_size)
 {
   /* Up to 512 bits (64 bytes) of entropy for computing the salt portion
      of the MCF-setting are supported.  */
@@ -71,7 +73,10 @@ gensalt_gost_yescrypt_rn (unsigned long count,
 
   /* We pass 'o_size - 1' to gensalt, because we need to shift
            the prefix by 1 char to insert the gost marker.  */
-  gensalt_yescrypt_rn (count, rbytes, nrbytes, output, o_size - 1);
+  if (use_rom)
+    gensalt_yescrypt_rom_rn (count, rbytes, nrbytes, output, o_size - 1);
+  else
+    gensalt_yescrypt_rn (count, rbytes, nrbytes, output, o_size - 1);
 
   /* Check for failures.  */
   if (output[0] == '*')
@@ -84,6 +89,22 @@ gensalt_gost_yescrypt_rn (unsigned long count,
   output[1] = 'g';
 }
 
+void
+gensalt_gost_yescrypt_rn (unsigned long count,
+                          const uint8_t *rbytes, size_t nrbytes,
+                          uint8_t *output, size_t o_size)
+{
+  gensalt_gost_yescrypt (count, false, rbytes, nrbytes, output, o_size);
+}
+
+void
+gensalt_gost_yescrypt_rom_rn (unsigned long count,
+                              const uint8_t *rbytes, size_t nrbytes,
+                              uint8_t *output, size_t o_size)
+{
+  gensalt_gost_yescrypt (count, true, rbytes, nrbytes, output, o_size);
+}
+
 void
 crypt_gost_yescrypt_rn (const char *phrase, size_t phr_size,
                         const char *setting, size_t set_size,
@@ -107,7 +128,7 @@ crypt_gost_yescrypt_rn (const char *phrase, size_t phr_size,
 
   crypt_gost_yescrypt_internal_t *intbuf = scratch;
 
-  if (yescrypt_init_local (&intbuf->local))
+  if (yescrypt_init_local_cached (&intbuf->local))
     return;
 
   /* convert gost setting to yescrypt setting */
@@ -116,15 +137,17 @@ crypt_gost_yescrypt_rn (const char *phrase, size_t phr_size,
   intbuf->gsetting[2] = '$';
   strcpy_or_abort (&intbuf->gsetting[3], set_size - 3, setting + 4);
 
-  intbuf->retval = yescrypt_r (NULL, &intbuf->local,
+  const yescrypt_shared_t *rom = yescrypt_rom_acquire ();
+  intbuf->retval = yescrypt_r (rom, &intbuf->local,
                                (const uint8_t *) phrase, phr_size,
                                intbuf->gsetting, NULL,
                                intbuf->outbuf + 1, o_size - 1);
+  yescrypt_rom_release (rom);
 
   if (!intbuf->retval)
     errno = EINVAL;
 
-  if (yescrypt_free_local (&intbuf->local) || !intbuf->retval)
+  if (yescrypt_free_local_cached (&intbuf->local) || !intbuf->retval)
     return;
 
   intbuf->outbuf[0] = '$';
@@ -20,6 +20,7 @@
 
 #include "crypt-port.h"
 #include "alg-md5.h"
+#include "byteorder.h"
 
 #include <errno.h>
 
@@ -52,31 +53,17 @@ struct md5_buffer
 
 static_assert (sizeof (struct md5_buffer) <= ALG_SPECIFIC_SIZE,
                "ALG_SPECIFIC_SIZE is too small for MD5");
+const size_t crypt_md5crypt_scratch_size = sizeof (struct md5_buffer);
 
 
-/* This entry point is equivalent to the `crypt' function in Unix
-   libcs.  */
-void
-crypt_md5crypt_rn (const char *phrase, size_t phr_size,
-                   const char *setting, size_t ARG_UNUSED (set_size),
-                   uint8_t *output, size_t out_size,
-                   void *scratch, size_t scr_size)
+/* Subroutine of crypt_md5crypt_rn and crypt_md5crypt_batch_rn:
+   Find the salt in SETTING.  On success, store its start and length
+   in *SALTP and *SALT_SIZEP and return true.  */
+static bool
+md5_parse_salt (const char *setting, const char **saltp, size_t *salt_sizep)
 {
-  /* This shouldn't ever happen, but...  */
-  if (out_size < MD5_HASH_LENGTH || scr_size < sizeof (struct md5_buffer))
-    {
-      errno = ERANGE;
-      return;
-    }
-
-  struct md5_buffer *buf = scratch;
-  MD5_CTX *ctx = &buf->ctx;
-  uint8_t *result = buf->result;
-  char *cp = (char *)output;
   const char *salt = setting;
-
   size_t salt_size;
-  size_t cnt;
 
   /* Find beginning of salt string.  The prefix should normally always
      be present.  Just in case it is not.  */
@@ -91,15 +78,27 @@ crypt_md5crypt_rn (const char *phrase, size_t phr_size,
      be on a single line. */
   salt_size = strcspn (salt, "$:\n");
   if (!(salt[salt_size] == '$' || !salt[salt_size]))
-    {
-      errno = EINVAL;
-      return;
-    }
+    return false;
 
   /* Ensure we do not use more salt than SALT_LEN_MAX. */
   if (salt_size > SALT_LEN_MAX)
     salt_size = SALT_LEN_MAX;
 
+  *saltp = salt;
+  *salt_sizep = salt_size;
+  return true;
+}
+
+/* Subroutine of crypt_md5crypt_rn and crypt_md5crypt_batch_rn:
+   Compute the intermediate result that the rounds loop starts from,
+   and leave it in RESULT.  */
+static void
+md5_prepare (const char *phrase, size_t phr_size,
+             const char *salt, size_t salt_size,
+             MD5_CTX *ctx, uint8_t result[16])
+{
+  size_t cnt;
+
   /* Compute alternate MD5 sum with input PHRASE, SALT, and PHRASE.  The
      final result will be added to the first context.  */
   MD5_Init (ctx);
@@ -149,6 +148,79 @@ crypt_md5crypt_rn (const char *phrase, size_t phr_size,
 
   /* Create intermediate result.  */
   MD5_Final (result, ctx);
+}
+
+/* Subroutine of crypt_md5crypt_rn and crypt_md5crypt_batch_rn:
+   Write the hash string for SALT and the final RESULT to OUTPUT,
+   which must have room for MD5_HASH_LENGTH bytes.  */
+static void
+md5_format_output (const char *salt, size_t salt_size,
+                   const uint8_t result[16], uint8_t *output)
+{
+  char *cp = (char *)output;
+
+  /* Now we can construct the result string.  It consists of three
+     parts.  We already know that there is enough space at CP.  */
+  memcpy (cp, md5_salt_prefix, sizeof (md5_salt_prefix) - 1);
+  cp += sizeof (md5_salt_prefix) - 1;
+
+  memcpy (cp, salt, salt_size);
+  cp += salt_size;
+  *cp++ = '$';
+
+#define b64_from_24bit(B2, B1, B0, N)                   \
+  do {                                                  \
+    unsigned int w = ((((unsigned int)(B2)) << 16) |    \
+                      (((unsigned int)(B1)) << 8) |     \
+                      ((unsigned int)(B0)));            \
+    int n = (N);                                        \
+    while (n-- > 0)                                     \
+      {                                                 \
+        *cp++ = b64t[w & 0x3f];                         \
+        w >>= 6;                                        \
+      }                                                 \
+  } while (0)
+
+
+  b64_from_24bit (result[0], result[6], result[12], 4);
+  b64_from_24bit (result[1], result[7], result[13], 4);
+  b64_from_24bit (result[2], result[8], result[14], 4);
+  b64_from_24bit (result[3], result[9], result[15], 4);
+  b64_from_24bit (result[4], result[10], result[5], 4);
+  b64_from_24bit (0, 0, result[11], 2);
+
+  *cp = '\0';
+}
+
+/* This entry point is equivalent to the `crypt' function in Unix
+   libcs.  */
+void
+crypt_md5crypt_rn (const char *phrase, size_t phr_size,
+                   const char *setting, size_t ARG_UNUSED (set_size),
+                   uint8_t *output, size_t out_size,
+                   void *scratch, size_t scr_size)
+{
+  /* This shouldn't ever happen, but...  */
+  if (out_size < MD5_HASH_LENGTH || scr_size < sizeof (struct md5_buffer))
+    {
+      errno = ERANGE;
+      return;
+    }
+
+  struct md5_buffer *buf = scratch;
+  MD5_CTX *ctx = &buf->ctx;
+  uint8_t *result = buf->result;
+  const char *salt;
+  size_t salt_size;
+  size_t cnt;
+
+  if (!md5_parse_salt (setting, &salt, &salt_size))
+    {
+      errno = EINVAL;
+      return;
+    }
+
+  md5_prepare (phrase, phr_size, salt, salt_size, ctx, result);
 
   /* Now comes another weirdness.  In fear of password crackers here
      comes a quite long loop which just processes the output of the
@@ -182,37 +254,238 @@ crypt_md5crypt_rn (const char *phrase, size_t phr_size,
       MD5_Final (result, ctx);
     }
 
-  /* Now we can construct the result string.  It consists of three
-     parts.  We already know that there is enough space at CP.  */
-  memcpy (cp, md5_salt_prefix, sizeof (md5_salt_prefix) - 1);
-  cp += sizeof (md5_salt_prefix) - 1;
+  md5_format_output (salt, salt_size, result, output);
+}
 
-  memcpy (cp, salt, salt_size);
-  cp += salt_size;
-  *cp++ = '$';
+/* The longest message hashed in one of the rounds above, after
+   padding: the phrase twice, the salt, and a previous result, plus
+   at least 9 bytes of padding, rounded up to a whole 64-byte block.  */
+#define MD5_ROUND_MSG_MAX                                             \
+  ((2 * (CRYPT_MAX_PASSPHRASE_SIZE - 1) + SALT_LEN_MAX + 16 + 9       \
+    + 63) / 64 * 64)
+
+/* Which of the optional parts of the message are present in round
+   CNT: bit 0 is set in odd rounds, which start with the phrase and
+   end with the previous result, bit 1 if the salt is included, and
+   bit 2 if the phrase is included twice.  Only eight layouts are
+   possible, and for short phrases all of them fit in MD5_ROUND_MSG_MAX
+   bytes, so crypt_md5crypt_batch_rn builds them once per lane and only
+   changes the previous result from one round to the next.  */
+#define MD5_LAYOUT(cnt)                                               \
+  ((unsigned int) (((cnt) & 1) | ((cnt) % 3 != 0 ? 2u : 0u)            \
+                   | ((cnt) % 7 != 0 ? 4u : 0u)))
+#define MD5_LAYOUT_MAX (MD5_ROUND_MSG_MAX / 8 / 64 * 64)
+
+/* One of the MD5_MB_MAX_LANES hashes that crypt_md5crypt_batch_rn
+   has in progress at any time.  */
+struct md5_batch_slot
+{
+  const char *salt;
+  size_t salt_size;
+  size_t lane;          /* index into the caller's array of lanes */
+  size_t cnt;           /* current round */
+  bool layouts;         /* whether MSG holds all eight layouts */
+  size_t pos;           /* offset in MSG of the next block to hash */
+  size_t end;           /* offset in MSG of the end of the message */
+  size_t res_off[8];    /* offset of the previous result in each layout */
+  size_t res_len[8];    /* length of each layout, including the padding */
+  uint8_t result[16];
+  uint8_t msg[MD5_ROUND_MSG_MAX];
+};
 
-#define b64_from_24bit(B2, B1, B0, N)                   \
-  do {                                                  \
-    unsigned int w = ((((unsigned int)(B2)) << 16) |    \
-                      (((unsigned int)(B1)) << 8) |     \
-                      ((unsigned int)(B0)));            \
-    int n = (N);                                        \
-    while (n-- > 0)                                     \
-      {                                                 \
-        *cp++ = b64t[w & 0x3f];                         \
-        w >>= 6;                                        \
-      }                                                 \
-  } while (0)
+/* Scratch space for crypt_md5crypt_batch_rn.  */
+struct md5_batch_buffer
+{
+  MD5_CTX ctx;
+  uint32_t state[MD5_MB_MAX_LANES][4];
+  struct md5_batch_slot slot[MD5_MB_MAX_LANES];
+};
+
+static_assert (sizeof (struct md5_batch_buffer) <= ALG_BATCH_SPECIFIC_SIZE,
+               "ALG_BATCH_SPECIFIC_SIZE is too small for MD5");
+
+/* Subroutine of crypt_md5crypt_batch_rn: Write the padded message for
+   a round with layout LAYOUT to M, the same sequence of inputs as in
+   crypt_md5crypt_rn, and return its length.  The previous result is
+   written at offset *RES_OFF.  */
+static size_t
+md5_batch_message (uint8_t *m, unsigned int layout,
+                   const char *phrase, size_t phr_size,
+                   const struct md5_batch_slot *slot, size_t *res_off)
+{
+  size_t len = 0, padded;
 
+  if (layout & 1)
+    {
+      memcpy (m + len, phrase, phr_size);
+      len += phr_size;
+    }
+  else
+    {
+      *res_off = len;
+      memcpy (m + len, slot->result, 16);
+      len += 16;
+    }
+  if (layout & 2)
+    {
+      memcpy (m + len, slot->salt, slot->salt_size);
+      len += slot->salt_size;
+    }
+  if (layout & 4)
+    {
+      memcpy (m + len, phrase, phr_size);
+      len += phr_size;
+    }
+  if (layout & 1)
+    {
+      *res_off = len;
+      memcpy (m + len, slot->result, 16);
+      len += 16;
+    }
+  else
+    {
+      memcpy (m + len, phrase, phr_size);
+      len += phr_size;
+    }
 
-  b64_from_24bit (result[0], result[6], result[12], 4);
-  b64_from_24bit (result[1], result[7], result[13], 4);
-  b64_from_24bit (result[2], result[8], result[14], 4);
-  b64_from_24bit (result[3], result[9], result[15], 4);
-  b64_from_24bit (result[4], result[10], result[5], 4);
-  b64_from_24bit (0, 0, result[11], 2);
+  padded = (len + 9 + 63) / 64 * 64;
+  m[len] = 0x80;
+  memset (m + len + 1, 0, padded - len - 1 - 8);
+  cpu_to_le64 (m + padded - 8, (uint64_t) len << 3);
+  return padded;
+}
 
-  *cp = '\0';
+/* Subroutine of crypt_md5crypt_batch_rn: Set up SLOT's message and
+   STATE for round SLOT->cnt.  */
+static void
+md5_batch_round (struct md5_batch_slot *slot, uint32_t state[4],
+                 const char *phrase, size_t phr_size)
+{
+  unsigned int layout = MD5_LAYOUT (slot->cnt);
+  size_t res_off;
+
+  if (slot->layouts)
+    {
+      slot->pos = layout * MD5_LAYOUT_MAX;
+      slot->end = slot->pos + slot->res_len[layout];
+      memcpy (slot->msg + slot->pos + slot->res_off[layout],
+              slot->result, 16);
+    }
+  else
+    {
+      slot->pos = 0;
+      slot->end = md5_batch_message (slot->msg, layout, phrase, phr_size,
+                                     slot, &res_off);
+    }
+
+  state[0] = 0x67452301;
+  state[1] = 0xefcdab89;
+  state[2] = 0x98badcfe;
+  state[3] = 0x10325476;
+}
+
+/* Hash several passphrases at once.  Each slot of the multi-buffer
+   MD5 engine works through the rounds of one lane, a block at a time;
+   whenever a slot finishes a round, its next message is set up, and
+   whenever it finishes a lane, it takes on the next one.  So the
+   slots stay busy even though the messages of different lanes, and
+   of different rounds, are not all the same length.  */
+void
+crypt_md5crypt_batch_rn (struct crypt_batch_lane *lanes, size_t nlanes,
+                         void *scratch, size_t scr_size)
+{
+  size_t nslots = MD5_Transform_MB_lanes ();
+
+  /* Without a SIMD implementation of the compression function, there is
+     nothing to gain from hashing the lanes together.  */
+  if (nslots == 1 || scr_size < sizeof (struct md5_batch_buffer))
+    {
+      for (size_t l = 0; l < nlanes; l++)
+        crypt_md5crypt_rn (lanes[l].phrase, lanes[l].phr_size,
+                           lanes[l].setting, lanes[l].set_size,
+                           lanes[l].output, lanes[l].out_size,
+                           scratch, scr_size);
+      return;
+    }
+
+  struct md5_batch_buffer *bb = scratch;
+  const uint8_t *blocks[MD5_MB_MAX_LANES];
+  size_t next = 0, active = 0, s;
+
+  for (;;)
+    {
+      /* Fill the free slots with lanes that have not been started.  */
+      while (active < nslots && next < nlanes)
+        {
+          const struct crypt_batch_lane *lane = &lanes[next];
+          struct md5_batch_slot *slot = &bb->slot[active];
+
+          slot->lane = next++;
+          if (lane->out_size < MD5_HASH_LENGTH
+              || !md5_parse_salt (lane->setting, &slot->salt,
+                                  &slot->salt_size))
+            continue;
+
+          md5_prepare (lane->phrase, lane->phr_size,
+                       slot->salt, slot->salt_size, &bb->ctx, slot->result);
+
+          /* The longest layout is the one with everything in it.  */
+          slot->layouts = (2 * lane->phr_size + slot->salt_size + 16 + 9
+                           <= MD5_LAYOUT_MAX);
+          if (slot->layouts)
+            for (unsigned int layout = 0; layout < 8; layout++)
+              slot->res_len[layout] =
+                md5_batch_message (slot->msg + layout * MD5_LAYOUT_MAX,
+                                   layout, lane->phrase, lane->phr_size,
+                                   slot, &slot->res_off[layout]);
+
+          slot->cnt = 0;
+          md5_batch_round (slot, bb->state[active],
+                           lane->phrase, lane->phr_size);
+          active++;
+        }
+      if (active == 0)
+        break;
+
+      for (s = 0; s < active; s++)
+        blocks[s] = bb->slot[s].msg + bb->slot[s].pos;
+      MD5_Transform_MB (bb->state, blocks, active);
+
+      for (s = 0; s < active; )
+        {
+          struct md5_batch_slot *slot = &bb->slot[s];
+          const struct crypt_batch_lane *lane = &lanes[slot->lane];
+
+          slot->pos += 64;
+          if (slot->pos < slot->end)
+            {
+              s++;
+              continue;
+            }
+
+          cpu_to_le32 (slot->result +  0, bb->state[s][0]);
+          cpu_to_le32 (slot->result +  4, bb->state[s][1]);
+          cpu_to_le32 (slot->result +  8, bb->state[s][2]);
+          cpu_to_le32 (slot->result + 12, bb->state[s][3]);
+          if (++slot->cnt < 1000)
+            {
+              md5_batch_round (slot, bb->state[s],
+                               lane->phrase, lane->phr_size);
+              s++;
+              continue;
+            }
+
+          md5_format_output (slot->salt, slot->salt_size, slot->result,
+                             lane->output);
+
+          /* Move the last active slot into this one.  */
+          if (s != --active)
+            {
+              *slot = bb->slot[active];
+              memcpy (bb->state[s], bb->state[active], sizeof bb->state[s]);
+            }
+        }
+    }
 }
 
 void
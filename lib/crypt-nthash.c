@@ -48,6 +48,7 @@ typedef struct
 
 static_assert (sizeof (crypt_nt_internal_t) <= ALG_SPECIFIC_SIZE,
                "ALG_SPECIFIC_SIZE is too small for NTHASH.");
+const size_t crypt_nt_scratch_size = sizeof (crypt_nt_internal_t);
 
 /*
  * NT HASH = md4(str2unicode(phrase))
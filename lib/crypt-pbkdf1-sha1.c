@@ -29,6 +29,7 @@
 
 #include "crypt-port.h"
 #include "alg-hmac-sha1.h"
+#include "alg-sha1.h"
 #include "byteorder.h"
 
 #include <errno.h>
@@ -64,6 +65,103 @@ to64 (uint8_t *s, unsigned long v, int n)
     }
 }
 
+/* Scratch space for crypt_sha1crypt_rn.  */
+struct sha1crypt_buffer
+{
+  struct hmac_sha1_key hk;
+  uint8_t hmac_buf[SHA1_SIZE];
+};
+
+static_assert (sizeof (struct sha1crypt_buffer) <= ALG_SPECIFIC_SIZE,
+               "ALG_SPECIFIC_SIZE is too small for SHA1");
+const size_t crypt_sha1crypt_scratch_size = sizeof (struct sha1crypt_buffer);
+
+/* Subroutine of crypt_sha1crypt_rn and crypt_sha1crypt_batch_rn:
+   Parse SETTING, which is $<tag>$<iterations>$salt[$].  On success,
+   write the iteration count to *ITERATIONSP, point *SALTP at the salt
+   and write its length to *SLP, and return true.  */
+static bool
+sha1crypt_parse_setting (const char *setting, unsigned long *iterationsp,
+                         const char **saltp, size_t *slp)
+{
+  static const char *magic = "$sha1$";
+  const char *sp;
+  char *ep;
+
+  /* If the string doesn't starts with the magic prefix, we shouldn't have been called */
+  if (strncmp (setting, magic, strlen (magic)))
+    return false;
+
+  setting += strlen (magic);
+  /* get the iteration count */
+  *iterationsp = (unsigned long)strtoul (setting, &ep, 10);
+  if (*ep != '$')
+    return false;  /* invalid input */
+  setting = ep + 1;  /* skip over the '$' */
+
+  /* The next 1..CRYPT_SHA1_SALT_LENGTH bytes should be itoa64 characters,
+     followed by another '$' (or end of string).  */
+  sp = setting + strspn (setting, (const char *)itoa64);
+  if (sp == setting || (*sp && *sp != '$'))
+    return false;
+
+  *saltp = setting;
+  *slp = (size_t)(sp - setting);
+  return true;
+}
+
+/* Subroutine of crypt_sha1crypt_rn and crypt_sha1crypt_batch_rn:
+   Compute the first HMAC, keyed with PHRASE, over
+   <salt><magic><iterations>, using OUTPUT as a temporary.  */
+static void
+sha1crypt_first_hmac (const char *phrase, size_t phr_size,
+                      unsigned long iterations, const char *salt, size_t sl,
+                      uint8_t *output, size_t out_size,
+                      uint8_t hmac_buf[SHA1_SIZE])
+{
+  int dl = snprintf ((char *)output, out_size, "%.*s$sha1$%lu",
+                     (int)sl, salt, iterations);
+  hmac_sha1_process_data ((const unsigned char *)output, (size_t)dl,
+                          (const uint8_t *)phrase, phr_size, hmac_buf);
+}
+
+/* Subroutine of crypt_sha1crypt_rn and crypt_sha1crypt_batch_rn:
+   Write the complete hash to OUTPUT.  */
+static void
+sha1crypt_format_output (uint8_t *output, size_t out_size,
+                         unsigned long iterations, const char *salt,
+                         size_t sl, const uint8_t hmac_buf[SHA1_SIZE])
+{
+  unsigned long ul;
+  size_t pl, i;
+  uint8_t *ep;
+
+  pl = (size_t)snprintf ((char *)output, out_size, "$sha1$%lu$%.*s$",
+                         iterations, (int)sl, salt);
+  ep = output + pl;
+
+  /* Every 3 bytes of hash gives 24 bits which is 4 base64 chars */
+  for (i = 0; i < SHA1_SIZE - 3; i += 3)
+    {
+      ul = (unsigned long)((hmac_buf[i+0] << 16) |
+                           (hmac_buf[i+1] << 8) |
+                           hmac_buf[i+2]);
+      to64 (ep, ul, 4);
+      ep += 4;
+    }
+  /* Only 2 bytes left, so we pad with byte0 */
+  ul = (unsigned long)((hmac_buf[SHA1_SIZE - 2] << 16) |
+                       (hmac_buf[SHA1_SIZE - 1] << 8) |
+                       hmac_buf[0]);
+  to64 (ep, ul, 4);
+  ep += 4;
+  *ep = '\0';
+}
+
+/* The smallest output buffer crypt_sha1crypt_rn accepts.  */
+#define SHA1_MIN_OUT_SIZE \
+  (sizeof "$sha1$" - 1 + 2 + 10 + CRYPT_SHA1_SALT_LENGTH + SHA1_OUTPUT_SIZE)
+
 /*
  * UNIX password using hmac_sha1
  * This is PBKDF1 from RFC 2898, but using hmac_sha1.
@@ -94,100 +192,175 @@ crypt_sha1crypt_rn (const char *phrase, size_t phr_size,
                     uint8_t *output, size_t out_size,
                     void *scratch, size_t scr_size)
 {
-  static const char *magic = "$sha1$";
-
-  if ((out_size < (strlen (magic) + 2 + 10 + CRYPT_SHA1_SALT_LENGTH +
-                   SHA1_OUTPUT_SIZE)) ||
-      scr_size < SHA1_SIZE)
+  if (out_size < SHA1_MIN_OUT_SIZE
+      || scr_size < sizeof (struct sha1crypt_buffer))
     {
       errno = ERANGE;
       return;
     }
 
-  const char *sp;
-  uint8_t *ep;
-  unsigned long ul;
-  size_t sl;
-  size_t pl = phr_size;
-  int dl;
+  struct sha1crypt_buffer *buf = scratch;
   unsigned long iterations;
-  unsigned long i;
-  /* XXX silence -Wpointer-sign (would be nice to fix this some other way) */
-  const uint8_t *pwu = (const uint8_t *)phrase;
-  uint8_t *hmac_buf = scratch;
-
-  /*
-   * Salt format is
-   * $<tag>$<iterations>$salt[$]
-   */
+  const char *salt;
+  size_t sl;
 
-  /* If the string doesn't starts with the magic prefix, we shouldn't have been called */
-  if (strncmp (setting, magic, strlen (magic)))
+  if (!sha1crypt_parse_setting (setting, &iterations, &salt, &sl))
     {
       errno = EINVAL;
       return;
     }
 
-  setting += strlen (magic);
-  /* get the iteration count */
-  iterations = (unsigned long)strtoul (setting, (char **)&ep, 10);
-  if (*ep != '$')
+  /*
+   * Now get to work...
+   * Prime the pump with <salt><magic><iterations>,
+   * then hmac using <phrase> as key, and repeat.  The pads of the
+   * key are absorbed once, up front, so each further round costs
+   * two SHA-1 compressions.
+   */
+  sha1crypt_first_hmac (phrase, phr_size, iterations, salt, sl,
+                        output, out_size, buf->hmac_buf);
+  if (iterations > 1)
     {
-      errno = EINVAL;
-      return;  /* invalid input */
+      hmac_sha1_init_key (&buf->hk, (const uint8_t *)phrase, phr_size);
+      hmac_sha1_iterate (&buf->hk, buf->hmac_buf, iterations - 1);
     }
-  setting = (char *)ep + 1;  /* skip over the '$' */
 
-  /* The next 1..CRYPT_SHA1_SALT_LENGTH bytes should be itoa64 characters,
-     followed by another '$' (or end of string).  */
-  sp = setting + strspn (setting, (const char *)itoa64);
-  if (sp == setting || (*sp && *sp != '$'))
+  /* Now output... */
+  sha1crypt_format_output (output, out_size, iterations, salt, sl,
+                           buf->hmac_buf);
+
+  /* Don't leave anything around in vm they could use. */
+  explicit_bzero (buf, sizeof *buf);
+}
+
+/* One of the hashes that crypt_sha1crypt_batch_rn has in progress.  */
+struct sha1crypt_batch_slot
+{
+  size_t lane;                /* index into the caller's array of lanes */
+  const char *salt;
+  size_t sl;
+  unsigned long iterations;
+  unsigned long left;         /* rounds still to be done */
+  struct hmac_sha1_key hk;
+  /* The current value, followed by the padding for the next
+     compression.  */
+  uint8_t block[64];
+};
+
+/* Scratch space for crypt_sha1crypt_batch_rn.  */
+struct sha1crypt_batch_buffer
+{
+  uint32_t state[CRYPT_BATCH_LANES][5];
+  struct sha1crypt_batch_slot slot[CRYPT_BATCH_LANES];
+};
+
+static_assert (sizeof (struct sha1crypt_batch_buffer)
+               <= ALG_BATCH_SPECIFIC_SIZE,
+               "ALG_BATCH_SPECIFIC_SIZE is too small for SHA1");
+static_assert (CRYPT_BATCH_LANES <= SHA1_MB_MAX_LANES,
+               "sha1_transform_mb cannot handle CRYPT_BATCH_LANES");
+
+/* Hash several passphrases at once.  After the first HMAC, every round
+   is two compressions of a single block, the same for every lane, so
+   the slots of the multi-buffer SHA-1 engine do the inner hashes of
+   one round together and then the outer hashes.  Lanes usually have
+   different iteration counts; whenever one finishes, the next lane
+   that has not been started takes over its slot.  */
+void
+crypt_sha1crypt_batch_rn (struct crypt_batch_lane *lanes, size_t nlanes,
+                          void *scratch, size_t scr_size)
+{
+  /* Without a SIMD implementation of the compression function, there is
+     nothing to gain from hashing the lanes together.  */
+  if (sha1_transform_mb_lanes () == 1
+      || scr_size < sizeof (struct sha1crypt_batch_buffer))
     {
-      errno = EINVAL;
+      for (size_t l = 0; l < nlanes; l++)
+        crypt_sha1crypt_rn (lanes[l].phrase, lanes[l].phr_size,
+                            lanes[l].setting, lanes[l].set_size,
+                            lanes[l].output, lanes[l].out_size,
+                            scratch, scr_size);
       return;
     }
 
-  sl = (size_t)(sp - setting);
+  struct sha1crypt_batch_buffer *bb = scratch;
+  const uint8_t *blocks[CRYPT_BATCH_LANES];
+  size_t next = 0, active = 0, s;
+  int j;
 
-  /*
-   * Now get to work...
-   * Prime the pump with <salt><magic><iterations>
-   */
-  dl = snprintf ((char *)output, out_size, "%.*s%s%lu",
-                 (int)sl, setting, magic, iterations);
-  /*
-   * Then hmac using <phrase> as key, and repeat...
-   */
-  hmac_sha1_process_data ((const unsigned char *)output, (size_t)dl,
-                          pwu, pl, hmac_buf);
-  for (i = 1; i < iterations; ++i)
+  for (;;)
     {
-      hmac_sha1_process_data (hmac_buf, SHA1_SIZE, pwu, pl, hmac_buf);
-    }
-  /* Now output... */
-  pl = (size_t)snprintf ((char *)output, out_size, "%s%lu$%.*s$",
-                         magic, iterations, (int)sl, setting);
-  ep = output + pl;
+      /* Fill the free slots with lanes that have not been started.  */
+      while (active < CRYPT_BATCH_LANES && next < nlanes)
+        {
+          const struct crypt_batch_lane *lane = &lanes[next];
+          struct sha1crypt_batch_slot *slot = &bb->slot[active];
 
-  /* Every 3 bytes of hash gives 24 bits which is 4 base64 chars */
-  for (i = 0; i < SHA1_SIZE - 3; i += 3)
-    {
-      ul = (unsigned long)((hmac_buf[i+0] << 16) |
-                           (hmac_buf[i+1] << 8) |
-                           hmac_buf[i+2]);
-      to64 (ep, ul, 4);
-      ep += 4;
-    }
-  /* Only 2 bytes left, so we pad with byte0 */
-  ul = (unsigned long)((hmac_buf[SHA1_SIZE - 2] << 16) |
-                       (hmac_buf[SHA1_SIZE - 1] << 8) |
-                       hmac_buf[0]);
-  to64 (ep, ul, 4);
-  ep += 4;
-  *ep = '\0';
+          slot->lane = next++;
+          if (lane->out_size < SHA1_MIN_OUT_SIZE
+              || !sha1crypt_parse_setting (lane->setting, &slot->iterations,
+                                           &slot->salt, &slot->sl))
+            continue;
 
-  /* Don't leave anything around in vm they could use. */
-  explicit_bzero (scratch, scr_size);
+          sha1crypt_first_hmac (lane->phrase, lane->phr_size,
+                                slot->iterations, slot->salt, slot->sl,
+                                lane->output, lane->out_size, slot->block);
+          slot->left = slot->iterations > 1 ? slot->iterations - 1 : 0;
+          if (slot->left == 0)
+            {
+              sha1crypt_format_output (lane->output, lane->out_size,
+                                       slot->iterations, slot->salt,
+                                       slot->sl, slot->block);
+              continue;
+            }
+
+          hmac_sha1_init_key (&slot->hk, (const uint8_t *)lane->phrase,
+                              lane->phr_size);
+          hmac_sha1_pad_block (slot->block);
+          active++;
+        }
+      if (active == 0)
+        break;
+
+      for (s = 0; s < active; s++)
+        blocks[s] = bb->slot[s].block;
+
+      /* Inner hash.  */
+      for (s = 0; s < active; s++)
+        memcpy (bb->state[s], bb->slot[s].hk.istate, sizeof bb->state[s]);
+      sha1_transform_mb (bb->state, blocks, active);
+      for (s = 0; s < active; s++)
+        for (j = 0; j < 5; j++)
+          cpu_to_be32 (bb->slot[s].block + 4 * j, bb->state[s][j]);
+
+      /* Outer hash.  */
+      for (s = 0; s < active; s++)
+        memcpy (bb->state[s], bb->slot[s].hk.ostate, sizeof bb->state[s]);
+      sha1_transform_mb (bb->state, blocks, active);
+      for (s = 0; s < active; s++)
+        for (j = 0; j < 5; j++)
+          cpu_to_be32 (bb->slot[s].block + 4 * j, bb->state[s][j]);
+
+      for (s = 0; s < active; )
+        {
+          struct sha1crypt_batch_slot *slot = &bb->slot[s];
+
+          if (--slot->left > 0)
+            {
+              s++;
+              continue;
+            }
+
+          const struct crypt_batch_lane *lane = &lanes[slot->lane];
+          sha1crypt_format_output (lane->output, lane->out_size,
+                                   slot->iterations, slot->salt, slot->sl,
+                                   slot->block);
+
+          /* Move the last active slot into this one.  */
+          if (s != --active)
+            *slot = bb->slot[active];
+        }
+    }
 }
 
 /* Modified excerpt from:
@@ -188,6 +188,169 @@ extern void explicit_bzero (void *, size_t);
 #define strcpy_or_abort _crypt_strcpy_or_abort
 extern size_t strcpy_or_abort (void *dst, size_t d_size, const void *src);
 
+/* Return the current value of the process-wide setting KNOB, one of
+   the CRYPT_TUNE_* constants from crypt.h, as last set with
+   crypt_set_tunable.  */
+#define get_tunable _crypt_get_tunable
+extern long get_tunable (int knob);
+
+/* Set KNOB to VALUE without any checks.  Used for the settings that
+   report what the library did, which crypt_set_tunable refuses to
+   change.  */
+#define store_tunable _crypt_store_tunable
+extern void store_tunable (int knob, long value);
+
+/* Call FN (ARG, i) once for each i from 0 to NLANES - 1, spreading
+   the calls over up to NTHREADS threads (counting the calling thread),
+   and return when all of them have finished.  The calls can happen in
+   any order.  NTHREADS is capped at MAX_LANE_THREADS; without thread
+   support, all calls are made from the calling thread.  */
+#define MAX_LANE_THREADS 256
+#define run_lanes _crypt_run_lanes
+extern void run_lanes (void (*fn) (void *, uint32_t), void *arg,
+                       uint32_t nlanes, uint32_t nthreads);
+
+/* The number of threads that the hash being computed on the calling
+   thread may use: CRYPT_TUNE_THREADS, or the limit last set with
+   set_call_threads on this thread if that is lower.  */
+#define lane_threads _crypt_lane_threads
+extern uint32_t lane_threads (void);
+
+/* Set the limit that lane_threads returns on the calling thread, for
+   the duration of one call into the library; 0 removes it.  */
+#define set_call_threads _crypt_set_call_threads
+extern void set_call_threads (unsigned int nthreads);
+
+/* x86 instruction set extensions that code is selected for at
+   runtime; see CPU_DISPATCH.  */
+#if defined HAVE_X86_TARGET_SSE2 || defined HAVE_X86_TARGET_SSE41 || \
+    defined HAVE_X86_TARGET_AVX2 || defined HAVE_X86_TARGET_AVX512F || \
+    defined HAVE_X86_TARGET_SHA
+#define HAVE_CPU_DISPATCH 1
+#endif
+#define CPU_SSE2    0x01u
+#define CPU_SSE41   0x02u
+#define CPU_SHA     0x04u
+#define CPU_AVX     0x08u
+#define CPU_XOP     0x10u
+#define CPU_AVX2    0x20u
+#define CPU_AVX512F 0x40u
+
+/* Whether the CPU has all of the extensions in FEATURES, and none of
+   them has been masked off with cpu_force_features.  Always false
+   without HAVE_CPU_DISPATCH.  */
+#define cpu_supports _crypt_cpu_supports
+extern bool cpu_supports (unsigned int features);
+
+/* Remember SELECT, and call it now and whenever cpu_force_features
+   changes what cpu_supports reports.  */
+#define cpu_dispatch_register _crypt_cpu_dispatch_register
+extern void cpu_dispatch_register (void (*select) (void));
+
+/* Make cpu_supports deny every extension not in FEATURES, rerun all of
+   the selectors, and return the set of extensions the code may now use.
+   ~0u undoes it.  For the tests, which use it to run each variant the
+   CPU can; no other thread may be in the library while it runs.  */
+#define cpu_force_features _crypt_cpu_force_features
+extern unsigned int cpu_force_features (unsigned int features);
+
+/* Declare SELECT, a function that points a module's implementation
+   pointers at the best code for what cpu_supports reports, and
+   register it when the library is loaded.  SELECT must start from
+   the portable code, so that it gives the same result whenever it is
+   called.  */
+#define CPU_DISPATCH(select)                                    \
+  static void select (void);                                    \
+  __attribute__((constructor)) static void                      \
+  select##_at_load (void)                                       \
+  {                                                             \
+    cpu_dispatch_register (select);                             \
+  }
+
+/* If a crypt_ctx is bound to the calling thread, its arena holds at
+   least SIZE bytes and no other thread is using it, return the arena
+   for the caller's exclusive use; otherwise return NULL.  Used by the
+   memory-hard hashing methods in place of allocating their working
+   memory.  */
+#define ctx_arena_acquire _crypt_ctx_arena_acquire
+extern void *ctx_arena_acquire (size_t size);
+
+/* If MEM is the arena of the crypt_ctx bound to the calling thread,
+   erase its first SIZE bytes, make it available again, and return
+   true; otherwise return false, and MEM must be freed as usual.  */
+#define ctx_arena_release _crypt_ctx_arena_release
+extern bool ctx_arena_release (void *mem, size_t size);
+
+/* A block of working memory for a memory-hard hashing method.  BASE
+   and BASE_SIZE describe what was mapped or allocated, ALIGNED and
+   ALIGNED_SIZE the part of it that is used.  */
+struct memory_region
+{
+  void *base, *aligned;
+  size_t base_size, aligned_size;
+};
+
+/* Make REGION empty, without freeing anything.  */
+#define init_region _crypt_init_region
+extern void init_region (struct memory_region *region);
+
+/* Map SIZE bytes into REGION, trying the CRYPT_MEMORY_* techniques in
+   POLICY.  Returns the techniques that took effect, or -1 with errno
+   set if no memory could be obtained.  */
+#define map_region _crypt_map_region
+extern long map_region (struct memory_region *region, size_t size,
+                        long policy);
+
+/* Fault in all of REGION now, and if LOCK, lock it in memory.
+   Returns 0 on success, or -1 with errno set.  */
+#define populate_region _crypt_populate_region
+extern int populate_region (struct memory_region *region, bool lock);
+
+/* Release memory obtained with map_region and make REGION empty.
+   Returns 0 on success, or -1 with errno set.  */
+#define unmap_region _crypt_unmap_region
+extern int unmap_region (struct memory_region *region);
+
+/* Obtain SIZE bytes for REGION from the arena of the crypt_ctx bound
+   to the calling thread, or else with map_region following
+   CRYPT_TUNE_MEMORY_POLICY, recording what it did in
+   CRYPT_TUNE_MEMORY_OBTAINED.  Returns REGION->aligned, or NULL with
+   errno set.  */
+#define alloc_region _crypt_alloc_region
+extern void *alloc_region (struct memory_region *region, size_t size);
+
+/* Release memory obtained with alloc_region, handing an arena back
+   to its crypt_ctx, and make REGION empty.  Returns 0 on success, or
+   -1 with errno set.  */
+#define free_region _crypt_free_region
+extern int free_region (struct memory_region *region);
+
+/* Like init_region, but hand over the region that the calling thread
+   kept after its last free_region_cached, if any.  */
+#define init_region_cached _crypt_init_region_cached
+extern void init_region_cached (struct memory_region *region);
+
+/* Like free_region, but if CRYPT_TUNE_KEEP_MEMORY allows, erase REGION
+   and keep it for the calling thread's next init_region_cached,
+   replacing what it kept before.  Kept memory is freed when the
+   thread exits.  */
+#define free_region_cached _crypt_free_region_cached
+extern int free_region_cached (struct memory_region *region);
+
+/* The calling thread's buffer for the result of crypt (a struct
+   crypt_data), crypt_gensalt or crypt_gensalt_calibrated, allocated
+   and zeroed on first use.  Returns NULL, with errno set, if it cannot
+   be allocated.  */
+enum thread_state_slot
+{
+  THREAD_STATE_CRYPT,
+  THREAD_STATE_GENSALT,
+  THREAD_STATE_GENSALT_CALIBRATED,
+  THREAD_STATE_NSLOTS
+};
+#define thread_state_get _crypt_thread_state_get
+extern void *thread_state_get (enum thread_state_slot slot);
+
 
 /* Define ALIASNAME as a strong alias for NAME.  */
 #define strong_alias(name, aliasname) _strong_alias(name, aliasname)
@@ -324,7 +487,17 @@ extern size_t strcpy_or_abort (void *dst, size_t d_size, const void *src);
 #define get_random_bytes         _crypt_get_random_bytes
 #define make_failure_token       _crypt_make_failure_token
 
+#if INCLUDE_argon2id
+#define argon2id_hash            _crypt_argon2id_hash
+#define blake2b_final            _crypt_blake2b_final
+#define blake2b_init             _crypt_blake2b_init
+#define blake2b_long             _crypt_blake2b_long
+#define blake2b_update           _crypt_blake2b_update
+#endif
+
 #if INCLUDE_descrypt || INCLUDE_bsdicrypt || INCLUDE_bigcrypt
+#define des_bs_crypt_zero        _crypt_des_bs_crypt_zero
+#define des_bs_set_lane          _crypt_des_bs_set_lane
 #define des_crypt_block          _crypt_des_crypt_block
 #define des_set_key              _crypt_des_set_key
 #define des_set_salt             _crypt_des_set_salt
@@ -350,6 +523,8 @@ extern size_t strcpy_or_abort (void *dst, size_t d_size, const void *src);
 #define MD5_Init   _crypt_MD5_Init
 #define MD5_Update _crypt_MD5_Update
 #define MD5_Final  _crypt_MD5_Final
+#define MD5_Transform_MB _crypt_MD5_Transform_MB
+#define MD5_Transform_MB_lanes _crypt_MD5_Transform_MB_lanes
 #endif
 
 #if INCLUDE_sha1crypt
@@ -357,6 +532,12 @@ extern size_t strcpy_or_abort (void *dst, size_t d_size, const void *src);
 #define sha1_finish_ctx          _crypt_sha1_finish_ctx
 #define sha1_init_ctx            _crypt_sha1_init_ctx
 #define sha1_process_bytes       _crypt_sha1_process_bytes
+#define sha1_transform           _crypt_sha1_transform
+#define sha1_transform_mb        _crypt_sha1_transform_mb
+#define sha1_transform_mb_lanes  _crypt_sha1_transform_mb_lanes
+#define hmac_sha1_init_key       _crypt_hmac_sha1_init_key
+#define hmac_sha1_pad_block      _crypt_hmac_sha1_pad_block
+#define hmac_sha1_iterate        _crypt_hmac_sha1_iterate
 #endif
 
 #if INCLUDE_sha512crypt
@@ -364,6 +545,9 @@ extern size_t strcpy_or_abort (void *dst, size_t d_size, const void *src);
 #define libcperciva_SHA512_Update _crypt_SHA512_Update
 #define libcperciva_SHA512_Final  _crypt_SHA512_Final
 #define libcperciva_SHA512_Buf    _crypt_SHA512_Buf
+#define libcperciva_SHA512_Transform_MB _crypt_SHA512_Transform_MB
+#define libcperciva_SHA512_Transform_MB_lanes \
+  _crypt_SHA512_Transform_MB_lanes
 #endif
 
 #if INCLUDE_md5crypt || INCLUDE_sha256crypt || INCLUDE_sha512crypt
@@ -372,6 +556,7 @@ extern size_t strcpy_or_abort (void *dst, size_t d_size, const void *src);
 
 #if INCLUDE_yescrypt || INCLUDE_scrypt || INCLUDE_gost_yescrypt
 #define PBKDF2_SHA256            _crypt_PBKDF2_SHA256
+#define PBKDF2_SHA256_HMAC       _crypt_PBKDF2_SHA256_HMAC
 #define crypto_scrypt            _crypt_crypto_scrypt
 #define yescrypt                 _crypt_yescrypt
 #define yescrypt_decode64        _crypt_yescrypt_decode64
@@ -380,12 +565,27 @@ extern size_t strcpy_or_abort (void *dst, size_t d_size, const void *src);
 #define yescrypt_encode_params   _crypt_yescrypt_encode_params
 #define yescrypt_encode_params_r _crypt_yescrypt_encode_params_r
 #define yescrypt_free_local      _crypt_yescrypt_free_local
+#define yescrypt_free_local_cached _crypt_yescrypt_free_local_cached
 #define yescrypt_free_shared     _crypt_yescrypt_free_shared
 #define yescrypt_init_local      _crypt_yescrypt_init_local
+#define yescrypt_init_local_cached _crypt_yescrypt_init_local_cached
 #define yescrypt_init_shared     _crypt_yescrypt_init_shared
 #define yescrypt_kdf             _crypt_yescrypt_kdf
 #define yescrypt_r               _crypt_yescrypt_r
 #define yescrypt_reencrypt       _crypt_yescrypt_reencrypt
+#define yescrypt_rom_acquire     _crypt_yescrypt_rom_acquire
+#define yescrypt_rom_release     _crypt_yescrypt_rom_release
+
+/* yescrypt_kdf compiled for particular x86 extensions, if configured */
+#ifdef HAVE_YESCRYPT_SSE2
+#define yescrypt_kdf_sse2        _crypt_yescrypt_kdf_sse2
+#endif
+#ifdef HAVE_YESCRYPT_AVX
+#define yescrypt_kdf_avx         _crypt_yescrypt_kdf_avx
+#endif
+#ifdef HAVE_YESCRYPT_XOP
+#define yescrypt_kdf_xop         _crypt_yescrypt_kdf_xop
+#endif
 
 #define libcperciva_HMAC_SHA256_Init _crypt_HMAC_SHA256_Init
 #define libcperciva_HMAC_SHA256_Update _crypt_HMAC_SHA256_Update
@@ -399,11 +599,17 @@ extern size_t strcpy_or_abort (void *dst, size_t d_size, const void *src);
 #define libcperciva_SHA256_Update _crypt_SHA256_Update
 #define libcperciva_SHA256_Final _crypt_SHA256_Final
 #define libcperciva_SHA256_Buf   _crypt_SHA256_Buf
+#define libcperciva_SHA256_Transform_MB _crypt_SHA256_Transform_MB
+#define libcperciva_SHA256_Transform_MB_lanes \
+  _crypt_SHA256_Transform_MB_lanes
+#define libcperciva_SHA256_Transform_accelerated \
+  _crypt_SHA256_Transform_accelerated
 #endif
 
 #if INCLUDE_gost_yescrypt
 #define GOST34112012Init       _crypt_GOST34112012_Init
 #define GOST34112012Update     _crypt_GOST34112012_Update
+#define GOST34112012UpdateBlock2 _crypt_GOST34112012_UpdateBlock2
 #define GOST34112012Final      _crypt_GOST34112012_Final
 #define GOST34112012Cleanup    _crypt_GOST34112012_Cleanup
 #define gost_hash256           _crypt_gost_hash256
@@ -418,6 +624,19 @@ extern void gensalt_yescrypt_rn
 #endif
 #endif
 
+/* Variants of the gensalt functions for yescrypt and gost-yescrypt
+   that make settings using the loaded ROM, for crypt_gensalt_rom_rn. */
+#if INCLUDE_yescrypt || INCLUDE_gost_yescrypt
+#define gensalt_yescrypt_rom_rn _crypt_gensalt_yescrypt_rom_rn
+extern void gensalt_yescrypt_rom_rn
+(unsigned long, const uint8_t *, size_t, uint8_t *, size_t);
+#endif
+#if INCLUDE_gost_yescrypt
+#define gensalt_gost_yescrypt_rom_rn _crypt_gensalt_gost_yescrypt_rom_rn
+extern void gensalt_gost_yescrypt_rom_rn
+(unsigned long, const uint8_t *, size_t, uint8_t *, size_t);
+#endif
+
 /* Those are not present, if des-big is selected, but des is not. */
 #if INCLUDE_bigcrypt && !INCLUDE_descrypt
 #define gensalt_descrypt_rn _crypt_gensalt_descrypt_rn
@@ -491,6 +710,30 @@ extern const unsigned char ascii64[65];
    this big.  */
 #define ALG_SPECIFIC_SIZE 8192
 
+/* crypt_verify_many hands passphrases to the hashing methods in
+   groups of at most this many, all of which use the same method.
+   Each group gets a scratch area of ALG_BATCH_SPECIFIC_SIZE bytes,
+   plus CRYPT_BATCH_LANES separate output buffers.  */
+#define CRYPT_BATCH_LANES 8
+#define ALG_BATCH_SPECIFIC_SIZE 24576
+
+/* Methods marked WIDEBATCH in hashes.conf get groups of up to this
+   many instead.  The same space is divided up into that many output
+   buffers, so each one is smaller than CRYPT_OUTPUT_SIZE; settings
+   that are too long for them are hashed in groups of one.  */
+#define CRYPT_WIDE_BATCH_LANES 64
+
+/* One element of such a group.  */
+struct crypt_batch_lane
+{
+  const char *phrase;
+  size_t phr_size;
+  const char *setting;
+  size_t set_size;
+  uint8_t *output;
+  size_t out_size;
+};
+
 #include "crypt.h"
 
 #endif /* crypt-port.h */
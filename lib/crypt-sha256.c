@@ -18,6 +18,7 @@
 
 #include "crypt-port.h"
 #include "alg-sha256.h"
+#include "byteorder.h"
 
 #include <errno.h>
 #include <stdio.h>
@@ -66,6 +67,7 @@ struct sha256_buffer
 
 static_assert (sizeof (struct sha256_buffer) <= ALG_SPECIFIC_SIZE,
                "ALG_SPECIFIC_SIZE is too small for SHA256");
+const size_t crypt_sha256crypt_scratch_size = sizeof (struct sha256_buffer);
 
 
 /* Feed CTX with LEN bytes of a virtual byte sequence consisting of
@@ -80,30 +82,22 @@ SHA256_Update_recycled (SHA256_CTX *ctx,
   SHA256_Update (ctx, block, cnt);
 }
 
-void
-crypt_sha256crypt_rn (const char *phrase, size_t phr_size,
-                      const char *setting, size_t ARG_UNUSED (set_size),
-                      uint8_t *output, size_t out_size,
-                      void *scratch, size_t scr_size)
+/* The parameters encoded in a setting string.  */
+struct sha256_setting
 {
-  /* This shouldn't ever happen, but...  */
-  if (out_size < SHA256_HASH_LENGTH
-      || scr_size < sizeof (struct sha256_buffer))
-    {
-      errno = ERANGE;
-      return;
-    }
+  const char *salt;
+  size_t salt_size;
+  size_t rounds;
+  bool rounds_custom;
+};
 
-  struct sha256_buffer *buf = scratch;
-  SHA256_CTX *ctx = &buf->ctx;
-  uint8_t *result = buf->result;
-  uint8_t *p_bytes = buf->p_bytes;
-  uint8_t *s_bytes = buf->s_bytes;
-  char *cp = (char *)output;
+/* Parse SETTING into SET.
+   Returns false, with errno set, if SETTING is invalid.  */
+static bool
+sha256_parse_setting (const char *setting, struct sha256_setting *set)
+{
   const char *salt = setting;
-
   size_t salt_size;
-  size_t cnt;
   /* Default number of rounds.  */
   size_t rounds = ROUNDS_DEFAULT;
   bool rounds_custom = false;
@@ -123,7 +117,7 @@ crypt_sha256crypt_rn (const char *phrase, size_t phr_size,
       if (!(*num >= '1' && *num <= '9'))
         {
           errno = EINVAL;
-          return;
+          return false;
         }
 
       errno = 0;
@@ -135,7 +129,7 @@ crypt_sha256crypt_rn (const char *phrase, size_t phr_size,
           || errno)
         {
           errno = EINVAL;
-          return;
+          return false;
         }
       salt = endp + 1;
       rounds_custom = true;
@@ -149,13 +143,33 @@ crypt_sha256crypt_rn (const char *phrase, size_t phr_size,
   if (!(salt[salt_size] == '$' || !salt[salt_size]))
     {
       errno = EINVAL;
-      return;
+      return false;
     }
 
   /* Ensure we do not use more salt than SALT_LEN_MAX. */
   if (salt_size > SALT_LEN_MAX)
     salt_size = SALT_LEN_MAX;
 
+  set->salt = salt;
+  set->salt_size = salt_size;
+  set->rounds = rounds;
+  set->rounds_custom = rounds_custom;
+  return true;
+}
+
+/* Compute the initial digest of PHRASE and the salt into BUF->result,
+   and the P and S byte sequences into BUF->p_bytes and BUF->s_bytes.  */
+static void
+sha256_prepare (const char *phrase, size_t phr_size,
+                const struct sha256_setting *set,
+                struct sha256_buffer *buf)
+{
+  SHA256_CTX *ctx = &buf->ctx;
+  uint8_t *result = buf->result;
+  const char *salt = set->salt;
+  size_t salt_size = set->salt_size;
+  size_t cnt;
+
   /* Compute alternate SHA256 sum with input PHRASE, SALT, and PHRASE.  The
      final result will be added to the first context.  */
   SHA256_Init (ctx);
@@ -207,7 +221,7 @@ crypt_sha256crypt_rn (const char *phrase, size_t phr_size,
     SHA256_Update (ctx, phrase, phr_size);
 
   /* Finish the digest.  */
-  SHA256_Final (p_bytes, ctx);
+  SHA256_Final (buf->p_bytes, ctx);
 
   /* Start computation of S byte sequence.  */
   SHA256_Init (ctx);
@@ -217,55 +231,34 @@ crypt_sha256crypt_rn (const char *phrase, size_t phr_size,
     SHA256_Update (ctx, salt, salt_size);
 
   /* Finish the digest.  */
-  SHA256_Final (s_bytes, ctx);
-
-  /* Repeatedly run the collected hash value through SHA256 to burn
-     CPU cycles.  */
-  for (cnt = 0; cnt < rounds; ++cnt)
-    {
-      /* New context.  */
-      SHA256_Init (ctx);
-
-      /* Add phrase or last result.  */
-      if ((cnt & 1) != 0)
-        SHA256_Update_recycled (ctx, p_bytes, phr_size);
-      else
-        SHA256_Update (ctx, result, 32);
-
-      /* Add salt for numbers not divisible by 3.  */
-      if (cnt % 3 != 0)
-        SHA256_Update_recycled (ctx, s_bytes, salt_size);
-
-      /* Add phrase for numbers not divisible by 7.  */
-      if (cnt % 7 != 0)
-        SHA256_Update_recycled (ctx, p_bytes, phr_size);
-
-      /* Add phrase or last result.  */
-      if ((cnt & 1) != 0)
-        SHA256_Update (ctx, result, 32);
-      else
-        SHA256_Update_recycled (ctx, p_bytes, phr_size);
+  SHA256_Final (buf->s_bytes, ctx);
+}
 
-      /* Create intermediate result.  */
-      SHA256_Final (result, ctx);
-    }
+/* Write the hashed passphrase, made from SET and the final digest
+   RESULT, to OUTPUT.  */
+static void
+sha256_format_output (const struct sha256_setting *set,
+                      const uint8_t result[32], uint8_t *output)
+{
+  char *cp = (char *)output;
 
   /* Now we can construct the result string.  It consists of four
      parts, one of which is optional.  We already know that there
      is sufficient space at CP for the longest possible result string.  */
+
   memcpy (cp, sha256_salt_prefix, sizeof (sha256_salt_prefix) - 1);
   cp += sizeof (sha256_salt_prefix) - 1;
 
-  if (rounds_custom)
+  if (set->rounds_custom)
     {
       int n = snprintf (cp,
                         SHA256_HASH_LENGTH - (sizeof (sha256_salt_prefix) - 1),
-                        "%s%zu$", sha256_rounds_prefix, rounds);
+                        "%s%zu$", sha256_rounds_prefix, set->rounds);
       cp += n;
     }
 
-  memcpy (cp, salt, salt_size);
-  cp += salt_size;
+  memcpy (cp, set->salt, set->salt_size);
+  cp += set->salt_size;
   *cp++ = '$';
 
 #define b64_from_24bit(B2, B1, B0, N)                   \
@@ -296,6 +289,277 @@ crypt_sha256crypt_rn (const char *phrase, size_t phr_size,
   *cp = '\0';
 }
 
+void
+crypt_sha256crypt_rn (const char *phrase, size_t phr_size,
+                      const char *setting, size_t ARG_UNUSED (set_size),
+                      uint8_t *output, size_t out_size,
+                      void *scratch, size_t scr_size)
+{
+  /* This shouldn't ever happen, but...  */
+  if (out_size < SHA256_HASH_LENGTH
+      || scr_size < sizeof (struct sha256_buffer))
+    {
+      errno = ERANGE;
+      return;
+    }
+
+  struct sha256_buffer *buf = scratch;
+  SHA256_CTX *ctx = &buf->ctx;
+  uint8_t *result = buf->result;
+  uint8_t *p_bytes = buf->p_bytes;
+  uint8_t *s_bytes = buf->s_bytes;
+  struct sha256_setting set;
+  size_t cnt;
+
+  if (!sha256_parse_setting (setting, &set))
+    return;
+
+  sha256_prepare (phrase, phr_size, &set, buf);
+
+  /* Repeatedly run the collected hash value through SHA256 to burn
+     CPU cycles.  */
+  for (cnt = 0; cnt < set.rounds; ++cnt)
+    {
+      /* New context.  */
+      SHA256_Init (ctx);
+
+      /* Add phrase or last result.  */
+      if ((cnt & 1) != 0)
+        SHA256_Update_recycled (ctx, p_bytes, phr_size);
+      else
+        SHA256_Update (ctx, result, 32);
+
+      /* Add salt for numbers not divisible by 3.  */
+      if (cnt % 3 != 0)
+        SHA256_Update_recycled (ctx, s_bytes, set.salt_size);
+
+      /* Add phrase for numbers not divisible by 7.  */
+      if (cnt % 7 != 0)
+        SHA256_Update_recycled (ctx, p_bytes, phr_size);
+
+      /* Add phrase or last result.  */
+      if ((cnt & 1) != 0)
+        SHA256_Update (ctx, result, 32);
+      else
+        SHA256_Update_recycled (ctx, p_bytes, phr_size);
+
+      /* Create intermediate result.  */
+      SHA256_Final (result, ctx);
+    }
+
+  sha256_format_output (&set, result, output);
+}
+
+/* The longest message hashed in one of the rounds above, after
+   padding: the phrase twice, the salt, and a previous result, plus
+   at least 9 bytes of padding, rounded up to a whole 64-byte block.  */
+#define SHA256_ROUND_MSG_MAX                                          \
+  ((2 * (CRYPT_MAX_PASSPHRASE_SIZE - 1) + SALT_LEN_MAX + 32 + 9       \
+    + 63) / 64 * 64)
+
+/* Scratch space for crypt_sha256crypt_batch_rn.  */
+struct sha256_batch_buffer
+{
+  struct sha256_buffer lane[CRYPT_BATCH_LANES];
+  struct sha256_setting set[CRYPT_BATCH_LANES];
+  uint32_t state[CRYPT_BATCH_LANES][8];
+  uint8_t p_seq[CRYPT_BATCH_LANES][CRYPT_MAX_PASSPHRASE_SIZE];
+  uint8_t msg[CRYPT_BATCH_LANES][SHA256_ROUND_MSG_MAX];
+};
+
+static_assert (sizeof (struct sha256_batch_buffer) <= ALG_BATCH_SPECIFIC_SIZE,
+               "ALG_BATCH_SPECIFIC_SIZE is too small for SHA256");
+static_assert (CRYPT_BATCH_LANES <= SHA256_MB_MAX_LANES,
+               "SHA256_Transform_MB cannot handle CRYPT_BATCH_LANES");
+
+/* Subroutine of crypt_sha256crypt_batch_rn: Run the rounds loop for
+   the NG lanes listed in GROUP, all of which have the same number of
+   rounds, the same phrase length PHR_SIZE, and the same salt length.
+   Because of that, the message hashed in each round has the same
+   length in every lane, so the lanes can be hashed in lockstep, one
+   block at a time, with SHA256_Transform_MB.  */
+static void
+sha256_rounds_lockstep (struct sha256_batch_buffer *bb,
+                        const size_t *group, size_t ng, size_t phr_size)
+{
+  static const uint32_t sha256_iv[8] =
+    {
+      0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+  const unsigned char *blocks[CRYPT_BATCH_LANES];
+  const size_t rounds = bb->set[group[0]].rounds;
+  const size_t salt_size = bb->set[group[0]].salt_size;
+  size_t cnt, g, b, i;
+
+  /* The P sequence is the P bytes repeated to the length of the phrase.  */
+  for (g = 0; g < ng; g++)
+    for (i = 0; i < phr_size; i++)
+      bb->p_seq[g][i] = bb->lane[group[g]].p_bytes[i % 32];
+
+  for (cnt = 0; cnt < rounds; ++cnt)
+    {
+      size_t len = 0;
+
+      for (g = 0; g < ng; g++)
+        {
+          const struct sha256_buffer *buf = &bb->lane[group[g]];
+          uint8_t *m = bb->msg[g];
+          len = 0;
+
+          /* The same sequence of inputs as in crypt_sha256crypt_rn.  */
+          if ((cnt & 1) != 0)
+            {
+              memcpy (m + len, bb->p_seq[g], phr_size);
+              len += phr_size;
+            }
+          else
+            {
+              memcpy (m + len, buf->result, 32);
+              len += 32;
+            }
+          if (cnt % 3 != 0)
+            {
+              memcpy (m + len, buf->s_bytes, salt_size);
+              len += salt_size;
+            }
+          if (cnt % 7 != 0)
+            {
+              memcpy (m + len, bb->p_seq[g], phr_size);
+              len += phr_size;
+            }
+          if ((cnt & 1) != 0)
+            {
+              memcpy (m + len, buf->result, 32);
+              len += 32;
+            }
+          else
+            {
+              memcpy (m + len, bb->p_seq[g], phr_size);
+              len += phr_size;
+            }
+        }
+
+      /* Pad all of the messages identically.  */
+      size_t padded = (len + 9 + 63) / 64 * 64;
+      for (g = 0; g < ng; g++)
+        {
+          uint8_t *m = bb->msg[g];
+          m[len] = 0x80;
+          memset (m + len + 1, 0, padded - len - 1 - 8);
+          cpu_to_be64 (m + padded - 8, (uint64_t) len << 3);
+          memcpy (bb->state[g], sha256_iv, sizeof sha256_iv);
+        }
+
+      for (b = 0; b < padded; b += 64)
+        {
+          for (g = 0; g < ng; g++)
+            blocks[g] = bb->msg[g] + b;
+          SHA256_Transform_MB (bb->state, blocks, ng);
+        }
+
+      for (g = 0; g < ng; g++)
+        cpu_to_be32_vect (bb->lane[group[g]].result, bb->state[g], 8);
+    }
+}
+
+/* crypt_verify_many sorts the passphrases by this number before
+   grouping them, so that the ones crypt_sha256crypt_batch_rn can hash
+   in lockstep, which have the same number of rounds, phrase length
+   and salt length, end up in the same group.  */
+uint64_t
+crypt_sha256crypt_batch_key (const char *ARG_UNUSED (phrase), size_t phr_size,
+                             const char *setting,
+                             size_t ARG_UNUSED (set_size))
+{
+  struct sha256_setting set;
+  if (!sha256_parse_setting (setting, &set))
+    return 0;
+  return ((uint64_t) set.rounds << 24
+          | (uint64_t) MIN (phr_size, 0xffff) << 8
+          | set.salt_size);
+}
+
+void
+crypt_sha256crypt_batch_rn (struct crypt_batch_lane *lanes, size_t nlanes,
+                            void *scratch, size_t scr_size)
+{
+  /* Hashing the lanes together only pays off with a SIMD implementation
+     of the compression function, and not at all when the CPU has
+     instructions for SHA256, which hash one lane about as fast as
+     SHA256_Transform_MB hashes eight.  */
+  size_t width = MIN (SHA256_Transform_MB_lanes (), CRYPT_BATCH_LANES);
+  if (width == 1
+      || SHA256_Transform_accelerated ()
+      || nlanes > CRYPT_BATCH_LANES
+      || scr_size < sizeof (struct sha256_batch_buffer))
+    {
+      for (size_t l = 0; l < nlanes; l++)
+        crypt_sha256crypt_rn (lanes[l].phrase, lanes[l].phr_size,
+                              lanes[l].setting, lanes[l].set_size,
+                              lanes[l].output, lanes[l].out_size,
+                              scratch, scr_size);
+      return;
+    }
+
+  struct sha256_batch_buffer *bb = scratch;
+  bool pending[CRYPT_BATCH_LANES];
+  size_t group[CRYPT_BATCH_LANES];
+  size_t l, m, ng;
+
+  for (l = 0; l < nlanes; l++)
+    pending[l] = (lanes[l].out_size >= SHA256_HASH_LENGTH
+                  && sha256_parse_setting (lanes[l].setting, &bb->set[l]));
+
+  /* Group together lanes that can be run in lockstep.  */
+  for (l = 0; l < nlanes; l++)
+    {
+      if (!pending[l])
+        continue;
+
+      ng = 0;
+      for (m = l; m < nlanes; m++)
+        if (pending[m]
+            && lanes[m].phr_size == lanes[l].phr_size
+            && bb->set[m].salt_size == bb->set[l].salt_size
+            && bb->set[m].rounds == bb->set[l].rounds)
+          {
+            group[ng++] = m;
+            pending[m] = false;
+          }
+
+      /* Each call to SHA256_Transform_MB costs about as much whether
+         its lanes are in use or not, and every round copies the
+         messages, so a group that fills less than half of the vector
+         is faster hashed one lane at a time.  Each lane's own buffer
+         is enough scratch space for that.  */
+      if (ng * 2 < width)
+        {
+          for (m = 0; m < ng; m++)
+            crypt_sha256crypt_rn (lanes[group[m]].phrase,
+                                  lanes[group[m]].phr_size,
+                                  lanes[group[m]].setting,
+                                  lanes[group[m]].set_size,
+                                  lanes[group[m]].output,
+                                  lanes[group[m]].out_size,
+                                  &bb->lane[group[m]],
+                                  sizeof bb->lane[group[m]]);
+          continue;
+        }
+
+      for (m = 0; m < ng; m++)
+        sha256_prepare (lanes[group[m]].phrase, lanes[group[m]].phr_size,
+                        &bb->set[group[m]], &bb->lane[group[m]]);
+
+      sha256_rounds_lockstep (bb, group, ng, lanes[l].phr_size);
+
+      for (m = 0; m < ng; m++)
+        sha256_format_output (&bb->set[group[m]],
+                              bb->lane[group[m]].result,
+                              lanes[group[m]].output);
+    }
+}
+
 void
 gensalt_sha256crypt_rn (unsigned long count,
                         const uint8_t *rbytes, size_t nrbytes,
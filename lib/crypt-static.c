@@ -19,14 +19,36 @@
 
 /* The functions that use global state objects are isolated in their
    own files so that a statically-linked program that doesn't use them
-   will not have the state objects in its data segment.  */
+   will not have the state objects in its data segment.  The state
+   itself is per-thread, see util-thread-state.c.  */
 
 #if INCLUDE_crypt
 char *
 crypt (const char *key, const char *setting)
 {
-  static struct crypt_data nr_crypt_ctx;
-  return crypt_r (key, setting, &nr_crypt_ctx);
+  struct crypt_data *nr_crypt_ctx = thread_state_get (THREAD_STATE_CRYPT);
+  if (!nr_crypt_ctx)
+    {
+      /* Without memory for a hash, a failure token is the best that
+         can be returned, and it only needs to be different from
+         SETTING.  It is one of two constant strings, chosen as
+         make_failure_token would, so that concurrent calls do not
+         write to shared storage.  The system headers may declare
+         SETTING nonnull, which would let the compiler drop the null
+         check, so it is read through a volatile copy.  */
+#if ENABLE_FAILURE_TOKENS
+      static const char failure_0[] = "*0";
+      static const char failure_1[] = "*1";
+      const char *volatile vsetting = setting;
+      const char *s = vsetting;
+      const char *failure =
+        (s && s[0] == '*' && s[1] == '0') ? failure_1 : failure_0;
+      return (char *) (uintptr_t) failure;
+#else
+      return 0;
+#endif
+    }
+  return crypt_r (key, setting, nr_crypt_ctx);
 }
 SYMVER_crypt;
 #endif
@@ -30,6 +30,7 @@
 
 #include "crypt-port.h"
 #include "alg-md5.h"
+#include "byteorder.h"
 
 #include <errno.h>
 #include <stdlib.h>
@@ -150,30 +151,20 @@ write_itoa64_2 (uint8_t *output,
   output[1] = itoa64[(value >> 6) & 0x3f];
 }
 
-/* Module entry points.  */
-
-void
-crypt_sunmd5_rn (const char *phrase, size_t phr_size,
-                 const char *setting, size_t ARG_UNUSED (set_size),
-                 uint8_t *output, size_t out_size,
-                 void *scratch, size_t scr_size)
+/* Subroutine of crypt_sunmd5_rn and crypt_sunmd5_batch_rn: Parse
+   SETTING.  On success, store the number of stretching rounds in
+   *NROUNDSP and the length of the part of SETTING that goes into the
+   hash (and into the output) in *SALTLENP, and return true.  */
+static bool
+sunmd5_parse_setting (const char *setting, unsigned int *nroundsp,
+                      size_t *saltlenp)
 {
-  struct crypt_sunmd5_scratch
-  {
-    MD5_CTX ctx;
-    uint8_t dg[16];
-    char    rn[16];
-  };
-
   /* If 'setting' doesn't start with the prefix, we should not have
      been called in the first place.  */
   if (strncmp (setting, SUNMD5_PREFIX, SUNMD5_PREFIX_LEN)
       || (setting[SUNMD5_PREFIX_LEN] != '$'
           && setting[SUNMD5_PREFIX_LEN] != ','))
-    {
-      errno = EINVAL;
-      return;
-    }
+    return false;
 
   /* For bug-compatibility with the original implementation, we allow
      'rounds=' to follow either '$md5,' or '$md5$'.  */
@@ -185,43 +176,79 @@ crypt_sunmd5_rn (const char *phrase, size_t phr_size,
       /* Do not allow an explicit setting of zero additional rounds,
          nor leading zeroes on the number of rounds.  */
       if (!(*p >= '1' && *p <= '9'))
-        {
-          errno = EINVAL;
-          return;
-        }
+        return false;
 
       errno = 0;
       char *endp;
       unsigned long arounds = strtoul (p, &endp, 10);
       if (endp == p || arounds > SUNMD5_MAX_ROUNDS || errno)
-        {
-          errno = EINVAL;
-          return;
-        }
+        return false;
       nrounds += (unsigned int)arounds;
       p = endp;
       if (*p != '$')
-        {
-          errno = EINVAL;
-          return;
-        }
+        return false;
       p += 1;
     }
 
   /* p now points to the beginning of the actual salt.  */
   p += strspn (p, (const char *)itoa64);
   if (*p != '\0' && *p != '$')
-    {
-      errno = EINVAL;
-      return;
-    }
+    return false;
   /* For bug-compatibility with the original implementation, if p
      points to a '$' and the following character is either another '$'
      or NUL, the first '$' should be included in the salt.  */
   if (p[0] == '$' && (p[1] == '$' || p[1] == '\0'))
     p += 1;
 
-  size_t saltlen = (size_t) (p - setting);
+  *nroundsp = nrounds;
+  *saltlenp = (size_t) (p - setting);
+  return true;
+}
+
+/* Subroutine of crypt_sunmd5_rn and crypt_sunmd5_batch_rn: Write the
+   hash string for the first SALTLEN bytes of SETTING and the final
+   digest DG to OUTPUT.  */
+static void
+sunmd5_format_output (const char *setting, size_t saltlen,
+                      const uint8_t dg[16], uint8_t *output)
+{
+  memcpy (output, setting, saltlen);
+  *(output + saltlen + 0) = '$';
+  /* This is the same permuted order used by BSD md5-crypt ($1$).  */
+  write_itoa64_4 (output + saltlen +  1, dg[12], dg[ 6], dg[0]);
+  write_itoa64_4 (output + saltlen +  5, dg[13], dg[ 7], dg[1]);
+  write_itoa64_4 (output + saltlen +  9, dg[14], dg[ 8], dg[2]);
+  write_itoa64_4 (output + saltlen + 13, dg[15], dg[ 9], dg[3]);
+  write_itoa64_4 (output + saltlen + 17, dg[ 5], dg[10], dg[4]);
+  write_itoa64_2 (output + saltlen + 21, dg[11], 0, 0);
+  *(output + saltlen + 23) = '\0';
+}
+
+/* Module entry points.  */
+
+struct crypt_sunmd5_scratch
+{
+  MD5_CTX ctx;
+  uint8_t dg[16];
+  char    rn[16];
+};
+
+const size_t crypt_sunmd5_scratch_size = sizeof (struct crypt_sunmd5_scratch);
+
+void
+crypt_sunmd5_rn (const char *phrase, size_t phr_size,
+                 const char *setting, size_t ARG_UNUSED (set_size),
+                 uint8_t *output, size_t out_size,
+                 void *scratch, size_t scr_size)
+{
+  unsigned int nrounds;
+  size_t saltlen;
+  if (!sunmd5_parse_setting (setting, &nrounds, &saltlen))
+    {
+      errno = EINVAL;
+      return;
+    }
+
   /* Do we have enough space?  */
   if (scr_size < sizeof (struct crypt_sunmd5_scratch)
       || out_size < saltlen + SUNMD5_BARE_OUTPUT_LEN + 2)
@@ -256,16 +283,199 @@ crypt_sunmd5_rn (const char *phrase, size_t phr_size,
       MD5_Final (s->dg, &s->ctx);
     }
 
-  memcpy (output, setting, saltlen);
-  *(output + saltlen + 0) = '$';
-  /* This is the same permuted order used by BSD md5-crypt ($1$).  */
-  write_itoa64_4 (output + saltlen +  1, s->dg[12], s->dg[ 6], s->dg[0]);
-  write_itoa64_4 (output + saltlen +  5, s->dg[13], s->dg[ 7], s->dg[1]);
-  write_itoa64_4 (output + saltlen +  9, s->dg[14], s->dg[ 8], s->dg[2]);
-  write_itoa64_4 (output + saltlen + 13, s->dg[15], s->dg[ 9], s->dg[3]);
-  write_itoa64_4 (output + saltlen + 17, s->dg[ 5], s->dg[10], s->dg[4]);
-  write_itoa64_2 (output + saltlen + 21, s->dg[11], 0, 0);
-  *(output + saltlen + 23) = '\0';
+  sunmd5_format_output (setting, saltlen, s->dg, output);
+}
+
+/* The longest message hashed in one of the stretching rounds, after
+   padding: the previous digest, the quotation, and the decimal round
+   number, plus at least 9 bytes of padding, rounded up to a whole
+   64-byte block.  Without the quotation, the message always fits in
+   one block.  */
+#define SUNMD5_ROUND_MSG_MAX \
+  ((16 + sizeof hamlet_quotation + 10 + 9 + 63) / 64 * 64)
+
+/* One of the hashes that crypt_sunmd5_batch_rn has in progress.  */
+struct sunmd5_batch_slot
+{
+  size_t lane;            /* index into the caller's array of lanes */
+  size_t saltlen;
+  unsigned int nrounds;
+  unsigned int i;         /* current round */
+  bool quoted;            /* whether this round includes the quotation */
+  size_t pos;             /* offset of the next block to hash */
+  size_t end;             /* length of the message, with the padding */
+  uint8_t dg[16];
+  uint8_t short_msg[64];
+  /* This holds the quotation from when the lane is started, so that
+     only the parts before and after it need to be written in each
+     round.  */
+  uint8_t long_msg[SUNMD5_ROUND_MSG_MAX];
+};
+
+/* Scratch space for crypt_sunmd5_batch_rn.  */
+struct sunmd5_batch_buffer
+{
+  MD5_CTX ctx;
+  uint32_t state[CRYPT_BATCH_LANES][4];
+  struct sunmd5_batch_slot slot[CRYPT_BATCH_LANES];
+};
+
+static_assert (sizeof (struct sunmd5_batch_buffer) <= ALG_BATCH_SPECIFIC_SIZE,
+               "ALG_BATCH_SPECIFIC_SIZE is too small for SUNMD5");
+static_assert (CRYPT_BATCH_LANES <= MD5_MB_MAX_LANES,
+               "MD5_Transform_MB cannot handle CRYPT_BATCH_LANES");
+
+/* Subroutine of crypt_sunmd5_batch_rn: Set up SLOT's message and
+   STATE for stretching round SLOT->i, the same sequence of inputs as
+   in crypt_sunmd5_rn.  */
+static void
+sunmd5_batch_round (struct sunmd5_batch_slot *slot, uint32_t state[4])
+{
+  uint8_t *m;
+  size_t len, padded;
+
+  /* The trailing nul is intentionally included.  */
+  slot->quoted = muffet_coin_toss (slot->dg, slot->i);
+  if (slot->quoted)
+    {
+      m = slot->long_msg;
+      len = 16 + sizeof hamlet_quotation;
+    }
+  else
+    {
+      m = slot->short_msg;
+      len = 16;
+    }
+  memcpy (m, slot->dg, 16);
+
+  /* The round number in decimal, without snprintf, which would cost
+     about as much as hashing the rest of a short message.  */
+  char rn[10];
+  size_t nd = 0;
+  unsigned int i = slot->i;
+  do
+    {
+      rn[nd++] = (char) ('0' + i % 10);
+      i /= 10;
+    }
+  while (i);
+  while (nd)
+    m[len++] = (uint8_t) rn[--nd];
+
+  padded = (len + 9 + 63) / 64 * 64;
+  m[len] = 0x80;
+  memset (m + len + 1, 0, padded - len - 1 - 8);
+  cpu_to_le64 (m + padded - 8, (uint64_t) len << 3);
+  slot->pos = 0;
+  slot->end = padded;
+
+  state[0] = 0x67452301;
+  state[1] = 0xefcdab89;
+  state[2] = 0x98badcfe;
+  state[3] = 0x10325476;
+}
+
+/* Hash several passphrases at once.  Whether a round includes the
+   quotation depends on the digest so far, so the lanes' messages do
+   not stay the same length; instead, each slot of the multi-buffer
+   MD5 engine works through one lane a block at a time, and moves on
+   to its next round, or to the next lane, as soon as it can.  */
+void
+crypt_sunmd5_batch_rn (struct crypt_batch_lane *lanes, size_t nlanes,
+                       void *scratch, size_t scr_size)
+{
+  size_t nslots = MIN (MD5_Transform_MB_lanes (), CRYPT_BATCH_LANES);
+
+  /* Without a SIMD implementation of the compression function, there is
+     nothing to gain from hashing the lanes together.  */
+  if (nslots == 1 || scr_size < sizeof (struct sunmd5_batch_buffer))
+    {
+      for (size_t l = 0; l < nlanes; l++)
+        crypt_sunmd5_rn (lanes[l].phrase, lanes[l].phr_size,
+                         lanes[l].setting, lanes[l].set_size,
+                         lanes[l].output, lanes[l].out_size,
+                         scratch, scr_size);
+      return;
+    }
+
+  struct sunmd5_batch_buffer *bb = scratch;
+  const uint8_t *blocks[CRYPT_BATCH_LANES];
+  size_t next = 0, active = 0, s;
+
+  for (;;)
+    {
+      /* Fill the free slots with lanes that have not been started.  */
+      while (active < nslots && next < nlanes)
+        {
+          const struct crypt_batch_lane *lane = &lanes[next];
+          struct sunmd5_batch_slot *slot = &bb->slot[active];
+
+          slot->lane = next++;
+          if (!sunmd5_parse_setting (lane->setting, &slot->nrounds,
+                                     &slot->saltlen)
+              || lane->out_size < slot->saltlen + SUNMD5_BARE_OUTPUT_LEN + 2)
+            continue;
+
+          /* Initial round.  */
+          MD5_Init (&bb->ctx);
+          MD5_Update (&bb->ctx, lane->phrase, lane->phr_size);
+          MD5_Update (&bb->ctx, lane->setting, slot->saltlen);
+          MD5_Final (slot->dg, &bb->ctx);
+
+          if (slot->nrounds == 0)
+            {
+              sunmd5_format_output (lane->setting, slot->saltlen,
+                                    slot->dg, lane->output);
+              continue;
+            }
+          memcpy (slot->long_msg + 16, hamlet_quotation,
+                  sizeof hamlet_quotation);
+          slot->i = 0;
+          sunmd5_batch_round (slot, bb->state[active]);
+          active++;
+        }
+      if (active == 0)
+        break;
+
+      for (s = 0; s < active; s++)
+        blocks[s] = (bb->slot[s].quoted ? bb->slot[s].long_msg
+                     : bb->slot[s].short_msg) + bb->slot[s].pos;
+      MD5_Transform_MB (bb->state, blocks, active);
+
+      for (s = 0; s < active; )
+        {
+          struct sunmd5_batch_slot *slot = &bb->slot[s];
+          const struct crypt_batch_lane *lane = &lanes[slot->lane];
+
+          slot->pos += 64;
+          if (slot->pos < slot->end)
+            {
+              s++;
+              continue;
+            }
+
+          cpu_to_le32 (slot->dg +  0, bb->state[s][0]);
+          cpu_to_le32 (slot->dg +  4, bb->state[s][1]);
+          cpu_to_le32 (slot->dg +  8, bb->state[s][2]);
+          cpu_to_le32 (slot->dg + 12, bb->state[s][3]);
+          if (++slot->i < slot->nrounds)
+            {
+              sunmd5_batch_round (slot, bb->state[s]);
+              s++;
+              continue;
+            }
+
+          sunmd5_format_output (lane->setting, slot->saltlen, slot->dg,
+                                lane->output);
+
+          /* Move the last active slot into this one.  */
+          if (s != --active)
+            {
+              *slot = bb->slot[active];
+              memcpy (bb->state[s], bb->state[active], sizeof bb->state[s]);
+            }
+        }
+    }
 }
 
 void
@@ -0,0 +1,133 @@
+/* Process-wide settings for how hashes are computed.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+
+/* Current values, indexed by the CRYPT_TUNE_* constants.  Element 0 is
+   not used.  They are read and written with relaxed atomic operations:
+   a hash that is already in progress when a value changes may use
+   either the old or the new value.  */
+static long tunables[] =
+{
+  [CRYPT_TUNE_THREADS] = 1,
+  [CRYPT_TUNE_KEEP_MEMORY] = 0,
+  [CRYPT_TUNE_MEMORY_POLICY] = CRYPT_MEMORY_HUGETLB,
+  [CRYPT_TUNE_MEMORY_OBTAINED] = 0,
+  [CRYPT_TUNE_SELF_TEST] = CRYPT_SELF_TEST_ALWAYS,
+  [CRYPT_TUNE_ASYNC_THREADS] = 0,
+  [CRYPT_TUNE_ASYNC_QUEUE] = 64,
+};
+
+long
+get_tunable (int knob)
+{
+  return __atomic_load_n (&tunables[knob], __ATOMIC_RELAXED);
+}
+
+void
+store_tunable (int knob, long value)
+{
+  __atomic_store_n (&tunables[knob], value, __ATOMIC_RELAXED);
+}
+
+#if INCLUDE_crypt_set_tunable
+int
+crypt_set_tunable (int knob, long value)
+{
+  switch (knob)
+    {
+    case CRYPT_TUNE_THREADS:
+      if (value < 1 || value > MAX_LANE_THREADS)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+#ifndef HAVE_PTHREADS
+      if (value > 1)
+        {
+          errno = ENOTSUP;
+          return -1;
+        }
+#endif
+      break;
+
+    case CRYPT_TUNE_KEEP_MEMORY:
+      if (value < 0)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+#ifndef HAVE_PTHREADS
+      if (value > 0)
+        {
+          errno = ENOTSUP;
+          return -1;
+        }
+#endif
+      break;
+
+    case CRYPT_TUNE_MEMORY_POLICY:
+      if (value & ~(long) (CRYPT_MEMORY_HUGETLB | CRYPT_MEMORY_THP
+                           | CRYPT_MEMORY_POPULATE))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+      break;
+
+    case CRYPT_TUNE_SELF_TEST:
+      if (value != CRYPT_SELF_TEST_ALWAYS && value != CRYPT_SELF_TEST_ONCE)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+      break;
+
+    case CRYPT_TUNE_ASYNC_THREADS:
+      if (value < 0 || value > MAX_LANE_THREADS)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+      break;
+
+    case CRYPT_TUNE_ASYNC_QUEUE:
+      if (value < 1)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+      break;
+
+    default:
+      errno = EINVAL;
+      return -1;
+    }
+
+  store_tunable (knob, value);
+  return 0;
+}
+SYMVER_crypt_set_tunable;
+#endif
+
+#if INCLUDE_crypt_get_tunable
+long
+crypt_get_tunable (int knob)
+{
+  if (knob <= 0 || (size_t) knob >= ARRAY_SIZE (tunables))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  return get_tunable (knob);
+}
+SYMVER_crypt_get_tunable;
+#endif
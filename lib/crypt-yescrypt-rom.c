@@ -0,0 +1,270 @@
+/* Creating and loading yescrypt ROMs.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   A yescrypt ROM is a large read-only array that every hash with the
+   NROM parameter reads from, in addition to its own working memory.
+   Filling it costs as much as a yescrypt hash of the same size, so it
+   is computed once by crypt_rom_create and stored in a file, which
+   crypt_rom_load maps read-only and shared, so that all the processes
+   that use it have a single copy in memory.  The file is just the ROM
+   itself; yescrypt_init_shared puts a tag and a digest of the ROM in
+   its last 48 bytes.  The digest can only be recomputed from the seed,
+   which crypt_rom_load does not have, so it only checks the tag: that
+   rejects files that are not ROMs, but not a ROM that was damaged,
+   whose hashes will simply fail to match.  */
+
+#include "crypt-port.h"
+#include "alg-yescrypt.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __unix__
+#include <sys/mman.h>
+#endif
+#ifdef __linux__
+#include <sys/vfs.h>
+#endif
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+#if INCLUDE_yescrypt || INCLUDE_scrypt || INCLUDE_gost_yescrypt
+#ifdef MAP_SHARED
+#define HAVE_ROM 1
+
+/* The block size of ROMs made by crypt_rom_create, in units of 128
+   bytes.  It is the same as crypt_gensalt uses for all but the two
+   lowest costs.  */
+#define ROM_R 32
+
+/* ROMs must be a power of two in size, and at least this big.  */
+#define ROM_MIN_SIZE ((size_t) 1 << 20)
+
+/* The loaded ROM, if any.  Hashes hold the lock for reading while they
+   use the ROM, so that crypt_rom_load cannot unmap it under them.  */
+static yescrypt_shared_t rom;
+#ifdef HAVE_PTHREADS
+static pthread_rwlock_t rom_lock = PTHREAD_RWLOCK_INITIALIZER;
+#define rom_rdlock() pthread_rwlock_rdlock (&rom_lock)
+#define rom_wrlock() pthread_rwlock_wrlock (&rom_lock)
+#define rom_unlock() pthread_rwlock_unlock (&rom_lock)
+#else
+#define rom_rdlock() 0
+#define rom_wrlock() 0
+#define rom_unlock() ((void) 0)
+#endif
+
+static bool
+rom_size_ok (uint64_t size)
+{
+  return size >= ROM_MIN_SIZE && size <= SIZE_MAX && !(size & (size - 1));
+}
+
+#endif /* MAP_SHARED */
+
+const yescrypt_shared_t *
+yescrypt_rom_acquire (void)
+{
+#ifdef HAVE_ROM
+  if (rom_rdlock ())
+    return NULL;
+  if (rom.aligned)
+    return &rom;
+  rom_unlock ();
+#endif
+  return NULL;
+}
+
+void
+yescrypt_rom_release (const yescrypt_shared_t *shared)
+{
+#ifdef HAVE_ROM
+  if (shared)
+    rom_unlock ();
+#else
+  (void) shared;
+#endif
+}
+#endif /* INCLUDE_yescrypt || INCLUDE_scrypt || INCLUDE_gost_yescrypt */
+
+#if INCLUDE_crypt_rom_create
+int
+crypt_rom_create (const char *path, const void *seed, int seedlen,
+                  unsigned long size)
+{
+#ifdef HAVE_ROM
+  yescrypt_shared_t shared;
+  yescrypt_params_t params =
+  {
+    .flags = YESCRYPT_DEFAULTS | YESCRYPT_SHARED_PREALLOCATED,
+    .r = ROM_R,
+    .p = 1,
+    .NROM = size / (128 * ROM_R),
+  };
+  void *base;
+  int fd, err;
+
+  if (!path || seedlen < 0 || (!seed && seedlen) || !rom_size_ok (size))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  /* Never write over an existing file: processes that have it mapped
+     would see the ROM change, or get SIGBUS if it shrank.  */
+  fd = open (path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return -1;
+  if (ftruncate (fd, (off_t) size))
+    goto fail;
+  base = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED)
+    goto fail;
+
+  shared.base = NULL;
+  shared.base_size = 0;
+  shared.aligned = base;
+  shared.aligned_size = size;
+  if (yescrypt_init_shared (&shared, seed, (size_t) seedlen, &params))
+    {
+      munmap (base, size);
+      goto fail;
+    }
+  if (munmap (base, size) || fsync (fd) || close (fd))
+    {
+      err = errno;
+      unlink (path);
+      errno = err;
+      return -1;
+    }
+  return 0;
+
+ fail:
+  err = errno;
+  close (fd);
+  unlink (path);
+  errno = err;
+  return -1;
+#else
+  (void) path;
+  (void) seed;
+  (void) seedlen;
+  (void) size;
+  errno = ENOTSUP;
+  return -1;
+#endif
+}
+SYMVER_crypt_rom_create;
+#endif
+
+#if INCLUDE_crypt_rom_load
+int
+crypt_rom_load (const char *path)
+{
+#ifdef HAVE_ROM
+  yescrypt_shared_t new_rom, old_rom;
+  long policy = get_tunable (CRYPT_TUNE_MEMORY_POLICY);
+  long obtained = 0;
+  int flags = MAP_SHARED;
+  struct stat st;
+  uint64_t *tag;
+  int fd, err;
+
+  new_rom.base = new_rom.aligned = NULL;
+  new_rom.base_size = new_rom.aligned_size = 0;
+
+  if (path)
+    {
+      fd = open (path, O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+        return -1;
+      if (fstat (fd, &st))
+        goto fail;
+      if (!S_ISREG (st.st_mode) || st.st_size < 0
+          || !rom_size_ok ((uint64_t) st.st_size))
+        {
+          errno = EINVAL;
+          goto fail;
+        }
+      new_rom.base_size = new_rom.aligned_size = (size_t) st.st_size;
+
+#ifdef MAP_POPULATE
+      if (policy & CRYPT_MEMORY_POPULATE)
+        flags |= MAP_POPULATE;
+#endif
+      new_rom.base = mmap (NULL, new_rom.base_size, PROT_READ, flags, fd, 0);
+      if (new_rom.base == MAP_FAILED)
+        goto fail;
+      new_rom.aligned = new_rom.base;
+
+      /* Explicit huge pages come from placing the file on hugetlbfs,
+         which the policy cannot ask for, only report.  Otherwise
+         the kernel may collapse read-only file pages into
+         transparent huge pages, if it is asked to.  */
+#ifdef __linux__
+      struct statfs sfs;
+      if (!fstatfs (fd, &sfs) && sfs.f_type == 0x958458f6)
+        obtained |= CRYPT_MEMORY_HUGETLB;
+#endif
+#ifdef MADV_HUGEPAGE
+      if (!(obtained & CRYPT_MEMORY_HUGETLB) && (policy & CRYPT_MEMORY_THP)
+          && !madvise (new_rom.base, new_rom.base_size, MADV_HUGEPAGE))
+        obtained |= CRYPT_MEMORY_THP;
+#endif
+#ifdef MAP_POPULATE
+      if (flags & MAP_POPULATE)
+        obtained |= CRYPT_MEMORY_POPULATE;
+#endif
+      close (fd);
+
+      tag = (uint64_t *) (void *)
+        ((uint8_t *) new_rom.aligned + new_rom.aligned_size - 48);
+      if (tag[0] != YESCRYPT_ROM_TAG1 || tag[1] != YESCRYPT_ROM_TAG2)
+        {
+          munmap (new_rom.base, new_rom.base_size);
+          errno = EINVAL;
+          return -1;
+        }
+      store_tunable (CRYPT_TUNE_MEMORY_OBTAINED, obtained);
+    }
+
+  if (rom_wrlock ())
+    {
+      if (new_rom.base)
+        munmap (new_rom.base, new_rom.base_size);
+      errno = EAGAIN;
+      return -1;
+    }
+  old_rom = rom;
+  rom = new_rom;
+  rom_unlock ();
+
+  if (old_rom.base)
+    munmap (old_rom.base, old_rom.base_size);
+  return 0;
+
+ fail:
+  err = errno;
+  close (fd);
+  errno = err;
+  return -1;
+#else
+  (void) path;
+  errno = ENOTSUP;
+  return -1;
+#endif
+}
+SYMVER_crypt_rom_load;
+#endif
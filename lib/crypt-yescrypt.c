@@ -34,6 +34,14 @@ typedef struct
 static_assert (sizeof (crypt_yescrypt_internal_t) <= ALG_SPECIFIC_SIZE,
                "ALG_SPECIFIC_SIZE is too small for YESCRYPT.");
 
+#if INCLUDE_yescrypt
+const size_t crypt_yescrypt_scratch_size = sizeof (crypt_yescrypt_internal_t);
+#endif
+/* crypt_scrypt_rn hands its scratch area to crypt_yescrypt_rn.  */
+#if INCLUDE_scrypt
+const size_t crypt_scrypt_scratch_size = sizeof (crypt_yescrypt_internal_t);
+#endif
+
 void
 crypt_yescrypt_rn (const char *phrase, size_t phr_size,
                    const char *setting, size_t set_size,
@@ -72,18 +80,22 @@ crypt_yescrypt_rn (const char *phrase, size_t phr_size,
 
   crypt_yescrypt_internal_t *intbuf = scratch;
 
-  if (yescrypt_init_local (&intbuf->local))
+  if (yescrypt_init_local_cached (&intbuf->local))
     return;
 
-  intbuf->retval = yescrypt_r (NULL, &intbuf->local,
+  /* Settings with the NROM parameter use the ROM loaded with
+     crypt_rom_load; yescrypt_r ignores it for the others.  */
+  const yescrypt_shared_t *rom = yescrypt_rom_acquire ();
+  intbuf->retval = yescrypt_r (rom, &intbuf->local,
                                (const uint8_t *)phrase, phr_size,
                                (const uint8_t *)setting, NULL,
                                intbuf->outbuf, o_size);
+  yescrypt_rom_release (rom);
 
   if (!intbuf->retval)
     errno = EINVAL;
 
-  if (yescrypt_free_local (&intbuf->local) || !intbuf->retval)
+  if (yescrypt_free_local_cached (&intbuf->local) || !intbuf->retval)
     return;
 
   strcpy_or_abort (output, o_size, intbuf->outbuf);
@@ -101,10 +113,10 @@ crypt_yescrypt_rn (const char *phrase, size_t phr_size,
  * Since O_SIZE is guaranteed to be greater than 2, we may fill OUTPUT
  * with a short failure token when need.
  */
-void
-gensalt_yescrypt_rn (unsigned long count,
-                     const uint8_t *rbytes, size_t nrbytes,
-                     uint8_t *output, size_t o_size)
+static void
+gensalt_yescrypt (unsigned long count, bool use_rom,
+                  const uint8_t *rbytes, size_t nrbytes,
+                  uint8_t *output, size_t o_size)
 {
   /* Up to 512 bits (64 bytes) of entropy for computing the salt portion
      of the MCF-setting are supported.  */
@@ -164,6 +176,21 @@ gensalt_yescrypt_rn (unsigned long count,
       params.N = 1ULL << (count + 7); // 3 -> 1024, 4 -> 2048, ... 11 -> 262144
     }
 
+  /* Settings only ask for the loaded ROM when the caller asked for one
+     with crypt_gensalt_rom_rn, since the hashes made with them cannot
+     be checked without it.  */
+  if (use_rom)
+    {
+      const yescrypt_shared_t *rom = yescrypt_rom_acquire ();
+      if (!rom)
+        {
+          errno = ENOENT;
+          return;
+        }
+      params.NROM = rom->aligned_size / (128 * params.r);
+      yescrypt_rom_release (rom);
+    }
+
   if (!yescrypt_encode_params_r (&params, rbytes, nrbytes, outbuf, o_size))
     {
       errno = ERANGE;
@@ -174,4 +201,20 @@ gensalt_yescrypt_rn (unsigned long count,
   return;
 }
 
+void
+gensalt_yescrypt_rn (unsigned long count,
+                     const uint8_t *rbytes, size_t nrbytes,
+                     uint8_t *output, size_t o_size)
+{
+  gensalt_yescrypt (count, false, rbytes, nrbytes, output, o_size);
+}
+
+void
+gensalt_yescrypt_rom_rn (unsigned long count,
+                         const uint8_t *rbytes, size_t nrbytes,
+                         uint8_t *output, size_t o_size)
+{
+  gensalt_yescrypt (count, true, rbytes, nrbytes, output, o_size);
+}
+
 #endif /* INCLUDE_gost_yescrypt || INCLUDE_yescrypt */
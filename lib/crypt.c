@@ -38,6 +38,26 @@ static_assert(sizeof (struct crypt_internal) + alignof (struct crypt_internal)
               <= CRYPT_DATA_INTERNAL_SIZE,
               "crypt_data.internal is too small for crypt_internal");
 
+/* When several passphrases are hashed as a group (see
+   crypt_verify_many), the same storage is divided up differently:
+   the algorithm module gets a larger scratch area, shared by all the
+   passphrases in the group, and each passphrase gets its own output
+   buffer.  */
+struct crypt_internal_batch
+{
+  char alignas (alignof (max_align_t)) alg_specific[ALG_BATCH_SPECIFIC_SIZE];
+  char output[CRYPT_BATCH_LANES * CRYPT_OUTPUT_SIZE];
+};
+
+static_assert(sizeof (struct crypt_internal_batch)
+              + alignof (struct crypt_internal_batch)
+              <= CRYPT_DATA_INTERNAL_SIZE,
+              "crypt_data.internal is too small for crypt_internal_batch");
+static_assert(alignof (struct crypt_internal_batch)
+              == alignof (struct crypt_internal),
+              "crypt_internal_batch and crypt_internal must have "
+              "the same alignment");
+
 /* struct crypt_data is allocated by application code and contains
    only char-typed fields, so its 'internal' field may not be
    sufficiently aligned.  */
@@ -50,6 +70,12 @@ get_internal (struct crypt_data *data)
   return (struct crypt_internal *)internalp;
 }
 
+static inline struct crypt_internal_batch *
+get_internal_batch (struct crypt_data *data)
+{
+  return (struct crypt_internal_batch *) get_internal (data);
+}
+
 typedef void (*crypt_fn) (const char *phrase, size_t phr_size,
                           const char *setting, size_t set_size,
                           uint8_t *output, size_t out_size,
@@ -59,6 +85,20 @@ typedef void (*gensalt_fn) (unsigned long count,
                             const uint8_t *rbytes, size_t nrbytes,
                             uint8_t *output, size_t output_size);
 
+/* Optional entry point that hashes all the passphrases in LANES.
+   Its effect on each lane's output buffer must be the same as that of
+   calling the corresponding crypt_fn on that lane by itself.  */
+typedef void (*crypt_batch_fn) (struct crypt_batch_lane *lanes,
+                                size_t nlanes,
+                                void *scratch, size_t scr_size);
+
+/* Optional entry point that returns a number for a passphrase and
+   setting, such that crypt_batch can hash entries with equal numbers
+   together more efficiently than others.  */
+typedef uint64_t (*crypt_batch_key_fn) (const char *phrase, size_t phr_size,
+                                        const char *setting,
+                                        size_t set_size);
+
 struct hashfn
 {
   const char *prefix;
@@ -69,6 +109,13 @@ struct hashfn
      be set larger than the size of an internal buffer in crypt_gensalt_rn.  */
   unsigned char nrbytes;
   unsigned char is_strong;
+  crypt_batch_fn crypt_batch;
+  /* The largest group crypt_verify_many will pass to crypt_batch.  */
+  unsigned char batch_lanes;
+  crypt_batch_key_fn batch_key;
+  /* How many bytes at the start of its scratch area crypt may write.
+     The rest is never touched, so it does not need to be erased.  */
+  const size_t *scratch_size;
 };
 
 static const struct hashfn hash_algorithms[] =
@@ -87,26 +134,22 @@ is_des_salt_char (char c)
 }
 #endif
 
+/* Find the hashing method for SETTING.  HASH_ALGORITHM_DISPATCH is a
+   tree of switch statements, generated from the enabled prefixes, that
+   looks at only as many characters of SETTING as it takes to tell the
+   prefixes apart and then compares it against the one prefix that can
+   still match, so the cost does not grow with the number of methods.
+   Settings with no prefix are DES, if they look like one.  */
 static const struct hashfn *
 get_hashfn (const char *setting)
 {
-  const struct hashfn *h;
-  for (h = hash_algorithms; h->prefix; h++)
-    {
-      if (h->plen > 0)
-        {
-          if (!strncmp (setting, h->prefix, h->plen))
-            return h;
-        }
+  HASH_ALGORITHM_DISPATCH (setting, hash_algorithms);
+
 #if INCLUDE_descrypt || INCLUDE_bigcrypt
-      else
-        {
-          if (setting[0] == '\0' ||
-              (is_des_salt_char (setting[0]) && is_des_salt_char (setting[1])))
-            return h;
-        }
+  if (setting[0] == '\0' ||
+      (is_des_salt_char (setting[0]) && is_des_salt_char (setting[1])))
+    return &hash_algorithms[HASH_ALGORITHM_DES_ENTRY];
 #endif
-    }
   return 0;
 }
 
@@ -180,11 +223,307 @@ do_crypt (const char *phrase, const char *setting, struct crypt_data *data)
             (unsigned char *)data->output, sizeof data->output,
             cint->alg_specific, sizeof cint->alg_specific);
 
-  explicit_bzero (data->internal, sizeof data->internal);
-  explicit_bzero (data->reserved, sizeof data->reserved);
+  explicit_bzero (cint->alg_specific, *h->scratch_size);
   data->initialized = 0;
 }
 
+#if INCLUDE_crypt_rn || INCLUDE_crypt_ra
+/* Like do_crypt, but honor the 'threads' field of DATA, up to
+   CRYPT_TUNE_THREADS (see lane_threads).  Only crypt_rn and crypt_ra
+   use this: their callers must clear the whole object before its
+   first use, whereas crypt_r's callers need only clear 'initialized',
+   so that field may hold garbage there.  */
+static void
+do_crypt_threads (const char *phrase, const char *setting,
+                  struct crypt_data *data)
+{
+  unsigned int nthreads = data->threads;
+  if (nthreads)
+    set_call_threads (nthreads);
+  do_crypt (phrase, setting, data);
+  if (nthreads)
+    set_call_threads (0);
+}
+#endif
+
+#if INCLUDE_crypt_verify_many
+/* Report whether OUTPUT, as written by a hashing method, is the same
+   string as SETTING, which is SET_SIZE bytes long.  The comparison
+   takes the same amount of time no matter where the first mismatch
+   is, so it does not reveal how much of the hash was guessed
+   correctly.  (The length of a hash is not secret.)  */
+static int
+hash_matches (const uint8_t *output, size_t out_size,
+              const char *setting, size_t set_size)
+{
+  if (set_size >= out_size || output[set_size] != '\0')
+    return 0;
+
+  uint8_t diff = 0;
+  for (size_t i = 0; i < set_size; i++)
+    diff |= (uint8_t) (output[i] ^ (uint8_t) setting[i]);
+
+  return diff == 0;
+}
+
+/* Hash all of the passphrases in LANES, which use the hashing method H,
+   and record in ITEMS whether each of them matched.  LANE_ITEM maps
+   lanes to indices into ITEMS.  Returns the number of matches.
+   A method leaves the failure token in a lane's output when it
+   rejects the setting, but also when the hash would not fit in the
+   lane, which can be smaller than CRYPT_OUTPUT_SIZE.  No hash begins
+   with '*', so such lanes are hashed again on their own, with a
+   full-size buffer, and reported as invalid if that fails too, as
+   crypt_rn would have.  */
+static int
+verify_group (const struct hashfn *h, struct crypt_batch_lane *lanes,
+              const int *lane_item, size_t nlanes,
+              struct crypt_verify_item *items,
+              struct crypt_internal_batch *cint)
+{
+  int matched = 0;
+
+  if (h->crypt_batch)
+    h->crypt_batch (lanes, nlanes,
+                    cint->alg_specific, sizeof cint->alg_specific);
+  else
+    for (size_t l = 0; l < nlanes; l++)
+      h->crypt (lanes[l].phrase, lanes[l].phr_size,
+                lanes[l].setting, lanes[l].set_size,
+                lanes[l].output, lanes[l].out_size,
+                cint->alg_specific, sizeof cint->alg_specific);
+
+  for (size_t l = 0; l < nlanes; l++)
+    {
+      const uint8_t *output = lanes[l].output;
+      size_t out_size = lanes[l].out_size;
+      uint8_t full[CRYPT_OUTPUT_SIZE];
+
+      if (output[0] == '*' && out_size < sizeof full)
+        {
+          make_failure_token (lanes[l].setting, (char *) full,
+                              (int) sizeof full);
+          h->crypt (lanes[l].phrase, lanes[l].phr_size,
+                    lanes[l].setting, lanes[l].set_size,
+                    full, sizeof full,
+                    cint->alg_specific, sizeof cint->alg_specific);
+          output = full;
+          out_size = sizeof full;
+        }
+
+      if (output[0] == '*')
+        items[lane_item[l]].result = CRYPT_VERIFY_INVALID;
+      else if (hash_matches (output, out_size,
+                             lanes[l].setting, lanes[l].set_size))
+        {
+          items[lane_item[l]].result = CRYPT_VERIFY_MATCH;
+          matched++;
+        }
+      else
+        items[lane_item[l]].result = CRYPT_VERIFY_MISMATCH;
+
+      if (output == full)
+        explicit_bzero (full, sizeof full);
+    }
+
+  return matched;
+}
+
+/* One entry of the order in which crypt_verify_many hashes the items
+   that use a method with a batch_key entry point.  */
+struct verify_order
+{
+  uint64_t key;
+  int item;
+};
+
+static int
+compare_verify_order (const void *a, const void *b)
+{
+  const struct verify_order *x = a, *y = b;
+  if (x->key != y->key)
+    return x->key < y->key ? -1 : 1;
+  return (x->item > y->item) - (x->item < y->item);
+}
+
+/* Fill *ORDER, which is allocated on first use with room for COUNT
+   entries, with the items whose result is TAG, sorted by their keys
+   for the method H.  Returns the number of such items, or 0 if there
+   is no memory, in which case the items are hashed in the order
+   given, which gives the same results, only more slowly.  */
+static size_t
+sort_items (const struct hashfn *h, int tag,
+            const struct crypt_verify_item *items, int count,
+            struct verify_order **order)
+{
+  if (!*order)
+    {
+      if ((size_t) count > SIZE_MAX / sizeof **order)
+        return 0;
+      *order = malloc ((size_t) count * sizeof **order);
+      if (!*order)
+        return 0;
+    }
+
+  size_t n = 0;
+  for (int i = 0; i < count; i++)
+    if (items[i].result == tag)
+      {
+        (*order)[n].key = h->batch_key (items[i].phrase,
+                                        strlen (items[i].phrase),
+                                        items[i].setting,
+                                        strlen (items[i].setting));
+        (*order)[n].item = i;
+        n++;
+      }
+  qsort (*order, n, sizeof **order, compare_verify_order);
+  return n;
+}
+
+int
+crypt_verify_many (struct crypt_verify_item *items, int count,
+                   void *data, int size)
+{
+  if (size < 0 || (size_t)size < sizeof (struct crypt_data))
+    {
+      errno = ERANGE;
+      return -1;
+    }
+  if (count < 0 || (count > 0 && !items))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  /* First pass: weed out invalid items and work out which hashing
+     method each of the others uses.  Until it has been hashed, the
+     'result' field of each valid item holds the negated, one-based
+     index of its method in hash_algorithms.  */
+  for (int i = 0; i < count; i++)
+    {
+      struct crypt_verify_item *item = &items[i];
+      item->result = CRYPT_VERIFY_INVALID;
+      if (!item->phrase || !item->setting ||
+          check_badsalt_chars (item->setting))
+        continue;
+
+      const struct hashfn *h = get_hashfn (item->setting);
+      if (h)
+        item->result = -(int) (h - hash_algorithms) - 1;
+    }
+
+  /* Second pass: hash the items one method at a time, in groups of
+     up to h->batch_lanes.  If the method has a batch_key entry point,
+     the items are taken in the order of their keys, and each group
+     only has items with the same key.  */
+  struct crypt_data *p = data;
+  struct crypt_internal_batch *cint = get_internal_batch (p);
+  struct crypt_batch_lane lanes[CRYPT_WIDE_BATCH_LANES];
+  int lane_item[CRYPT_WIDE_BATCH_LANES];
+  struct verify_order *order = 0;
+  int matched = 0;
+
+  if (p->threads)
+    set_call_threads (p->threads);
+
+  for (size_t k = 0; k < ARRAY_SIZE (hash_algorithms) - 1; k++)
+    {
+      const struct hashfn *h = &hash_algorithms[k];
+      const int tag = -(int) k - 1;
+      size_t max_lanes = h->batch_lanes;
+      size_t norder = 0;
+      bool deferred;
+
+      if (h->batch_key && count > 1)
+        norder = sort_items (h, tag, items, count, &order);
+
+      do
+        {
+          /* Items whose settings do not fit in this pass's output
+             buffers are left for another pass, with a single
+             full-size buffer.  */
+          size_t out_size = MIN (CRYPT_OUTPUT_SIZE,
+                                 sizeof cint->output / max_lanes);
+          size_t nlanes = 0;
+          uint64_t group_key = 0;
+          deferred = false;
+
+          for (size_t j = 0; j < (norder ? norder : (size_t) count); j++)
+            {
+              int i = norder ? order[j].item : (int) j;
+              struct crypt_verify_item *item = &items[i];
+              if (item->result != tag)
+                continue;
+
+              size_t phr_size = strlen (item->phrase);
+              if (phr_size >= CRYPT_MAX_PASSPHRASE_SIZE)
+                {
+                  item->result = CRYPT_VERIFY_INVALID;
+                  continue;
+                }
+
+              size_t set_size = strlen (item->setting);
+              if (set_size >= out_size && out_size < CRYPT_OUTPUT_SIZE)
+                {
+                  deferred = true;
+                  continue;
+                }
+
+              /* Entries with different keys gain nothing from being
+                 hashed together, and would only split up the runs of
+                 entries with the same key that come after them.  */
+              if (norder && nlanes > 0 && order[j].key != group_key)
+                {
+                  matched += verify_group (h, lanes, lane_item, nlanes,
+                                           items, cint);
+                  nlanes = 0;
+                }
+              if (norder)
+                group_key = order[j].key;
+
+              struct crypt_batch_lane *lane = &lanes[nlanes];
+              lane->phrase = item->phrase;
+              lane->phr_size = phr_size;
+              lane->setting = item->setting;
+              lane->set_size = set_size;
+              lane->output = (uint8_t *) cint->output + nlanes * out_size;
+              lane->out_size = out_size;
+              make_failure_token (lane->setting, (char *) lane->output,
+                                  (int) lane->out_size);
+              lane_item[nlanes] = i;
+
+              if (++nlanes == max_lanes)
+                {
+                  matched += verify_group (h, lanes, lane_item, nlanes,
+                                           items, cint);
+                  nlanes = 0;
+                }
+            }
+
+          if (nlanes > 0)
+            matched += verify_group (h, lanes, lane_item, nlanes,
+                                     items, cint);
+          max_lanes = 1;
+        }
+      while (deferred);
+    }
+
+  if (p->threads)
+    set_call_threads (0);
+  if (order)
+    {
+      /* The keys can reveal the lengths of the passphrases.  */
+      explicit_bzero (order, (size_t) count * sizeof *order);
+      free (order);
+    }
+  explicit_bzero (p->internal, sizeof p->internal);
+  explicit_bzero (p->reserved, sizeof p->reserved);
+  p->initialized = 0;
+  return matched;
+}
+SYMVER_crypt_verify_many;
+#endif
+
 #if INCLUDE_crypt_rn
 char *
 crypt_rn (const char *phrase, const char *setting, void *data, int size)
@@ -197,7 +536,7 @@ crypt_rn (const char *phrase, const char *setting, void *data, int size)
     }
 
   struct crypt_data *p = data;
-  do_crypt (phrase, setting, p);
+  do_crypt_threads (phrase, setting, p);
   return p->output[0] == '*' ? 0 : p->output;
 }
 SYMVER_crypt_rn;
@@ -228,7 +567,7 @@ crypt_ra (const char *phrase, const char *setting, void **data, int *size)
 
   struct crypt_data *p = *data;
   make_failure_token (setting, p->output, sizeof p->output);
-  do_crypt (phrase, setting, p);
+  do_crypt_threads (phrase, setting, p);
   return p->output[0] == '*' ? 0 : p->output;
 }
 SYMVER_crypt_ra;
@@ -255,6 +594,39 @@ strong_alias (crypt_r, xcrypt_r);
 SYMVER_xcrypt_r;
 #endif
 
+#if INCLUDE_crypt_gensalt_rn || INCLUDE_crypt_gensalt_rom_rn
+/* Write a setting for the hashing method H to OUTPUT, using GENSALT,
+   which is H->gensalt or a variant of it.  If RBYTES is 0, read random
+   bytes from the operating system if possible.  */
+static char *
+make_setting (const struct hashfn *h, gensalt_fn gensalt,
+              unsigned long count, const char *rbytes, int nrbytes,
+              char *output, int output_size)
+{
+  char internal_rbytes[UCHAR_MAX] = "\0";
+  /* typeof (internal_nrbytes) == typeof (h->nrbytes).  */
+  unsigned char internal_nrbytes = 0;
+
+  if (!rbytes)
+    {
+      if (!get_random_bytes (internal_rbytes, h->nrbytes))
+        return 0;
+
+      rbytes = internal_rbytes;
+      nrbytes = internal_nrbytes = h->nrbytes;
+    }
+
+  gensalt (count,
+           (const unsigned char *)rbytes, (size_t)nrbytes,
+           (unsigned char *)output, (size_t)output_size);
+
+  if (internal_nrbytes)
+    explicit_bzero (internal_rbytes, internal_nrbytes);
+
+  return output[0] == '*' ? 0 : output;
+}
+#endif
+
 #if INCLUDE_crypt_gensalt_rn
 char *
 crypt_gensalt_rn (const char *prefix, unsigned long count,
@@ -294,29 +666,8 @@ crypt_gensalt_rn (const char *prefix, unsigned long count,
       return 0;
     }
 
-  char internal_rbytes[UCHAR_MAX] = "\0";
-  /* typeof (internal_nrbytes) == typeof (h->nrbytes).  */
-  unsigned char internal_nrbytes = 0;
-
-  /* If rbytes is 0, read random bytes from the operating system if
-     possible.  */
-  if (!rbytes)
-    {
-      if (!get_random_bytes (internal_rbytes, h->nrbytes))
-        return 0;
-
-      rbytes = internal_rbytes;
-      nrbytes = internal_nrbytes = h->nrbytes;
-    }
-
-  h->gensalt (count,
-              (const unsigned char *)rbytes, (size_t)nrbytes,
-              (unsigned char *)output, (size_t)output_size);
-
-  if (internal_nrbytes)
-    explicit_bzero (internal_rbytes, internal_nrbytes);
-
-  return output[0] == '*' ? 0 : output;
+  return make_setting (h, h->gensalt, count, rbytes, nrbytes,
+                       output, output_size);
 }
 SYMVER_crypt_gensalt_rn;
 #endif
@@ -333,6 +684,45 @@ strong_alias (crypt_gensalt_rn, xcrypt_gensalt_r);
 SYMVER_xcrypt_gensalt_r;
 #endif
 
+#if INCLUDE_crypt_gensalt_rom_rn
+char *
+crypt_gensalt_rom_rn (const char *prefix, unsigned long count,
+                      const char *rbytes, int nrbytes, char *output,
+                      int output_size)
+{
+  make_failure_token ("", output, output_size);
+
+  if (output_size < 3)
+    {
+      errno = ERANGE;
+      return 0;
+    }
+
+  /* Only the methods that can use a ROM are accepted, and there is no
+     default, so that a setting that needs the ROM is never made by
+     accident.  */
+  const struct hashfn *h = prefix ? get_hashfn (prefix) : 0;
+  gensalt_fn gensalt = 0;
+#if INCLUDE_yescrypt
+  if (h && h->gensalt == gensalt_yescrypt_rn)
+    gensalt = gensalt_yescrypt_rom_rn;
+#endif
+#if INCLUDE_gost_yescrypt
+  if (h && h->gensalt == gensalt_gost_yescrypt_rn)
+    gensalt = gensalt_gost_yescrypt_rom_rn;
+#endif
+  if (!gensalt)
+    {
+      errno = EINVAL;
+      return 0;
+    }
+
+  return make_setting (h, gensalt, count, rbytes, nrbytes,
+                       output, output_size);
+}
+SYMVER_crypt_gensalt_rom_rn;
+#endif
+
 #if INCLUDE_crypt_gensalt_ra
 char *
 crypt_gensalt_ra (const char *prefix, unsigned long count,
@@ -0,0 +1,301 @@
+/* Working memory for the memory-hard hashing methods.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   yescrypt, gost-yescrypt, scrypt and argon2id need far more memory
+   than fits in struct crypt_data.  It is mapped here, following
+   CRYPT_TUNE_MEMORY_POLICY, or taken from the arena of a crypt_ctx
+   bound to the calling thread; crypt_ctx_new maps its arenas here
+   too.  Each thread may also keep one region between hashes, as
+   allowed by CRYPT_TUNE_KEEP_MEMORY, whichever method used it.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#ifdef __unix__
+#include <sys/mman.h>
+#endif
+#ifdef __linux__
+#include <linux/mman.h> /* for MAP_HUGE_2MB */
+#endif
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#define HUGEPAGE_THRESHOLD (32 * 1024 * 1024)
+#ifdef __x86_64__
+#define HUGEPAGE_SIZE      (2 * 1024 * 1024)
+#endif
+
+void
+init_region (struct memory_region *region)
+{
+  region->base = region->aligned = NULL;
+  region->base_size = region->aligned_size = 0;
+}
+
+long
+map_region (struct memory_region *region, size_t size, long policy)
+{
+  size_t base_size = size;
+  uint8_t *base, *aligned;
+
+  init_region (region);
+#ifdef MAP_ANON
+  long obtained = 0;
+  unsigned int flags = MAP_ANON | MAP_PRIVATE;
+#ifdef MAP_NOCORE
+  flags |= MAP_NOCORE;
+#endif
+#ifdef MAP_POPULATE
+  if (policy & CRYPT_MEMORY_POPULATE)
+    flags |= MAP_POPULATE;
+#endif
+
+  base = aligned = MAP_FAILED;
+#if defined MAP_HUGETLB && defined MAP_HUGE_2MB && defined HUGEPAGE_SIZE
+  if ((policy & CRYPT_MEMORY_HUGETLB) && size >= HUGEPAGE_THRESHOLD
+      && size + HUGEPAGE_SIZE > size)
+    {
+      /* munmap fails on huge page mappings whose size is not a
+         multiple of the huge page size.  */
+      size_t new_size = (size + HUGEPAGE_SIZE - 1)
+                        & ~(size_t) (HUGEPAGE_SIZE - 1);
+      base = mmap (NULL, new_size, PROT_READ | PROT_WRITE,
+                   (int) (flags | MAP_HUGETLB | MAP_HUGE_2MB), -1, 0);
+      if (base != MAP_FAILED)
+        {
+          aligned = base;
+          base_size = new_size;
+          obtained |= CRYPT_MEMORY_HUGETLB;
+        }
+    }
+#endif
+#if defined MADV_HUGEPAGE && defined HUGEPAGE_SIZE
+  if (base == MAP_FAILED && (policy & CRYPT_MEMORY_THP)
+      && size >= HUGEPAGE_SIZE && size + HUGEPAGE_SIZE > size)
+    {
+      /* Transparent huge pages only back aligned huge pages, so map
+         one huge page more than needed and start at the first
+         boundary.  The memory must be advised before it is populated,
+         or it would be faulted in as small pages.  */
+      size_t new_size = size + HUGEPAGE_SIZE;
+      unsigned int thp_flags = flags;
+#ifdef MAP_POPULATE
+      thp_flags &= ~(unsigned int) MAP_POPULATE;
+#endif
+      base = mmap (NULL, new_size, PROT_READ | PROT_WRITE, (int) thp_flags,
+                   -1, 0);
+      if (base != MAP_FAILED)
+        {
+          aligned = base + (-(uintptr_t) base & (HUGEPAGE_SIZE - 1));
+          base_size = new_size;
+          if (!madvise (aligned, size, MADV_HUGEPAGE))
+            obtained |= CRYPT_MEMORY_THP;
+#if defined MADV_POPULATE_WRITE && defined MAP_POPULATE
+          if ((flags & MAP_POPULATE)
+              && !madvise (aligned, size, MADV_POPULATE_WRITE))
+            obtained |= CRYPT_MEMORY_POPULATE;
+#endif
+          flags = thp_flags;
+        }
+    }
+#endif
+  if (base == MAP_FAILED)
+    base = aligned = mmap (NULL, size, PROT_READ | PROT_WRITE, (int) flags,
+                           -1, 0);
+  if (base == MAP_FAILED)
+    return -1;
+#ifdef MAP_POPULATE
+  if (flags & MAP_POPULATE)
+    obtained |= CRYPT_MEMORY_POPULATE;
+#endif
+#else /* mmap not available */
+  long obtained = 0;
+  (void) policy;
+
+  if (size + 63 < size)
+    {
+      errno = ENOMEM;
+      return -1;
+    }
+  base = malloc (size + 63);
+  if (!base)
+    return -1;
+  aligned = base + (-(uintptr_t) base & 63);
+#endif
+
+  region->base = base;
+  region->aligned = aligned;
+  region->base_size = base_size;
+  region->aligned_size = size;
+  return obtained;
+}
+
+int
+populate_region (struct memory_region *region, bool lock)
+{
+#ifdef MAP_ANON
+  if (lock)
+    return mlock (region->aligned, region->aligned_size);
+#else
+  if (lock)
+    {
+      errno = ENOTSUP;
+      return -1;
+    }
+#endif
+  memset (region->aligned, 0, region->aligned_size);
+  return 0;
+}
+
+int
+unmap_region (struct memory_region *region)
+{
+  if (region->base)
+    {
+#ifdef MAP_ANON
+      if (munmap (region->base, region->base_size))
+        return -1;
+#else
+      free (region->base);
+#endif
+    }
+  init_region (region);
+  return 0;
+}
+
+void *
+alloc_region (struct memory_region *region, size_t size)
+{
+  /* The arena of a crypt_ctx bound to this thread is already mapped
+     and faulted in; free_region hands it back.  */
+  void *arena = ctx_arena_acquire (size);
+  if (arena)
+    {
+      region->base = region->aligned = arena;
+      region->base_size = region->aligned_size = size;
+      return arena;
+    }
+
+  long obtained = map_region (region, size,
+                              get_tunable (CRYPT_TUNE_MEMORY_POLICY));
+  if (obtained < 0)
+    return NULL;
+  store_tunable (CRYPT_TUNE_MEMORY_OBTAINED, obtained);
+  return region->aligned;
+}
+
+int
+free_region (struct memory_region *region)
+{
+  if (ctx_arena_release (region->aligned, region->aligned_size))
+    {
+      init_region (region);
+      return 0;
+    }
+  return unmap_region (region);
+}
+
+/* The region each thread keeps is attached to a thread-specific data
+   key, whose destructor frees it when the thread exits.  Without
+   thread support, nothing is kept.  */
+#ifdef HAVE_PTHREADS
+static pthread_key_t kept_region_key;
+static pthread_once_t kept_region_once = PTHREAD_ONCE_INIT;
+static bool kept_region_ok;
+
+static void
+kept_region_destroy (void *kept)
+{
+  unmap_region (kept);
+  free (kept);
+}
+
+static void
+kept_region_create (void)
+{
+  __atomic_store_n (&kept_region_ok,
+                    !pthread_key_create (&kept_region_key,
+                                         kept_region_destroy),
+                    __ATOMIC_RELEASE);
+}
+
+/* If the library is unloaded, the key's destructor would no longer
+   exist by the time other threads exit, so delete the key first.  */
+static void __attribute__ ((destructor))
+kept_region_unload (void)
+{
+  if (__atomic_load_n (&kept_region_ok, __ATOMIC_ACQUIRE))
+    {
+      void *kept = pthread_getspecific (kept_region_key);
+      pthread_key_delete (kept_region_key);
+      kept_region_ok = false;
+      if (kept)
+        kept_region_destroy (kept);
+    }
+}
+#endif
+
+void
+init_region_cached (struct memory_region *region)
+{
+  init_region (region);
+#ifdef HAVE_PTHREADS
+  if (pthread_once (&kept_region_once, kept_region_create)
+      || !__atomic_load_n (&kept_region_ok, __ATOMIC_ACQUIRE))
+    return;
+  struct memory_region *kept = pthread_getspecific (kept_region_key);
+  if (kept)
+    {
+      *region = *kept;
+      init_region (kept);
+    }
+#endif
+}
+
+int
+free_region_cached (struct memory_region *region)
+{
+  /* The arena of a crypt_ctx is never kept, but handed back.  */
+  if (ctx_arena_release (region->aligned, region->aligned_size))
+    {
+      init_region (region);
+      return 0;
+    }
+#ifdef HAVE_PTHREADS
+  long keep = get_tunable (CRYPT_TUNE_KEEP_MEMORY);
+  if (region->base && __atomic_load_n (&kept_region_ok, __ATOMIC_ACQUIRE)
+      && region->base_size <= (size_t) keep)
+    {
+      struct memory_region *kept = pthread_getspecific (kept_region_key);
+      if (!kept)
+        {
+          kept = malloc (sizeof *kept);
+          if (kept)
+            {
+              init_region (kept);
+              if (pthread_setspecific (kept_region_key, kept))
+                {
+                  free (kept);
+                  kept = NULL;
+                }
+            }
+        }
+      if (kept && !unmap_region (kept))
+        {
+          explicit_bzero (region->aligned, region->aligned_size);
+          *kept = *region;
+          init_region (region);
+          return 0;
+        }
+    }
+#endif
+  return unmap_region (region);
+}
@@ -0,0 +1,98 @@
+/* Finding out which x86 instruction set extensions the CPU has.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   The modules with code for several extensions each select one in a
+   function declared with CPU_DISPATCH, which asks cpu_supports.  */
+
+#include "crypt-port.h"
+
+#include <stdlib.h>
+
+/* The selectors declared with CPU_DISPATCH, filled in while the
+   library's constructors run.  There is one per module with SIMD
+   code, and at most two in any one module.  */
+#define MAX_CPU_SELECTORS 16
+static void (*selectors[MAX_CPU_SELECTORS]) (void);
+static size_t nselectors;
+
+/* The extensions cpu_supports may report.  */
+static unsigned int cpu_allowed = ~0u;
+
+void
+cpu_dispatch_register (void (*select) (void))
+{
+  if (nselectors == MAX_CPU_SELECTORS)
+    abort ();
+  selectors[nselectors++] = select;
+  select ();
+}
+
+unsigned int
+cpu_force_features (unsigned int features)
+{
+  unsigned int usable = 0;
+
+  cpu_allowed = features;
+  for (size_t i = 0; i < nselectors; i++)
+    selectors[i] ();
+
+  for (unsigned int f = CPU_SSE2; f <= CPU_AVX512F; f <<= 1)
+    if (cpu_supports (f))
+      usable |= f;
+  return usable;
+}
+
+bool
+cpu_supports (unsigned int features)
+{
+#ifdef HAVE_CPU_DISPATCH
+  unsigned int have = 0;
+
+  if ((features & cpu_allowed) != features)
+    return false;
+
+  /* The selectors run as constructors, possibly before libgcc has
+     filled in what __builtin_cpu_supports reads.  */
+  __builtin_cpu_init ();
+  /* Only ask about the extensions configure found the compiler to
+     know, since it rejects names it does not.  */
+#ifdef HAVE_X86_TARGET_SSE2
+  if (__builtin_cpu_supports ("sse2"))
+    have |= CPU_SSE2;
+#endif
+#ifdef HAVE_X86_TARGET_SSE41
+  if (__builtin_cpu_supports ("sse4.1"))
+    have |= CPU_SSE41;
+#endif
+#ifdef HAVE_X86_TARGET_SHA
+  if (__builtin_cpu_supports ("sha"))
+    have |= CPU_SHA;
+#endif
+#ifdef HAVE_YESCRYPT_AVX
+  if (__builtin_cpu_supports ("avx"))
+    have |= CPU_AVX;
+#endif
+#ifdef HAVE_YESCRYPT_XOP
+  if (__builtin_cpu_supports ("xop"))
+    have |= CPU_XOP;
+#endif
+#ifdef HAVE_X86_TARGET_AVX2
+  if (__builtin_cpu_supports ("avx2"))
+    have |= CPU_AVX2;
+#endif
+#ifdef HAVE_X86_TARGET_AVX512F
+  if (__builtin_cpu_supports ("avx512f"))
+    have |= CPU_AVX512F;
+#endif
+  return (features & have) == features;
+#else
+  (void) features;
+  return false;
+#endif
+}
@@ -0,0 +1,262 @@
+/* Spread independent pieces of one computation over several threads.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.  */
+
+#include "crypt-port.h"
+
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+struct lane_job
+{
+  void (*fn) (void *, uint32_t);
+  void *arg;
+  uint32_t nlanes;
+  uint32_t next;
+};
+
+/* Take lanes from JOB until there are none left.  */
+static void
+do_lanes (struct lane_job *job)
+{
+  uint32_t i;
+  while ((i = __atomic_fetch_add (&job->next, 1, __ATOMIC_RELAXED))
+         < job->nlanes)
+    job->fn (job->arg, i);
+}
+
+#ifdef HAVE_PTHREADS
+/* Starting threads for every hash would cost more than it saves for
+   hashes that take a millisecond or so, and argon2id calls run_lanes
+   several times per hash.  So the helper threads are started on first
+   use and then wait for work, until the library is unloaded.  The
+   pool works on one job at a time; a caller that finds it busy does
+   all of its lanes itself.
+
+   Everything below is protected by POOL_LOCK.  POOL_WANTED is the
+   number of helpers that may still join POOL_JOB, and POOL_ACTIVE the
+   number working on it.  */
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_idle = PTHREAD_COND_INITIALIZER;
+static pthread_t pool_threads[MAX_LANE_THREADS - 1];
+static uint32_t pool_size, pool_wanted, pool_active;
+static struct lane_job *pool_job;
+static bool pool_busy, pool_stopping, pool_atfork_registered;
+
+static void *
+lane_thread (void *unused)
+{
+  (void) unused;
+
+  pthread_mutex_lock (&pool_lock);
+  for (;;)
+    {
+      while (!pool_wanted && !pool_stopping)
+        pthread_cond_wait (&pool_work, &pool_lock);
+      if (pool_stopping)
+        break;
+
+      struct lane_job *job = pool_job;
+      pool_wanted--;
+      pool_active++;
+      pthread_mutex_unlock (&pool_lock);
+
+      do_lanes (job);
+
+      pthread_mutex_lock (&pool_lock);
+      if (--pool_active == 0)
+        pthread_cond_signal (&pool_idle);
+    }
+  pthread_mutex_unlock (&pool_lock);
+  return 0;
+}
+
+/* Hold POOL_LOCK across fork, so that the child sees the pool in a
+   consistent state.  */
+static void
+pool_atfork_prepare (void)
+{
+  pthread_mutex_lock (&pool_lock);
+}
+
+static void
+pool_atfork_parent (void)
+{
+  pthread_mutex_unlock (&pool_lock);
+}
+
+/* The helpers do not exist in the child of a fork, and neither does
+   any other thread that was using the pool.  */
+static void
+pool_atfork_child (void)
+{
+  pool_size = pool_wanted = pool_active = 0;
+  pool_job = 0;
+  pool_busy = false;
+  pthread_cond_init (&pool_work, 0);
+  pthread_cond_init (&pool_idle, 0);
+  pthread_mutex_unlock (&pool_lock);
+}
+
+/* Start helpers until there are NHELPERS of them, or as many as can
+   be started.  Called with POOL_LOCK held.  */
+static void
+grow_pool (uint32_t nhelpers)
+{
+  if (pool_size >= nhelpers)
+    return;
+  if (!pool_atfork_registered)
+    {
+      if (pthread_atfork (pool_atfork_prepare, pool_atfork_parent,
+                          pool_atfork_child))
+        return;
+      pool_atfork_registered = true;
+    }
+
+  /* The helper threads are ours; make sure none of the application's
+     signals are delivered to them.  */
+  sigset_t all, saved;
+  sigfillset (&all);
+  pthread_sigmask (SIG_SETMASK, &all, &saved);
+  while (pool_size < nhelpers
+         && pthread_create (&pool_threads[pool_size], 0, lane_thread, 0) == 0)
+    pool_size++;
+  pthread_sigmask (SIG_SETMASK, &saved, 0);
+}
+
+/* Stop the helpers when the library is unloaded or the program
+   exits.  Helpers finish the lanes they have taken; the rest of a job
+   that is still running, and any later one, is done by its caller.  */
+static void __attribute__ ((destructor))
+stop_pool (void)
+{
+  pthread_mutex_lock (&pool_lock);
+  pool_stopping = true;
+  pthread_cond_broadcast (&pool_work);
+  pthread_mutex_unlock (&pool_lock);
+
+  for (uint32_t i = 0; i < pool_size; i++)
+    pthread_join (pool_threads[i], 0);
+  pool_size = 0;
+}
+#endif
+
+void
+run_lanes (void (*fn) (void *, uint32_t), void *arg,
+           uint32_t nlanes, uint32_t nthreads)
+{
+  struct lane_job job = { fn, arg, nlanes, 0 };
+
+#ifdef HAVE_PTHREADS
+  nthreads = MIN (nthreads, MIN (nlanes, MAX_LANE_THREADS));
+  if (nthreads > 1)
+    {
+      pthread_mutex_lock (&pool_lock);
+      if (pool_busy || pool_stopping)
+        {
+          pthread_mutex_unlock (&pool_lock);
+          do_lanes (&job);
+          return;
+        }
+      pool_busy = true;
+
+      /* If a thread cannot be started, the lanes it would have taken
+         are done by the others.  */
+      grow_pool (nthreads - 1);
+      pool_job = &job;
+      pool_wanted = MIN (nthreads - 1, pool_size);
+      pthread_cond_broadcast (&pool_work);
+      pthread_mutex_unlock (&pool_lock);
+
+      do_lanes (&job);
+
+      /* Every lane has been taken.  Helpers that have not joined yet
+         are no longer needed; wait for the ones that have.  */
+      pthread_mutex_lock (&pool_lock);
+      pool_wanted = 0;
+      while (pool_active)
+        pthread_cond_wait (&pool_idle, &pool_lock);
+      pool_job = 0;
+      pool_busy = false;
+      pthread_mutex_unlock (&pool_lock);
+      return;
+    }
+#else
+  (void) nthreads;
+#endif
+  do_lanes (&job);
+}
+
+/* The limit set with set_call_threads is kept per thread, as the
+   value of a thread-specific key, so that a struct crypt_data can
+   carry its own limit down to the hashing method without changing
+   how methods are called.  Before the first call with a nonzero limit,
+   there is no key.  */
+#ifdef HAVE_PTHREADS
+static pthread_key_t call_threads_key;
+static pthread_once_t call_threads_once = PTHREAD_ONCE_INIT;
+static bool call_threads_ok;
+
+static void
+call_threads_create (void)
+{
+  __atomic_store_n (&call_threads_ok,
+                    !pthread_key_create (&call_threads_key, NULL),
+                    __ATOMIC_RELEASE);
+}
+
+/* If the library is unloaded, delete the key so that it is not
+   leaked.  No destructor is needed, as the values are not
+   pointers.  */
+static void __attribute__ ((destructor))
+call_threads_unload (void)
+{
+  if (__atomic_load_n (&call_threads_ok, __ATOMIC_ACQUIRE))
+    {
+      pthread_key_delete (call_threads_key);
+      call_threads_ok = false;
+    }
+}
+#endif
+
+void
+set_call_threads (unsigned int nthreads)
+{
+#ifdef HAVE_PTHREADS
+  if (nthreads == 0 && !__atomic_load_n (&call_threads_ok, __ATOMIC_ACQUIRE))
+    return;
+  if (!pthread_once (&call_threads_once, call_threads_create)
+      && __atomic_load_n (&call_threads_ok, __ATOMIC_ACQUIRE))
+    pthread_setspecific (call_threads_key, (void *) (uintptr_t) nthreads);
+#else
+  (void) nthreads;
+#endif
+}
+
+uint32_t
+lane_threads (void)
+{
+  uint32_t limit = (uint32_t) get_tunable (CRYPT_TUNE_THREADS);
+#ifdef HAVE_PTHREADS
+  /* The per-call limit can only lower the process-wide one: the
+     threads field it comes from may be left over from whatever the
+     caller's memory held, and must not start threads that the
+     application never asked for.  */
+  if (__atomic_load_n (&call_threads_ok, __ATOMIC_ACQUIRE))
+    {
+      void *value = pthread_getspecific (call_threads_key);
+      uintptr_t nthreads = (uintptr_t) value;
+      if (nthreads && nthreads < limit)
+        return (uint32_t) nthreads;
+    }
+#endif
+  return limit;
+}
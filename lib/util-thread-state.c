@@ -0,0 +1,111 @@
+/* Per-thread result buffers for the non-reentrant interfaces.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   crypt, crypt_gensalt and crypt_gensalt_calibrated return pointers
+   to storage that belongs to the library.  Each thread gets its own,
+   allocated the first time the thread calls the function, so that
+   the functions can be called from several threads at once and
+   processes that never call them do not carry the buffers around.
+   The buffers are erased and freed when the thread exits.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+static const size_t slot_size[THREAD_STATE_NSLOTS] =
+{
+  [THREAD_STATE_CRYPT] = sizeof (struct crypt_data),
+  [THREAD_STATE_GENSALT] = CRYPT_GENSALT_OUTPUT_SIZE,
+  [THREAD_STATE_GENSALT_CALIBRATED] = CRYPT_GENSALT_OUTPUT_SIZE,
+};
+
+struct thread_state
+{
+  void *slot[THREAD_STATE_NSLOTS];
+};
+
+#ifdef HAVE_PTHREADS
+static void
+state_destroy (void *arg)
+{
+  struct thread_state *ts = arg;
+
+  for (int i = 0; i < THREAD_STATE_NSLOTS; i++)
+    if (ts->slot[i])
+      {
+        explicit_bzero (ts->slot[i], slot_size[i]);
+        free (ts->slot[i]);
+      }
+  free (ts);
+}
+
+static pthread_key_t state_key;
+static pthread_once_t state_once = PTHREAD_ONCE_INIT;
+static bool state_ok;
+
+static void
+state_create (void)
+{
+  state_ok = !pthread_key_create (&state_key, state_destroy);
+}
+
+/* If the library is unloaded, the key's destructor would no longer
+   exist by the time other threads exit, so delete the key first.
+   The buffers of threads other than the current one are leaked.  */
+static void __attribute__ ((destructor))
+state_unload (void)
+{
+  if (state_ok)
+    {
+      void *ts = pthread_getspecific (state_key);
+      pthread_key_delete (state_key);
+      state_ok = false;
+      if (ts)
+        state_destroy (ts);
+    }
+}
+#endif
+
+void *
+thread_state_get (enum thread_state_slot slot)
+{
+  struct thread_state *ts;
+
+#ifdef HAVE_PTHREADS
+  if (pthread_once (&state_once, state_create) || !state_ok)
+    {
+      errno = ENOMEM;
+      return NULL;
+    }
+  ts = pthread_getspecific (state_key);
+  if (!ts)
+    {
+      ts = calloc (1, sizeof *ts);
+      if (!ts)
+        return NULL;
+      if (pthread_setspecific (state_key, ts))
+        {
+          free (ts);
+          errno = ENOMEM;
+          return NULL;
+        }
+    }
+#else
+  static struct thread_state state;
+  ts = &state;
+#endif
+
+  if (!ts->slot[slot])
+    ts->slot[slot] = calloc (1, slot_size[slot]);
+  return ts->slot[slot];
+}
@@ -0,0 +1,117 @@
+#include "crypt-port.h"
+#include "alg-argon2.h"
+#include "alg-blake2b.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#if INCLUDE_argon2id
+
+#include "cpu-variants.h"
+
+static void
+dump_hex (const char *label, const uint8_t *buf, size_t len)
+{
+  printf ("  %s: ", label);
+  for (size_t i = 0; i < len; i++)
+    printf ("%02x", buf[i]);
+  putchar ('\n');
+}
+
+static int
+check (const char *name, const uint8_t *expected, const uint8_t *got,
+       size_t len)
+{
+  if (!memcmp (expected, got, len))
+    return 0;
+  printf ("FAIL: %s\n", name);
+  dump_hex ("expected", expected, len);
+  dump_hex ("     got", got, len);
+  return 1;
+}
+
+/* RFC 7693, appendix A.  */
+static int
+test_blake2b (void)
+{
+  static const uint8_t expected[64] =
+    "\xba\x80\xa5\x3f\x98\x1c\x4d\x0d\x6a\x27\x97\xb6\x9f\x12\xf6\xe9"
+    "\x4c\x21\x2f\x14\x68\x5a\xc4\xb7\x4b\x12\xbb\x6f\xdb\xff\xa2\xd1"
+    "\x7d\x87\xc5\x39\x2a\xab\x79\x2d\xc2\x52\xd5\xde\x45\x33\xcc\x95"
+    "\x18\xd3\x8a\xa8\xdb\xf1\x92\x5a\xb9\x23\x86\xed\xd4\x00\x99\x23";
+  struct blake2b_ctx ctx;
+  uint8_t got[64];
+
+  blake2b_init (&ctx, 64);
+  blake2b_update (&ctx, "abc", 3);
+  blake2b_final (&ctx, got);
+  return check ("BLAKE2b-512(\"abc\")", expected, got, sizeof got);
+}
+
+/* RFC 9106, section 5.3, with NTHREADS threads.  */
+static int
+test_argon2id (long nthreads)
+{
+  static const uint8_t expected[32] =
+    "\x0d\x64\x0d\xf5\x8d\x78\x76\x6c\x08\xc0\x37\xa3\x4a\x8b\x53\xc9"
+    "\xd0\x1e\xf0\x45\x2d\x75\xb6\x5e\xb5\x25\x20\xe9\x6b\x01\xe6\x59";
+  uint8_t pwd[32], salt[16], secret[8], ad[12], got[32];
+  argon2_local_t local;
+  char name[64];
+  int r;
+
+  memset (pwd, 0x01, sizeof pwd);
+  memset (salt, 0x02, sizeof salt);
+  memset (secret, 0x03, sizeof secret);
+  memset (ad, 0x04, sizeof ad);
+
+  crypt_set_tunable (CRYPT_TUNE_THREADS, nthreads);
+  snprintf (name, sizeof name, "Argon2id, RFC 9106, %ld thread(s)",
+            nthreads);
+
+  init_region_cached (&local);
+  r = argon2id_hash (3, 32, 4, pwd, sizeof pwd, salt, sizeof salt,
+                     secret, sizeof secret, ad, sizeof ad,
+                     got, sizeof got, &local);
+  free_region_cached (&local);
+  if (r)
+    {
+      printf ("FAIL: %s: %s\n", name, strerror (errno));
+      return 1;
+    }
+  return check (name, expected, got, sizeof got);
+}
+
+/* The Argon2id test vector, with the fill_block code selected for the
+   CPU extensions currently allowed.  */
+static int
+test_fill_block (const void *arg)
+{
+  int result = 0;
+
+  (void) arg;
+  result |= test_argon2id (1);
+  result |= test_argon2id (4);
+  return result;
+}
+
+int
+main (void)
+{
+  int result = 0;
+
+  result |= test_blake2b ();
+  result |= for_each_cpu_variant (test_fill_block, 0);
+
+  return result;
+}
+
+#else
+
+int
+main (void)
+{
+  return 77; /* UNSUPPORTED */
+}
+
+#endif
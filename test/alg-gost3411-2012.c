@@ -22,6 +22,7 @@
 #if INCLUDE_gost_yescrypt
 
 #include "alg-gost3411-2012-hmac.h"
+#include "cpu-variants.h"
 
 #include <stdio.h>
 
@@ -103,11 +104,65 @@ test_gost2012_hash512(const char *subject, const char *t, const char *match)
   return 0;
 }
 
-int
-main (void)
+/* GOST34112012UpdateBlock2 must give the same results as two
+   separate calls to GOST34112012Update.  */
+static int
+test_gost2012_update_block2(void)
+{
+  GOST34112012Context c1, c2, r1, r2;
+  unsigned char b1[64], b2[64], d1[32], d2[32], e1[32], e2[32];
+  size_t i;
+
+  for (i = 0; i < sizeof(b1); i++)
+    {
+      b1[i] = (unsigned char)(i * 7 + 1);
+      b2[i] = (unsigned char)(0xff - i * 3);
+    }
+
+  GOST34112012Init(&c1, GOSTR3411_2012_BITS);
+  GOST34112012Init(&c2, GOSTR3411_2012_BITS);
+  GOST34112012UpdateBlock2(&c1, b1, &c2, b2);
+  GOST34112012Update(&c1, b2, 17);
+  GOST34112012Update(&c2, b1, 17);
+  GOST34112012Final(&c1, d1);
+  GOST34112012Final(&c2, d2);
+
+  GOST34112012Init(&r1, GOSTR3411_2012_BITS);
+  GOST34112012Init(&r2, GOSTR3411_2012_BITS);
+  GOST34112012Update(&r1, b1, sizeof(b1));
+  GOST34112012Update(&r2, b2, sizeof(b2));
+  GOST34112012Update(&r1, b2, 17);
+  GOST34112012Update(&r2, b1, 17);
+  GOST34112012Final(&r1, e1);
+  GOST34112012Final(&r2, e2);
+
+  if (memcmp(d1, e1, sizeof(d1)) || memcmp(d2, e2, sizeof(d2)))
+    {
+      fprintf(stderr, "ERROR: GOST34112012UpdateBlock2\n");
+      printf("   digest1 = ");
+      dumphex(d1, sizeof(d1));
+      printf("   expected1 = ");
+      dumphex(e1, sizeof(e1));
+      printf("   digest2 = ");
+      dumphex(d2, sizeof(d2));
+      printf("   expected2 = ");
+      dumphex(e2, sizeof(e2));
+      return 1;
+    }
+  else
+    fprintf(stderr, "   ok: GOST34112012UpdateBlock2\n");
+
+  return 0;
+}
+
+/* All of the above, with the compression function selected for the
+   CPU extensions currently allowed.  */
+static int
+test_gost2012(const void *arg)
 {
   int result = 0;
 
+  (void) arg;
   result |= test_gost2012_hash(
               "test vector from example A.1 from GOST-34.11-2012 (256 Bit)",
               "012345678901234567890123456789012345678901234567890123456789012",
@@ -177,9 +232,17 @@ main (void)
               "8b06f41e59907d9636e892caf5942fcdfb71fa31169a5e70f0edb873664df41c"
               "2cce6e06dc6755d15a61cdeb92bd607cc4aaca6732bf3568a23a210dd520fd41");
 
+  result |= test_gost2012_update_block2();
+
   return result;
 }
 
+int
+main (void)
+{
+  return for_each_cpu_variant(test_gost2012, 0);
+}
+
 #else
 
 int
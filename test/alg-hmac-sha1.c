@@ -172,6 +172,33 @@ main (void)
           fputs (test->expect, stdout);
           fputs ("\n", stdout);
         }
+
+      /* Iterating with a precomputed key must give the same results
+         as repeated calls to hmac_sha1_process_data.  */
+      struct hmac_sha1_key hk;
+      char expect[HASH_LENGTH], iterated[HASH_LENGTH];
+      size_t key_len = strlen (test->key);
+
+      memcpy (expect, digest, HASH_LENGTH);
+      memcpy (iterated, digest, HASH_LENGTH);
+      for (int i = 0; i < 3; i++)
+        hmac_sha1_process_data ((const uint8_t *)expect, HASH_LENGTH,
+                                (const uint8_t *)test->key, key_len, expect);
+      hmac_sha1_init_key (&hk, (const uint8_t *)test->key, key_len);
+      hmac_sha1_iterate (&hk, (uint8_t *)iterated, 3);
+      if (memcmp (expect, iterated, HASH_LENGTH) != 0)
+        {
+          n = 1;
+          fputs ("\nkey=", stdout);
+          fputs (test->key, stdout);
+          fputs (": hmac_sha1_iterate result=", stdout);
+          bin_to_char (dbuf, sizeof dbuf, iterated, HASH_LENGTH);
+          fputs (dbuf, stdout);
+          fputs (", expected ", stdout);
+          bin_to_char (dbuf, sizeof dbuf, expect, HASH_LENGTH);
+          fputs (dbuf, stdout);
+          fputs ("\n", stdout);
+        }
     }
   return n;
 }
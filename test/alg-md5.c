@@ -5,6 +5,9 @@
 
 #if INCLUDE_md5crypt || INCLUDE_sunmd5
 
+#include "cpu-variants.h"
+#include "transform-mb.h"
+
 static const struct
 {
   const char *input;
@@ -73,6 +76,32 @@ report_failure(int n, const char *tag,
   putchar ('\n');
 }
 
+static const uint32_t md5_iv[4] =
+  {
+    0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476
+  };
+
+static void
+md5_transform_mb (void *states, const uint8_t *const *blocks, size_t nlanes)
+{
+  MD5_Transform_MB (states, blocks, nlanes);
+}
+
+static void
+md5_buf (const uint8_t *msg, size_t len, uint8_t *digest)
+{
+  MD5_CTX ctx;
+  MD5_Init (&ctx);
+  MD5_Update (&ctx, msg, len);
+  MD5_Final (digest, &ctx);
+}
+
+static const struct mb_hash md5_mb =
+{
+  "MD5", 64, 4, 4, MD5_MB_MAX_LANES, false, md5_iv,
+  md5_transform_mb, md5_buf
+};
+
 int
 main (void)
 {
@@ -120,6 +149,8 @@ main (void)
       result = 1;
     }
 
+  result |= for_each_cpu_variant (test_transform_mb, &md5_mb);
+
   return result;
 }
 
@@ -244,6 +244,40 @@ test_pbkdf2_hmac_sha256 (void)
                           (const unsigned char *)t->dk, output);
           status = 1;
         }
+
+      /* The same, twice over with one HMAC state, which must not be
+         changed by the first use.  */
+      HMAC_SHA256_CTX ctx;
+      HMAC_SHA256_Init (&ctx, t->passwd, t->plen);
+      for (int k = 0; k < 2; k++)
+        {
+          memset (output, 0, sizeof output);
+          PBKDF2_SHA256_HMAC (&ctx, (const unsigned char *)t->salt, t->slen,
+                              t->c, output, t->dklen);
+          if (memcmp (output, t->dk, t->dklen))
+            {
+              report_failure ("PBKDF2-HMAC-SHA256 (precomputed key)", i,
+                              t->dklen, (const unsigned char *)t->dk, output);
+              status = 1;
+            }
+        }
+    }
+
+  /* With c = 1 and a whole number of blocks, the blocks are computed
+     together.  Check that against the general code, which is used
+     when the last block is partial.  */
+  static uint8_t dk_fast[32 * 20], dk_slow[32 * 20 - 1];
+  PBKDF2_SHA256 ((const unsigned char *)"password", 8,
+                 (const unsigned char *)"salt", 4, 1,
+                 dk_fast, sizeof dk_fast);
+  PBKDF2_SHA256 ((const unsigned char *)"password", 8,
+                 (const unsigned char *)"salt", 4, 1,
+                 dk_slow, sizeof dk_slow);
+  if (memcmp (dk_fast, dk_slow, sizeof dk_slow))
+    {
+      report_failure ("PBKDF2-HMAC-SHA256 (c=1, 20 blocks)", 0,
+                      sizeof dk_slow, dk_slow, dk_fast);
+      status = 1;
     }
   return status;
 }
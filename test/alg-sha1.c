@@ -11,6 +11,9 @@
 
 #if INCLUDE_sha1crypt
 
+#include "cpu-variants.h"
+#include "transform-mb.h"
+
 /* Test Vectors (from FIPS PUB 180-1) */
 const char *test_data[3] =
 {
@@ -38,6 +41,32 @@ bin_to_hex (uint8_t *digest, char *output)
     }
 }
 
+static const uint32_t sha1_iv[5] =
+  {
+    0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+  };
+
+static void
+sha1_transform_mb_fn (void *states, const uint8_t *const *blocks,
+                      size_t nlanes)
+{
+  sha1_transform_mb (states, blocks, nlanes);
+}
+
+static void
+sha1_buf (const uint8_t *msg, size_t len, uint8_t *digest)
+{
+  struct sha1_ctx ctx;
+  sha1_init_ctx (&ctx);
+  sha1_process_bytes (msg, &ctx, len);
+  sha1_finish_ctx (&ctx, digest);
+}
+
+static const struct mb_hash sha1_mb =
+{
+  "SHA-1", 64, 4, 5, SHA1_MB_MAX_LANES, true, sha1_iv,
+  sha1_transform_mb_fn, sha1_buf
+};
 
 int
 main (void)
@@ -96,6 +125,9 @@ main (void)
       retval = 1;
     }
 
+  if (for_each_cpu_variant (test_transform_mb, &sha1_mb))
+    retval = 1;
+
   /* success */
   return retval;
 }
@@ -6,6 +6,9 @@
 #if INCLUDE_sha256crypt || INCLUDE_scrypt || INCLUDE_yescrypt || \
     INCLUDE_gost_yescrypt
 
+#include "cpu-variants.h"
+#include "transform-mb.h"
+
 static const struct
 {
   const char *input;
@@ -82,8 +85,35 @@ report_failure(int n, const char *tag,
   putchar ('\n');
 }
 
-int
-main (void)
+static const uint32_t sha256_iv[8] =
+  {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+
+static void
+sha256_transform_mb (void *states, const uint8_t *const *blocks,
+                     size_t nlanes)
+{
+  SHA256_Transform_MB (states, blocks, nlanes);
+}
+
+static void
+sha256_buf (const uint8_t *msg, size_t len, uint8_t *digest)
+{
+  SHA256_Buf (msg, len, digest);
+}
+
+static const struct mb_hash sha256_mb =
+{
+  "SHA-256", 64, 4, 8, SHA256_MB_MAX_LANES, true, sha256_iv,
+  sha256_transform_mb, sha256_buf
+};
+
+/* Check SHA256_Transform and SHA256_Transform_MB, with the latter
+   described by the struct mb_hash at ARG.  */
+static int
+test_sha256 (const void *arg)
 {
   SHA256_CTX ctx;
   uint8_t sum[32];
@@ -127,9 +157,17 @@ main (void)
       result = 1;
     }
 
+  result |= test_transform_mb (arg);
+
   return result;
 }
 
+int
+main (void)
+{
+  return for_each_cpu_variant (test_sha256, &sha256_mb);
+}
+
 #else
 
 int
@@ -5,6 +5,9 @@
 
 #if INCLUDE_sha512crypt
 
+#include "cpu-variants.h"
+#include "transform-mb.h"
+
 static const struct
 {
   const char *input;
@@ -109,6 +112,33 @@ report_failure(int n, const char *tag,
   putchar ('\n');
 }
 
+static const uint64_t sha512_iv[8] =
+  {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+    0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+  };
+
+static void
+sha512_transform_mb (void *states, const uint8_t *const *blocks,
+                     size_t nlanes)
+{
+  SHA512_Transform_MB (states, blocks, nlanes);
+}
+
+static void
+sha512_buf (const uint8_t *msg, size_t len, uint8_t *digest)
+{
+  SHA512_Buf (msg, len, digest);
+}
+
+static const struct mb_hash sha512_mb =
+{
+  "SHA-512", SHA512_BLOCK_LENGTH, 8, 8, SHA512_MB_MAX_LANES, true,
+  sha512_iv, sha512_transform_mb, sha512_buf
+};
+
 int
 main (void)
 {
@@ -156,6 +186,8 @@ main (void)
       result = 1;
     }
 
+  result |= for_each_cpu_variant (test_transform_mb, &sha512_mb);
+
   return result;
 }
 
@@ -191,6 +191,17 @@ static const struct testcase testcases[] =
 #else
   { "$gy$",  0, 0, 0 },
 #endif
+
+  /* argon2id */
+#if INCLUDE_argon2id
+  { "$argon2id", 0,  0, 0 },    // truncated prefix
+  { "$argon2id$", 9,  0, 0 },   // too small
+  { "$argon2id$", 23, 0, 0 },   // too large
+  { "$argon2id$", 0,  2, 0 },   // inadequate rbytes
+  { "$argon2id$", 0,  0, 4 },   // inadequate osize
+#else
+  { "$argon2id$", 0, 0, 0 },
+#endif
 };
 
 static void
@@ -108,6 +108,11 @@ static const struct testcase testcases[] =
 #else
   { "$gy$",  CRYPT_SALT_INVALID,       CRYPT_SALT_INVALID,       CRYPT_SALT_INVALID       },
 #endif
+#if INCLUDE_argon2id
+  { "$argon2id$", CRYPT_SALT_OK,       CRYPT_SALT_OK,            CRYPT_SALT_OK            },
+#else
+  { "$argon2id$", CRYPT_SALT_INVALID,  CRYPT_SALT_INVALID,       CRYPT_SALT_INVALID       },
+#endif
 
   /* All of these are invalid. */
   { "$@",       CRYPT_SALT_INVALID, CRYPT_SALT_INVALID, CRYPT_SALT_INVALID },
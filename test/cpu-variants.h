@@ -0,0 +1,57 @@
+/*
+ * Running a test with each of the SIMD variants the CPU can use.
+ * The library picks the best code for the CPU when it is loaded, so
+ * without this the tests would only ever check one variant.  Tests
+ * that use it must link the library's objects, since
+ * cpu_force_features is not exported.
+ */
+
+#ifndef _CRYPT_TEST_CPU_VARIANTS_H
+#define _CRYPT_TEST_CPU_VARIANTS_H 1
+
+#include <stdio.h>
+
+/* The extensions to take away, one more each time round.  SHA goes
+   first, since the SHA-256 code does not use the multi-buffer
+   transforms when the CPU has it.  */
+static const unsigned int cpu_variant_drop[] =
+{
+  CPU_SHA, CPU_AVX512F, CPU_AVX2, CPU_XOP, CPU_AVX, CPU_SSE41, CPU_SSE2
+};
+
+static int
+cpu_variant_run (int (*fn) (const void *), const void *arg,
+                 unsigned int usable)
+{
+  if (!fn (arg))
+    return 0;
+  printf ("  (with CPU extensions 0x%02x)\n", usable);
+  return 1;
+}
+
+/* Call FN (ARG) with everything the CPU has, then again each time
+   another extension from cpu_variant_drop is taken away, skipping the
+   ones the CPU did not have.  Return the results of FN or'ed
+   together.  */
+static int
+for_each_cpu_variant (int (*fn) (const void *), const void *arg)
+{
+  unsigned int mask = ~0u;
+  unsigned int usable = cpu_force_features (mask);
+  int result = cpu_variant_run (fn, arg, usable);
+
+  for (size_t i = 0; i < ARRAY_SIZE (cpu_variant_drop); i++)
+    {
+      mask &= ~cpu_variant_drop[i];
+      unsigned int now = cpu_force_features (mask);
+      if (now == usable)
+        continue;
+      usable = now;
+      result |= cpu_variant_run (fn, arg, usable);
+    }
+
+  cpu_force_features (~0u);
+  return result;
+}
+
+#endif /* cpu-variants.h */
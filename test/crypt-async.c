@@ -0,0 +1,293 @@
+/* Test crypt_submit, crypt_poll and crypt_async_fd.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined HAVE_PTHREADS && (INCLUDE_yescrypt || INCLUDE_sha512crypt \
+                              || INCLUDE_md5crypt || INCLUDE_descrypt)
+
+static const char setting[] =
+#if INCLUDE_yescrypt
+  "$y$j75$MJHnaAkegEVYHsFKkmfzJ1";
+#elif INCLUDE_sha512crypt
+  "$6$rounds=1000$MJHnaAkegEVYHsFK";
+#elif INCLUDE_md5crypt
+  "$1$MJHnaAke";
+#else
+  "Mp";
+#endif
+
+#define NREQ 4
+
+static const char *phrases[NREQ] =
+{
+  "",
+  "Ob-La-Di, Ob-La-Da",
+  "the ritual question of how much is two plus two",
+  "0123456789abcdef0123456789abcdef",
+};
+
+static struct crypt_data cds[NREQ + 1];
+static char expected[NREQ][CRYPT_OUTPUT_SIZE];
+static int finished[NREQ + 1];
+static int errs[NREQ + 1];
+
+static void
+done (struct crypt_data *data, int err, void *arg)
+{
+  int i = (int) (intptr_t) arg;
+  if (data != &cds[i])
+    printf ("FAIL: request %d: completion for the wrong data\n", i);
+  finished[i]++;
+  errs[i] = err;
+}
+
+/* Wait for the notification descriptor and call completion functions,
+   at most MAX at a time, until N of them have been called.  */
+static bool
+wait_for (int fd, int n, int max)
+{
+  int total = 0;
+  while (total < n)
+    {
+      struct pollfd pfd = { fd, POLLIN, 0 };
+      int rv = poll (&pfd, 1, 30000);
+      if (rv != 1)
+        {
+          printf ("FAIL: no completion after %d of %d\n", total, n);
+          return false;
+        }
+      rv = crypt_poll (max);
+      if (rv < 0 || rv > max)
+        {
+          printf ("FAIL: crypt_poll returned %d\n", rv);
+          return false;
+        }
+      total += rv;
+    }
+  return true;
+}
+
+static bool
+expect_fail (const char *what, int rv, int err)
+{
+  if (rv != -1 || errno != err)
+    {
+      printf ("FAIL: %s: got %d (%s), expected -1 (%s)\n",
+              what, rv, strerror (errno), strerror (err));
+      return false;
+    }
+  return true;
+}
+
+int
+main (void)
+{
+  bool ok = true;
+  int i;
+
+  for (i = 0; i < NREQ; i++)
+    {
+      memset (&cds[i], 0, sizeof cds[i]);
+      if (!crypt_rn (phrases[i], setting, &cds[i], (int) sizeof cds[i]))
+        {
+          printf ("ERROR: crypt_rn(\"%s\", \"%s\"): %s\n",
+                  phrases[i], setting, strerror (errno));
+          return 99;
+        }
+      strcpy (expected[i], cds[i].output);
+    }
+
+  int fd = crypt_async_fd ();
+  if (fd < 0)
+    {
+      printf ("ERROR: crypt_async_fd: %s\n", strerror (errno));
+      return 99;
+    }
+  if (crypt_async_fd () != fd)
+    {
+      printf ("FAIL: crypt_async_fd changed\n");
+      ok = false;
+    }
+  if (crypt_poll (NREQ) != 0)
+    {
+      printf ("FAIL: crypt_poll with nothing submitted\n");
+      ok = false;
+    }
+
+  if (crypt_set_tunable (CRYPT_TUNE_ASYNC_THREADS, 2)
+      || crypt_set_tunable (CRYPT_TUNE_ASYNC_QUEUE, NREQ))
+    {
+      printf ("ERROR: crypt_set_tunable: %s\n", strerror (errno));
+      return 99;
+    }
+
+  /* Fill the queue; one more request is refused, and leaves its data
+     alone.  */
+  for (i = 0; i < NREQ; i++)
+    {
+      memset (&cds[i], 0, sizeof cds[i]);
+      if (crypt_submit (phrases[i], setting, &cds[i], done,
+                        (void *) (intptr_t) i))
+        {
+          printf ("FAIL: crypt_submit %d: %s\n", i, strerror (errno));
+          return 1;
+        }
+    }
+  memset (&cds[NREQ], 0, sizeof cds[NREQ]);
+  errno = 0;
+  ok &= expect_fail ("full queue",
+                     crypt_submit ("x", setting, &cds[NREQ], done,
+                                   (void *) (intptr_t) NREQ), EAGAIN);
+  if (cds[NREQ].input[0] || cds[NREQ].setting[0])
+    {
+      printf ("FAIL: refused request changed its data\n");
+      ok = false;
+    }
+
+  /* Take the results two at a time.  */
+  if (!wait_for (fd, NREQ, 2))
+    return 1;
+  for (i = 0; i < NREQ; i++)
+    {
+      if (finished[i] != 1 || errs[i] != 0)
+        {
+          printf ("FAIL: request %d: finished %d times, error %d\n",
+                  i, finished[i], errs[i]);
+          ok = false;
+        }
+      else if (strcmp (cds[i].output, expected[i]))
+        {
+          printf ("FAIL: request %d: got %s, expected %s\n",
+                  i, cds[i].output, expected[i]);
+          ok = false;
+        }
+      if (cds[i].input[0])
+        {
+          printf ("FAIL: request %d: passphrase not erased\n", i);
+          ok = false;
+        }
+    }
+
+  /* Nothing left, and the descriptor is no longer readable.  */
+  struct pollfd pfd = { fd, POLLIN, 0 };
+  if (crypt_poll (NREQ) != 0 || poll (&pfd, 1, 0) != 0)
+    {
+      printf ("FAIL: completions left over\n");
+      ok = false;
+    }
+
+  /* A request that fails is reported to its completion function.  The
+     passphrase and setting may already be in the data.  */
+  memset (&cds[NREQ], 0, sizeof cds[NREQ]);
+  strcpy (cds[NREQ].input, "x");
+  strcpy (cds[NREQ].setting, "$@");
+  if (crypt_submit (cds[NREQ].input, cds[NREQ].setting, &cds[NREQ], done,
+                    (void *) (intptr_t) NREQ)
+      || !wait_for (fd, 1, NREQ))
+    {
+      printf ("FAIL: crypt_submit with a bad setting: %s\n",
+              strerror (errno));
+      return 1;
+    }
+  if (finished[NREQ] != 1 || errs[NREQ] != EINVAL
+      || cds[NREQ].output[0] != '*')
+    {
+      printf ("FAIL: bad setting: finished %d times, error %d, output %s\n",
+              finished[NREQ], errs[NREQ], cds[NREQ].output);
+      ok = false;
+    }
+
+  /* Fork while a request is in flight.  The child forgets it, and can
+     submit requests of its own, which it is notified of on a new
+     descriptor.  */
+  memset (&cds[0], 0, sizeof cds[0]);
+  memset (&cds[1], 0, sizeof cds[1]);
+  finished[0] = finished[1] = 0;
+  if (crypt_submit (phrases[0], setting, &cds[0], done, (void *) (intptr_t) 0))
+    {
+      printf ("FAIL: crypt_submit before fork: %s\n", strerror (errno));
+      return 1;
+    }
+  pid_t pid = fork ();
+  if (pid < 0)
+    {
+      printf ("ERROR: fork: %s\n", strerror (errno));
+      return 99;
+    }
+  if (pid == 0)
+    {
+      if (crypt_poll (NREQ) != 0)
+        _exit (1);
+      if (crypt_submit (phrases[1], setting, &cds[1], done,
+                        (void *) (intptr_t) 1))
+        _exit (1);
+      int cfd = crypt_async_fd ();
+      if (cfd < 0 || !wait_for (cfd, 1, NREQ))
+        _exit (1);
+      _exit (finished[0] == 0 && finished[1] == 1
+             && !strcmp (cds[1].output, expected[1]) ? 0 : 1);
+    }
+  int status;
+  if (waitpid (pid, &status, 0) != pid
+      || !WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    {
+      printf ("FAIL: requests in the child of fork\n");
+      ok = false;
+    }
+  if (!wait_for (fd, 1, NREQ)
+      || finished[0] != 1 || strcmp (cds[0].output, expected[0]))
+    {
+      printf ("FAIL: request in flight across fork\n");
+      ok = false;
+    }
+
+  /* Argument errors.  */
+  static char long_phrase[CRYPT_MAX_PASSPHRASE_SIZE + 1];
+  memset (long_phrase, 'x', CRYPT_MAX_PASSPHRASE_SIZE);
+  errno = 0;
+  ok &= expect_fail ("null phrase",
+                     crypt_submit (0, setting, &cds[0], done, 0), EINVAL);
+  errno = 0;
+  ok &= expect_fail ("null data",
+                     crypt_submit ("x", setting, 0, done, 0), EINVAL);
+  errno = 0;
+  ok &= expect_fail ("null function",
+                     crypt_submit ("x", setting, &cds[0], 0, 0), EINVAL);
+  errno = 0;
+  ok &= expect_fail ("long phrase",
+                     crypt_submit (long_phrase, setting, &cds[0], done, 0),
+                     ERANGE);
+  errno = 0;
+  ok &= expect_fail ("crypt_poll (0)", crypt_poll (0), EINVAL);
+  errno = 0;
+  ok &= expect_fail ("negative thread limit",
+                     crypt_set_tunable (CRYPT_TUNE_ASYNC_THREADS, -1), EINVAL);
+  errno = 0;
+  ok &= expect_fail ("zero queue limit",
+                     crypt_set_tunable (CRYPT_TUNE_ASYNC_QUEUE, 0), EINVAL);
+
+  return ok ? 0 : 1;
+}
+
+#else
+
+int
+main (void)
+{
+  return 77; /* UNSUPPORTED */
+}
+
+#endif
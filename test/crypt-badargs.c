@@ -75,6 +75,9 @@ static const char *settings[] =
 #if INCLUDE_gost_yescrypt
   "$gy$j9T$MJHnaAkegEVYHsFKkmfzJ1",
 #endif
+#if INCLUDE_argon2id
+  "$argon2id$v=19$m=1024,t=3,p=4$WDXNJgOrLBSSEx5ZsLz+1Q",
+#endif
 };
 
 /* In some of the tests below, a segmentation fault is the expected result.  */
@@ -0,0 +1,173 @@
+/* Test crypt_ctx_new, crypt_ctx_bind and crypt_ctx_free.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#if INCLUDE_yescrypt || INCLUDE_scrypt || INCLUDE_argon2id
+
+#define ARENA_SIZE (4UL << 20)
+
+/* Settings that fit in the arena, and some that do not.  */
+static const char *const settings[] =
+{
+#if INCLUDE_yescrypt
+  "$y$j75$MJHnaAkegEVYHsFKkmfzJ1",
+  "$y$j85.0$k2XAnEHBqQ1Ct2aMXFKNa/",
+  "$y$jB5$MJHnaAkegEVYHsFKkmfzJ1",
+#endif
+#if INCLUDE_gost_yescrypt
+  "$gy$j75$MJHnaAkegEVYHsFKkmfzJ1",
+#endif
+#if INCLUDE_scrypt
+  "$7$6U..../....2Q9obwLhin8qvQl6sisAO/$",
+#endif
+#if INCLUDE_argon2id
+  "$argon2id$v=19$m=2048,t=2,p=2$c29tZXNhbHQ",
+  "$argon2id$v=19$m=8192,t=1,p=1$c29tZXNhbHQ",
+#endif
+};
+
+static char expected[ARRAY_SIZE (settings)][CRYPT_OUTPUT_SIZE];
+
+static bool
+hash (const char *setting, char *output, long *obtained)
+{
+  struct crypt_data cd;
+
+  memset (&cd, 0, sizeof cd);
+  if (!crypt_rn ("Ob-La-Di, Ob-La-Da", setting, &cd, (int) sizeof cd))
+    {
+      printf ("FAIL: hashing with %s: %s\n", setting, strerror (errno));
+      return false;
+    }
+  strcpy (output, cd.output);
+  *obtained = crypt_get_tunable (CRYPT_TUNE_MEMORY_OBTAINED);
+  return true;
+}
+
+/* With plain memory, only hashes that take their memory from the
+   arena report it as populated.  Hashes must be the same either way,
+   including when the arena is used several times in a row.  */
+static bool
+check_hashes (const char *label, bool bound)
+{
+  char output[CRYPT_OUTPUT_SIZE];
+  bool ok = true;
+  long obtained;
+
+  for (int round = 0; round < 2; round++)
+    for (size_t i = 0; i < ARRAY_SIZE (settings); i++)
+      {
+        if (!hash (settings[i], output, &obtained))
+          {
+            ok = false;
+            continue;
+          }
+        if (strcmp (output, expected[i]))
+          {
+            printf ("FAIL: %s: got %s, expected %s\n",
+                    label, output, expected[i]);
+            ok = false;
+          }
+        bool fits = !strstr (settings[i], "$jB5$")
+                    && !strstr (settings[i], "m=8192,");
+        bool used = (obtained & CRYPT_MEMORY_POPULATE) != 0;
+        if (used != (bound && fits))
+          {
+            printf ("FAIL: %s: %s %s the arena\n", label, settings[i],
+                    used ? "used" : "did not use");
+            ok = false;
+          }
+      }
+  return ok;
+}
+
+int
+main (void)
+{
+  struct crypt_ctx *ctx;
+  bool ok = true;
+  long obtained;
+
+  crypt_set_tunable (CRYPT_TUNE_MEMORY_POLICY, 0);
+  for (size_t i = 0; i < ARRAY_SIZE (settings); i++)
+    if (!hash (settings[i], expected[i], &obtained))
+      return 99;
+
+  errno = 0;
+  if (crypt_ctx_new (0, 0) || errno != EINVAL)
+    {
+      printf ("FAIL: crypt_ctx_new accepted size 0\n");
+      ok = false;
+    }
+  errno = 0;
+  if (crypt_ctx_new (ARENA_SIZE, ~CRYPT_CTX_LOCK) || errno != EINVAL)
+    {
+      printf ("FAIL: crypt_ctx_new accepted unknown flags\n");
+      ok = false;
+    }
+  crypt_ctx_free (NULL);
+
+  ctx = crypt_ctx_new (ARENA_SIZE, 0);
+  if (!ctx)
+    {
+      printf ("FAIL: crypt_ctx_new: %s\n", strerror (errno));
+      return 1;
+    }
+  ok &= check_hashes ("unbound", false);
+  if (crypt_ctx_bind (ctx))
+    {
+      printf ("FAIL: crypt_ctx_bind: %s\n", strerror (errno));
+      return 1;
+    }
+  ok &= check_hashes ("bound", true);
+  if (crypt_ctx_bind (NULL))
+    {
+      printf ("FAIL: crypt_ctx_bind (NULL): %s\n", strerror (errno));
+      ok = false;
+    }
+  ok &= check_hashes ("unbound again", false);
+
+  /* Freeing a bound context unbinds it.  */
+  crypt_ctx_bind (ctx);
+  crypt_ctx_free (ctx);
+  ok &= check_hashes ("freed", false);
+
+  /* Locking may well not be allowed here, but if it is, the arena must
+     work the same.  */
+  ctx = crypt_ctx_new (ARENA_SIZE, CRYPT_CTX_LOCK);
+  if (ctx)
+    {
+      crypt_ctx_bind (ctx);
+      ok &= check_hashes ("locked", true);
+      crypt_ctx_free (ctx);
+    }
+  else if (errno != EPERM && errno != ENOMEM && errno != EAGAIN
+           && errno != ENOTSUP)
+    {
+      printf ("FAIL: crypt_ctx_new with CRYPT_CTX_LOCK: %s\n",
+              strerror (errno));
+      ok = false;
+    }
+
+  return ok ? 0 : 1;
+}
+
+#else
+
+int
+main (void)
+{
+  return 77; /* UNSUPPORTED */
+}
+
+#endif
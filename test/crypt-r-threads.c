@@ -0,0 +1,166 @@
+/* Test that crypt_r ignores the threads field of struct crypt_data,
+   and that crypt_rn never lets it raise CRYPT_TUNE_THREADS.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   Callers of crypt_r only have to clear 'initialized', so 'threads'
+   may hold whatever was in memory; crypt_r must not start threads
+   because of it.  Nor may crypt_rn start more threads than the
+   application allowed with CRYPT_TUNE_THREADS, whatever the field
+   says.  It also checks that threads started for one hash
+   are reused for the next.  This test links the library objects
+   directly and wraps pthread_create to count the threads they start.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if !defined HAVE_LD_WRAP || !defined HAVE_PTHREADS || !INCLUDE_yescrypt
+int
+main (void)
+{
+  return 77;
+}
+#else
+
+#include <pthread.h>
+
+static unsigned int threads_started;
+
+extern int __wrap_pthread_create (pthread_t *, const pthread_attr_t *,
+                                  void *(*) (void *), void *);
+extern int __real_pthread_create (pthread_t *, const pthread_attr_t *,
+                                  void *(*) (void *), void *);
+int
+__wrap_pthread_create (pthread_t *thread, const pthread_attr_t *attr,
+                       void *(*start) (void *), void *arg)
+{
+  __atomic_fetch_add (&threads_started, 1, __ATOMIC_RELAXED);
+  return __real_pthread_create (thread, attr, start, arg);
+}
+
+/* yescrypt, N=2048, r=8, p=4.  */
+static const char p4_setting[] = "$y$j85.0$k2XAnEHBqQ1Ct2aMXFKNa/";
+static const char phrase[] = "Ob-La-Di, Ob-La-Da";
+
+int
+main (void)
+{
+  static char expected[CRYPT_OUTPUT_SIZE];
+  struct crypt_data *cd = malloc (sizeof *cd);
+  if (!cd)
+    {
+      perror ("malloc");
+      return 99;
+    }
+
+  /* As documented for crypt_r, clear only 'initialized', and leave
+     something other than zero where 'threads' is.  */
+  memset (cd, 0xA5, sizeof *cd);
+  cd->initialized = 0;
+  if (!crypt_r (phrase, p4_setting, cd) || cd->output[0] == '*')
+    {
+      printf ("ERROR: crypt_r: %s\n", strerror (errno));
+      return 99;
+    }
+  strcpy (expected, cd->output);
+
+  int status = 0;
+  if (threads_started)
+    {
+      printf ("FAIL: crypt_r started %u threads with threads = %u\n",
+              threads_started, 0xA5u);
+      status = 1;
+    }
+
+  /* crypt_rn reads the field, but it cannot go over the default
+     CRYPT_TUNE_THREADS of 1.  */
+  memset (cd, 0, sizeof *cd);
+  cd->threads = 4;
+  if (!crypt_rn (phrase, p4_setting, cd, (int) sizeof *cd)
+      || strcmp (cd->output, expected))
+    {
+      printf ("FAIL: crypt_rn with 4 threads over a limit of 1:"
+              " got %s, expected %s\n", cd->output, expected);
+      status = 1;
+    }
+  if (threads_started)
+    {
+      printf ("FAIL: crypt_rn started %u threads over a limit of 1\n",
+              threads_started);
+      status = 1;
+    }
+
+  /* Once the application allows more threads, the field can still
+     lower the limit ...  */
+  if (crypt_set_tunable (CRYPT_TUNE_THREADS, 4))
+    {
+      printf ("ERROR: crypt_set_tunable: %s\n", strerror (errno));
+      return 99;
+    }
+  memset (cd, 0, sizeof *cd);
+  cd->threads = 1;
+  if (!crypt_rn (phrase, p4_setting, cd, (int) sizeof *cd)
+      || strcmp (cd->output, expected))
+    {
+      printf ("FAIL: crypt_rn with 1 thread: got %s, expected %s\n",
+              cd->output, expected);
+      status = 1;
+    }
+  if (threads_started)
+    {
+      printf ("FAIL: crypt_rn started %u threads with threads = 1\n",
+              threads_started);
+      status = 1;
+    }
+
+  /* ... and use it all.  */
+  memset (cd, 0, sizeof *cd);
+  cd->threads = 4;
+  if (!crypt_rn (phrase, p4_setting, cd, (int) sizeof *cd))
+    {
+      printf ("ERROR: crypt_rn: %s\n", strerror (errno));
+      return 99;
+    }
+  if (strcmp (cd->output, expected))
+    {
+      printf ("FAIL: crypt_rn with 4 threads: got %s, expected %s\n",
+              cd->output, expected);
+      status = 1;
+    }
+  if (!threads_started)
+    {
+      printf ("FAIL: crypt_rn started no threads with threads = 4\n");
+      status = 1;
+    }
+
+  /* The threads are kept for the next hash.  */
+  unsigned int started = threads_started;
+  memset (cd, 0, sizeof *cd);
+  cd->threads = 4;
+  if (!crypt_rn (phrase, p4_setting, cd, (int) sizeof *cd)
+      || strcmp (cd->output, expected))
+    {
+      printf ("FAIL: second crypt_rn with 4 threads: got %s, expected %s\n",
+              cd->output, expected);
+      status = 1;
+    }
+  if (threads_started != started)
+    {
+      printf ("FAIL: second crypt_rn started %u more threads\n",
+              threads_started - started);
+      status = 1;
+    }
+
+  free (cd);
+  return status;
+}
+
+#endif
@@ -0,0 +1,239 @@
+/* Test crypt_rom_create, crypt_rom_load and crypt_gensalt_rom_rn.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#if INCLUDE_yescrypt && defined __unix__
+
+#define ROM1 "crypt-rom-test-1.rom"
+#define ROM2 "crypt-rom-test-2.rom"
+#define ROM_SIZE (1UL << 20)
+
+static const char phrase[] = "Ob-La-Di, Ob-La-Da";
+static const char rbytes[] = "0123456789abcdef";
+
+/* A hash that does not use a ROM.  */
+static const char plain_setting[] = "$y$j75$MJHnaAkegEVYHsFKkmfzJ1";
+static const char plain_hash[] =
+  "$y$j75$MJHnaAkegEVYHsFKkmfzJ1$K2PXS.kbfzxWZaaBjSHNtzfQN6qrrr1LmlMjMpfBDV4";
+
+/* What crypt_gensalt_rom_rn gives for RBYTES and cost 3 with a 1 MiB
+   ROM, and
+   the hash with the ROM made from "seed 1", which is the same as with
+   a ROM computed in memory by yescrypt_init_shared.  */
+static const char rom_expected[] =
+  "$y$j7T55$k2XAnEHBqQ1Ct2aMXFKNa/$tNtuNSlQxaAxqA0Hkdsll61iD9xX9wLBVuM6DMuOon2";
+
+/* Hash PHRASE with SETTING, and return the result, or NULL on failure.  */
+static const char *
+hash (const char *setting, struct crypt_data *cd)
+{
+  memset (cd, 0, sizeof *cd);
+  return crypt_rn (phrase, setting, cd, (int) sizeof *cd);
+}
+
+static bool
+expect_fail (const char *what, int rv, int err)
+{
+  if (rv != -1 || errno != err)
+    {
+      printf ("FAIL: %s: got %d (%s), expected -1 (%s)\n",
+              what, rv, strerror (errno), strerror (err));
+      return false;
+    }
+  return true;
+}
+
+int
+main (void)
+{
+  struct crypt_data cd;
+  char setting[CRYPT_GENSALT_OUTPUT_SIZE];
+  char rom_setting[CRYPT_GENSALT_OUTPUT_SIZE];
+  char rom_hash[CRYPT_OUTPUT_SIZE];
+  bool ok = true;
+  FILE *fp;
+
+  unlink (ROM1);
+  unlink (ROM2);
+
+  if (crypt_rom_create (ROM1, "seed 1", 6, ROM_SIZE)
+      || crypt_rom_create (ROM2, "seed 2", 6, ROM_SIZE))
+    {
+      printf ("ERROR: crypt_rom_create: %s\n", strerror (errno));
+      return 99;
+    }
+
+  /* Argument errors.  */
+  errno = 0;
+  ok &= expect_fail ("existing file",
+                     crypt_rom_create (ROM1, "x", 1, ROM_SIZE), EEXIST);
+  errno = 0;
+  ok &= expect_fail ("size not a power of two",
+                     crypt_rom_create ("never", "x", 1, 3 * ROM_SIZE), EINVAL);
+  errno = 0;
+  ok &= expect_fail ("size too small",
+                     crypt_rom_create ("never", "x", 1, ROM_SIZE / 2), EINVAL);
+  errno = 0;
+  ok &= expect_fail ("missing file", crypt_rom_load ("never"), ENOENT);
+  errno = 0;
+  ok &= expect_fail ("ROM setting without a ROM",
+                     crypt_gensalt_rom_rn ("$y$", 3, rbytes, 16, rom_setting,
+                                           sizeof rom_setting) ? 0 : -1,
+                     ENOENT);
+
+  /* A file of the right size without the ROM tag.  */
+  fp = fopen ("never", "w");
+  if (!fp || fseek (fp, (long) ROM_SIZE - 1, SEEK_SET) || putc (0, fp) == EOF
+      || fclose (fp))
+    {
+      printf ("ERROR: creating a file: %s\n", strerror (errno));
+      return 99;
+    }
+  errno = 0;
+  ok &= expect_fail ("not a ROM", crypt_rom_load ("never"), EINVAL);
+  unlink ("never");
+
+  if (!crypt_gensalt_rn ("$y$", 3, rbytes, 16, setting, sizeof setting))
+    {
+      printf ("ERROR: crypt_gensalt: %s\n", strerror (errno));
+      return 99;
+    }
+
+  if (crypt_rom_load (ROM1))
+    {
+      printf ("ERROR: crypt_rom_load: %s\n", strerror (errno));
+      return 99;
+    }
+
+  /* Hashes without a ROM are unaffected.  */
+  if (!hash (plain_setting, &cd) || strcmp (cd.output, plain_hash))
+    {
+      printf ("FAIL: %s with a ROM loaded: got %s\n", plain_setting,
+              cd.output);
+      ok = false;
+    }
+
+  /* Settings only ask for the ROM when that is asked for.  */
+  if (!crypt_gensalt_rn ("$y$", 3, rbytes, 16,
+                         rom_setting, sizeof rom_setting)
+      || strcmp (rom_setting, setting))
+    {
+      printf ("FAIL: crypt_gensalt with a ROM loaded: got %s\n",
+              rom_setting);
+      ok = false;
+    }
+  errno = 0;
+  ok &= expect_fail ("ROM setting for $6$",
+                     crypt_gensalt_rom_rn ("$6$", 5000, rbytes, 16,
+                                           rom_setting,
+                                           sizeof rom_setting) ? 0 : -1,
+                     EINVAL);
+  if (!crypt_gensalt_rom_rn ("$y$", 3, rbytes, 16,
+                             rom_setting, sizeof rom_setting)
+      || !strcmp (rom_setting, setting))
+    {
+      printf ("FAIL: crypt_gensalt_rom_rn: got %s\n", rom_setting);
+      return 1;
+    }
+
+  if (!hash (rom_setting, &cd))
+    {
+      printf ("FAIL: hashing %s with a ROM: %s\n", rom_setting,
+              strerror (errno));
+      return 1;
+    }
+  strcpy (rom_hash, cd.output);
+  if (strcmp (rom_hash, rom_expected))
+    {
+      printf ("FAIL: hashing with a ROM: got %s, expected %s\n",
+              rom_hash, rom_expected);
+      ok = false;
+    }
+  if (!hash (rom_hash, &cd) || strcmp (cd.output, rom_hash))
+    {
+      printf ("FAIL: %s does not verify\n", rom_hash);
+      ok = false;
+    }
+
+#if INCLUDE_gost_yescrypt
+  char gsetting[CRYPT_GENSALT_OUTPUT_SIZE];
+  if (!crypt_gensalt_rom_rn ("$gy$", 3, rbytes, 16,
+                             gsetting, sizeof gsetting)
+      || strcmp (gsetting + 4, rom_setting + 3))
+    {
+      printf ("FAIL: crypt_gensalt_rom_rn: got %s\n", gsetting);
+      ok = false;
+    }
+  else if (!hash (gsetting, &cd))
+    {
+      printf ("FAIL: hashing %s with a ROM: %s\n", gsetting,
+              strerror (errno));
+      ok = false;
+    }
+#endif
+
+  /* A different ROM gives a different hash.  */
+  if (crypt_rom_load (ROM2))
+    {
+      printf ("ERROR: crypt_rom_load: %s\n", strerror (errno));
+      return 99;
+    }
+  if (!hash (rom_setting, &cd) || !strcmp (cd.output, rom_hash))
+    {
+      printf ("FAIL: hashing with another ROM: got %s\n", cd.output);
+      ok = false;
+    }
+
+  /* And the first one the same hash again.  */
+  if (crypt_rom_load (ROM1) || !hash (rom_setting, &cd)
+      || strcmp (cd.output, rom_hash))
+    {
+      printf ("FAIL: reloading the ROM: got %s\n", cd.output);
+      ok = false;
+    }
+
+  /* Without a ROM, settings that ask for one cannot be hashed, and
+     new settings do not ask for one.  */
+  if (crypt_rom_load (NULL))
+    {
+      printf ("FAIL: unloading the ROM: %s\n", strerror (errno));
+      ok = false;
+    }
+  if (hash (rom_setting, &cd))
+    {
+      printf ("FAIL: hashing %s without a ROM succeeded\n", rom_setting);
+      ok = false;
+    }
+  if (!crypt_gensalt_rn ("$y$", 3, rbytes, 16, rom_setting,
+                         sizeof rom_setting)
+      || strcmp (rom_setting, setting))
+    {
+      printf ("FAIL: crypt_gensalt without a ROM: got %s\n", rom_setting);
+      ok = false;
+    }
+
+  unlink (ROM1);
+  unlink (ROM2);
+  return ok ? 0 : 1;
+}
+
+#else
+
+int
+main (void)
+{
+  return 77; /* UNSUPPORTED */
+}
+
+#endif
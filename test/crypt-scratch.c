@@ -0,0 +1,117 @@
+/* Test that crypt_rn leaves nothing behind in its scratch area.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   crypt_rn erases only as much of crypt_data.internal as the hashing
+   method says it may write.  Fill the area with a canary byte before
+   hashing; afterward every byte must be either erased or still the
+   canary, or else the method wrote past the size it declared.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#define CANARY 0xAA
+
+static const char *const settings[] =
+{
+#if INCLUDE_descrypt || INCLUDE_bigcrypt
+  "Mp",
+#endif
+#if INCLUDE_bsdicrypt
+  "_J9..MJHn",
+#endif
+#if INCLUDE_md5crypt
+  "$1$MJHnaAke",
+#endif
+#if INCLUDE_nt
+  "$3$",
+#endif
+#if INCLUDE_sunmd5
+  "$md5,rounds=55349$BPm.fm03$",
+#endif
+#if INCLUDE_sha1crypt
+  "$sha1$248488$ggu.H673kaZ5$",
+#endif
+#if INCLUDE_sha256crypt
+  "$5$MJHnaAkegEVYHsFK",
+#endif
+#if INCLUDE_sha512crypt
+  "$6$MJHnaAkegEVYHsFK",
+#endif
+#if INCLUDE_bcrypt_a
+  "$2a$05$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+#if INCLUDE_bcrypt
+  "$2b$05$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+#if INCLUDE_bcrypt_x
+  "$2x$05$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+#if INCLUDE_bcrypt_y
+  "$2y$05$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+#if INCLUDE_yescrypt
+  "$y$j9T$MJHnaAkegEVYHsFKkmfzJ1",
+#endif
+#if INCLUDE_scrypt
+  "$7$CU..../....MJHnaAkegEVYHsFKkmfzJ1",
+#endif
+#if INCLUDE_gost_yescrypt
+  "$gy$j9T$MJHnaAkegEVYHsFKkmfzJ1",
+#endif
+#if INCLUDE_argon2id
+  "$argon2id$v=19$m=1024,t=3,p=4$WDXNJgOrLBSSEx5ZsLz+1Q",
+#endif
+  /* Keep the array nonempty when no method is enabled.  */
+  "*"
+};
+
+int
+main (void)
+{
+  struct crypt_data cd;
+  bool ok = true;
+
+  for (size_t i = 0; i < ARRAY_SIZE (settings) - 1; i++)
+    {
+      memset (&cd, 0, sizeof cd);
+      memset (cd.internal, CANARY, sizeof cd.internal);
+      if (!crypt_rn ("Ob-La-Di, Ob-La-Da", settings[i], &cd,
+                     (int) sizeof cd))
+        {
+          printf ("FAIL: hashing with %s: %s\n", settings[i],
+                  strerror (errno));
+          ok = false;
+          continue;
+        }
+
+      size_t erased = 0;
+      for (size_t j = 0; j < sizeof cd.internal; j++)
+        {
+          unsigned char c = (unsigned char) cd.internal[j];
+          if (c == 0)
+            erased++;
+          else if (c != CANARY)
+            {
+              printf ("FAIL: %s: byte %zu of the scratch area "
+                      "was left as 0x%02x\n", settings[i], j, c);
+              ok = false;
+              break;
+            }
+        }
+      if (erased == 0)
+        {
+          printf ("FAIL: %s: nothing was erased\n", settings[i]);
+          ok = false;
+        }
+    }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+/* Test that crypt and crypt_gensalt keep their results per thread.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#if defined HAVE_PTHREADS && (INCLUDE_sha512crypt || INCLUDE_md5crypt)
+
+#include <pthread.h>
+
+#if INCLUDE_sha512crypt
+#define PREFIX "$6$"
+#define COUNT  1000
+#else
+#define PREFIX "$1$"
+#define COUNT  0
+#endif
+
+#define NTHREADS 4
+#define ROUNDS   25
+
+struct worker
+{
+  int id;
+  char rbytes[16];
+  char phrase[32];
+  char setting[CRYPT_GENSALT_OUTPUT_SIZE];
+  char hash[CRYPT_OUTPUT_SIZE];
+  char *crypt_result;
+  char *gensalt_result;
+  bool ok;
+};
+
+static struct worker workers[NTHREADS];
+static pthread_barrier_t barrier;
+
+/* Every thread makes its own setting and hash over and over, all at
+   the same time, and must always get its own results back, in the
+   same buffers each time.  No thread exits before all are done, so
+   that no buffer is freed and handed to another thread.  */
+static void *
+work (void *arg)
+{
+  struct worker *w = arg;
+
+  w->ok = true;
+  pthread_barrier_wait (&barrier);
+  for (int round = 0; round < ROUNDS; round++)
+    {
+      char *s = crypt_gensalt (PREFIX, COUNT, w->rbytes,
+                               (int) sizeof w->rbytes);
+      if (!s || strcmp (s, w->setting))
+        {
+          printf ("FAIL: thread %d: crypt_gensalt gave %s, expected %s\n",
+                  w->id, s ? s : "(null)", w->setting);
+          w->ok = false;
+          break;
+        }
+      char *h = crypt (w->phrase, s);
+      if (!h || strcmp (h, w->hash))
+        {
+          printf ("FAIL: thread %d: crypt gave %s, expected %s\n",
+                  w->id, h ? h : "(null)", w->hash);
+          w->ok = false;
+          break;
+        }
+      if (round > 0 && (s != w->gensalt_result || h != w->crypt_result))
+        {
+          printf ("FAIL: thread %d: result buffers moved\n", w->id);
+          w->ok = false;
+          break;
+        }
+      w->gensalt_result = s;
+      w->crypt_result = h;
+    }
+  pthread_barrier_wait (&barrier);
+  return 0;
+}
+
+int
+main (void)
+{
+  pthread_t threads[NTHREADS];
+  struct crypt_data cd;
+  bool ok = true;
+
+  for (int i = 0; i < NTHREADS; i++)
+    {
+      struct worker *w = &workers[i];
+      w->id = i;
+      memset (w->rbytes, 'a' + i, sizeof w->rbytes);
+      snprintf (w->phrase, sizeof w->phrase, "passphrase %d", i);
+      if (!crypt_gensalt_rn (PREFIX, COUNT, w->rbytes,
+                             (int) sizeof w->rbytes,
+                             w->setting, (int) sizeof w->setting))
+        {
+          printf ("ERROR: crypt_gensalt_rn: %s\n", strerror (errno));
+          return 99;
+        }
+      memset (&cd, 0, sizeof cd);
+      if (!crypt_rn (w->phrase, w->setting, &cd, (int) sizeof cd))
+        {
+          printf ("ERROR: crypt_rn: %s\n", strerror (errno));
+          return 99;
+        }
+      strcpy (w->hash, cd.output);
+    }
+
+  pthread_barrier_init (&barrier, NULL, NTHREADS);
+  for (int i = 0; i < NTHREADS; i++)
+    if (pthread_create (&threads[i], NULL, work, &workers[i]))
+      {
+        printf ("ERROR: pthread_create failed\n");
+        return 99;
+      }
+  for (int i = 0; i < NTHREADS; i++)
+    {
+      pthread_join (threads[i], NULL);
+      ok &= workers[i].ok;
+    }
+  pthread_barrier_destroy (&barrier);
+
+  for (int i = 0; i < NTHREADS; i++)
+    for (int j = i + 1; j < NTHREADS; j++)
+      if (workers[i].crypt_result == workers[j].crypt_result
+          || workers[i].gensalt_result == workers[j].gensalt_result)
+        {
+          printf ("FAIL: threads %d and %d shared a result buffer\n", i, j);
+          ok = false;
+        }
+
+  return ok ? 0 : 1;
+}
+
+#else
+
+int
+main (void)
+{
+  return 77; /* UNSUPPORTED */
+}
+
+#endif
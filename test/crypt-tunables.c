@@ -0,0 +1,397 @@
+/* Test crypt_set_tunable and crypt_get_tunable.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+
+static bool
+expect_error (const char *what, long rv, int err)
+{
+  if (rv != -1 || errno != err)
+    {
+      printf ("FAIL: %s: got %ld (%s), expected -1 (%s)\n",
+              what, rv, strerror (errno), strerror (err));
+      return false;
+    }
+  return true;
+}
+
+#if INCLUDE_yescrypt
+/* yescrypt, N=2048, r=8, p=4.  */
+static const char p4_setting[] = "$y$j85.0$k2XAnEHBqQ1Ct2aMXFKNa/";
+
+static bool
+check_threads (long nthreads, const char *expected)
+{
+  struct crypt_data cd;
+  memset (&cd, 0, sizeof cd);
+
+  if (crypt_set_tunable (CRYPT_TUNE_THREADS, nthreads))
+    {
+      printf ("FAIL: setting %ld threads: %s\n", nthreads, strerror (errno));
+      return false;
+    }
+  if (!crypt_rn ("Ob-La-Di, Ob-La-Da", p4_setting, &cd, (int) sizeof cd))
+    {
+      printf ("FAIL: hashing with %ld threads: %s\n",
+              nthreads, strerror (errno));
+      return false;
+    }
+  if (strcmp (cd.output, expected))
+    {
+      printf ("FAIL: %ld threads: got %s, expected %s\n",
+              nthreads, cd.output, expected);
+      return false;
+    }
+  return true;
+}
+
+/* The threads field of struct crypt_data lowers the process-wide
+   setting for one call, is capped by it, and leaves it alone.  */
+static bool
+check_call_threads (unsigned char nthreads, const char *expected)
+{
+  struct crypt_data cd;
+  memset (&cd, 0, sizeof cd);
+  cd.threads = nthreads;
+
+  crypt_set_tunable (CRYPT_TUNE_THREADS, 4);
+  if (!crypt_rn ("Ob-La-Di, Ob-La-Da", p4_setting, &cd, (int) sizeof cd))
+    {
+      printf ("FAIL: hashing with %u threads per call: %s\n",
+              nthreads, strerror (errno));
+      return false;
+    }
+  if (strcmp (cd.output, expected))
+    {
+      printf ("FAIL: %u threads per call: got %s, expected %s\n",
+              nthreads, cd.output, expected);
+      return false;
+    }
+  if (crypt_get_tunable (CRYPT_TUNE_THREADS) != 4)
+    {
+      printf ("FAIL: %u threads per call changed the global setting\n",
+              nthreads);
+      return false;
+    }
+  return true;
+}
+#endif
+
+#if INCLUDE_yescrypt || INCLUDE_gost_yescrypt
+/* Settings that need different amounts of memory, so that kept memory
+   is reused both for smaller and for larger hashes.  */
+static const char *const keep_settings[] =
+{
+#if INCLUDE_yescrypt
+  "$y$j85.0$k2XAnEHBqQ1Ct2aMXFKNa/",
+  "$y$j75$MJHnaAkegEVYHsFKkmfzJ1",
+  "$y$j95$MJHnaAkegEVYHsFKkmfzJ1",
+#endif
+#if INCLUDE_gost_yescrypt
+  "$gy$j75$MJHnaAkegEVYHsFKkmfzJ1",
+#endif
+};
+
+/* Hashes must not depend on whether memory is kept between them.  */
+static bool
+check_keep_memory (void)
+{
+  static char expected[ARRAY_SIZE (keep_settings)][CRYPT_OUTPUT_SIZE];
+  struct crypt_data cd;
+  bool ok = true;
+
+  for (size_t i = 0; i < ARRAY_SIZE (keep_settings); i++)
+    {
+      memset (&cd, 0, sizeof cd);
+      if (!crypt_rn ("Ob-La-Di, Ob-La-Da", keep_settings[i],
+                     &cd, (int) sizeof cd))
+        {
+          printf ("ERROR: hashing with %s: %s\n",
+                  keep_settings[i], strerror (errno));
+          return false;
+        }
+      strcpy (expected[i], cd.output);
+    }
+
+  if (crypt_set_tunable (CRYPT_TUNE_KEEP_MEMORY, LONG_MAX))
+    {
+      if (errno != ENOTSUP)
+        {
+          printf ("FAIL: keeping memory: %s\n", strerror (errno));
+          return false;
+        }
+      return true;
+    }
+
+  for (int round = 0; round < 2; round++)
+    for (size_t i = 0; i < ARRAY_SIZE (keep_settings); i++)
+      {
+        memset (&cd, 0, sizeof cd);
+        if (!crypt_rn ("Ob-La-Di, Ob-La-Da", keep_settings[i],
+                       &cd, (int) sizeof cd))
+          {
+            printf ("FAIL: hashing with %s and kept memory: %s\n",
+                    keep_settings[i], strerror (errno));
+            ok = false;
+          }
+        else if (strcmp (cd.output, expected[i]))
+          {
+            printf ("FAIL: kept memory: got %s, expected %s\n",
+                    cd.output, expected[i]);
+            ok = false;
+          }
+      }
+
+  crypt_set_tunable (CRYPT_TUNE_KEEP_MEMORY, 0);
+  return ok;
+}
+#endif
+
+#if INCLUDE_yescrypt
+/* Hashes must not depend on how their memory was allocated, and only
+   what was asked for can have been obtained.  */
+static bool
+check_memory_policy (void)
+{
+  static const char setting[] = "$y$j95$MJHnaAkegEVYHsFKkmfzJ1";
+  char expected[CRYPT_OUTPUT_SIZE];
+  struct crypt_data cd;
+  bool ok = true;
+
+  memset (&cd, 0, sizeof cd);
+  if (!crypt_rn ("Ob-La-Di, Ob-La-Da", setting, &cd, (int) sizeof cd))
+    {
+      printf ("ERROR: hashing with %s: %s\n", setting, strerror (errno));
+      return false;
+    }
+  strcpy (expected, cd.output);
+
+  for (long policy = 0;
+       policy <= (CRYPT_MEMORY_HUGETLB | CRYPT_MEMORY_THP
+                  | CRYPT_MEMORY_POPULATE);
+       policy++)
+    {
+      if (crypt_set_tunable (CRYPT_TUNE_MEMORY_POLICY, policy))
+        {
+          printf ("FAIL: setting memory policy %ld: %s\n",
+                  policy, strerror (errno));
+          ok = false;
+          continue;
+        }
+      memset (&cd, 0, sizeof cd);
+      if (!crypt_rn ("Ob-La-Di, Ob-La-Da", setting, &cd, (int) sizeof cd))
+        {
+          printf ("FAIL: hashing with memory policy %ld: %s\n",
+                  policy, strerror (errno));
+          ok = false;
+          continue;
+        }
+      if (strcmp (cd.output, expected))
+        {
+          printf ("FAIL: memory policy %ld: got %s, expected %s\n",
+                  policy, cd.output, expected);
+          ok = false;
+        }
+      long obtained = crypt_get_tunable (CRYPT_TUNE_MEMORY_OBTAINED);
+      if (obtained & ~policy)
+        {
+          printf ("FAIL: memory policy %ld: obtained %ld\n",
+                  policy, obtained);
+          ok = false;
+        }
+    }
+
+  crypt_set_tunable (CRYPT_TUNE_MEMORY_POLICY, CRYPT_MEMORY_HUGETLB);
+  return ok;
+}
+#endif
+
+#if INCLUDE_bcrypt || INCLUDE_bcrypt_a || INCLUDE_bcrypt_x || INCLUDE_bcrypt_y
+static const char *const bcrypt_settings[] =
+{
+#if INCLUDE_bcrypt_a
+  "$2a$04$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+#if INCLUDE_bcrypt
+  "$2b$04$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+#if INCLUDE_bcrypt_x
+  "$2x$04$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+#if INCLUDE_bcrypt_y
+  "$2y$04$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+};
+
+/* Hashes must not depend on whether the self-test is run.  */
+static bool
+check_self_test_once (void)
+{
+  static char expected[ARRAY_SIZE (bcrypt_settings)][CRYPT_OUTPUT_SIZE];
+  struct crypt_data cd;
+  bool ok = true;
+
+  for (size_t i = 0; i < ARRAY_SIZE (bcrypt_settings); i++)
+    {
+      memset (&cd, 0, sizeof cd);
+      if (!crypt_rn ("Ob-La-Di, Ob-La-Da", bcrypt_settings[i],
+                     &cd, (int) sizeof cd))
+        {
+          printf ("ERROR: hashing with %s: %s\n",
+                  bcrypt_settings[i], strerror (errno));
+          return false;
+        }
+      strcpy (expected[i], cd.output);
+    }
+
+  if (crypt_set_tunable (CRYPT_TUNE_SELF_TEST, CRYPT_SELF_TEST_ONCE))
+    {
+      printf ("FAIL: self-testing once: %s\n", strerror (errno));
+      return false;
+    }
+
+  for (int round = 0; round < 2; round++)
+    for (size_t i = 0; i < ARRAY_SIZE (bcrypt_settings); i++)
+      {
+        memset (&cd, 0, sizeof cd);
+        if (!crypt_rn ("Ob-La-Di, Ob-La-Da", bcrypt_settings[i],
+                       &cd, (int) sizeof cd))
+          {
+            printf ("FAIL: hashing with %s, self-testing once: %s\n",
+                    bcrypt_settings[i], strerror (errno));
+            ok = false;
+          }
+        else if (strcmp (cd.output, expected[i]))
+          {
+            printf ("FAIL: self-testing once: got %s, expected %s\n",
+                    cd.output, expected[i]);
+            ok = false;
+          }
+      }
+
+  crypt_set_tunable (CRYPT_TUNE_SELF_TEST, CRYPT_SELF_TEST_ALWAYS);
+  return ok;
+}
+#endif
+
+int
+main (void)
+{
+  bool ok = true;
+
+  long v = crypt_get_tunable (CRYPT_TUNE_THREADS);
+  if (v != 1)
+    {
+      printf ("FAIL: default CRYPT_TUNE_THREADS is %ld\n", v);
+      ok = false;
+    }
+
+  errno = 0;
+  ok &= expect_error ("get unknown", crypt_get_tunable (0), EINVAL);
+  errno = 0;
+  ok &= expect_error ("get unknown", crypt_get_tunable (-1), EINVAL);
+  errno = 0;
+  ok &= expect_error ("set unknown", crypt_set_tunable (0, 1), EINVAL);
+  errno = 0;
+  ok &= expect_error ("0 threads",
+                      crypt_set_tunable (CRYPT_TUNE_THREADS, 0), EINVAL);
+  errno = 0;
+  ok &= expect_error ("257 threads",
+                      crypt_set_tunable (CRYPT_TUNE_THREADS, 257), EINVAL);
+  if (crypt_get_tunable (CRYPT_TUNE_THREADS) != 1)
+    {
+      printf ("FAIL: CRYPT_TUNE_THREADS changed by invalid calls\n");
+      ok = false;
+    }
+
+  if (crypt_get_tunable (CRYPT_TUNE_KEEP_MEMORY) != 0)
+    {
+      printf ("FAIL: default CRYPT_TUNE_KEEP_MEMORY is not 0\n");
+      ok = false;
+    }
+  errno = 0;
+  ok &= expect_error ("negative memory",
+                      crypt_set_tunable (CRYPT_TUNE_KEEP_MEMORY, -1), EINVAL);
+#if INCLUDE_yescrypt || INCLUDE_gost_yescrypt
+  ok &= check_keep_memory ();
+#endif
+
+  if (crypt_get_tunable (CRYPT_TUNE_MEMORY_POLICY) != CRYPT_MEMORY_HUGETLB)
+    {
+      printf ("FAIL: default CRYPT_TUNE_MEMORY_POLICY is not HUGETLB\n");
+      ok = false;
+    }
+  errno = 0;
+  ok &= expect_error ("unknown memory policy",
+                      crypt_set_tunable (CRYPT_TUNE_MEMORY_POLICY, 8),
+                      EINVAL);
+  errno = 0;
+  ok &= expect_error ("set obtained memory",
+                      crypt_set_tunable (CRYPT_TUNE_MEMORY_OBTAINED, 0),
+                      EINVAL);
+#if INCLUDE_yescrypt
+  ok &= check_memory_policy ();
+#endif
+
+  if (crypt_get_tunable (CRYPT_TUNE_SELF_TEST) != CRYPT_SELF_TEST_ALWAYS)
+    {
+      printf ("FAIL: default CRYPT_TUNE_SELF_TEST is not ALWAYS\n");
+      ok = false;
+    }
+  errno = 0;
+  ok &= expect_error ("unknown self-test mode",
+                      crypt_set_tunable (CRYPT_TUNE_SELF_TEST, 2), EINVAL);
+#if INCLUDE_bcrypt || INCLUDE_bcrypt_a || INCLUDE_bcrypt_x || INCLUDE_bcrypt_y
+  ok &= check_self_test_once ();
+#endif
+
+  if (crypt_set_tunable (CRYPT_TUNE_THREADS, 4))
+    {
+      if (errno != ENOTSUP)
+        {
+          printf ("FAIL: setting 4 threads: %s\n", strerror (errno));
+          ok = false;
+        }
+      return ok ? 0 : 1;
+    }
+  v = crypt_get_tunable (CRYPT_TUNE_THREADS);
+  if (v != 4)
+    {
+      printf ("FAIL: CRYPT_TUNE_THREADS is %ld after setting 4\n", v);
+      ok = false;
+    }
+
+#if INCLUDE_yescrypt
+  /* The result must not depend on the number of threads, including
+     numbers that do not divide the lanes evenly.  */
+  static char expected[CRYPT_OUTPUT_SIZE];
+  struct crypt_data cd;
+  memset (&cd, 0, sizeof cd);
+  crypt_set_tunable (CRYPT_TUNE_THREADS, 1);
+  if (!crypt_rn ("Ob-La-Di, Ob-La-Da", p4_setting, &cd, (int) sizeof cd))
+    {
+      printf ("ERROR: hashing with one thread: %s\n", strerror (errno));
+      return 99;
+    }
+  strcpy (expected, cd.output);
+
+  ok &= check_threads (2, expected);
+  ok &= check_threads (3, expected);
+  ok &= check_threads (4, expected);
+  ok &= check_threads (256, expected);
+  ok &= check_call_threads (3, expected);
+  ok &= check_call_threads (255, expected);
+#endif
+
+  return ok ? 0 : 1;
+}
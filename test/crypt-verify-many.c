@@ -0,0 +1,456 @@
+/* Test crypt_verify_many.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.  */
+
+#include "crypt-port.h"
+#include "cpu-variants.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Cheap settings for every hashing method, so that the test does not
+   take too long.  */
+static const char *settings[] =
+{
+#if INCLUDE_descrypt
+  "Mp",
+#endif
+#if INCLUDE_bigcrypt
+  "Mp............",
+#endif
+#if INCLUDE_bsdicrypt
+  "_J9..MJHn",
+#endif
+#if INCLUDE_md5crypt
+  "$1$MJHnaAke",
+#endif
+#if INCLUDE_nt
+  "$3$",
+#endif
+#if INCLUDE_sunmd5
+  "$md5,rounds=100$BPm.fm03$",
+#endif
+#if INCLUDE_sha1crypt
+  "$sha1$1000$ggu.H673kaZ5$",
+#endif
+#if INCLUDE_sha256crypt
+  "$5$rounds=1000$MJHnaAkegEVYHsFK",
+#endif
+#if INCLUDE_sha512crypt
+  "$6$rounds=1000$MJHnaAkegEVYHsFK",
+#endif
+#if INCLUDE_bcrypt_a
+  "$2a$04$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+#if INCLUDE_bcrypt
+  "$2b$04$UBVLHeMpJ/QQCv3XqJx8zO",
+  /* A different cost, in the same groups as the one above.  */
+  "$2b$05$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+#if INCLUDE_bcrypt_x
+  "$2x$04$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+#if INCLUDE_bcrypt_y
+  "$2y$04$UBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+#if INCLUDE_yescrypt
+  "$y$j75$MJHnaAkegEVYHsFKkmfzJ1",
+#endif
+#if INCLUDE_scrypt
+  "$7$AU..../....MJHnaAkegEVYHsFKkmfzJ1",
+#endif
+#if INCLUDE_gost_yescrypt
+  "$gy$j75$MJHnaAkegEVYHsFKkmfzJ1",
+#endif
+#if INCLUDE_argon2id
+  "$argon2id$v=19$m=64,t=1,p=2$TUpIbmFBa2VnRVZZSHNGSw",
+#endif
+};
+
+static const char *phrases[] =
+{
+  "",
+  "a",
+  "Ob-La-Di, Ob-La-Da",
+  "the ritual question of how much is two plus two",
+  "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+  "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef",
+};
+
+/* Enough entries per method to fill more than one group.  */
+#define PER_SETTING (2 * ARRAY_SIZE (phrases))
+
+static const char *
+result_name (int result)
+{
+  switch (result)
+    {
+    case CRYPT_VERIFY_MATCH:    return "MATCH";
+    case CRYPT_VERIFY_MISMATCH: return "MISMATCH";
+    case CRYPT_VERIFY_INVALID:  return "INVALID";
+    default:                    return "(bad value)";
+    }
+}
+
+#if INCLUDE_descrypt || INCLUDE_bigcrypt || INCLUDE_bsdicrypt
+/* The DES-based methods are hashed in much larger groups.  Check a
+   lot of them at once, each with a different salt, and for bsdicrypt
+   a different iteration count.  Some of the bigcrypt hashes are too
+   long for the smaller output buffers those groups use.  */
+#define N_WIDE 200
+
+static const char b64[] =
+  "./0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+static bool
+check_wide_groups (void)
+{
+  static char phrase[N_WIDE][64];
+  static char hash[N_WIDE][CRYPT_OUTPUT_SIZE];
+  static struct crypt_verify_item items[N_WIDE];
+  static int expected[N_WIDE];
+  struct crypt_data cd;
+  char setting[16];
+  bool ok = true;
+  int nitems = 0, nmatch = 0;
+
+  for (unsigned int i = 0; i < N_WIDE; i++)
+    {
+      switch (i % 3)
+        {
+        case 0:
+#if INCLUDE_descrypt
+          setting[0] = b64[i % 64];
+          setting[1] = b64[(i / 64 + 5 * i) % 64];
+          setting[2] = '\0';
+          break;
+#else
+          continue;
+#endif
+        case 1:
+#if INCLUDE_bsdicrypt
+          setting[0] = '_';
+          setting[1] = b64[(i % 9) * 2 + 1];
+          memcpy (setting + 2, "...", 3);
+          setting[5] = b64[i % 64];
+          setting[6] = b64[(i * 7) % 64];
+          memcpy (setting + 7, "..", 3);
+          break;
+#else
+          continue;
+#endif
+        default:
+#if INCLUDE_bigcrypt
+          setting[0] = b64[(i * 3) % 64];
+          setting[1] = b64[i % 64];
+          memcpy (setting + 2, "............", 13);
+          break;
+#else
+          continue;
+#endif
+        }
+
+      /* Every seventh phrase is long enough that bigcrypt needs
+         more than four blocks for it.  */
+      snprintf (phrase[nitems], sizeof phrase[nitems],
+                i % 7 ? "pass%u" : "a considerably longer passphrase, #%u",
+                i);
+      memset (&cd, 0, sizeof cd);
+      if (!crypt_rn (phrase[nitems], setting, &cd, (int) sizeof cd))
+        {
+          printf ("ERROR: crypt_rn(\"%s\", \"%s\") failed: %s\n",
+                  phrase[nitems], setting, strerror (errno));
+          return false;
+        }
+      strcpy (hash[nitems], cd.output);
+
+      /* Every other entry is given a phrase that differs in its first
+         character, which all of these methods use.  */
+      if (i % 2)
+        {
+          phrase[nitems][0] ^= 1;
+          expected[nitems] = CRYPT_VERIFY_MISMATCH;
+        }
+      else
+        {
+          expected[nitems] = CRYPT_VERIFY_MATCH;
+          nmatch++;
+        }
+      items[nitems].phrase = phrase[nitems];
+      items[nitems].setting = hash[nitems];
+      items[nitems].result = -1;
+      nitems++;
+    }
+
+  memset (&cd, 0, sizeof cd);
+  int rv = crypt_verify_many (items, nitems, &cd, (int) sizeof cd);
+  if (rv != nmatch)
+    {
+      printf ("FAIL: DES batch: crypt_verify_many returned %d, expected %d\n",
+              rv, nmatch);
+      ok = false;
+    }
+  for (int i = 0; i < nitems; i++)
+    if (items[i].result != expected[i])
+      {
+        printf ("FAIL: DES batch: item %d (\"%s\"): got %s, expected %s\n",
+                i, items[i].setting, result_name (items[i].result),
+                result_name (expected[i]));
+        ok = false;
+      }
+  return ok;
+}
+#endif
+
+#if INCLUDE_sha256crypt || INCLUDE_sha512crypt
+/* sha256crypt and sha512crypt entries are sorted, and hashed together
+   only with others of the same phrase length, salt length and number
+   of rounds.  Mix a few of each, in an order that makes runs of them
+   cross group boundaries, with some that have no partner at all.  */
+#define N_SORTED 60
+
+static bool
+check_sorted_groups (void)
+{
+  static const char *const sha_settings[] =
+  {
+#if INCLUDE_sha256crypt
+    "$5$rounds=1000$MJHnaAkegEVYHsFK",
+    "$5$rounds=1001$MJHnaAkegEVY",
+#endif
+#if INCLUDE_sha512crypt
+    "$6$rounds=1000$MJHnaAkegEVYHsFK",
+    "$6$rounds=1001$MJHnaAkegEVY",
+#endif
+  };
+  static char phrase[N_SORTED][32];
+  static char hash[N_SORTED][CRYPT_OUTPUT_SIZE];
+  static struct crypt_verify_item items[N_SORTED];
+  static int expected[N_SORTED];
+  struct crypt_data cd;
+  bool ok = true;
+  int nmatch = 0;
+
+  for (int i = 0; i < N_SORTED; i++)
+    {
+      const char *setting = sha_settings[(size_t) i % ARRAY_SIZE (sha_settings)];
+
+      /* Three common lengths, and every eleventh entry a unique one.  */
+      if (i % 11 == 0)
+        snprintf (phrase[i], sizeof phrase[i], "%.*s", 12 + i / 11,
+                  "unique length phrases");
+      else
+        snprintf (phrase[i], sizeof phrase[i], "%0*d", 6 + i % 3, i);
+
+      memset (&cd, 0, sizeof cd);
+      if (!crypt_rn (phrase[i], setting, &cd, (int) sizeof cd))
+        {
+          printf ("ERROR: crypt_rn(\"%s\", \"%s\") failed: %s\n",
+                  phrase[i], setting, strerror (errno));
+          return false;
+        }
+      strcpy (hash[i], cd.output);
+
+      if (i % 5 == 1)
+        {
+          phrase[i][0] ^= 1;
+          expected[i] = CRYPT_VERIFY_MISMATCH;
+        }
+      else
+        {
+          expected[i] = CRYPT_VERIFY_MATCH;
+          nmatch++;
+        }
+      items[i].phrase = phrase[i];
+      items[i].setting = hash[i];
+      items[i].result = -1;
+    }
+
+  memset (&cd, 0, sizeof cd);
+  int rv = crypt_verify_many (items, N_SORTED, &cd, (int) sizeof cd);
+  if (rv != nmatch)
+    {
+      printf ("FAIL: SHA batch: crypt_verify_many returned %d, expected %d\n",
+              rv, nmatch);
+      ok = false;
+    }
+  for (int i = 0; i < N_SORTED; i++)
+    if (items[i].result != expected[i])
+      {
+        printf ("FAIL: SHA batch: item %d (\"%s\"): got %s, expected %s\n",
+                i, items[i].setting, result_name (items[i].result),
+                result_name (expected[i]));
+        ok = false;
+      }
+  return ok;
+}
+#endif
+
+/* Settings with the prefix of an enabled method but parameters that
+   method rejects.  */
+static const char *const malformed[] =
+{
+#if INCLUDE_sha512crypt
+  "$6$rounds=$MJHnaAkegEVYHsFK",
+#endif
+#if INCLUDE_bcrypt
+  "$2b$99$UBVLHeMpJ/QQCv3XqJx8zOUBVLHeMpJ/QQCv3XqJx8zO",
+#endif
+  0
+};
+
+/* The batch main puts together, with every method mixed in.  */
+static struct crypt_verify_item *items;
+static int *expected;
+static size_t nitems;
+
+/* Check the batch and the groups above with the code selected for the
+   CPU extensions currently allowed.  */
+static int
+check_batches (const void *arg)
+{
+  struct crypt_data cd;
+  bool ok = true;
+  int nmatch = 0;
+
+  (void) arg;
+  for (size_t i = 0; i < nitems; i++)
+    {
+      items[i].result = -1;
+      if (expected[i] == CRYPT_VERIFY_MATCH)
+        nmatch++;
+    }
+
+  memset (&cd, 0, sizeof cd);
+  int rv = crypt_verify_many (items, (int) nitems, &cd, (int) sizeof cd);
+  if (rv != nmatch)
+    {
+      printf ("FAIL: crypt_verify_many returned %d, expected %d\n",
+              rv, nmatch);
+      ok = false;
+    }
+  for (size_t i = 0; i < nitems; i++)
+    if (items[i].result != expected[i])
+      {
+        printf ("FAIL: item %zu (\"%s\"): got %s, expected %s\n",
+                i, items[i].setting ? items[i].setting : "(nil)",
+                result_name (items[i].result), result_name (expected[i]));
+        ok = false;
+      }
+
+#if INCLUDE_descrypt || INCLUDE_bigcrypt || INCLUDE_bsdicrypt
+  if (!check_wide_groups ())
+    ok = false;
+#endif
+#if INCLUDE_sha256crypt || INCLUDE_sha512crypt
+  if (!check_sorted_groups ())
+    ok = false;
+#endif
+  return ok ? 0 : 1;
+}
+
+int
+main (void)
+{
+  bool ok = true;
+  struct crypt_data cd;
+  size_t nhashed = ARRAY_SIZE (settings) * PER_SETTING;
+  nitems = nhashed + 4 + ARRAY_SIZE (malformed) - 1;
+  char (*hashes)[CRYPT_OUTPUT_SIZE] = calloc (nhashed, CRYPT_OUTPUT_SIZE);
+  items = calloc (nitems, sizeof *items);
+  expected = calloc (nitems, sizeof *expected);
+  if (!hashes || !items || !expected)
+    {
+      perror ("calloc");
+      return 99;
+    }
+
+  /* Interleave the methods, so crypt_verify_many has to sort them
+     out.  Every other entry is given the wrong passphrase.  */
+  size_t n = 0;
+  for (size_t j = 0; j < PER_SETTING; j++)
+    for (size_t i = 0; i < ARRAY_SIZE (settings); i++)
+      {
+        const char *phrase = phrases[j % ARRAY_SIZE (phrases)];
+        memset (&cd, 0, sizeof cd);
+        if (!crypt_rn (phrase, settings[i], &cd, (int) sizeof cd))
+          {
+            printf ("ERROR: crypt_rn(\"%s\", \"%s\") failed: %s\n",
+                    phrase, settings[i], strerror (errno));
+            return 99;
+          }
+        strcpy (hashes[n], cd.output);
+
+        items[n].setting = hashes[n];
+        if (j < ARRAY_SIZE (phrases))
+          {
+            items[n].phrase = phrase;
+            expected[n] = CRYPT_VERIFY_MATCH;
+          }
+        else
+          {
+            items[n].phrase = phrases[(j + 1) % ARRAY_SIZE (phrases)];
+            expected[n] = CRYPT_VERIFY_MISMATCH;
+          }
+        n++;
+      }
+
+  /* Invalid entries mixed in at the end.  */
+  static char long_phrase[CRYPT_MAX_PASSPHRASE_SIZE + 1];
+  memset (long_phrase, 'x', CRYPT_MAX_PASSPHRASE_SIZE);
+
+  items[n].phrase = 0;
+  items[n].setting = hashes[0];
+  expected[n++] = CRYPT_VERIFY_INVALID;
+  items[n].phrase = phrases[0];
+  items[n].setting = 0;
+  expected[n++] = CRYPT_VERIFY_INVALID;
+  items[n].phrase = phrases[0];
+  items[n].setting = "$@";
+  expected[n++] = CRYPT_VERIFY_INVALID;
+  items[n].phrase = long_phrase;
+  items[n].setting = hashes[0];
+  expected[n++] = CRYPT_VERIFY_INVALID;
+  for (size_t i = 0; malformed[i]; i++)
+    {
+      items[n].phrase = phrases[0];
+      items[n].setting = malformed[i];
+      expected[n++] = CRYPT_VERIFY_INVALID;
+    }
+
+  if (for_each_cpu_variant (check_batches, 0))
+    ok = false;
+
+  /* Argument errors.  */
+  errno = 0;
+  int rv = crypt_verify_many (items, (int) nitems, &cd, (int) sizeof cd - 1);
+  if (rv != -1 || errno != ERANGE)
+    {
+      printf ("FAIL: short data area: got %d (%s)\n", rv, strerror (errno));
+      ok = false;
+    }
+  errno = 0;
+  rv = crypt_verify_many (0, 1, &cd, (int) sizeof cd);
+  if (rv != -1 || errno != EINVAL)
+    {
+      printf ("FAIL: null items: got %d (%s)\n", rv, strerror (errno));
+      ok = false;
+    }
+  rv = crypt_verify_many (0, 0, &cd, (int) sizeof cd);
+  if (rv != 0)
+    {
+      printf ("FAIL: empty batch: got %d\n", rv);
+      ok = false;
+    }
+
+  free (hashes);
+  free (items);
+  free (expected);
+  return ok ? 0 : 1;
+}
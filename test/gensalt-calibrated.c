@@ -0,0 +1,160 @@
+/* Test crypt_gensalt_calibrated and crypt_gensalt_calibrated_rn.
+
+   Written by the libxcrypt contributors in 2026.
+   To the extent possible under law, the authors have waived all
+   copyright and related or neighboring rights to this work.
+
+   See https://creativecommons.org/publicdomain/zero/1.0/ for further
+   details.
+
+   How long hashes take depends on the machine and on what else it is
+   doing, so this test does not check the times, only that the costs
+   chosen are within the limits, that they are remembered, and that
+   the settings work.  */
+
+#include "crypt-port.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char rbytes[] = "0123456789abcdef";
+
+#if INCLUDE_sha512crypt || INCLUDE_yescrypt || INCLUDE_argon2id \
+  || INCLUDE_md5crypt
+static bool
+check_works (const char *setting)
+{
+  struct crypt_data cd;
+  memset (&cd, 0, sizeof cd);
+  if (!crypt_rn ("calibrated", setting, &cd, (int) sizeof cd))
+    {
+      printf ("FAIL: hashing with %s: %s\n", setting, strerror (errno));
+      return false;
+    }
+  return true;
+}
+#endif
+
+#if INCLUDE_yescrypt || INCLUDE_argon2id || INCLUDE_md5crypt
+/* Check that calibrating PREFIX for MSEC and MEMORY gives the same
+   setting as crypt_gensalt_rn with COUNT.  */
+static bool
+expect_count (const char *prefix, int msec, unsigned long memory,
+              unsigned long count)
+{
+  char got[CRYPT_GENSALT_OUTPUT_SIZE], want[CRYPT_GENSALT_OUTPUT_SIZE];
+
+  if (!crypt_gensalt_rn (prefix, count, rbytes, 16, want, sizeof want))
+    {
+      printf ("ERROR: crypt_gensalt_rn(%s, %lu): %s\n", prefix, count,
+              strerror (errno));
+      return false;
+    }
+  if (!crypt_gensalt_calibrated_rn (prefix, msec, memory, rbytes, 16,
+                                    got, sizeof got))
+    {
+      printf ("FAIL: %s, %d ms, %lu bytes: %s\n", prefix, msec, memory,
+              strerror (errno));
+      return false;
+    }
+  if (strcmp (got, want))
+    {
+      printf ("FAIL: %s, %d ms, %lu bytes: got %s, expected %s\n",
+              prefix, msec, memory, got, want);
+      return false;
+    }
+  return check_works (got);
+}
+#endif
+
+static bool
+expect_fail (const char *prefix, int msec, unsigned long memory, int err)
+{
+  char out[CRYPT_GENSALT_OUTPUT_SIZE];
+
+  errno = 0;
+  if (crypt_gensalt_calibrated_rn (prefix, msec, memory, rbytes, 16,
+                                   out, sizeof out)
+      || errno != err || out[0] != '*')
+    {
+      printf ("FAIL: %s, %d ms, %lu bytes: got %s (%s), expected %s\n",
+              prefix ? prefix : "(null)", msec, memory, out,
+              strerror (errno), strerror (err));
+      return false;
+    }
+  return true;
+}
+
+int
+main (void)
+{
+  bool ok = true;
+
+#if INCLUDE_sha512crypt
+  {
+    /* The same rounds every time.  */
+    char first[CRYPT_GENSALT_OUTPUT_SIZE];
+    const char *s = crypt_gensalt_calibrated ("$6$", 20, 0, rbytes, 16);
+    if (!s || strncmp (s, "$6$rounds=", 10))
+      {
+        printf ("FAIL: $6$, 20 ms: got %s\n", s ? s : strerror (errno));
+        ok = false;
+      }
+    else
+      {
+        strcpy (first, s);
+        unsigned long rounds = strtoul (first + 10, 0, 10);
+        if (rounds < 1000)
+          {
+            printf ("FAIL: $6$, 20 ms: %lu rounds\n", rounds);
+            ok = false;
+          }
+        ok &= check_works (first);
+        s = crypt_gensalt_calibrated ("$6$", 20, 0, rbytes, 16);
+        if (!s || strcmp (s, first))
+          {
+            printf ("FAIL: $6$, 20 ms again: got %s, expected %s\n",
+                    s ? s : strerror (errno), first);
+            ok = false;
+          }
+      }
+  }
+#endif
+
+#if INCLUDE_bcrypt
+  {
+    /* The lowest cost takes about a millisecond.  */
+    const char *s = crypt_gensalt_calibrated ("$2b$", 1, 0, rbytes, 16);
+    if (!s || strncmp (s, "$2b$0", 5) || s[5] < '4' || s[5] > '6')
+      {
+        printf ("FAIL: $2b$, 1 ms: got %s\n", s ? s : strerror (errno));
+        ok = false;
+      }
+  }
+#endif
+
+#if INCLUDE_yescrypt
+  /* Only the lowest cost fits in 1 MiB, however long it may take.  */
+  ok &= expect_count ("$y$", 10000, 1UL << 20, 1);
+  ok &= expect_fail ("$y$", 10000, (1UL << 20) - 1, EINVAL);
+#endif
+
+#if INCLUDE_argon2id
+  /* Likewise, 1 MiB.  */
+  ok &= expect_count ("$argon2id$", 10000, 1UL << 20, 10);
+  ok &= expect_fail ("$argon2id$", 10000, (1UL << 20) - 1, EINVAL);
+#endif
+
+#if INCLUDE_md5crypt
+  /* No cost parameter.  */
+  ok &= expect_count ("$1$", 100, 0, 0);
+#endif
+
+  ok &= expect_fail ("$@", 100, 0, EINVAL);
+#if INCLUDE_sha512crypt
+  ok &= expect_fail ("$6$", 0, 0, EINVAL);
+#endif
+
+  return ok ? 0 : 1;
+}
@@ -81,6 +81,9 @@ static const struct testcase testcases[] =
 #endif
 #if INCLUDE_gost_yescrypt
   { "$gy$", 7, 11, },
+#endif
+#if INCLUDE_argon2id
+  { "$argon2id$", 12, 14, },
 #endif
   { 0, 0, 0, }
 };
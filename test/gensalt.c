@@ -280,6 +280,29 @@ static const char *gost_yescrypt_expected_output_h[] =
   "$gy$jFT$UqGBkVu01rurVZqgNchTB0"
 };
 #endif
+#if INCLUDE_argon2id
+static const char *argon2id_expected_output[] =
+{
+  "$argon2id$v=19$m=65536,t=3,p=4$WDXNJgOrLBSSEx5ZsLz+1Q",
+  "$argon2id$v=19$m=65536,t=3,p=4$mzWiRetono/ZqQlxzE0hRA",
+  "$argon2id$v=19$m=65536,t=3,p=4$JRPFlMOTHfT91E+9EOUoCA",
+  "$argon2id$v=19$m=65536,t=3,p=4$oC01cKgLw63fYWmzGdp+jQ"
+};
+static const char *argon2id_expected_output_l[] =
+{
+  "$argon2id$v=19$m=1024,t=3,p=4$WDXNJgOrLBSSEx5ZsLz+1Q",
+  "$argon2id$v=19$m=1024,t=3,p=4$mzWiRetono/ZqQlxzE0hRA",
+  "$argon2id$v=19$m=1024,t=3,p=4$JRPFlMOTHfT91E+9EOUoCA",
+  "$argon2id$v=19$m=1024,t=3,p=4$oC01cKgLw63fYWmzGdp+jQ"
+};
+static const char *argon2id_expected_output_h[] =
+{
+  "$argon2id$v=19$m=4194304,t=3,p=4$WDXNJgOrLBSSEx5ZsLz+1Q",
+  "$argon2id$v=19$m=4194304,t=3,p=4$mzWiRetono/ZqQlxzE0hRA",
+  "$argon2id$v=19$m=4194304,t=3,p=4$JRPFlMOTHfT91E+9EOUoCA",
+  "$argon2id$v=19$m=4194304,t=3,p=4$oC01cKgLw63fYWmzGdp+jQ"
+};
+#endif
 
 struct testcase
 {
@@ -375,6 +398,11 @@ static const struct testcase testcases[] =
   { "$gy$",  gost_yescrypt_expected_output,   30, 30,  0 },
   { "$gy$",  gost_yescrypt_expected_output_l, 30, 30,  1 },
   { "$gy$",  gost_yescrypt_expected_output_h, 30, 30, 11 },
+#endif
+#if INCLUDE_argon2id
+  { "$argon2id$", argon2id_expected_output,   53, 53,  0 },
+  { "$argon2id$", argon2id_expected_output_l, 52, 52, 10 },
+  { "$argon2id$", argon2id_expected_output_h, 55, 55, 22 },
 #endif
   { 0, 0, 0, 0, 0 }
 };
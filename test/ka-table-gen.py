@@ -27,7 +27,9 @@
 # implementation.
 
 import array
+import base64
 import ctypes
+import ctypes.util
 import multiprocessing
 import os
 import re
@@ -546,6 +548,50 @@ def h_gost_yescrypt(phrase, rounds, salt):
     setting = yescrypt_gensalt("gy", rounds, salt)
     yield (phrase, setting, xcrypt_crypt(phrase, setting))
 
+# passlib's Argon2 support needs one of several optional backends; call
+# the reference implementation, libargon2, directly instead.  Its
+# encoded form is the same as ours.  The rounds parameter is the
+# memory in KiB; the number of passes and lanes follow the salt.
+# libargon2 is only looked up when argon2id hashes are wanted, so that
+# the other methods' tables can be generated without it.
+_argon2id_hash_encoded = None
+
+def load_libargon2():
+    global _argon2id_hash_encoded
+    if _argon2id_hash_encoded is None:
+        path = ctypes.util.find_library("argon2")
+        if path is None:
+            return None
+        fn = ctypes.cdll.LoadLibrary(path).argon2id_hash_encoded
+        fn.argtypes = [ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32,
+                       ctypes.c_char_p, ctypes.c_size_t,
+                       ctypes.c_char_p, ctypes.c_size_t,
+                       ctypes.c_size_t,
+                       ctypes.c_char_p, ctypes.c_size_t]
+        fn.restype = ctypes.c_int
+        _argon2id_hash_encoded = fn
+    return _argon2id_hash_encoded
+
+def h_argon2id(phrase, rounds, salt, passes, lanes):
+    argon2id_hash_encoded = load_libargon2()
+    binsalt = base64.b64decode(salt + "=" * (-len(salt) % 4))
+    encoded = ctypes.create_string_buffer(256)
+    rv = argon2id_hash_encoded(passes, rounds, lanes,
+                               phrase, len(phrase),
+                               binsalt, len(binsalt), 32,
+                               encoded, len(encoded))
+    if rv != 0:
+        raise RuntimeError("argon2id_hash_encoded: error {}".format(rv))
+    setting = "$argon2id$v=19$m={},t={},p={}${}".format(rounds, passes,
+                                                        lanes, salt)
+    yield (phrase, setting, encoded.value)
+
+# Methods whose reference implementation is an optional library, and
+# the function that loads it, returning None if it is missing.
+OPTIONAL_METHODS = {
+    'argon2id': load_libargon2,
+}
+
 # Each method should contribute a group of parameters to the array
 # below.  Each block has the form
 #
@@ -572,6 +618,13 @@ def h_gost_yescrypt(phrase, rounds, salt):
 # Methods should be in alphabetical order by their INCLUDE_macro name.
 
 SETTINGS = [
+    ('argon2id', [
+        (16, 'c29tZXNhbHQ', 1, 1),
+        (16, 'TGRKTUVOcEJBQkpKM2hJSA', 2, 2),
+        (64, 'c29tZXNhbHQ', 1, 1),
+        (64, 'TGRKTUVOcEJBQkpKM2hJSA', 2, 2),
+    ]),
+
     ('bcrypt', [
         (5, 'CCCCCCCCCCCCCCCCCCCCC.'),
         (5, 'abcdefghijklmnopqrstuu'),
@@ -837,6 +890,12 @@ def report_unexpected_collision(p1, p2, s1, s2, expected):
 
 def generate_phrase_setting_combs():
     for macro_name, settings in SETTINGS:
+        load = OPTIONAL_METHODS.get(macro_name)
+        if load is not None and load() is None:
+            sys.stderr.write("ka-table-gen.py: reference implementation "
+                             "of {} not found, skipping it\n"
+                             .format(macro_name))
+            continue
         for phrase in PHRASES:
             for setting in settings:
                 yield (macro_name, phrase, setting)
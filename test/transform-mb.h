@@ -0,0 +1,150 @@
+/*
+ * Checking a multi-buffer block transform against the one-message
+ * hash built on the same compression function.  Used by the tests
+ * for MD5, SHA-1, SHA-256 and SHA-512, which fill in a struct
+ * mb_hash and call test_transform_mb.
+ */
+
+#ifndef _CRYPT_TEST_TRANSFORM_MB_H
+#define _CRYPT_TEST_TRANSFORM_MB_H 1
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The most lanes any of the transforms accepts.  */
+#define TEST_MB_MAX_LANES 16
+
+/* The longest block any of the hashes uses.  */
+#define TEST_MB_MAX_BLOCK 128
+
+struct mb_hash
+{
+  const char *name;
+  /* Block length in bytes.  The message length goes in the last
+     2 * WORD_LEN bytes of the padding.  */
+  size_t block_len;
+  /* Size of a state word in bytes, 4 or 8.  */
+  size_t word_len;
+  size_t state_words;
+  size_t max_lanes;
+  /* Whether the state words and the message length are big-endian.  */
+  bool big_endian;
+  const void *iv;
+  /* Run the transform over one block per lane.  STATES points to
+     NLANES states of STATE_WORDS words each.  */
+  void (*transform) (void *states, const uint8_t *const *blocks,
+                     size_t nlanes);
+  /* Hash LEN bytes at MSG the usual way.  */
+  void (*hash) (const uint8_t *msg, size_t len, uint8_t *digest);
+};
+
+static void
+mb_print_hex (const uint8_t *bytes, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+    printf ("%02x", (unsigned int) bytes[i]);
+  putchar ('\n');
+}
+
+/* Hash NLANES different messages of LEN bytes each with T's
+   multi-buffer transform, and compare the results with T->hash.  */
+static int
+test_transform_mb_1 (const struct mb_hash *t, size_t nlanes, size_t len)
+{
+  static uint8_t msg[TEST_MB_MAX_LANES][4 * TEST_MB_MAX_BLOCK];
+  const uint8_t *blocks[TEST_MB_MAX_LANES];
+  uint8_t expected[64], sum[64];
+  size_t state_len = t->state_words * t->word_len;
+  size_t len_bytes = 2 * t->word_len;
+  size_t padded = (len + 1 + len_bytes + t->block_len - 1)
+    / t->block_len * t->block_len;
+  size_t l, b;
+  int result = 0;
+
+  uint8_t *states = malloc (nlanes * state_len);
+  if (!states)
+    {
+      perror ("malloc");
+      return 1;
+    }
+
+  for (l = 0; l < nlanes; l++)
+    {
+      for (b = 0; b < len; b++)
+        msg[l][b] = (uint8_t)(b * 7 + l * 31 + 1);
+      memset (msg[l] + len, 0, padded - len);
+      msg[l][len] = 0x80;
+      for (b = 0; b < 8; b++)
+        {
+          uint8_t v = (uint8_t)((len << 3) >> (b * 8));
+          if (t->big_endian)
+            msg[l][padded - 1 - b] = v;
+          else
+            msg[l][padded - len_bytes + b] = v;
+        }
+      memcpy (states + l * state_len, t->iv, state_len);
+    }
+
+  for (b = 0; b < padded; b += t->block_len)
+    {
+      for (l = 0; l < nlanes; l++)
+        blocks[l] = msg[l] + b;
+      t->transform (states, blocks, nlanes);
+    }
+
+  for (l = 0; l < nlanes; l++)
+    {
+      t->hash (msg[l], len, expected);
+      for (b = 0; b < state_len; b++)
+        {
+          size_t i = b / t->word_len, k = b % t->word_len;
+          uint64_t w;
+          if (t->word_len == 4)
+            {
+              uint32_t w32;
+              memcpy (&w32, states + l * state_len + i * 4, 4);
+              w = w32;
+            }
+          else
+            memcpy (&w, states + l * state_len + i * 8, 8);
+          if (t->big_endian)
+            k = t->word_len - 1 - k;
+          sum[b] = (uint8_t)(w >> (8 * k));
+        }
+      if (memcmp (expected, sum, state_len) != 0)
+        {
+          printf ("FAIL: %s multi-buffer hash of %zu bytes,"
+                  " lane %zu of %zu\n", t->name, len, l, nlanes);
+          fputs ("  exp: ", stdout);
+          mb_print_hex (expected, state_len);
+          fputs ("  got: ", stdout);
+          mb_print_hex (sum, state_len);
+          result = 1;
+        }
+    }
+
+  free (states);
+  return result;
+}
+
+/* Check the multi-buffer transform of the struct mb_hash at ARG with
+   every number of lanes it accepts, on messages that take one, two
+   and four blocks.  */
+static int
+test_transform_mb (const void *arg)
+{
+  const struct mb_hash *t = arg;
+  size_t one_block = t->block_len - 1 - 2 * t->word_len;
+  int result = 0;
+
+  for (size_t nlanes = 1; nlanes <= t->max_lanes; nlanes++)
+    {
+      result |= test_transform_mb_1 (t, nlanes, 0);
+      result |= test_transform_mb_1 (t, nlanes, one_block);
+      result |= test_transform_mb_1 (t, nlanes, one_block + 1);
+      result |= test_transform_mb_1 (t, nlanes, 3 * t->block_len);
+    }
+  return result;
+}
+
+#endif /* transform-mb.h */